@@ -42,6 +42,8 @@
 #include "client/ClientPropertyManager.h"
 
 #include <sys/prctl.h>
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
 #include <rules/python/CyPy_Rules.h>
 
 
@@ -66,6 +68,10 @@ STRING_OPTION(account, "", "aiclient", "account", "Account name to use to authen
 
 STRING_OPTION(password, "", "aiclient", "password", "Password to use to authenticate to the server");
 
+INT_OPTION(navmesh_threads, 0, CYPHESIS, "navmesh_threads", "Number of threads used for building navmesh tiles in the background. Set to 0 to build tiles on the main thread.");
+
+BOOL_OPTION(navmesh_cache, false, CYPHESIS, "navmesh_cache", "Store built navmesh tiles on disk, and reuse them when the AI client is restarted");
+
 static void connectToServer(boost::asio::io_context& io_context, AwareMindFactory& mindFactory)
 {
     if (exit_flag_soft || exit_flag) {
@@ -141,7 +147,18 @@ int main(int argc, char** argv)
         FileSystemObserver file_system_observer(io_context);
 
         ClientPropertyManager propertyManager{};
-        AwareMindFactory mindFactory(propertyManager);
+        std::string navmeshCacheDirectory;
+        if (navmesh_cache) {
+            auto navmeshCachePath = boost::filesystem::path(var_directory) / "lib" / "cyphesis" / "navmesh" / instance;
+            boost::system::error_code ec;
+            boost::filesystem::create_directories(navmeshCachePath, ec);
+            if (ec) {
+                log(WARNING, String::compose("Could not create navmesh cache directory '%1': %2", navmeshCachePath.string(), ec.message()));
+            } else {
+                navmeshCacheDirectory = navmeshCachePath.string();
+            }
+        }
+        AwareMindFactory mindFactory(propertyManager, static_cast<size_t>(std::max(0, navmesh_threads)), navmeshCacheDirectory);
 
         AssetsManager assets_manager(file_system_observer);
         assets_manager.init();
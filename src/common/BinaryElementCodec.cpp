@@ -0,0 +1,401 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "BinaryElementCodec.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using Atlas::Message::Element;
+using Atlas::Message::FloatType;
+using Atlas::Message::IntType;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+namespace {
+
+    const char FORMAT_VERSION = 1;
+
+    /**
+     * Nesting deeper than this is treated as corrupt data, rather than risking running out of stack.
+     */
+    const int MAX_DEPTH = 256;
+
+    enum Tag : unsigned char
+    {
+        TAG_NONE = 0,
+        TAG_INT = 1,
+        TAG_DOUBLE = 2,
+        TAG_SINGLE = 3,
+        TAG_STRING = 4,
+        TAG_LIST = 5,
+        TAG_MAP = 6,
+        TAG_DOUBLE_LIST = 7,
+        TAG_SINGLE_LIST = 8
+    };
+
+    void writeVarint(std::string& data, std::uint64_t value)
+    {
+        while (value >= 0x80) {
+            data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<char>(value));
+    }
+
+    void writeInt(std::string& data, IntType value)
+    {
+        //Zigzag encode, so that small negative numbers also get short.
+        auto bits = static_cast<std::uint64_t>(value);
+        writeVarint(data, value < 0 ? ~(bits << 1) : (bits << 1));
+    }
+
+    /**
+     * @return True if the value can be stored as a single precision float without losing anything.
+     */
+    bool isSingle(FloatType value)
+    {
+        //NaN and infinity fail the range check, and are always stored with double precision.
+        return std::abs(value) <= std::numeric_limits<float>::max()
+               && static_cast<FloatType>(static_cast<float>(value)) == value;
+    }
+
+    void writeSingle(std::string& data, FloatType value)
+    {
+        auto single = static_cast<float>(value);
+        std::uint32_t bits;
+        std::memcpy(&bits, &single, sizeof(bits));
+        for (int i = 0; i < 4; ++i) {
+            data.push_back(static_cast<char>((bits >> (i * 8)) & 0xff));
+        }
+    }
+
+    void writeDouble(std::string& data, FloatType value)
+    {
+        double number = value;
+        std::uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        for (int i = 0; i < 8; ++i) {
+            data.push_back(static_cast<char>((bits >> (i * 8)) & 0xff));
+        }
+    }
+
+    void writeString(std::string& data, const std::string& value)
+    {
+        writeVarint(data, value.size());
+        data.append(value);
+    }
+
+    void writeMap(std::string& data, const MapType& map);
+
+    void writeElement(std::string& data, const Element& element)
+    {
+        switch (element.getType()) {
+            case Element::TYPE_INT:
+                data.push_back(TAG_INT);
+                writeInt(data, element.Int());
+                break;
+            case Element::TYPE_FLOAT:
+                if (isSingle(element.Float())) {
+                    data.push_back(TAG_SINGLE);
+                    writeSingle(data, element.Float());
+                } else {
+                    data.push_back(TAG_DOUBLE);
+                    writeDouble(data, element.Float());
+                }
+                break;
+            case Element::TYPE_STRING:
+                data.push_back(TAG_STRING);
+                writeString(data, element.String());
+                break;
+            case Element::TYPE_MAP:
+                data.push_back(TAG_MAP);
+                writeMap(data, element.Map());
+                break;
+            case Element::TYPE_LIST: {
+                auto& list = element.List();
+                bool allFloats = !list.empty();
+                bool allSingle = true;
+                for (auto& entry : list) {
+                    if (!entry.isFloat()) {
+                        allFloats = false;
+                        break;
+                    }
+                    allSingle = allSingle && isSingle(entry.Float());
+                }
+                if (allFloats) {
+                    data.push_back(allSingle ? TAG_SINGLE_LIST : TAG_DOUBLE_LIST);
+                    writeVarint(data, list.size());
+                    for (auto& entry : list) {
+                        if (allSingle) {
+                            writeSingle(data, entry.Float());
+                        } else {
+                            writeDouble(data, entry.Float());
+                        }
+                    }
+                } else {
+                    data.push_back(TAG_LIST);
+                    writeVarint(data, list.size());
+                    for (auto& entry : list) {
+                        writeElement(data, entry);
+                    }
+                }
+            }
+                break;
+            default:
+                //Pointers can't be persisted.
+                data.push_back(TAG_NONE);
+                break;
+        }
+    }
+
+    void writeMap(std::string& data, const MapType& map)
+    {
+        writeVarint(data, map.size());
+        for (auto& entry : map) {
+            writeString(data, entry.first);
+            writeElement(data, entry.second);
+        }
+    }
+
+    /**
+     * Reads from encoded data, checking that it never reads past the end.
+     */
+    struct Reader
+    {
+        const char* pos;
+        const char* end;
+
+        size_t remaining() const
+        {
+            return static_cast<size_t>(end - pos);
+        }
+
+        bool readByte(unsigned char& value)
+        {
+            if (pos == end) {
+                return false;
+            }
+            value = static_cast<unsigned char>(*pos++);
+            return true;
+        }
+
+        bool readVarint(std::uint64_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                unsigned char byte;
+                if (!readByte(byte)) {
+                    return false;
+                }
+                value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * Reads a length, which is checked against the number of remaining bytes since every entry takes at least one byte.
+         */
+        bool readLength(size_t& length, size_t bytesPerEntry = 1)
+        {
+            std::uint64_t value;
+            if (!readVarint(value) || value > remaining() / bytesPerEntry) {
+                return false;
+            }
+            length = static_cast<size_t>(value);
+            return true;
+        }
+
+        bool readInt(IntType& value)
+        {
+            std::uint64_t bits;
+            if (!readVarint(bits)) {
+                return false;
+            }
+            value = static_cast<IntType>((bits & 1) ? ~(bits >> 1) : (bits >> 1));
+            return true;
+        }
+
+        bool readSingle(FloatType& value)
+        {
+            if (remaining() < 4) {
+                return false;
+            }
+            std::uint32_t bits = 0;
+            for (int i = 0; i < 4; ++i) {
+                bits |= static_cast<std::uint32_t>(static_cast<unsigned char>(*pos++)) << (i * 8);
+            }
+            float single;
+            std::memcpy(&single, &bits, sizeof(single));
+            value = single;
+            return true;
+        }
+
+        bool readDouble(FloatType& value)
+        {
+            if (remaining() < 8) {
+                return false;
+            }
+            std::uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(*pos++)) << (i * 8);
+            }
+            double number;
+            std::memcpy(&number, &bits, sizeof(number));
+            value = number;
+            return true;
+        }
+
+        bool readString(std::string& value)
+        {
+            size_t length;
+            if (!readLength(length)) {
+                return false;
+            }
+            value.assign(pos, length);
+            pos += length;
+            return true;
+        }
+    };
+
+    bool readMap(Reader& reader, MapType& map, int depth);
+
+    bool readElement(Reader& reader, Element& element, int depth)
+    {
+        if (depth > MAX_DEPTH) {
+            return false;
+        }
+        unsigned char tag;
+        if (!reader.readByte(tag)) {
+            return false;
+        }
+        switch (tag) {
+            case TAG_NONE:
+                element = Element();
+                return true;
+            case TAG_INT: {
+                IntType value;
+                if (!reader.readInt(value)) {
+                    return false;
+                }
+                element = value;
+                return true;
+            }
+            case TAG_SINGLE:
+            case TAG_DOUBLE: {
+                FloatType value;
+                if (!(tag == TAG_SINGLE ? reader.readSingle(value) : reader.readDouble(value))) {
+                    return false;
+                }
+                element = value;
+                return true;
+            }
+            case TAG_STRING: {
+                std::string value;
+                if (!reader.readString(value)) {
+                    return false;
+                }
+                element = std::move(value);
+                return true;
+            }
+            case TAG_MAP: {
+                element = MapType();
+                return readMap(reader, element.Map(), depth + 1);
+            }
+            case TAG_LIST: {
+                size_t length;
+                if (!reader.readLength(length)) {
+                    return false;
+                }
+                element = ListType(length);
+                for (auto& entry : element.List()) {
+                    if (!readElement(reader, entry, depth + 1)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            case TAG_SINGLE_LIST:
+            case TAG_DOUBLE_LIST: {
+                size_t length;
+                if (!reader.readLength(length, tag == TAG_SINGLE_LIST ? 4 : 8)) {
+                    return false;
+                }
+                element = ListType();
+                auto& list = element.List();
+                list.reserve(length);
+                for (size_t i = 0; i < length; ++i) {
+                    FloatType value;
+                    if (!(tag == TAG_SINGLE_LIST ? reader.readSingle(value) : reader.readDouble(value))) {
+                        return false;
+                    }
+                    list.emplace_back(value);
+                }
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool readMap(Reader& reader, MapType& map, int depth)
+    {
+        size_t length;
+        if (!reader.readLength(length)) {
+            return false;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            std::string key;
+            if (!reader.readString(key)) {
+                return false;
+            }
+            if (!readElement(reader, map[std::move(key)], depth)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+void BinaryElementCodec::encode(const MapType& map, std::string& data)
+{
+    data.clear();
+    data.push_back('\0');
+    data.push_back(FORMAT_VERSION);
+    writeMap(data, map);
+}
+
+bool BinaryElementCodec::decode(const std::string& data, MapType& map)
+{
+    if (!isEncoded(data)) {
+        return false;
+    }
+    Reader reader{data.data() + 2, data.data() + data.size()};
+    map.clear();
+    return readMap(reader, map, 0) && reader.remaining() == 0;
+}
+
+bool BinaryElementCodec::isEncoded(const std::string& data)
+{
+    return data.size() >= 2 && data[0] == '\0' && data[1] == FORMAT_VERSION;
+}
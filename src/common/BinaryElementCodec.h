@@ -0,0 +1,58 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_BINARYELEMENTCODEC_H
+#define CYPHESIS_BINARYELEMENTCODEC_H
+
+#include <Atlas/Message/Element.h>
+
+#include <string>
+
+/**
+ * @brief A compact binary encoding of Atlas message maps, used for persisting entities and properties.
+ *
+ * Encoded data starts with a null byte followed by a format version. Neither can appear at the start of data encoded
+ * with the Atlas text codecs, so isEncoded() can be used to tell which decoder to use for stored data.
+ *
+ * Every element is written as a one byte type tag followed by its value. Integers are written as zigzag variable length
+ * integers, and floats as little endian IEEE 754 numbers; in single precision if that doesn't lose anything.
+ * Strings, lists and maps are prefixed with their length. Lists which only contain floats, such as positions and terrain
+ * points, are written as arrays of numbers without any tags.
+ */
+class BinaryElementCodec
+{
+    public:
+        /**
+         * Encodes the map, replacing the contents of "data".
+         */
+        static void encode(const Atlas::Message::MapType& map, std::string& data);
+
+        /**
+         * Decodes data written by encode().
+         * @return False if the data isn't valid.
+         */
+        static bool decode(const std::string& data, Atlas::Message::MapType& map);
+
+        /**
+         * @return True if the data was written by encode().
+         */
+        static bool isEncoded(const std::string& data);
+};
+
+
+#endif //CYPHESIS_BINARYELEMENTCODEC_H
@@ -33,9 +33,14 @@
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/steady_timer.hpp>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <deque>
+#include <vector>
 
 template<typename ProtocolT>
 class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
@@ -47,6 +52,22 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
                        boost::asio::io_context& io_context,
                        const Atlas::Objects::Factories& factories);
 
+        /**
+         * Creates a client whose socket is handled by a separate io_context, which is run by other threads.
+         *
+         * All reading from and writing to the socket is then done on those threads, while decoding and
+         * encoding of Atlas data, as well as handling of ops, is done on the thread running the main io_context.
+         * Data is handed over between the threads by posting handlers, so the main thread never waits for any socket.
+         * @param name
+         * @param io_context The main io_context.
+         * @param networkContext The io_context which handles the socket.
+         * @param factories
+         */
+        CommAsioClient(std::string name,
+                       boost::asio::io_context& io_context,
+                       boost::asio::io_context& networkContext,
+                       const Atlas::Objects::Factories& factories);
+
         ~CommAsioClient() override;
 
         typename ProtocolT::socket& getSocket();
@@ -70,20 +91,60 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
         int mMaxOpsPerDispatch;
 
     protected:
+        /**
+         * True if the socket is handled by a separate network io_context.
+         */
+        const bool mThreaded;
+
         typename ProtocolT::socket mSocket;
 
+        /**
+         * Serializes all handlers of the socket when it's handled by a separate network io_context.
+         */
+        boost::asio::io_context::strand mStrand;
+
         boost::asio::streambuf mReadBuffer;
         /**
          * A buffer into which any outgoing data is written. This is always attached to mOutStream,
          * which basically means that any Atlas op being serialized for outgoing data is written to
          * this buffer.
          */
-        std::unique_ptr<boost::asio::streambuf> mWriteBuffer;
+        std::shared_ptr<boost::asio::streambuf> mWriteBuffer;
 
         /**
          * A buffer which is used when data is being sent asynchronously.
          */
-        std::unique_ptr<boost::asio::streambuf> mSendBuffer;
+        std::shared_ptr<boost::asio::streambuf> mSendBuffer;
+
+        /**
+         * Buffers handed over to the network threads, waiting to be written to the socket. Only accessed through mStrand.
+         */
+        std::deque<std::shared_ptr<boost::asio::streambuf>> mNetworkSendQueue;
+
+        /**
+         * Buffers which have been written by the network threads and can be reused. Only accessed from the main thread.
+         */
+        std::vector<std::shared_ptr<boost::asio::streambuf>> mSpareBuffers;
+
+        /**
+         * The number of reads, writes and other tasks handed over to the network threads which haven't reported
+         * back to the main thread yet.
+         *
+         * This is changed both from the main thread and from the network threads, since the read loop counts every
+         * chunk of data it hands over to the main thread, and therefore needs to be atomic. The read loop itself
+         * counts as a task, so the count can only go up from zero on the main thread.
+         *
+         * While there are any pending tasks the client keeps a reference to itself, and the main io_context is kept busy.
+         * This makes sure that the client always is destroyed on the main thread, and only when no network thread uses it.
+         */
+        std::atomic<int> mPendingNetworkTasks;
+        std::shared_ptr<CommAsioClient> mNetworkSelfReference;
+        std::unique_ptr<boost::asio::io_context::work> mNetworkWork;
+
+        /**
+         * The name of the socket, as it was when negotiation was started.
+         */
+        std::string mSocketName;
 
         /**
          * The stream onto which data is received.
@@ -109,14 +170,52 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
          */
         bool mShouldSend;
 
+        /**
+         * True if flushing has been deferred until the next call to CommSocket::flushCorkedSockets().
+         */
+        bool mFlushDeferred;
+
+        /**
+         * Bytes and writes since the statistics were last published.
+         */
+        size_t mStatisticsBytes;
+        int mStatisticsWrites;
+        std::chrono::steady_clock::time_point mStatisticsStart;
+
+        /**
+         * Publishes the statistics once every second while there are writes, so that the rates drop to zero when the connection goes idle.
+         */
+        boost::asio::steady_timer mStatisticsTimer;
+
+        /**
+         * True if mStatisticsTimer is waiting to publish the statistics.
+         */
+        bool mStatisticsTimerActive;
+
+        /**
+         * Keys of the monitors for this connection; empty until the first statistics have been published.
+         */
+        std::string mBytesMonitorKey;
+        std::string mWritesMonitorKey;
+
         enum
         {
             /**
              * Arbitrary size of the read buffer.
              */
-                read_buffer_size = 16384
+                read_buffer_size = 16384,
+            /**
+             * When corked, data is written right away if there's more than this amount waiting to be sent.
+             */
+                cork_flush_threshold = 65536
         };
 
+        /**
+         * The buffer into which data is read on the network threads, before being handed over to the main thread.
+         * Only used when threaded.
+         */
+        std::array<char, read_buffer_size> mNetworkReadBuffer;
+
         /// \brief Queue of operations that have been decoded by not dispatched.
         DispatchQueue m_opQueue;
         /// \brief Atlas codec that handles encoding and decoding traffic.
@@ -134,6 +233,51 @@ class CommAsioClient : public Atlas::Objects::ObjectsDecoder,
 
         void write();
 
+        /**
+         * Reads from the socket on the network threads, handing over all data to the main thread. Must be called through mStrand.
+         */
+        void network_read();
+
+        /**
+         * Writes the first queued buffer to the socket on the network threads. Must be called through mStrand.
+         */
+        void network_write();
+
+        /**
+         * Handles data which has been read by the network threads, on the main thread.
+         */
+        void dataReceived(const std::string& data);
+
+        /**
+         * Runs a task on the network threads, making sure the client is kept alive until it's done.
+         */
+        void postToNetwork(std::function<void()> task);
+
+        void networkTaskStarted();
+
+        /**
+         * Called on the main thread when a task on the network threads is done. This might destroy the client.
+         */
+        void networkTaskCompleted();
+
+        void logSocketError(const boost::system::error_code& ec, const std::string& action);
+
+        void flushDeferred() override;
+
+        /**
+         * Records a write, starting the statistics timer if it isn't already running.
+         */
+        void updateStatistics(size_t bytes);
+
+        /**
+         * Updates the bytes and writes per second monitors for this connection.
+         *
+         * The timer is started again only if there were any writes since last time, so an idle connection reports zero once and then stops.
+         */
+        void publishStatistics();
+
+        void scheduleStatistics();
+
         void dispatch();
 
         void startNegotiation();
@@ -28,6 +28,7 @@
 #include "common/log.h"
 #include "common/compose.hpp"
 #include "common/debug.h"
+#include "common/Monitors.h"
 
 #include "CommAsioClient.h"
 
@@ -48,17 +49,35 @@ template<class ProtocolT>
 CommAsioClient<ProtocolT>::CommAsioClient(std::string name,
                                           boost::asio::io_context& io_context,
                                           const Atlas::Objects::Factories& factories) :
+    CommAsioClient(std::move(name), io_context, io_context, factories)
+{
+}
+
+template<class ProtocolT>
+CommAsioClient<ProtocolT>::CommAsioClient(std::string name,
+                                          boost::asio::io_context& io_context,
+                                          boost::asio::io_context& networkContext,
+                                          const Atlas::Objects::Factories& factories) :
     ObjectsDecoder(factories),
     CommSocket(io_context),
     mMaxOpsPerDispatch(1),
-    mSocket(io_context),
+    mThreaded(&io_context != &networkContext),
+    mSocket(networkContext),
+    mStrand(networkContext),
     mWriteBuffer(new boost::asio::streambuf()),
     mSendBuffer(new boost::asio::streambuf()),
+    mPendingNetworkTasks(0),
     mInStream(&mReadBuffer),
     mOutStream(mWriteBuffer.get()),
     mNegotiateTimer(io_context, std::chrono::seconds(1)),
     mIsSending(false),
     mShouldSend(false),
+    mFlushDeferred(false),
+    mStatisticsBytes(0),
+    mStatisticsWrites(0),
+    mStatisticsStart(std::chrono::steady_clock::now()),
+    mStatisticsTimer(io_context),
+    mStatisticsTimerActive(false),
     mName(std::move(name))
 {
 }
@@ -74,6 +93,10 @@ CommAsioClient<ProtocolT>::~CommAsioClient()
         mSocket.close();
     } catch (const std::exception& e) {
     }
+    if (!mBytesMonitorKey.empty() && Monitors::hasInstance()) {
+        Monitors::instance().remove(mBytesMonitorKey);
+        Monitors::instance().remove(mWritesMonitorKey);
+    }
 }
 
 template<class ProtocolT>
@@ -110,6 +133,12 @@ namespace {
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::do_read()
 {
+    if (mThreaded) {
+        //The read loop counts as one task, which lasts until the socket is closed.
+        networkTaskStarted();
+        mStrand.post([this]() { this->network_read(); });
+        return;
+    }
     auto self(this->shared_from_this());
     mSocket.async_read_some(mReadBuffer.prepare(read_buffer_size),
                             [this, self](boost::system::error_code ec, std::size_t length) {
@@ -145,6 +174,30 @@ void CommAsioClient<ProtocolT>::do_read()
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::write()
 {
+    if (mThreaded) {
+        if (mWriteBuffer->size() != 0) {
+            updateStatistics(mWriteBuffer->size());
+            //Hand the buffer over to the network threads, and continue writing into another one.
+            auto buffer = std::move(mWriteBuffer);
+            if (mSpareBuffers.empty()) {
+                mWriteBuffer = std::make_shared<boost::asio::streambuf>();
+            } else {
+                mWriteBuffer = std::move(mSpareBuffers.back());
+                mSpareBuffers.pop_back();
+            }
+            mOutStream.rdbuf(mWriteBuffer.get());
+
+            networkTaskStarted();
+            mStrand.post([this, buffer]() {
+                mNetworkSendQueue.push_back(buffer);
+                //If there's already a buffer being written this one will be written when that is done.
+                if (mNetworkSendQueue.size() == 1) {
+                    this->network_write();
+                }
+            });
+        }
+        return;
+    }
     if (mWriteBuffer->size() != 0) {
         if (mIsSending) {
             //We're already sending in the background.
@@ -161,6 +214,7 @@ void CommAsioClient<ProtocolT>::write()
         std::swap(mWriteBuffer, mSendBuffer);
         mOutStream.rdbuf(mWriteBuffer.get());
         mIsSending = true;
+        updateStatistics(mSendBuffer->size());
 
         boost::asio::async_write(mSocket, *mSendBuffer,
                                  [this, self](boost::system::error_code ec, std::size_t length) {
@@ -191,6 +245,188 @@ void CommAsioClient<ProtocolT>::write()
     }
 }
 
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::network_read()
+{
+    mSocket.async_read_some(boost::asio::buffer(mNetworkReadBuffer),
+                            mStrand.wrap([this](boost::system::error_code ec, std::size_t length) {
+                                if (!ec) {
+                                    //Decoding is done on the main thread, since Atlas objects can't be created concurrently.
+                                    //The read loop is still pending, so it's safe to count another task from this thread.
+                                    mPendingNetworkTasks++;
+                                    std::string data(mNetworkReadBuffer.data(), length);
+                                    m_io_context.post([this, data]() {
+                                        this->dataReceived(data);
+                                        this->networkTaskCompleted();
+                                    });
+                                    this->network_read();
+                                } else {
+                                    //This ends the read loop. Nothing can be touched after this, since the client might be destroyed.
+                                    m_io_context.post([this, ec]() {
+                                        this->logSocketError(ec, "reading from");
+                                        this->networkTaskCompleted();
+                                    });
+                                }
+                            }));
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::network_write()
+{
+    auto buffer = mNetworkSendQueue.front();
+    boost::asio::async_write(mSocket, *buffer,
+                             mStrand.wrap([this, buffer](boost::system::error_code ec, std::size_t length) {
+                                 mNetworkSendQueue.pop_front();
+                                 if (!mNetworkSendQueue.empty()) {
+                                     this->network_write();
+                                 }
+                                 //Give the buffer back to the main thread, so it can be reused.
+                                 //Nothing can be touched after this, since the client might be destroyed.
+                                 m_io_context.post([this, buffer, ec]() {
+                                     if (ec) {
+                                         this->logSocketError(ec, "writing to");
+                                     } else {
+                                         buffer->consume(buffer->size());
+                                         mSpareBuffers.push_back(buffer);
+                                     }
+                                     this->networkTaskCompleted();
+                                 });
+                             }));
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::dataReceived(const std::string& data)
+{
+    //No need to handle data if connection has been actively shut down.
+    if (!m_active) {
+        return;
+    }
+    auto buffers = mReadBuffer.prepare(data.size());
+    boost::asio::buffer_copy(buffers, boost::asio::buffer(data));
+    mReadBuffer.commit(data.size());
+
+    if (m_negotiate) {
+        if (this->negotiate() < 0) {
+            //Closing the socket will end the read loop, which will release the client.
+            disconnect();
+            return;
+        }
+        //Either send the rest of the negotiation, or if it's done, the start of the stream.
+        this->write();
+    } else {
+        m_codec->poll();
+        this->dispatch();
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::postToNetwork(std::function<void()> task)
+{
+    networkTaskStarted();
+    mStrand.post([this, task]() {
+        task();
+        m_io_context.post([this]() { this->networkTaskCompleted(); });
+    });
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::networkTaskStarted()
+{
+    //Only the main thread can start the first task, so there's no race with the release in networkTaskCompleted().
+    if (mPendingNetworkTasks++ == 0) {
+        mNetworkSelfReference = this->shared_from_this();
+        //Keep the main io_context running until the network threads are done with this client, so that it's destroyed properly on shutdown.
+        mNetworkWork = std::make_unique<boost::asio::io_context::work>(m_io_context);
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::networkTaskCompleted()
+{
+    if (--mPendingNetworkTasks == 0) {
+        mNetworkWork.reset();
+        //This might destroy the client.
+        auto selfReference = std::move(mNetworkSelfReference);
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::logSocketError(const boost::system::error_code& ec, const std::string& action)
+{
+    //No need to report errors if connection has been actively shut down.
+    if (m_active) {
+        std::stringstream ss;
+        log_level level = WARNING;
+        if (ec == boost::asio::error::eof) {
+            ss << String::compose("Connection at '%1' hung up unexpectedly.", mSocketName);
+            level = NOTICE;
+        } else {
+            ss << String::compose("Error when %1 socket at '%2': (", action, mSocketName) << ec << ") " << ec.message();
+        }
+        log(level, ss.str());
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::flushDeferred()
+{
+    mFlushDeferred = false;
+    write();
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::updateStatistics(size_t bytes)
+{
+    mStatisticsBytes += bytes;
+    mStatisticsWrites++;
+    if (!mStatisticsTimerActive) {
+        mStatisticsTimerActive = true;
+        mStatisticsStart = std::chrono::steady_clock::now();
+        scheduleStatistics();
+    }
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::scheduleStatistics()
+{
+    //Use a weak reference, so that the timer doesn't keep the client alive.
+    std::weak_ptr<CommAsioClient> weakSelf = this->shared_from_this();
+    mStatisticsTimer.expires_from_now(std::chrono::seconds(1));
+    mStatisticsTimer.async_wait([weakSelf](const boost::system::error_code& ec) {
+        if (!ec) {
+            auto self = weakSelf.lock();
+            if (self) {
+                self->publishStatistics();
+            }
+        }
+    });
+}
+
+template<class ProtocolT>
+void CommAsioClient<ProtocolT>::publishStatistics()
+{
+    auto now = std::chrono::steady_clock::now();
+    auto elapsed = now - mStatisticsStart;
+    if (m_link && Monitors::hasInstance()) {
+        if (mBytesMonitorKey.empty()) {
+            mBytesMonitorKey = String::compose("comm_bytes_per_second{connection=\"%1\"}", m_link->getId());
+            mWritesMonitorKey = String::compose("comm_writes_per_second{connection=\"%1\"}", m_link->getId());
+        }
+        auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(elapsed).count();
+        Monitors::instance().insert(mBytesMonitorKey, static_cast<Atlas::Message::IntType>(mStatisticsBytes / seconds));
+        Monitors::instance().insert(mWritesMonitorKey, static_cast<Atlas::Message::IntType>(mStatisticsWrites / seconds));
+    }
+    bool idle = mStatisticsWrites == 0;
+    mStatisticsBytes = 0;
+    mStatisticsWrites = 0;
+    mStatisticsStart = now;
+    if (idle) {
+        mStatisticsTimerActive = false;
+    } else {
+        scheduleStatistics();
+    }
+}
+
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::negotiate_read()
 {
@@ -263,21 +499,33 @@ void CommAsioClient<ProtocolT>::startConnect(std::unique_ptr<Link> connection)
 template<class ProtocolT>
 void CommAsioClient<ProtocolT>::startNegotiation()
 {
+    mSocketName = socketName(mSocket);
     auto self(this->shared_from_this());
     mNegotiateTimer.expires_from_now(std::chrono::seconds(10));
     mNegotiateTimer.async_wait([this, self](const boost::system::error_code& ec) {
         //If the negotiator still exists after the deadline it means that the negotiation hasn't
         //completed yet; we'll consider that a "timeout".
         if (m_negotiate != nullptr) {
-            log(NOTICE, String::compose("Client at '%1' disconnected because of negotiation timeout.", socketName(mSocket)));
-            mSocket.close();
+            log(NOTICE, String::compose("Client at '%1' disconnected because of negotiation timeout.", mSocketName));
+            if (mThreaded) {
+                //Cancelling the socket will end the read loop, which will release the client.
+                disconnect();
+            } else {
+                mSocket.close();
+            }
         }
     });
 
     m_negotiate->poll();
 
-    negotiate_write();
-    negotiate_read();
+    if (mThreaded) {
+        //When threaded, reading is done continuously, and the data is handled in dataReceived().
+        this->write();
+        this->do_read();
+    } else {
+        negotiate_write();
+        negotiate_read();
+    }
 }
 
 template<class ProtocolT>
@@ -292,7 +540,7 @@ int CommAsioClient<ProtocolT>::negotiate()
 
     // Check if negotiation failed
     if (m_negotiate->getState() == Atlas::Negotiate::FAILED) {
-        log(NOTICE, String::compose("Failed to negotiate with client at '%1'.", socketName(mSocket)));
+        log(NOTICE, String::compose("Failed to negotiate with client at '%1'.", mSocketName));
         return -1;
     }
     // Negotiation was successful
@@ -304,7 +552,7 @@ int CommAsioClient<ProtocolT>::negotiate()
     m_negotiate.reset();
 
     if (m_codec == nullptr) {
-        log(NOTICE, String::compose("Could not create codec during negotiation with '%1'.", socketName(mSocket)));
+        log(NOTICE, String::compose("Could not create codec during negotiation with '%1'.", mSocketName));
         return -1;
     }
     // Create a new encoder to send high level objects to the codec
@@ -373,7 +621,7 @@ void CommAsioClient<ProtocolT>::objectArrived(const Atlas::Objects::Root& obj)
         log(ERROR,
             String::compose("Object of type \"%1\" with parent "
                             "\"%2\" arrived from client at '%1'", obj->getObjtype(),
-                            obj->getParent(), socketName(mSocket)));
+                            obj->getParent(), mSocketName));
         return;
     }
     m_opQueue.push_back(op);
@@ -383,7 +631,8 @@ template<class ProtocolT>
 int CommAsioClient<ProtocolT>::send(
     const Atlas::Objects::Operation::RootOperation& op)
 {
-    if (!mSocket.is_open()) {
+    //When threaded the socket belongs to the network threads, and any error is reported from there instead.
+    if (!mThreaded && !mSocket.is_open()) {
         log(ERROR, "Writing to closed client");
         return -1;
     }
@@ -412,12 +661,30 @@ void CommAsioClient<ProtocolT>::disconnect()
     m_active = false;
     m_negotiate.reset();
     mNegotiateTimer.cancel();
-    mSocket.cancel();
+    if (mThreaded) {
+        //If there are no pending tasks there's nothing to cancel.
+        if (mPendingNetworkTasks > 0) {
+            postToNetwork([this]() {
+                boost::system::error_code cancelError;
+                mSocket.cancel(cancelError);
+            });
+        }
+    } else {
+        mSocket.cancel();
+    }
 }
 
 template<class ProtocolT>
 int CommAsioClient<ProtocolT>::flush()
 {
+    //When corked, wait with writing until the end of the main loop iteration, unless there's a lot of data waiting.
+    if (s_corked && mWriteBuffer->size() < cork_flush_threshold) {
+        if (!mFlushDeferred) {
+            mFlushDeferred = true;
+            deferFlush(this->shared_from_this());
+        }
+        return 0;
+    }
     write();
     return 0;
 }
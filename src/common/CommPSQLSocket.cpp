@@ -42,7 +42,8 @@ CommPSQLSocket::CommPSQLSocket(boost::asio::io_context& io_context, DatabasePost
                                m_reindexTimer(io_context),
                                m_reconnectTimer(io_context),
                                m_db(db),
-                               m_vacuumFull(false)
+                               m_vacuumFull(false),
+                               m_flushing(false)
 {
     // This assumes the database connection is already sorted, which I think
     // is okay
@@ -58,6 +59,7 @@ CommPSQLSocket::CommPSQLSocket(boost::asio::io_context& io_context, DatabasePost
     if (fd >= 0) {
         m_socket->assign(boost::asio::ip::tcp::v4(), fd);
     }
+    m_flushNeededConnection = m_db.FlushNeeded.connect([this]() { this->do_flush(); });
     vacuum();
     reindex();
     do_read();
@@ -90,6 +92,7 @@ void CommPSQLSocket::tryReConnect()
 
 CommPSQLSocket::~CommPSQLSocket()
 {
+    m_flushNeededConnection.disconnect();
     m_db.shutdownConnection();
 }
 
@@ -117,6 +120,26 @@ void CommPSQLSocket::do_read()
             });
 }
 
+void CommPSQLSocket::do_flush()
+{
+    if (m_flushing || !m_socket) {
+        return;
+    }
+    m_flushing = true;
+    //Wait for the socket to become writable, and let libpq send as much of the query as it can.
+    m_socket->async_write_some(boost::asio::null_buffers(),
+            [this](boost::system::error_code ec, std::size_t length)
+            {
+                m_flushing = false;
+                if (!ec && m_socket) {
+                    PGconn * con = m_db.getConnection();
+                    if (con != nullptr && PQflush(con) == 1) {
+                        this->do_flush();
+                    }
+                }
+            });
+}
+
 int CommPSQLSocket::read()
 {
     debug_print("CommPSQLSocket::read()")
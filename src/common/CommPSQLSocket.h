@@ -24,6 +24,7 @@
 #include "asio.h"
 #include <boost/asio/steady_timer.hpp>
 #include <boost/noncopyable.hpp>
+#include <sigc++/connection.h>
 
 class DatabasePostgres;
 
@@ -46,7 +47,13 @@ class CommPSQLSocket : private boost::noncopyable {
     /// Flag indicating whether the next vacuum job should be vacuum full.
     bool m_vacuumFull;
 
+    /// Flag indicating whether we're waiting for the socket to become writable, to flush a query.
+    bool m_flushing;
+
+    sigc::connection m_flushNeededConnection;
+
     void do_read();
+    void do_flush();
     int read();
     void dispatch();
 
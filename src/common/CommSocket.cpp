@@ -0,0 +1,50 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#include "CommSocket.h"
+
+bool CommSocket::s_corked = false;
+
+std::vector<std::weak_ptr<CommSocket>> CommSocket::s_deferredSockets;
+
+void CommSocket::flushCorkedSockets()
+{
+    if (s_deferredSockets.empty()) {
+        return;
+    }
+    //Swap out the list, in case a socket defers again while being flushed.
+    std::vector<std::weak_ptr<CommSocket>> sockets;
+    std::swap(sockets, s_deferredSockets);
+    for (auto& entry : sockets) {
+        auto socket = entry.lock();
+        //The socket might have been closed and destroyed since it deferred its flush.
+        if (socket) {
+            socket->flushDeferred();
+        }
+    }
+    //Reuse the memory of the list.
+    sockets.clear();
+    if (s_deferredSockets.empty()) {
+        std::swap(sockets, s_deferredSockets);
+    }
+}
+
+void CommSocket::deferFlush(std::weak_ptr<CommSocket> socket)
+{
+    s_deferredSockets.emplace_back(std::move(socket));
+}
@@ -21,6 +21,9 @@
 
 #include "common/io_context.h"
 
+#include <memory>
+#include <vector>
+
 
 /// \defgroup ServerSockets Server Socket Classes
 ///
@@ -57,6 +60,31 @@ class CommSocket {
 
     /// \brief Flush the socket
     virtual int flush() = 0;
+
+    /// \brief Flushes all sockets which have deferred flushing because of corking.
+    ///
+    /// This should be called once per iteration of the main loop.
+    static void flushCorkedSockets();
+
+    /// \brief If true, sockets may defer flushing until flushCorkedSockets() is called.
+    ///
+    /// This means that all ops sent to a client during one iteration of the
+    /// main loop are written to the socket together, instead of one at a time.
+    static bool s_corked;
+
+  protected:
+
+    /// \brief Registers the socket as having data which should be written in flushCorkedSockets().
+    static void deferFlush(std::weak_ptr<CommSocket> socket);
+
+    /// \brief Writes data whose flushing was deferred.
+    virtual void flushDeferred()
+    {
+        flush();
+    }
+
+  private:
+    static std::vector<std::weak_ptr<CommSocket>> s_deferredSockets;
 };
 
 #endif // COMMON_COMM_SOCKET_H
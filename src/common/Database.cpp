@@ -24,6 +24,7 @@
 #include "globals.h"
 #include "compose.hpp"
 #include "const.h"
+#include "BinaryElementCodec.h"
 
 #include <Atlas/Codecs/Packed.h>
 
@@ -87,21 +88,29 @@ int Database::decodeMessage(const std::string & data,
         return 0;
     }
 
-    std::stringstream str(data, std::ios::in);
+    if (BinaryElementCodec::isEncoded(data)) {
+        if (!BinaryElementCodec::decode(data, o)) {
+            log(WARNING, "Database entry does not appear to be decodable");
+            return -1;
+        }
+        return 0;
+    }
 
-    Serialiser codec(str, str, m_d);
+    //Records written before the binary encoding was introduced, or by databases which store text, use the Packed codec.
+    std::stringstream str(data, std::ios::in);
 
-    // Clear the decoder
-    m_d.get();
+    //Use a decoder of our own, so that records can be decoded on multiple threads.
+    Decoder decoder;
+    Serialiser codec(str, str, decoder);
 
     codec.poll();
 
-    if (!m_d.check()) {
+    if (!decoder.check()) {
         log(WARNING, "Database entry does not appear to be decodable");
         return -1;
     }
 
-    o = m_d.get();
+    o = decoder.get();
     return 0;
 }
 
@@ -242,6 +251,15 @@ DatabaseResult Database::selectEntities(const std::string & loc)
     return runSimpleSelectQuery(query);
 }
 
+DatabaseResult Database::selectAllEntities()
+{
+    std::string query = "SELECT id, loc, type, seq, location FROM entities";
+
+    debug(std::cout << "Selecting all entities ... " << std::flush;);
+
+    return runSimpleSelectQuery(query);
+}
+
 int Database::dropEntity(long id)
 {
     std::string query = compose("DELETE FROM properties WHERE id = '%1'", id);
@@ -286,6 +304,15 @@ DatabaseResult Database::selectProperties(const std::string & id)
     return runSimpleSelectQuery(query);
 }
 
+DatabaseResult Database::selectAllProperties()
+{
+    std::string query = "SELECT id, name, value FROM properties ORDER BY id";
+
+    debug(std::cout << "Selecting all properties ... " << std::endl << std::flush;);
+
+    return runSimpleSelectQuery(query);
+}
+
 int Database::updateProperties(const std::string & id,
                                const KeyValues & tuples)
 {
@@ -122,6 +122,10 @@ class Database : public Singleton<Database>
 
         virtual size_t queryQueueSize() const = 0;
 
+        /// \brief Decodes a record encoded with encodeObject().
+        ///
+        /// Both the binary encoding and the older Packed encoding are accepted.
+        /// This is safe to call from multiple threads at once.
         int decodeMessage(const std::string& data,
                           Atlas::Message::MapType&);
 
@@ -185,41 +189,47 @@ class Database : public Singleton<Database>
         virtual int registerEntityIdGenerator() = 0;
 
         /// Creates a new unique id for the database.
-        /// Note that this method will access the database, so it's a fairly expensive method.
+        /// Ids are handed out from blocks reserved in advance, so this only occasionally needs to access the database.
         virtual long newId(std::string& id) = 0;
 
         // Interface for Entity and Property tables.
 
         virtual int registerEntityTable(const std::map<std::string, int>& chunks) = 0;
 
-        int insertEntity(const std::string& id,
-                         const std::string& loc,
-                         const std::string& type,
-                         int seq,
-                         const std::string& value);
+        virtual int insertEntity(const std::string& id,
+                                 const std::string& loc,
+                                 const std::string& type,
+                                 int seq,
+                                 const std::string& value);
 
-        int updateEntityWithoutLoc(const std::string& id,
-                                   int seq,
-                                   const std::string& location_data);
+        virtual int updateEntityWithoutLoc(const std::string& id,
+                                           int seq,
+                                           const std::string& location_data);
 
-        int updateEntity(const std::string& id,
-                         int seq,
-                         const std::string& location_data,
-                         const std::string& location_entity_id);
+        virtual int updateEntity(const std::string& id,
+                                 int seq,
+                                 const std::string& location_data,
+                                 const std::string& location_entity_id);
 
         DatabaseResult selectEntities(const std::string& loc);
 
-        int dropEntity(long id);
+        /// \brief Selects all entities, with the columns "id", "loc", "type", "seq" and "location".
+        DatabaseResult selectAllEntities();
+
+        virtual int dropEntity(long id);
 
         virtual int registerPropertyTable() = 0;
 
-        int insertProperties(const std::string& id,
-                             const KeyValues& tuples);
+        virtual int insertProperties(const std::string& id,
+                                     const KeyValues& tuples);
 
         DatabaseResult selectProperties(const std::string& loc);
 
-        int updateProperties(const std::string& id,
-                             const KeyValues& tuples);
+        /// \brief Selects the properties of all entities, with the columns "id", "name" and "value", ordered by entity id.
+        DatabaseResult selectAllProperties();
+
+        virtual int updateProperties(const std::string& id,
+                                     const KeyValues& tuples);
 
         virtual int registerThoughtsTable() = 0;
 
@@ -270,6 +280,9 @@ class DatabaseResult
 
             virtual const char* column(const char* column) const = 0;
 
+            /// \brief Gets the full contents of a column, which unlike column() may contain null bytes.
+            virtual std::string data(const char* column) const = 0;
+
             virtual const_iterator_worker& operator++() = 0;
 
             virtual bool operator==(const const_iterator_worker& other) const = 0;
@@ -311,6 +324,11 @@ class DatabaseResult
                     return m_worker->column(column);
                 }
 
+                std::string data(const char* column) const
+                {
+                    return m_worker->data(column);
+                }
+
                 friend class DatabaseResult;
         };
 
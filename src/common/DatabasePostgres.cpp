@@ -25,11 +25,14 @@
 #include "globals.h"
 #include "compose.hpp"
 #include "const.h"
+#include "IdBlockAllocator.h"
 
 #include <Atlas/Codecs/XML.h>
 
 #include <varconf/config.h>
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
 
@@ -42,6 +45,12 @@ typedef Atlas::Codecs::XML Serialiser;
 
 static const bool debug_flag = false;
 
+namespace {
+    INT_OPTION(postgres_batch_size, 16, CYPHESIS, "postgres_batch_size",
+               "Max number of writes to send to PostgreSQL at once, to be run in one transaction. "
+               "Set to 0 to send each write on its own.")
+}
+
 static void databaseNotice(void*, const char* message)
 {
     log(NOTICE, "Notice from database:");
@@ -49,7 +58,13 @@ static void databaseNotice(void*, const char* message)
 }
 
 DatabasePostgres::DatabasePostgres() : Database(),
-                                       m_connection(nullptr)
+                                       m_connection(nullptr),
+                                       m_batchSize(static_cast<size_t>(std::max(0, postgres_batch_size))),
+                                       m_inProgressCount(0),
+                                       m_resultCount(0),
+                                       m_inProgressFailed(false),
+                                       m_unbatchedCount(0),
+                                       m_idConnection(nullptr)
 {
 }
 
@@ -135,9 +150,9 @@ int DatabasePostgres::connect(const std::string& context, std::string& error_msg
         conninfos << "password=" << db_passwd << " ";
     }
 
-    const std::string cinfo = conninfos.str();
+    m_connectionInfo = conninfos.str();
 
-    m_connection = PQconnectdb(cinfo.c_str());
+    m_connection = PQconnectdb(m_connectionInfo.c_str());
 
     if (m_connection == nullptr) {
         error_msg = "Unknown error";
@@ -171,6 +186,12 @@ int DatabasePostgres::initConnection()
 
 void DatabasePostgres::shutdownConnection()
 {
+    //Wait for any reservation of ids in progress before closing its connection.
+    m_idAllocator.reset();
+    if (m_idConnection != nullptr) {
+        PQfinish(m_idConnection);
+        m_idConnection = nullptr;
+    }
     if (m_connection != nullptr) {
         PQfinish(m_connection);
         m_connection = nullptr;
@@ -481,43 +502,62 @@ int DatabasePostgres::registerEntityIdGenerator()
         debug(reportError(););
         debug_print("Sequence does not yet exist"
                        )
+        if (runCommandQuery("CREATE SEQUENCE entity_ent_id_seq") != 0) {
+            return -1;
+        }
     } else {
         debug_print("Sequence exists")
-        return 0;
     }
-    return runCommandQuery("CREATE SEQUENCE entity_ent_id_seq");
+    //Each call to nextval() reserves a whole block of ids. The sequence is durable, so it also serves as the high water mark.
+    if (runCommandQuery(compose("ALTER SEQUENCE entity_ent_id_seq INCREMENT BY %1", IdBlockAllocator::DEFAULT_BLOCK_SIZE)) != 0) {
+        return -1;
+    }
+    //Blocks are reserved on a background thread, using a separate connection, so that the main connection is never blocked.
+    m_idAllocator = std::make_unique<IdBlockAllocator>([this](long count) { return reserveIdBlock(count); },
+                                                       IdBlockAllocator::DEFAULT_BLOCK_SIZE, true);
+    return 0;
 }
 
 long DatabasePostgres::newId(std::string& id)
 {
-    assert(m_connection != nullptr);
-
-    clearPendingQuery();
-    int status = PQsendQuery(m_connection,
-                             "SELECT nextval('entity_ent_id_seq')");
-    if (!status) {
-        log(ERROR, "newId(): Database query error.");
-        reportError();
+    if (!m_idAllocator) {
+        log(ERROR, "newId(): The id generator hasn't been registered.");
         return -1;
     }
-    PGresult* res;
-    if ((res = PQgetResult(m_connection)) == nullptr) {
-        log(ERROR, "Error getting new ID.");
-        reportError();
+    long new_id = m_idAllocator->next();
+    if (new_id < 0) {
         return -1;
     }
-    const char* cid = PQgetvalue(res, 0, 0);
-    id = cid;
-    PQclear(res);
-    while ((res = PQgetResult(m_connection)) != nullptr) {
-        PQclear(res);
-        log(ERROR, "Extra database result to simple query.");
-    };
-    if (id.empty()) {
-        log(ERROR, "Unknown error getting ID from database.");
-        return -1;
+    id = std::to_string(new_id);
+    return new_id;
+}
+
+IdBlockAllocator::Block DatabasePostgres::reserveIdBlock(long count)
+{
+    IdBlockAllocator::Block block{-1, -1};
+
+    if (m_idConnection == nullptr) {
+        m_idConnection = PQconnectdb(m_connectionInfo.c_str());
     }
-    return forceIntegerId(id);
+    if (PQstatus(m_idConnection) != CONNECTION_OK) {
+        log(ERROR, compose("Could not connect to database to reserve ids: %1", PQerrorMessage(m_idConnection)));
+        PQfinish(m_idConnection);
+        m_idConnection = nullptr;
+        return block;
+    }
+
+    PGresult* res = PQexec(m_idConnection, "SELECT nextval('entity_ent_id_seq')");
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+        //The sequence is incremented by the block size, so the returned value is the last id of the block.
+        //A sequence which has never been used returns its start value though, in which case we only get the ids up to that.
+        long last = std::strtol(PQgetvalue(res, 0, 0), nullptr, 10);
+        block.first = std::max(last - count + 1, 1L);
+        block.end = last + 1;
+    } else {
+        log(ERROR, compose("Could not reserve ids: %1", PQerrorMessage(m_idConnection)));
+    }
+    PQclear(res);
+    return block;
 }
 
 int DatabasePostgres::registerEntityTable(const std::map<std::string, int>& chunks)
@@ -647,20 +687,18 @@ void DatabasePostgres::queryResult(ExecStatusType status)
         log(ERROR, "Got database result when no query was pending.");
         return;
     }
-    DatabaseQuery& q = pendingQueries.front();
-    if (q.second == PGRES_EMPTY_QUERY) {
+    if (m_resultCount >= m_inProgressCount) {
         log(ERROR, "Got database result which is already done.");
         return;
     }
-    if (q.second == status) {
+    DatabaseQuery& q = pendingQueries[m_resultCount++];
+    if (q.status == status) {
         debug_print("Query status ok")
-        // Mark this query as done
-        q.second = PGRES_EMPTY_QUERY;
     } else {
         log(ERROR, "Database error from async query");
-        std::cerr << "Query error in : " << q.first << std::endl << std::flush;
+        std::cerr << "Query error in : " << q.query << std::endl << std::flush;
         reportError();
-        q.second = PGRES_EMPTY_QUERY;
+        m_inProgressFailed = true;
     }
 }
 
@@ -670,13 +708,30 @@ void DatabasePostgres::queryComplete()
         log(ERROR, "Got database query complete when no query was pending");
         return;
     }
-    DatabaseQuery& q = pendingQueries.front();
-    if (q.second != PGRES_EMPTY_QUERY) {
+    if (m_resultCount == 0) {
         log(ERROR, "Got database query complete when query was not done");
         return;
     }
     debug_print("Query complete")
-    pendingQueries.pop_front();
+    finishQuery();
+}
+
+void DatabasePostgres::finishQuery()
+{
+    if (m_inProgressFailed && m_inProgressCount > 1) {
+        //All commands in a batch are run in one transaction, so if one fails none are applied.
+        //Send them again one at a time, so that only the failing ones are lost.
+        log(WARNING, compose("Batch of %1 database commands failed; sending them again one at a time.", m_inProgressCount));
+        m_unbatchedCount = m_inProgressCount;
+    } else {
+        pendingQueries.erase(pendingQueries.begin(), pendingQueries.begin() + m_inProgressCount);
+        if (m_unbatchedCount > 0) {
+            --m_unbatchedCount;
+        }
+    }
+    m_inProgressCount = 0;
+    m_resultCount = 0;
+    m_inProgressFailed = false;
     m_queryInProgress = false;
 }
 
@@ -696,24 +751,55 @@ int DatabasePostgres::launchNewQuery()
     }
     debug(std::cout << pendingQueries.size() << " queries pending"
                     << std::endl << std::flush;);
-    DatabaseQuery& q = pendingQueries.front();
-    debug(std::cout << "Launching async query: " << q.first
+
+    //When batching, multiple commands are sent as one query string. Postgres runs them all in one transaction,
+    //and sends one result for each of them.
+    size_t count = 1;
+    if (m_batchSize > 1 && m_unbatchedCount == 0 && !pendingQueries.front().maintenance) {
+        while (count < pendingQueries.size()
+               && count < m_batchSize
+               && !pendingQueries[count].maintenance) {
+            ++count;
+        }
+    }
+    std::string batchQuery;
+    const std::string* query = &pendingQueries.front().query;
+    if (count > 1) {
+        for (size_t i = 0; i < count; ++i) {
+            batchQuery += pendingQueries[i].query;
+            batchQuery += ";\n";
+        }
+        query = &batchQuery;
+    }
+
+    debug(std::cout << "Launching async query: " << *query
                     << std::endl << std::flush;);
-    int status = PQsendQuery(m_connection, q.first.c_str());
+    int status = PQsendQuery(m_connection, query->c_str());
     if (!status) {
         log(ERROR, "Database query error when launching.");
         reportError();
         return -1;
     } else {
         m_queryInProgress = true;
-        PQflush(m_connection);
+        m_inProgressCount = count;
+        m_resultCount = 0;
+        m_inProgressFailed = false;
+        //In non-blocking mode not all of the query might be sent at once; the rest needs to be sent when the socket is writable.
+        if (PQflush(m_connection) == 1) {
+            FlushNeeded();
+        }
         return 0;
     }
 }
 
 int DatabasePostgres::scheduleCommand(const std::string& query)
 {
-    pendingQueries.push_back(std::make_pair(query, PGRES_COMMAND_OK));
+    return scheduleQuery(query, false);
+}
+
+int DatabasePostgres::scheduleQuery(const std::string& query, bool maintenance)
+{
+    pendingQueries.push_back(DatabaseQuery{query, PGRES_COMMAND_OK, maintenance});
     if (!m_queryInProgress) {
         debug(std::cout << "Query: " << query << " launched"
                         << std::endl << std::flush;);
@@ -734,15 +820,15 @@ int DatabasePostgres::clearPendingQuery()
     assert(!pendingQueries.empty());
     debug_print("Clearing a pending query")
 
-    DatabaseQuery& q = pendingQueries.front();
-    if (q.second == PGRES_COMMAND_OK) {
-        m_queryInProgress = false;
-        pendingQueries.pop_front();
-        return commandOk();
-    } else {
-        log(ERROR, "Pending query wants unknown status");
-        return -1;
+    //Wait for all remaining results of the query in progress.
+    PGresult* res;
+    while ((res = PQgetResult(m_connection)) != nullptr) {
+        queryResult(PQresultStatus(res));
+        PQclear(res);
     }
+    bool failed = m_inProgressFailed;
+    finishQuery();
+    return failed ? -1 : 0;
 }
 
 int DatabasePostgres::runMaintainance(unsigned int command)
@@ -752,7 +838,7 @@ int DatabasePostgres::runMaintainance(unsigned int command)
         std::string query("REINDEX TABLE ");
         auto Iend = allTables.end();
         for (auto I = allTables.begin(); I != Iend; ++I) {
-            scheduleCommand(query + *I);
+            scheduleQuery(query + *I, true);
         }
     }
     if ((command & MAINTAIN_VACUUM) == MAINTAIN_VACUUM) {
@@ -765,7 +851,7 @@ int DatabasePostgres::runMaintainance(unsigned int command)
         }
         auto Iend = allTables.end();
         for (auto I = allTables.begin(); I != Iend; ++I) {
-            scheduleCommand(query + *I);
+            scheduleQuery(query + *I, true);
         }
     }
     return 0;
@@ -22,10 +22,22 @@
 #define COMMON_DATABASEPOSTGRES_H
 
 #include "Database.h"
+#include "IdBlockAllocator.h"
 
 #include <libpq-fe.h>
+#include <sigc++/signal.h>
 
-typedef std::pair<std::string, ExecStatusType> DatabaseQuery;
+#include <deque>
+
+/// \brief A command waiting to be sent to the database.
+struct DatabaseQuery
+{
+    std::string query;
+    /// The result status expected for the command.
+    ExecStatusType status;
+    /// True if the command can't be run inside a transaction, such as VACUUM.
+    bool maintenance;
+};
 typedef std::deque<DatabaseQuery> QueryQue;
 
 class DatabasePostgres : public Database
@@ -36,6 +48,33 @@ class DatabasePostgres : public Database
         PGconn* m_connection;
         TableSet allTables;
 
+        /// \brief Max number of commands to send in one query string, to be run in one transaction.
+        ///
+        /// If this is zero or one each command is sent on its own.
+        size_t m_batchSize;
+        /// \brief Number of commands at the front of the queue which were sent in the query in progress.
+        size_t m_inProgressCount;
+        /// \brief Number of results received so far for the query in progress.
+        size_t m_resultCount;
+        /// \brief True if any command in the query in progress failed.
+        bool m_inProgressFailed;
+        /// \brief Number of commands at the front of the queue which must be sent one at a time, since the batch they were sent in failed.
+        size_t m_unbatchedCount;
+
+        /// \brief Removes the commands of the query in progress from the queue, or prepares them to be sent again if their batch failed.
+        void finishQuery();
+
+        int scheduleQuery(const std::string& query, bool maintenance);
+
+        /// The connection parameters, kept so that more connections can be opened.
+        std::string m_connectionInfo;
+        /// A separate connection, only used for reserving blocks of ids on a background thread.
+        PGconn* m_idConnection;
+        std::unique_ptr<IdBlockAllocator> m_idAllocator;
+
+        /// Reserves a block of ids from the sequence. Called from a background thread.
+        IdBlockAllocator::Block reserveIdBlock(long count);
+
 
         bool tuplesOk();
 
@@ -47,6 +86,9 @@ class DatabasePostgres : public Database
         static const unsigned int MAINTAIN_VACUUM_ANALYZE = 0x0002;
         static const unsigned int MAINTAIN_REINDEX = 0x0200;
 
+        /// \brief Emitted when a query couldn't be sent in full without blocking, and the rest needs to be flushed once the connection is writable.
+        sigc::signal<void> FlushNeeded;
+
         DatabasePostgres();
 
         ~DatabasePostgres() override;
@@ -97,7 +139,7 @@ class DatabasePostgres : public Database
 
 
         /// Creates a new unique id for the database.
-        /// Note that this method will access the database, so it's a fairly expensive method.
+        /// Ids are handed out from blocks reserved in advance, so this normally doesn't need to wait for the database.
         long newId(std::string& id) override;
 
         int registerEntityIdGenerator() override;
@@ -177,6 +219,15 @@ struct DatabaseResultWorkerPostgres : public DatabaseResult::DatabaseResultWorke
             return PQgetvalue(m_dr.m_res.get(), m_row, col_num);
         }
 
+        std::string data(const char* column) const override
+        {
+            int col_num = PQfnumber(m_dr.m_res.get(), column);
+            if (col_num == -1) {
+                return "";
+            }
+            return std::string(PQgetvalue(m_dr.m_res.get(), m_row, col_num), PQgetlength(m_dr.m_res.get(), m_row, col_num));
+        }
+
         const_iterator_worker& operator++() override
         {
             if (m_row != -1) {
@@ -28,13 +28,17 @@
 #include "globals.h"
 #include "compose.hpp"
 #include "const.h"
-
-#include <Atlas/Codecs/Packed.h>
+#include "Monitors.h"
+#include "Variable.h"
+#include "IdBlockAllocator.h"
+#include "BinaryElementCodec.h"
 
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <chrono>
+
 using Atlas::Message::Element;
 using Atlas::Message::MapType;
 using Atlas::Objects::Root;
@@ -42,16 +46,80 @@ using String::compose;
 
 using namespace sqlite3pp;
 
-typedef Atlas::Codecs::Packed Serialiser;
-
 static const bool debug_flag = false;
 
+namespace {
+    INT_OPTION(sqlite_batch_size, 0, CYPHESIS, "sqlite_batch_size",
+               "Max number of writes to commit in one SQLite transaction. "
+               "Set to 0 to run each write in its own transaction.")
+
+    BOOL_OPTION(sqlite_wal, false, CYPHESIS, "sqlite_wal",
+                "Use write-ahead logging for the SQLite database.")
+
+    STRING_OPTION(sqlite_synchronous, "", CYPHESIS, "sqlite_synchronous",
+                  "The SQLite synchronous level, one of OFF, NORMAL, FULL or EXTRA. Leave empty to use the SQLite default.")
+
+    /**
+     * The SQL for each of the DatabaseSQLite::StatementType values, in order.
+     */
+    const char* const preparedStatementsSql[] = {
+        nullptr,
+        nullptr,
+        "INSERT INTO entities VALUES (?, ?, ?, ?, ?)",
+        "UPDATE entities SET seq = ?, location = ?, loc = ? WHERE id = ?",
+        "UPDATE entities SET seq = ?, location = ? WHERE id = ?",
+        "DELETE FROM entities WHERE id = ?",
+        "INSERT INTO properties VALUES (?, ?, ?)",
+        "UPDATE properties SET value = ? WHERE id = ? AND name = ?",
+        "DELETE FROM properties WHERE id = ?",
+        "DELETE FROM thoughts WHERE id = ?"
+    };
+
+    /**
+     * The number of times a COMMIT of a batch is retried while the database is busy.
+     */
+    const int commitRetries = 5;
+
+    static_assert(sizeof(preparedStatementsSql) / sizeof(preparedStatementsSql[0]) == static_cast<size_t>(DatabaseSQLite::StatementType::Count),
+                  "There must be SQL for each prepared statement type.");
+
+    /**
+     * For each of the DatabaseSQLite::StatementType values, in order, the index of the parameter holding encoded
+     * entity or property data, or -1 if there is none. That parameter is bound as a blob, all others as text.
+     */
+    const int preparedStatementsBlobParam[] = {
+        -1,
+        -1,
+        4,
+        1,
+        1,
+        -1,
+        2,
+        0,
+        -1,
+        -1
+    };
+
+    static_assert(sizeof(preparedStatementsBlobParam) / sizeof(preparedStatementsBlobParam[0]) == static_cast<size_t>(DatabaseSQLite::StatementType::Count),
+                  "There must be a blob parameter index for each prepared statement type.");
+}
+
 
 DatabaseSQLite::DatabaseSQLite() :
     Database(),
+    m_batchSize(std::max(0, sqlite_batch_size)),
+    m_lastBatchSize(0),
+    m_lastCommitLatency(0),
+    m_batchCount(0),
+    m_idHighWaterMark(0),
     m_active(true),
     m_workerThread([&]() { this->poll_tasks(); })
 {
+    if (isBatching() && Monitors::hasInstance()) {
+        Monitors::instance().watch("storage_sqlite_batch_size", new Variable<std::atomic<int>>(m_lastBatchSize));
+        Monitors::instance().watch("storage_sqlite_commit_latency_us", new Variable<std::atomic<int>>(m_lastCommitLatency));
+        Monitors::instance().watch("storage_sqlite_batches", new Variable<std::atomic<int>>(m_batchCount));
+    }
 }
 
 DatabaseSQLite::~DatabaseSQLite()
@@ -72,14 +140,32 @@ void DatabaseSQLite::poll_tasks()
 #ifndef _WIN32
     pthread_setname_np(pthread_self(), "SQLite task processor");
 #endif
+    std::vector<PendingCommand> batch;
     while (true) {
         std::unique_lock<std::mutex> lock(m_pendingQueriesMutex);
         if (!pendingQueries.empty()) {
-            auto command = std::move(pendingQueries.front());
-            lock.unlock();
-            runCommandQuery(command);
-            lock.lock();
-            pendingQueries.pop_front();
+            if (isBatching() && pendingQueries.front().type != StatementType::Maintenance) {
+                //Leave the commands in the queue until they've been committed, so that queryQueueSize() includes them.
+                //Maintenance commands can't be run inside a transaction, so any batch ends before one.
+                size_t count = 0;
+                while (count < pendingQueries.size()
+                       && count < static_cast<size_t>(m_batchSize)
+                       && pendingQueries[count].type != StatementType::Maintenance) {
+                    batch.emplace_back(std::move(pendingQueries[count]));
+                    ++count;
+                }
+                lock.unlock();
+                runBatch(batch);
+                batch.clear();
+                lock.lock();
+                pendingQueries.erase(pendingQueries.begin(), pendingQueries.begin() + count);
+            } else {
+                auto command = std::move(pendingQueries.front());
+                lock.unlock();
+                runCommand(command);
+                lock.lock();
+                pendingQueries.pop_front();
+            }
         } else {
             if (m_active) {
                 m_workerCondition.wait(lock);
@@ -90,6 +176,99 @@ void DatabaseSQLite::poll_tasks()
     }
 }
 
+void DatabaseSQLite::runBatch(std::vector<PendingCommand>& batch)
+{
+    assert(m_database);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // A command failing with for example a constraint error is logged and skipped. SQLite then only undoes that
+    // statement, and the rest of the transaction goes ahead.
+    bool inTransaction = m_database->execute("BEGIN") == SQLITE_OK;
+    if (!inTransaction) {
+        log(ERROR, String::compose("Could not begin transaction: %1", m_database->error_msg()));
+    }
+    for (auto& command : batch) {
+        runCommand(command);
+    }
+    if (inTransaction) {
+        int result = m_database->execute("COMMIT");
+        // If the database is busy the transaction is left open, and the COMMIT can be retried.
+        for (int attempt = 1; (result & 0xff) == SQLITE_BUSY && attempt <= commitRetries; ++attempt) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10 * attempt));
+            result = m_database->execute("COMMIT");
+        }
+        if (result != SQLITE_OK) {
+            log(ERROR, String::compose("Could not commit batch of %1 queries: %2", batch.size(), m_database->error_msg()));
+            // Some errors make SQLite roll back the transaction by itself, in which case the following commands
+            // already have been run on their own. Otherwise nothing in the batch has been written, so run the
+            // commands again one at a time, in the same way as when not batching.
+            if (m_database->execute("ROLLBACK") == SQLITE_OK) {
+                log(NOTICE, String::compose("Running the %1 queries of the failed batch one at a time.", batch.size()));
+                for (auto& command : batch) {
+                    runCommand(command);
+                }
+            }
+        }
+    }
+
+    m_lastCommitLatency = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    m_lastBatchSize = static_cast<int>(batch.size());
+    ++m_batchCount;
+}
+
+int DatabaseSQLite::runCommand(const PendingCommand& pendingCommand)
+{
+    if (pendingCommand.type == StatementType::Raw || pendingCommand.type == StatementType::Maintenance) {
+        return runCommandQuery(pendingCommand.sql);
+    }
+    return runPreparedCommand(pendingCommand);
+}
+
+sqlite3pp::command& DatabaseSQLite::getPreparedStatement(StatementType type)
+{
+    auto& statement = m_preparedStatements[static_cast<size_t>(type)];
+    if (!statement) {
+        statement = std::make_unique<command>(*m_database, preparedStatementsSql[static_cast<size_t>(type)]);
+    }
+    return *statement;
+}
+
+int DatabaseSQLite::runPreparedCommand(const PendingCommand& pendingCommand)
+{
+    assert(m_database);
+
+    try {
+        auto& cmd = getPreparedStatement(pendingCommand.type);
+        cmd.reset();
+        auto blobParam = preparedStatementsBlobParam[static_cast<size_t>(pendingCommand.type)];
+        int index = 1;
+        for (auto& param : pendingCommand.params) {
+            //Encoded entity data is stored as blobs, everything else as text.
+            int result;
+            if (index - 1 == blobParam) {
+                result = cmd.bind(index, param.data(), static_cast<int>(param.size()), sqlite3pp::copy);
+            } else {
+                result = cmd.bind(index, param, sqlite3pp::copy);
+            }
+            if (result != SQLITE_OK) {
+                throw database_error(*m_database);
+            }
+            ++index;
+        }
+        if (cmd.execute() != SQLITE_OK) {
+            log(ERROR, String::compose("runPreparedCommand('%1'): Database query error.", preparedStatementsSql[static_cast<size_t>(pendingCommand.type)]));
+            reportError(m_database->error_msg());
+            return -1;
+        }
+    } catch (const database_error& e) {
+        log(ERROR, String::compose("runPreparedCommand('%1'): Database query error.", preparedStatementsSql[static_cast<size_t>(pendingCommand.type)]));
+        reportError(e.what());
+        return -1;
+    }
+    return 0;
+}
+
 int DatabaseSQLite::connect(const std::string& context, std::string& error_msg)
 {
     return 0;
@@ -107,30 +286,38 @@ int DatabaseSQLite::initConnection()
         return -1;
     }
 
+    if (sqlite_wal) {
+        if (m_database->execute("PRAGMA journal_mode=WAL") != SQLITE_OK) {
+            log(WARNING, compose("Could not enable write-ahead logging for SQLite database: %1", m_database->error_msg()));
+        }
+    }
+
+    if (!sqlite_synchronous.empty()) {
+        auto level = boost::algorithm::to_upper_copy(sqlite_synchronous);
+        if (level == "OFF" || level == "NORMAL" || level == "FULL" || level == "EXTRA") {
+            m_database->execute(compose("PRAGMA synchronous=%1", level).c_str());
+        } else {
+            log(WARNING, compose("Unrecognized SQLite synchronous level '%1'.", sqlite_synchronous));
+        }
+    }
+
     return 0;
 }
 
 void DatabaseSQLite::shutdownConnection()
 {
+    //Prepared statements must be finalized before the database can be closed.
+    for (auto& statement : m_preparedStatements) {
+        statement.reset();
+    }
     m_database.reset(nullptr);
 }
 
 int DatabaseSQLite::encodeObject(const MapType& o,
                                  std::string& data)
 {
-    std::stringstream str;
-
-    Serialiser codec(str, str, m_d);
-    Atlas::Message::Encoder enc(codec);
-
-    codec.streamBegin();
-    enc.streamMessageElement(o);
-    codec.streamEnd();
-
-    data = str.str();
-
-    //Escape ' characters by doubling them.
-    boost::algorithm::replace_all(data, "'", "''");
+    //Entity and property data is always bound to prepared statements as blobs, so it can use the binary encoding.
+    BinaryElementCodec::encode(o, data);
 
     return 0;
 }
@@ -278,22 +465,33 @@ int DatabaseSQLite::registerSimpleTable(const std::string& name,
     return ret;
 }
 
-static long idGenerator = 0;
-
 int DatabaseSQLite::registerEntityIdGenerator()
 {
     assert(m_database);
 
-    query qryEntities(*m_database, "SELECT MAX(id) FROM entities;");
-    auto entitiesI = qryEntities.begin();
-    if (entitiesI != qryEntities.end()) {
-        idGenerator = std::max(idGenerator, static_cast<long>((*entitiesI).get<int>(0)));
+    //The highest reserved id is stored, so that ids handed out to entities which haven't been stored aren't reused after a restart.
+    if (runCommandQuery("CREATE TABLE IF NOT EXISTS entity_ids (id integer UNIQUE PRIMARY KEY, high integer)") != 0) {
+        return -1;
     }
-    query qryAccounts(*m_database, "SELECT MAX(id) FROM accounts;");
-    auto accountsI = qryAccounts.begin();
-    if (accountsI != qryAccounts.end()) {
-        idGenerator = std::max(idGenerator, static_cast<long>((*accountsI).get<int>(0)));
+
+    long highWaterMark = 0;
+    for (auto sql : {"SELECT MAX(high) FROM entity_ids;", "SELECT MAX(id) FROM entities;", "SELECT MAX(id) FROM accounts;"}) {
+        query qry(*m_database, sql);
+        auto I = qry.begin();
+        if (I != qry.end()) {
+            highWaterMark = std::max(highWaterMark, static_cast<long>((*I).get<long long int>(0)));
+        }
     }
+    m_idHighWaterMark = highWaterMark;
+
+    //Reserving a block is cheap, since the new high water mark is written through the same queue as all other writes.
+    //That also means that it's always committed before any entity using an id from the block.
+    m_idAllocator = std::make_unique<IdBlockAllocator>([this](long count) {
+        IdBlockAllocator::Block block{m_idHighWaterMark + 1, m_idHighWaterMark + 1 + count};
+        m_idHighWaterMark += count;
+        scheduleCommand(compose("INSERT OR REPLACE INTO entity_ids VALUES (0, %1)", m_idHighWaterMark));
+        return block;
+    }, IdBlockAllocator::DEFAULT_BLOCK_SIZE, false);
 
     return 0;
 }
@@ -301,14 +499,16 @@ int DatabaseSQLite::registerEntityIdGenerator()
 
 long DatabaseSQLite::newId(std::string& id)
 {
-
-    static char buf[32];
-    long new_id = ++idGenerator;
-    sprintf(buf, "%ld", new_id);
-    id = buf;
-    assert(!id.empty());
+    if (!m_idAllocator) {
+        log(ERROR, "newId(): The id generator hasn't been registered.");
+        return -1;
+    }
+    long new_id = m_idAllocator->next();
+    if (new_id < 0) {
+        return -1;
+    }
+    id = std::to_string(new_id);
     return new_id;
-
 }
 
 int DatabaseSQLite::registerEntityTable(const std::map<std::string, int>& chunks)
@@ -374,19 +574,75 @@ int DatabaseSQLite::registerThoughtsTable()
 // General functions for handling queries at the low level.
 
 int DatabaseSQLite::scheduleCommand(const std::string& query)
+{
+    return enqueueCommand({StatementType::Raw, query, {}});
+}
+
+
+int DatabaseSQLite::enqueueCommand(PendingCommand pendingCommand)
 {
     {
         std::unique_lock<std::mutex> lock(m_pendingQueriesMutex);
-        pendingQueries.push_back(query);
+        pendingQueries.emplace_back(std::move(pendingCommand));
     }
     m_workerCondition.notify_all();
     return 0;
 }
 
+int DatabaseSQLite::insertEntity(const std::string& id,
+                                 const std::string& loc,
+                                 const std::string& type,
+                                 int seq,
+                                 const std::string& value)
+{
+    return enqueueCommand({StatementType::InsertEntity, "", {id, loc, type, std::to_string(seq), value}});
+}
+
+int DatabaseSQLite::updateEntityWithoutLoc(const std::string& id,
+                                           int seq,
+                                           const std::string& location_data)
+{
+    return enqueueCommand({StatementType::UpdateEntityWithoutLoc, "", {std::to_string(seq), location_data, id}});
+}
+
+int DatabaseSQLite::updateEntity(const std::string& id,
+                                 int seq,
+                                 const std::string& location_data,
+                                 const std::string& location_entity_id)
+{
+    return enqueueCommand({StatementType::UpdateEntity, "", {std::to_string(seq), location_data, location_entity_id, id}});
+}
+
+int DatabaseSQLite::dropEntity(long id)
+{
+    auto idString = std::to_string(id);
+    enqueueCommand({StatementType::DeleteProperties, "", {idString}});
+    enqueueCommand({StatementType::DeleteEntity, "", {idString}});
+    enqueueCommand({StatementType::DeleteThoughts, "", {idString}});
+    return 0;
+}
+
+int DatabaseSQLite::insertProperties(const std::string& id,
+                                     const KeyValues& tuples)
+{
+    for (auto& tuple : tuples) {
+        enqueueCommand({StatementType::InsertProperty, "", {id, tuple.first, tuple.second}});
+    }
+    return 0;
+}
+
+int DatabaseSQLite::updateProperties(const std::string& id,
+                                     const KeyValues& tuples)
+{
+    for (auto& tuple : tuples) {
+        enqueueCommand({StatementType::UpdateProperty, "", {tuple.second, id, tuple.first}});
+    }
+    return 0;
+}
 
 int DatabaseSQLite::runMaintainance()
 {
-    scheduleCommand("VACUUM");
+    enqueueCommand({StatementType::Maintenance, "VACUUM", {}});
 
     return 0;
 }
@@ -407,6 +663,22 @@ const char* DatabaseResultWorkerSqlite::const_iterator_worker_sqlite::column(con
     return nullptr;
 }
 
+std::string DatabaseResultWorkerSqlite::const_iterator_worker_sqlite::data(const char* column) const
+{
+    for (int i = 0; i < m_dr.m_res->column_count(); ++i) {
+        if (std::strcmp(m_dr.m_res->column_name(i), column) == 0) {
+            auto row = *m_iterator;
+            //The size must be read after the data, since getting the data might convert it.
+            auto blob = static_cast<const char*>(row.get<const void*>(i));
+            if (blob == nullptr) {
+                return "";
+            }
+            return std::string(blob, static_cast<size_t>(row.column_bytes(i)));
+        }
+    }
+    return "";
+}
+
 DatabaseResult::const_iterator_worker& DatabaseResultWorkerSqlite::const_iterator_worker_sqlite::operator++()
 {
     m_iterator.operator++();
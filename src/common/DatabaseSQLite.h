@@ -23,9 +23,14 @@
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <array>
+#include <deque>
+#include <vector>
 #include "Database.h"
 
 
+class IdBlockAllocator;
+
 namespace sqlite3pp {
     class database;
 
@@ -34,11 +39,61 @@ namespace sqlite3pp {
 
 class DatabaseSQLite : public Database
 {
+    public:
+        /// \brief The shapes of the write queries which are run through cached prepared statements.
+        enum class StatementType
+        {
+            /// Plain SQL, not using any prepared statement.
+            Raw,
+            /// Plain SQL which can't be run inside a transaction, such as VACUUM.
+            Maintenance,
+            InsertEntity,
+            UpdateEntity,
+            UpdateEntityWithoutLoc,
+            DeleteEntity,
+            InsertProperty,
+            UpdateProperty,
+            DeleteProperties,
+            DeleteThoughts,
+            Count
+        };
+
+        /// \brief A write command waiting to be processed by the worker thread.
+        struct PendingCommand
+        {
+            StatementType type;
+            /// The SQL to run if the type is Raw.
+            std::string sql;
+            /// The values to bind to the prepared statement, in order.
+            ///
+            /// Which of them is encoded data, to be bound as a blob, is given by the type.
+            std::vector<std::string> params;
+        };
+
     protected:
 
-        std::deque<std::string> pendingQueries;
+        std::deque<PendingCommand> pendingQueries;
         std::unique_ptr<sqlite3pp::database> m_database;
 
+        /// \brief Max number of commands to run in one transaction.
+        ///
+        /// If this is zero each command is run on its own, in its own implicit transaction.
+        int m_batchSize;
+
+        /// \brief Prepared statements, indexed by StatementType. Only accessed from the worker thread.
+        std::array<std::unique_ptr<sqlite3pp::command>, static_cast<size_t>(StatementType::Count)> m_preparedStatements;
+
+        /// \brief Number of commands in the last committed batch.
+        std::atomic<int> m_lastBatchSize;
+        /// \brief Time in microseconds it took to run and commit the last batch.
+        std::atomic<int> m_lastCommitLatency;
+        /// \brief Total number of committed batches.
+        std::atomic<int> m_batchCount;
+
+        /// \brief The highest id reserved so far.
+        long m_idHighWaterMark;
+        std::unique_ptr<IdBlockAllocator> m_idAllocator;
+
         std::atomic<bool> m_active;
         std::condition_variable m_workerCondition;
         std::mutex m_pendingQueriesMutex;
@@ -46,6 +101,16 @@ class DatabaseSQLite : public Database
 
         void poll_tasks();
 
+        void runBatch(std::vector<PendingCommand>& batch);
+
+        int runCommand(const PendingCommand& pendingCommand);
+
+        int runPreparedCommand(const PendingCommand& pendingCommand);
+
+        sqlite3pp::command& getPreparedStatement(StatementType type);
+
+        int enqueueCommand(PendingCommand pendingCommand);
+
     public:
 
         DatabaseSQLite();
@@ -98,7 +163,7 @@ class DatabaseSQLite : public Database
 
 
         /// Creates a new unique id for the database.
-        /// Note that this method will access the database, so it's a fairly expensive method.
+        /// Ids are handed out from blocks reserved in advance, so this doesn't need to wait for the database.
         long newId(std::string& id) override;
 
         int registerEntityIdGenerator() override;
@@ -107,8 +172,37 @@ class DatabaseSQLite : public Database
         int registerSimpleTable(const std::string& name,
                                 const Atlas::Message::MapType& row) override;
 
+        int insertEntity(const std::string& id,
+                         const std::string& loc,
+                         const std::string& type,
+                         int seq,
+                         const std::string& value) override;
+
+        int updateEntityWithoutLoc(const std::string& id,
+                                   int seq,
+                                   const std::string& location_data) override;
+
+        int updateEntity(const std::string& id,
+                         int seq,
+                         const std::string& location_data,
+                         const std::string& location_entity_id) override;
+
+        int dropEntity(long id) override;
+
+        int insertProperties(const std::string& id,
+                             const KeyValues& tuples) override;
+
+        int updateProperties(const std::string& id,
+                             const KeyValues& tuples) override;
+
         int scheduleCommand(const std::string& query) override;
 
+        /// \brief True if writes are batched into transactions.
+        bool isBatching() const
+        {
+            return m_batchSize > 0;
+        }
+
         int runMaintainance();
 
         int launchNewQuery() override
@@ -153,6 +247,8 @@ struct DatabaseResultWorkerSqlite : public DatabaseResult::DatabaseResultWorker
 
         const char* column(const char* column) const override;
 
+        std::string data(const char* column) const override;
+
         const_iterator_worker& operator++() override;
 
         bool operator==(const const_iterator_worker& other) const override;
@@ -0,0 +1,66 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "IdBlockAllocator.h"
+
+#include "log.h"
+
+constexpr long IdBlockAllocator::DEFAULT_BLOCK_SIZE;
+
+IdBlockAllocator::IdBlockAllocator(ReserveFunction reserveFunction, long blockSize, bool asynchronous)
+    : m_reserveFunction(std::move(reserveFunction)),
+      m_blockSize(blockSize),
+      m_asynchronous(asynchronous),
+      m_next(0),
+      m_end(0)
+{
+}
+
+IdBlockAllocator::~IdBlockAllocator()
+{
+    if (m_pendingBlock.valid()) {
+        m_pendingBlock.wait();
+    }
+}
+
+long IdBlockAllocator::next()
+{
+    if (m_next >= m_end) {
+        Block block{-1, -1};
+        if (m_pendingBlock.valid()) {
+            block = m_pendingBlock.get();
+        }
+        if (block.first < 0) {
+            //Either there was no reservation in progress, or it failed; try again on this thread.
+            block = m_reserveFunction(m_blockSize);
+        }
+        if (block.first < 0 || block.end <= block.first) {
+            log(ERROR, "Could not reserve a new block of ids.");
+            return -1;
+        }
+        m_next = block.first;
+        m_end = block.end;
+    }
+
+    auto id = m_next++;
+
+    if (m_asynchronous && !m_pendingBlock.valid() && (m_end - m_next) <= m_blockSize / 4) {
+        m_pendingBlock = std::async(std::launch::async, m_reserveFunction, m_blockSize);
+    }
+    return id;
+}
@@ -0,0 +1,92 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_IDBLOCKALLOCATOR_H
+#define CYPHESIS_IDBLOCKALLOCATOR_H
+
+#include <functional>
+#include <future>
+
+/**
+ * @brief Hands out ids from blocks reserved from the database, so that the database only needs to be accessed once per block.
+ *
+ * Blocks are reserved through a supplied function, which must have durably recorded the block as used before it returns,
+ * so that no id is handed out twice, even after a crash. Any ids left in a block when the server is stopped are lost.
+ *
+ * If asynchronous, the next block is reserved on a background thread once a quarter of the current block remains,
+ * so that next() normally doesn't have to wait for the database. Only one reservation is ever in progress at a time.
+ */
+class IdBlockAllocator
+{
+    public:
+        static constexpr long DEFAULT_BLOCK_SIZE = 1024;
+
+        /**
+         * A range of reserved ids, from "first" up to but not including "end".
+         */
+        struct Block
+        {
+            /**
+             * The first id in the block, or -1 if no block could be reserved.
+             */
+            long first;
+            long end;
+        };
+
+        /**
+         * Reserves a block of ids. If asynchronous this is called from a background thread.
+         * The returned block may be smaller than asked for, but not larger.
+         */
+        typedef std::function<Block(long count)> ReserveFunction;
+
+        /**
+         * @param reserveFunction Reserves new blocks.
+         * @param blockSize The number of ids to reserve each time.
+         * @param asynchronous If true, blocks are reserved on a background thread before the current block runs out.
+         */
+        IdBlockAllocator(ReserveFunction reserveFunction, long blockSize, bool asynchronous);
+
+        /**
+         * Waits for any reservation in progress.
+         */
+        ~IdBlockAllocator();
+
+        /**
+         * @brief Hands out the next id.
+         *
+         * Only blocks if a new block needs to be reserved and there's no reservation in progress, or if it hasn't completed yet.
+         * @return A new id, or -1 if no block could be reserved.
+         */
+        long next();
+
+    private:
+        ReserveFunction m_reserveFunction;
+        const long m_blockSize;
+        const bool m_asynchronous;
+
+        long m_next;
+        long m_end;
+
+        /**
+         * The block being reserved on a background thread, if any.
+         */
+        std::future<Block> m_pendingBlock;
+};
+
+
+#endif //CYPHESIS_IDBLOCKALLOCATOR_H
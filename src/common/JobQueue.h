@@ -0,0 +1,72 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_JOBQUEUE_H
+#define CYPHESIS_JOBQUEUE_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads which run posted jobs in the background.
+ *
+ * Unlike WorkerPool the caller doesn't wait for the jobs to finish. Jobs are started in the order they are posted.
+ * It's up to the poster to make sure that a job only touches data which isn't used by other threads while it runs,
+ * and to pick up the results once it's done.
+ */
+class JobQueue
+{
+    public:
+        /**
+         * @param numberOfThreads The number of worker threads. Must be at least 1.
+         */
+        explicit JobQueue(size_t numberOfThreads);
+
+        /**
+         * Waits for the jobs that are running to finish. Jobs that haven't started yet are discarded.
+         */
+        ~JobQueue();
+
+        size_t getNumberOfThreads() const
+        {
+            return m_threads.size();
+        }
+
+        /**
+         * @brief Queues a job, to be run on one of the worker threads.
+         * @param job The job. It must not throw.
+         */
+        void post(std::function<void()> job);
+
+    private:
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_workCondition;
+        std::deque<std::function<void()>> m_jobs;
+        bool m_shutdown;
+
+        void workerLoop();
+};
+
+
+#endif //CYPHESIS_JOBQUEUE_H
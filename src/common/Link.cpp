@@ -32,7 +32,8 @@ static const bool debug_flag = false;
 Link::Link(CommSocket & socket, const std::string & id, long iid) :
             Router(id, iid),
             m_encoder(nullptr),
-            m_commSocket(socket)
+            m_commSocket(socket),
+            m_movementDeltas(false)
 {
 }
 
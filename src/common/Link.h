@@ -37,6 +37,10 @@ class Link : public Router {
   public:
     CommSocket & m_commSocket;
 
+    /// \brief True if the client has negotiated the "movement_delta"
+    /// capability, and wants movement updates in the compact form.
+    bool m_movementDeltas;
+
     Link(CommSocket & commSocket, const std::string & id, long iid);
 
     ~Link() override;
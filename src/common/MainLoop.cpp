@@ -19,6 +19,7 @@
 #include "MainLoop.h"
 
 #include "common/system.h"
+#include "common/CommSocket.h"
 #include "globals.h"
 #include "OperationsDispatcher.h"
 #include "compose.hpp"
@@ -27,6 +28,9 @@
 #include <boost/asio/steady_timer.hpp>
 
 namespace {
+    BOOL_OPTION(cork_sends, false, CYPHESIS, "cork_sends",
+                "Flag to control if data sent to clients should be written once per main loop iteration, instead of once per operation")
+
     void interactiveSignalsHandler(boost::asio::signal_set& this_, boost::system::error_code error, int signal_number)
     {
         if (!error) {
@@ -96,6 +100,8 @@ void MainLoop::run(bool daemon, boost::asio::io_context& io_context, OperationsH
 
     bool soft_exit_in_progress = false;
 
+    CommSocket::s_corked = cork_sends;
+
 
     //Make sure that the io_context never runs out of work.
     boost::asio::io_context::work work(io_context);
@@ -111,6 +117,8 @@ void MainLoop::run(bool daemon, boost::asio::io_context& io_context, OperationsH
             operationsHandler.markQueueAsClean();
             //Even if the world is busy we should interleave with a poll, to make sure we always do some IO.
             io_context.poll_one();
+            //Send everything written to clients by the ops and IO handled so far.
+            CommSocket::flushCorkedSockets();
             if (!busy) {
                 //If it's not busy however we should run until we get a task.
                 //We will either get an io task, or we will be triggered by the timer
@@ -127,6 +135,7 @@ void MainLoop::run(bool daemon, boost::asio::io_context& io_context, OperationsH
                 //any new operation) or the timer has expired.
                 do {
                     io_context.run_one();
+                    CommSocket::flushCorkedSockets();
                 } while (!operationsHandler.isQueueDirty() && !nextOpTimeExpired &&
                          !exit_flag_soft && !exit_flag && !soft_exit_in_progress);
                 nextOpTimer.cancel();
@@ -170,6 +179,9 @@ void MainLoop::run(bool daemon, boost::asio::io_context& io_context, OperationsH
     // by the game has been done before exit flag was set.
     log(NOTICE, "Performing clean shutdown...");
 
+    CommSocket::flushCorkedSockets();
+    CommSocket::s_corked = false;
+
 
     signalSet.cancel();
     signalSet.clear();
@@ -40,6 +40,12 @@ void Monitors::watch(const ::std::string& name, VariableBase* monitor)
     m_variableMonitors[name] = std::unique_ptr<VariableBase>(monitor);
 }
 
+void Monitors::remove(const std::string& key)
+{
+    m_pairs.erase(key);
+    m_variableMonitors.erase(key);
+}
+
 static std::ostream& operator<<(std::ostream& s, const Element& e)
 {
     switch (e.getType()) {
@@ -43,6 +43,7 @@ class Monitors : public Singleton<Monitors>{
 
     void insert(const std::string &, const Atlas::Message::Element &);
     void watch(const std::string &, VariableBase *);
+    void remove(const std::string &);
     void send(std::ostream &);
     void sendNumerics(std::ostream &);
     int readVariable(const std::string& key, std::ostream& out_stream) const;
@@ -20,6 +20,7 @@
 #define OPERATIONSDISPATCHER_H_
 
 #include "OperationRouter.h"
+#include "TimingWheelQueue.h"
 #include "const.h"
 
 #include <Atlas/Objects/RootOperation.h>
@@ -28,6 +29,7 @@
 #include <set>
 #include <queue>
 #include <functional>
+#include <unordered_map>
 #include "modules/Ref.h"
 
 #include <chrono>
@@ -140,9 +142,22 @@ struct OperationsHandler
     virtual void dispatchNextOp() = 0;
 };
 
-/// \brief Handles dispatching of operations at suitable time.
+/// \brief A queue of operations, kept as a binary heap.
+///
+/// This was the only queue used before the timing wheel was added, and is kept for comparison.
+template<typename T>
+using OpHeapQueue = std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>>;
+
+/// \brief A queue of operations, kept in a hierarchical timing wheel.
 ///
+/// This has constant time insertion and removal, and is the default queue.
 template<typename T>
+using OpTimingWheelQueue = TimingWheelQueue<OpQueEntry<T>>;
+
+/// \brief Handles dispatching of operations at suitable time.
+///
+/// \tparam QueueT The queue used for storing the operations; either OpTimingWheelQueue or OpHeapQueue.
+template<typename T, typename QueueT = OpTimingWheelQueue<T>>
 class OperationsDispatcher : public OperationsHandler
 {
     public:
@@ -212,12 +227,30 @@ class OperationsDispatcher : public OperationsHandler
          */
         std::chrono::milliseconds m_time_diff_report;
 
-        const std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>>& getQueue() const
+        /**
+         * If true, a Tick op supersedes any older Tick op still in the queue which is sent to the same entity,
+         * and which has a first arg with the same name and id (such as "domain" or "task" ticks).
+         * Superseded ops are dropped when they are reached in the queue, so that when the server falls behind
+         * each entity only gets one tick instead of a backlog of them.
+         * Any "lastTick" attribute of a superseded op is carried over to the op superseding it, so that the tick size
+         * calculated by the receiver covers the whole time since the last handled tick.
+         */
+        bool m_coalesce_ticks;
+
+        /**
+         * @return The number of Tick ops which have been dropped since they were superseded by newer ones.
+         */
+        long getCoalescedTickCount() const
+        {
+            return m_coalescedTickCount;
+        }
+
+        const QueueT& getQueue() const
         {
             return m_operationQueue;
         }
 
-        std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>>& getQueue()
+        QueueT& getQueue()
         {
             return m_operationQueue;
         }
@@ -231,13 +264,46 @@ class OperationsDispatcher : public OperationsHandler
         const TimeProviderFnType m_timeProviderFn;
 
         /// An ordered queue of operations to be dispatched in the future
-        std::priority_queue<OpQueEntry<T>, std::vector<OpQueEntry<T>>, std::greater<OpQueEntry<T>>> m_operationQueue;
+        QueueT m_operationQueue;
         /// Keeps track of if the operation queues are dirty.
         bool m_operation_queues_dirty;
 
         /// A sequence number, used when ops that have the same second set needs ordering.
         long m_sequence;
 
+        /// \brief Bookkeeping for the queued Ticks which share a coalescing key.
+        struct PendingTicks
+        {
+            /// The sequence number of the newest queued Tick.
+            long newestSequence;
+            /// The newest queued Tick.
+            Operation newest;
+            /// The number of Ticks with this key which are still in the queue.
+            size_t queuedCount;
+            /// Set once the newest Tick has been dispatched, while older ones might still be in the queue.
+            bool newestDispatched;
+        };
+
+        /// The queued Ticks for each coalescing key. Only used when m_coalesce_ticks is set.
+        std::unordered_map<std::string, PendingTicks> m_pendingTicks;
+
+        /// The number of Tick ops dropped since they were superseded.
+        long m_coalescedTickCount;
+
+        /**
+         * @brief Gets the key used for coalescing an op.
+         * @return The key, or an empty string if the op isn't a Tick which can be coalesced.
+         */
+        static std::string getCoalescingKey(const Operation& op);
+
+        /**
+         * @brief Checks if a popped entry has been superseded by a newer Tick, in which case it shouldn't be dispatched.
+         *
+         * Ticks can be dispatched out of the order they were queued in, so the bookkeeping for a key is kept until all of its Ticks have been popped.
+         * @return True if the entry should be dropped.
+         */
+        bool isSuperseded(const OpQueEntry<T>& opQueueEntry);
+
 
         /**
          * @brief Dispatches the operation contained in the OpQueueEntry.
@@ -25,6 +25,9 @@
 #include "debug.h"
 #include "Monitors.h"
 
+#include <Atlas/Objects/Operation.h>
+
+#include <algorithm>
 #include <iostream>
 #include <cstdint>
 #include <chrono>
@@ -32,15 +35,15 @@
 
 static const bool opdispatcher_debug_flag = false;
 
-template<typename T>
-OperationsDispatcher<T>::~OperationsDispatcher()
+template<typename T, typename QueueT>
+OperationsDispatcher<T, QueueT>::~OperationsDispatcher()
 {
     m_operationQueue = decltype(m_operationQueue)();
 }
 
 
-template<typename T>
-void OperationsDispatcher<T>::dispatchOperation(OpQueEntry<T>& oqe)
+template<typename T, typename QueueT>
+void OperationsDispatcher<T, QueueT>::dispatchOperation(OpQueEntry<T>& oqe)
 {
     //Set the time of when this op is dispatched. That way, other components in the system can
     //always use the seconds set on the op to know the current time.
@@ -62,23 +65,26 @@ void OperationsDispatcher<T>::dispatchOperation(OpQueEntry<T>& oqe)
     }
 }
 
-template<typename T>
-void OperationsDispatcher<T>::dispatchNextOp()
+template<typename T, typename QueueT>
+void OperationsDispatcher<T, QueueT>::dispatchNextOp()
 {
     if (!m_operationQueue.empty()) {
         auto opQueueEntry = std::move(m_operationQueue.top());
         //Pop it before we dispatch it, since dispatching might alter the queue.
         m_operationQueue.pop();
 
-        dispatchOperation(opQueueEntry);
+        if (!isSuperseded(opQueueEntry)) {
+            dispatchOperation(opQueueEntry);
+        }
     }
 }
 
 
-template<typename T>
-bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point& processUntil)
+template<typename T, typename QueueT>
+bool OperationsDispatcher<T, QueueT>::idle(const std::chrono::steady_clock::time_point& processUntil)
 {
     bool opsAvailableRightNow;
+    std::chrono::milliseconds maxLag(0);
     do {
         auto realtime = getTime();
         opsAvailableRightNow = !m_operationQueue.empty() && m_operationQueue.top().time_for_dispatch <= realtime;
@@ -88,9 +94,14 @@ bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point&
             //Pop it before we dispatch it, since dispatching might alter the queue.
             m_operationQueue.pop();
 
+            if (isSuperseded(opQueueEntry)) {
+                continue;
+            }
+
+            auto timeDiff = realtime - opQueueEntry.time_for_dispatch;
+            maxLag = std::max(maxLag, std::chrono::duration_cast<std::chrono::milliseconds>(timeDiff));
             if (m_time_diff_report.count() > 0) {
                 //Check if there's too large a difference in time
-                auto timeDiff = realtime - opQueueEntry.time_for_dispatch;
                 if (timeDiff > m_time_diff_report) {
                     log(WARNING, String::compose("Op (%1, from %2 to %3) was handled too late. Time diff: %4 seconds. Ops in queue: %5",
                                                  opQueueEntry->getParent(), opQueueEntry.from->describeEntity(),
@@ -107,30 +118,33 @@ bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point&
     // that we keep processing ops at a the maximum rate without leaving
     // clients unattended.
     Monitors::instance().insert("operations_queue", (Atlas::Message::IntType) m_operationQueue.size());
+    //Catch up statistics: how far behind the most delayed op handled in this pass was, and how many ticks have been coalesced in total.
+    Monitors::instance().insert("operations_lag_ms", (Atlas::Message::IntType) maxLag.count());
+    Monitors::instance().insert("operations_ticks_coalesced", (Atlas::Message::IntType) m_coalescedTickCount);
     return !m_operationQueue.empty() && m_operationQueue.top().time_for_dispatch <= std::chrono::duration_cast<std::chrono::milliseconds>(getTime());
 }
 
 
-template<typename T>
-bool OperationsDispatcher<T>::isQueueDirty() const
+template<typename T, typename QueueT>
+bool OperationsDispatcher<T, QueueT>::isQueueDirty() const
 {
     return m_operation_queues_dirty;
 }
 
-template<typename T>
-void OperationsDispatcher<T>::markQueueAsClean()
+template<typename T, typename QueueT>
+void OperationsDispatcher<T, QueueT>::markQueueAsClean()
 {
     m_operation_queues_dirty = false;
 }
 
-template<typename T>
-std::chrono::steady_clock::duration OperationsDispatcher<T>::getTime() const
+template<typename T, typename QueueT>
+std::chrono::steady_clock::duration OperationsDispatcher<T, QueueT>::getTime() const
 {
     return m_timeProviderFn();
 }
 
-template<typename T>
-std::chrono::steady_clock::duration OperationsDispatcher<T>::timeUntilNextOp() const
+template<typename T, typename QueueT>
+std::chrono::steady_clock::duration OperationsDispatcher<T, QueueT>::timeUntilNextOp() const
 {
     if (m_operationQueue.empty()) {
         //600 is a fairly large number of seconds
@@ -172,21 +186,68 @@ template<typename T>
 OpQueEntry<T>::~OpQueEntry() = default;
 
 
-template<typename T>
-OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor,
-                                              TimeProviderFnType timeProviderFn)
+template<typename T, typename QueueT>
+OperationsDispatcher<T, QueueT>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor,
+                                                      TimeProviderFnType timeProviderFn)
         :       m_time_diff_report(0),
+                m_coalesce_ticks(false),
                 m_operationProcessor(std::move(operationProcessor)),
                 m_timeProviderFn(std::move(timeProviderFn)),
                 m_operation_queues_dirty(false),
-                m_sequence(0)
+                m_sequence(0),
+                m_coalescedTickCount(0)
 {
 }
 
-template<typename T>
-void OperationsDispatcher<T>::clearQueues()
+template<typename T, typename QueueT>
+void OperationsDispatcher<T, QueueT>::clearQueues()
 {
     m_operationQueue = decltype(m_operationQueue)();
+    m_pendingTicks.clear();
+}
+
+template<typename T, typename QueueT>
+std::string OperationsDispatcher<T, QueueT>::getCoalescingKey(const Operation& op)
+{
+    if (op->getClassNo() != Atlas::Objects::Operation::TICK_NO || op->getArgs().empty()) {
+        return "";
+    }
+    auto& arg = op->getArgs().front();
+    if (arg->isDefaultName()) {
+        return "";
+    }
+    //The id of the arg is included since some ticks, like those for tasks, are told apart by it.
+    return op->getTo() + "/" + arg->getName() + "/" + (arg->isDefaultId() ? "" : arg->getId());
+}
+
+template<typename T, typename QueueT>
+bool OperationsDispatcher<T, QueueT>::isSuperseded(const OpQueEntry<T>& opQueueEntry)
+{
+    //Check the map rather than the flag, so that any ticks queued while coalescing was enabled are handled correctly if it's disabled.
+    if (m_pendingTicks.empty()) {
+        return false;
+    }
+    auto key = getCoalescingKey(opQueueEntry.op);
+    if (key.empty()) {
+        return false;
+    }
+    auto I = m_pendingTicks.find(key);
+    //Ticks newer than the newest known one were queued after coalescing was disabled, and aren't counted.
+    if (I == m_pendingTicks.end() || opQueueEntry.sequence > I->second.newestSequence) {
+        return false;
+    }
+    auto& pendingTicks = I->second;
+    bool superseded = pendingTicks.newestSequence != opQueueEntry.sequence;
+    if (superseded) {
+        m_coalescedTickCount++;
+    } else {
+        pendingTicks.newestDispatched = true;
+    }
+    //An older Tick might be due later than the newest one, so keep track of the key until all of its Ticks have been popped.
+    if (--pendingTicks.queuedCount == 0) {
+        m_pendingTicks.erase(I);
+    }
+    return superseded;
 }
 
 /// \brief Add an operation to the ordered op queue.
@@ -196,8 +257,8 @@ void OperationsDispatcher<T>::clearQueues()
 /// queue. The From attribute of the operation is set to the id of
 /// the entity that is responsible for adding the operation to the
 /// queue.
-template<typename T>
-void OperationsDispatcher<T>::addOperationToQueue(Operation op, Ref<T> ent)
+template<typename T, typename QueueT>
+void OperationsDispatcher<T, QueueT>::addOperationToQueue(Operation op, Ref<T> ent)
 {
     assert(op.isValid());
 
@@ -218,11 +279,37 @@ void OperationsDispatcher<T>::addOperationToQueue(Operation op, Ref<T> ent)
         debug_dump(op, std::cout);
         std::cout << "}" << std::endl << std::flush;
     }
-    m_operationQueue.emplace(std::move(op), std::move(ent), ++m_sequence);
+    ++m_sequence;
+    if (m_coalesce_ticks) {
+        auto key = getCoalescingKey(op);
+        if (!key.empty()) {
+            auto result = m_pendingTicks.emplace(key, PendingTicks{m_sequence, op, 1, false});
+            if (!result.second) {
+                auto& pendingTicks = result.first->second;
+                //Carry over the time of the last handled tick, so that the receiver can calculate the full tick size.
+                //If the newest tick already has been handled there's nothing to carry over.
+                if (!pendingTicks.newestDispatched) {
+                    auto& superseded = pendingTicks.newest;
+                    Atlas::Message::Element supersededLastTick;
+                    Atlas::Message::Element lastTick;
+                    if (superseded->copyAttr("lastTick", supersededLastTick) == 0 && supersededLastTick.isNum()) {
+                        if (op->copyAttr("lastTick", lastTick) != 0 || !lastTick.isNum() || supersededLastTick.asNum() < lastTick.asNum()) {
+                            op->setAttr("lastTick", supersededLastTick);
+                        }
+                    }
+                }
+                pendingTicks.newestSequence = m_sequence;
+                pendingTicks.newest = op;
+                pendingTicks.newestDispatched = false;
+                pendingTicks.queuedCount++;
+            }
+        }
+    }
+    m_operationQueue.emplace(std::move(op), std::move(ent), m_sequence);
 }
 
-template<typename T>
-size_t OperationsDispatcher<T>::getQueueSize() const
+template<typename T, typename QueueT>
+size_t OperationsDispatcher<T, QueueT>::getQueueSize() const
 {
     return m_operationQueue.size();
 }
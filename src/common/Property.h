@@ -119,6 +119,11 @@ class PropertyBase : public OperationsListener {
 };
 
 /// \brief Flag indicating data has been written to permanent store
+///
+/// This acts as the per property dirty marker for persistence. It's removed
+/// whenever the property is applied to an entity, and added again once the
+/// value has been written to storage. Only properties without this flag are
+/// written when an entity is updated.
 /// \ingroup PropertyFlags
 static const std::uint32_t prop_flag_persistence_clean = 1u << 0u;
 /// \brief Flag indicating data should never be persisted
@@ -0,0 +1,263 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_TIMINGWHEELQUEUE_H
+#define CYPHESIS_TIMINGWHEELQUEUE_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+/**
+ * @brief A priority queue of timed entries, implemented as a hierarchical timing wheel.
+ *
+ * It has the same interface as the std::priority_queue it replaces (top(), pop(), emplace(), size() and empty()),
+ * and gives the same order: entries are ordered by time, and entries with the same time by their sequence number.
+ * Unlike a binary heap, inserting and removing entries is done in amortized constant time, which matters when there
+ * are hundreds of thousands of entries.
+ *
+ * Time is kept with millisecond resolution. The first level of the wheel has one slot per millisecond, and each of
+ * the coarser levels covers a whole rotation of the level below in each slot. When the wheel reaches a slot in a coarser
+ * level all of its entries are cascaded down into the finer levels. Entries too far into the future to fit in the wheel
+ * are kept in an overflow heap, and entries which are added with a time which the wheel already has passed are kept in
+ * a "late" heap, which is always served first.
+ *
+ * Within each slot entries are kept in the order they were added, which is also the order of their sequence numbers,
+ * since cascading always happens before any entry can be added directly to a slot.
+ *
+ * @tparam EntryT The entry type. It must have a "time_for_dispatch" field of type std::chrono::milliseconds, an
+ * increasing "sequence" field which is used for ordering entries with the same time, and an operator>.
+ */
+template<typename EntryT>
+class TimingWheelQueue
+{
+    public:
+        TimingWheelQueue()
+                : m_now(0),
+                  m_currentIndex(0),
+                  m_size(0)
+        {
+        }
+
+        /**
+         * The first entry. The queue must not be empty.
+         * This is const, like for std::priority_queue, but might advance the wheel internally to find the next entry.
+         */
+        const EntryT& top() const
+        {
+            if (!m_late.empty()) {
+                return m_late.top();
+            }
+            if (m_currentIndex == m_current.size()) {
+                advance();
+            }
+            return m_current[m_currentIndex];
+        }
+
+        /**
+         * Removes the first entry. The queue must not be empty.
+         */
+        void pop()
+        {
+            if (!m_late.empty()) {
+                m_late.pop();
+            } else {
+                if (m_currentIndex == m_current.size()) {
+                    advance();
+                }
+                {
+                    //Destroy the entry now instead of waiting for the slot to be emptied.
+                    EntryT discarded(std::move(m_current[m_currentIndex]));
+                }
+                m_currentIndex++;
+                if (m_currentIndex == m_current.size()) {
+                    m_current.clear();
+                    m_currentIndex = 0;
+                }
+            }
+            m_size--;
+        }
+
+        template<typename... Args>
+        void emplace(Args&& ... args)
+        {
+            push(EntryT(std::forward<Args>(args)...));
+        }
+
+        void push(EntryT entry)
+        {
+            auto time = entry.time_for_dispatch.count();
+            if (m_size == 0) {
+                //With nothing in the wheel we can start anew at the time of the entry.
+                m_now = time;
+            }
+            m_size++;
+            if (time < m_now) {
+                m_late.push(std::move(entry));
+            } else {
+                place(std::move(entry));
+            }
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+    private:
+        /**
+         * The number of bits of time covered by each level. The first level covers 256 ms, and the whole wheel about 18 hours.
+         */
+        static constexpr int LEVEL_COUNT = 4;
+        static constexpr int SLOT_BITS[LEVEL_COUNT] = {8, 6, 6, 6};
+        static constexpr int LEVEL_SHIFT[LEVEL_COUNT] = {0, 8, 14, 20};
+        static constexpr int WHEEL_BITS = 26;
+        static constexpr size_t MAX_SLOTS = 256;
+
+        typedef std::priority_queue<EntryT, std::vector<EntryT>, std::greater<EntryT>> Heap;
+
+        struct Level
+        {
+            std::array<std::vector<EntryT>, MAX_SLOTS> slots;
+            std::bitset<MAX_SLOTS> occupied;
+        };
+
+        /**
+         * The time of the current slot. All entries in the wheel are at this time or later.
+         */
+        mutable std::int64_t m_now;
+        /**
+         * Entries at m_now, in order.
+         */
+        mutable std::vector<EntryT> m_current;
+        mutable size_t m_currentIndex;
+        mutable std::array<Level, LEVEL_COUNT> m_levels;
+        /**
+         * Entries beyond the range of the wheel.
+         */
+        mutable Heap m_overflow;
+        /**
+         * Entries added with a time earlier than m_now.
+         */
+        Heap m_late;
+        size_t m_size;
+
+        static std::int64_t slotIndex(std::int64_t time, int level)
+        {
+            return (time >> LEVEL_SHIFT[level]) & ((1 << SLOT_BITS[level]) - 1);
+        }
+
+        /**
+         * Puts an entry at m_now or later into the finest level which contains both m_now and the time of the entry.
+         */
+        void place(EntryT&& entry) const
+        {
+            auto time = entry.time_for_dispatch.count();
+            if (time == m_now) {
+                m_current.push_back(std::move(entry));
+                return;
+            }
+            for (int level = 0; level < LEVEL_COUNT; ++level) {
+                auto rotationShift = LEVEL_SHIFT[level] + SLOT_BITS[level];
+                if ((time >> rotationShift) == (m_now >> rotationShift)) {
+                    auto index = slotIndex(time, level);
+                    m_levels[level].slots[index].push_back(std::move(entry));
+                    m_levels[level].occupied.set(index);
+                    return;
+                }
+            }
+            m_overflow.push(std::move(entry));
+        }
+
+        /**
+         * @return The first occupied slot at or after the index, or -1 if there is none.
+         */
+        static int findOccupied(const Level& level, int fromIndex, int slotCount)
+        {
+            for (int i = fromIndex; i < slotCount; ++i) {
+                if (level.occupied.test(i)) {
+                    return i;
+                }
+            }
+            return -1;
+        }
+
+        /**
+         * Moves the wheel forward to the next occupied slot, and moves its entries into m_current.
+         * Must only be called when m_current is exhausted and there are entries in the wheel.
+         */
+        void advance() const
+        {
+            m_current.clear();
+            m_currentIndex = 0;
+            while (true) {
+                bool foundSlot = false;
+                for (int level = 0; level < LEVEL_COUNT && !foundSlot; ++level) {
+                    //The slot at the current index has already been handled (or cascaded) for all levels.
+                    auto index = findOccupied(m_levels[level], static_cast<int>(slotIndex(m_now, level)) + 1, 1 << SLOT_BITS[level]);
+                    if (index != -1) {
+                        foundSlot = true;
+                        auto rotationShift = LEVEL_SHIFT[level] + SLOT_BITS[level];
+                        m_now = ((m_now >> rotationShift) << rotationShift) + (static_cast<std::int64_t>(index) << LEVEL_SHIFT[level]);
+                        auto& slot = m_levels[level].slots[index];
+                        m_levels[level].occupied.reset(index);
+                        //Swap and clear instead of moving, so that the allocated memory of the vectors is reused.
+                        if (level == 0) {
+                            m_current.swap(slot);
+                        } else {
+                            //Cascade the entries into the finer levels.
+                            for (auto& entry : slot) {
+                                place(std::move(entry));
+                            }
+                            slot.clear();
+                        }
+                    }
+                }
+                if (!foundSlot) {
+                    if (m_overflow.empty()) {
+                        return;
+                    }
+                    //Jump to the start of the rotation of the wheel which contains the next overflowing entry, and bring in all entries for that rotation.
+                    auto rotation = m_overflow.top().time_for_dispatch.count() >> WHEEL_BITS;
+                    m_now = rotation << WHEEL_BITS;
+                    while (!m_overflow.empty() && (m_overflow.top().time_for_dispatch.count() >> WHEEL_BITS) == rotation) {
+                        place(std::move(const_cast<EntryT&>(m_overflow.top())));
+                        m_overflow.pop();
+                    }
+                }
+                if (!m_current.empty()) {
+                    return;
+                }
+            }
+        }
+};
+
+template<typename EntryT>
+constexpr int TimingWheelQueue<EntryT>::SLOT_BITS[];
+template<typename EntryT>
+constexpr int TimingWheelQueue<EntryT>::LEVEL_SHIFT[];
+
+#endif //CYPHESIS_TIMINGWHEELQUEUE_H
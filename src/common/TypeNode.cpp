@@ -33,14 +33,16 @@ using Atlas::Message::MapType;
 
 TypeNode::TypeNode(std::string name)
         : m_name(std::move(name)),
-          m_parent(nullptr)
+          m_parent(nullptr),
+          m_defaultsRevision(0)
 {
 }
 
 TypeNode::TypeNode(std::string name,
                    const Atlas::Objects::Root& d)
         : m_name(std::move(name)),
-          m_parent(nullptr)
+          m_parent(nullptr),
+          m_defaultsRevision(0)
 {
     setDescription(d);
 }
@@ -88,6 +90,7 @@ TypeNode::PropertiesUpdate TypeNode::injectProperty(const std::string& name,
         m_defaults.emplace(name, std::move(prop));
         update.newProps.insert(name);
     }
+    ++m_defaultsRevision;
 
     auto add_attribute_fn = [&](Atlas::Objects::Root& description) {
         Atlas::Message::Element propertiesElement = Atlas::Message::MapType();
@@ -130,6 +133,7 @@ void TypeNode::addProperties(const MapType& attributes, const PropertyManager& p
         p->install(this, entry.first);
         m_defaults[entry.first] = std::move(p);
     }
+    ++m_defaultsRevision;
 }
 
 TypeNode::PropertiesUpdate TypeNode::updateProperties(const MapType& attributes, const PropertyManager& propertyManager)
@@ -214,6 +218,10 @@ TypeNode::PropertiesUpdate TypeNode::updateProperties(const MapType& attributes,
     m_protectedDescription->setAttr("properties", std::move(propertiesMapProtected));
     m_publicDescription->setAttr("properties", std::move(propertiesMapPublic));
 
+    if (!propertiesUpdate.newProps.empty() || !propertiesUpdate.removedProps.empty()) {
+        ++m_defaultsRevision;
+    }
+
     return propertiesUpdate;
 }
 
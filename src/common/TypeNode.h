@@ -61,6 +61,12 @@ class TypeNode
 
         /// \brief parent node
         const TypeNode* m_parent;
+
+        /// \brief revision of the property defaults
+        ///
+        /// Increased whenever a default property is added, replaced or removed,
+        /// so that references to the default properties can be refreshed.
+        unsigned int m_defaultsRevision;
     public:
 
         struct PropertiesUpdate
@@ -104,6 +110,12 @@ class TypeNode
             return m_defaults;
         }
 
+        /// \brief const accessor for the revision of the property defaults
+        unsigned int defaultsRevision() const
+        {
+            return m_defaultsRevision;
+        }
+
         void setDescription(const Atlas::Objects::Root& description);
 
         /// \brief accessor for type description
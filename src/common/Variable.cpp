@@ -19,6 +19,7 @@
 #include "Variable.h"
 
 #include <iostream>
+#include <atomic>
 
 VariableBase::~VariableBase() = default;
 
@@ -43,6 +44,12 @@ bool Variable<int>::isNumeric() const
     return true;
 }
 
+template <>
+bool Variable<std::atomic<int>>::isNumeric() const
+{
+    return true;
+}
+
 template <>
 bool Variable<std::string>::isNumeric() const
 {
@@ -56,6 +63,7 @@ bool Variable<const char *>::isNumeric() const
 }
 
 template class Variable<int>;
+template class Variable<std::atomic<int>>;
 template class Variable<std::string>;
 template class Variable<const char *>;
 
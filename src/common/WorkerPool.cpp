@@ -0,0 +1,109 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t numberOfThreads)
+    : m_generation(0),
+      m_function(nullptr),
+      m_count(0),
+      m_nextIndex(0),
+      m_activeWorkers(0),
+      m_shutdown(false)
+{
+    for (size_t i = 0; i < numberOfThreads; ++i) {
+        m_threads.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_workCondition.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& function)
+{
+    if (count == 0) {
+        return;
+    }
+    if (m_threads.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_count = count;
+        m_nextIndex = 0;
+        m_activeWorkers = m_threads.size();
+        m_generation++;
+    }
+    m_workCondition.notify_all();
+
+    process(function, count);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCondition.wait(lock, [&]() { return m_activeWorkers == 0; });
+    m_function = nullptr;
+}
+
+void WorkerPool::workerLoop()
+{
+    unsigned int seenGeneration = 0;
+    while (true) {
+        const std::function<void(size_t)>* function;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCondition.wait(lock, [&]() { return m_shutdown || m_generation != seenGeneration; });
+            if (m_shutdown) {
+                return;
+            }
+            seenGeneration = m_generation;
+            function = m_function;
+            count = m_count;
+        }
+
+        process(*function, count);
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_activeWorkers--;
+            if (m_activeWorkers == 0) {
+                m_doneCondition.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::process(const std::function<void(size_t)>& function, size_t count)
+{
+    for (size_t i = m_nextIndex++; i < count; i = m_nextIndex++) {
+        function(i);
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_WORKERPOOL_H
+#define CYPHESIS_WORKERPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief A fixed set of worker threads, used to spread a batch of independent jobs over multiple cores.
+ *
+ * The calling thread takes part in the work, and blocks until the whole batch is done.
+ * Only one thread at a time may submit work to the pool.
+ */
+class WorkerPool
+{
+    public:
+        /**
+         * @param numberOfThreads The number of worker threads, in addition to the calling thread. If 0, all work is done on the calling thread.
+         */
+        explicit WorkerPool(size_t numberOfThreads);
+
+        ~WorkerPool();
+
+        size_t getNumberOfThreads() const
+        {
+            return m_threads.size();
+        }
+
+        /**
+         * @brief Calls the function once for each index in [0, count), spread over all threads.
+         *
+         * Returns when all calls are done. The function must not throw.
+         * @param count The number of indices.
+         * @param function The function to call.
+         */
+        void parallelFor(size_t count, const std::function<void(size_t)>& function);
+
+    private:
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+        std::condition_variable m_workCondition;
+        std::condition_variable m_doneCondition;
+
+        /**
+         * Incremented each time new work is submitted, so that the workers can tell new work from old.
+         */
+        unsigned int m_generation;
+        const std::function<void(size_t)>* m_function;
+        size_t m_count;
+        std::atomic<size_t> m_nextIndex;
+        /**
+         * The number of workers still processing the current batch.
+         */
+        size_t m_activeWorkers;
+        bool m_shutdown;
+
+        void workerLoop();
+
+        void process(const std::function<void(size_t)>& function, size_t count);
+};
+
+
+#endif //CYPHESIS_WORKERPOOL_H
@@ -67,6 +67,8 @@
 #include "RecastDetour/Detour/Include/DetourObstacleAvoidance.h"
 
 #include "common/debug.h"
+#include "common/JobQueue.h"
+#include "TileCacheStore.h"
 
 #include "rules/MemEntity.h"
 
@@ -81,10 +83,12 @@
 #include <boost/multi_index/identity.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <cstring>
 #include <queue>
+#include <atomic>
 
 static const bool debug_flag = false;
 
@@ -139,29 +143,211 @@ struct InputGeometry
     std::vector<WFMath::RotBox<2>> entityAreas;
 };
 
+static void logRecastMessage(const rcLogCategory category, const std::string& msg)
+{
+    if (category == RC_LOG_PROGRESS) {
+        ::log(INFO, String::compose("Recast: %1", msg));
+    } else if (category == RC_LOG_WARNING) {
+        ::log(WARNING, String::compose("Recast: %1", msg));
+    } else {
+        ::log(ERROR, String::compose("Recast: %1", msg));
+    }
+}
+
 class AwarenessContext : public rcContext
 {
     protected:
         void doLog(const rcLogCategory category, const char* msg, const int len) override
         {
-            if (category == RC_LOG_PROGRESS) {
-                ::log(INFO, String::compose("Recast: %1", msg));
-            } else if (category == RC_LOG_WARNING) {
-                ::log(WARNING, String::compose("Recast: %1", msg));
-            } else {
-                ::log(ERROR, String::compose("Recast: %1", msg));
-            }
+            logRecastMessage(category, std::string(msg, len));
+        }
+
+};
+
+/**
+ * @brief A Recast context which stores all messages, so that they can be logged from the main thread once a background build is done.
+ */
+class TileBuildContext : public rcContext
+{
+    public:
+        std::vector<std::pair<rcLogCategory, std::string>> messages;
+
+    protected:
+        void doLog(const rcLogCategory category, const char* msg, const int len) override
+        {
+            messages.emplace_back(category, std::string(msg, len));
         }
+};
 
+/**
+ * @brief Terrain heights for a tile, with a one meter interval.
+ */
+struct TileHeights
+{
+    int xMin;
+    int xMax;
+    int yMin;
+    int yMax;
+    std::vector<float> heights;
+};
+
+/**
+ * @brief A tile being built in the background.
+ *
+ * All input data is copied when the build is started, so that the worker thread doesn't need to touch the Awareness.
+ * The build is shared between the Awareness and the worker thread; the worker thread only writes to it until "done" is set.
+ */
+struct TileBuild
+{
+    int tx;
+    int ty;
+    rcConfig cfg;
+    TileHeights heights;
+    std::vector<WFMath::RotBox<2>> entityAreas;
+    /**
+     * Hash of the input, used when storing the result in the tile cache store.
+     */
+    std::uint64_t inputHash = 0;
+
+    /**
+     * Set by the main thread if the build no longer is needed.
+     */
+    std::atomic<bool> cancelled{false};
+    /**
+     * Set by the worker thread when the build is done; after this the worker thread won't touch the build.
+     */
+    std::atomic<bool> done{false};
+
+    TileBuildContext context;
+    TileCacheData tiles[MAX_LAYERS]{};
+    int ntiles = 0;
+
+    ~TileBuild()
+    {
+        for (auto& tile : tiles) {
+            dtFree(tile.data);
+        }
+    }
 };
 
+/**
+ * @brief Max number of tile builds in progress per background thread.
+ *
+ * Tiles aren't all queued at once, since the order of the dirty tiles might change, and tiles might be dirtied again.
+ */
+static const size_t MAX_TILE_BUILDS_PER_THREAD = 2;
+
+/**
+ * Creates the configuration for a specific tile, including the border.
+ */
+static rcConfig createTileConfig(const rcConfig& cfg, int tx, int ty)
+{
+    const float tcs = cfg.tileSize * cfg.cs;
+
+    rcConfig tcfg{};
+    memcpy(&tcfg, &cfg, sizeof(tcfg));
+
+    tcfg.bmin[0] = cfg.bmin[0] + tx * tcs;
+    tcfg.bmin[1] = cfg.bmin[1];
+    tcfg.bmin[2] = cfg.bmin[2] + ty * tcs;
+    tcfg.bmax[0] = cfg.bmin[0] + (tx + 1) * tcs;
+    tcfg.bmax[1] = cfg.bmax[1];
+    tcfg.bmax[2] = cfg.bmin[2] + (ty + 1) * tcs;
+    tcfg.bmin[0] -= tcfg.borderSize * tcfg.cs;
+    tcfg.bmin[2] -= tcfg.borderSize * tcfg.cs;
+    tcfg.bmax[0] += tcfg.borderSize * tcfg.cs;
+    tcfg.bmax[2] += tcfg.borderSize * tcfg.cs;
+    return tcfg;
+}
+
+static void blitTileHeights(const IHeightProvider& heightProvider, const rcConfig& tcfg, TileHeights& tileHeights)
+{
+    //Get one extra vertex in each direction so that there's no cutoff at the tile's edges.
+    tileHeights.xMin = static_cast<int>(std::floor(tcfg.bmin[0]) - 1);
+    tileHeights.xMax = static_cast<int>(std::ceil(tcfg.bmax[0]) + 1);
+    tileHeights.yMin = static_cast<int>(std::floor(tcfg.bmin[2]) - 1);
+    tileHeights.yMax = static_cast<int>(std::ceil(tcfg.bmax[2]) + 1);
+
+    tileHeights.heights.resize((tileHeights.xMax - tileHeights.xMin) * (tileHeights.yMax - tileHeights.yMin));
+    heightProvider.blitHeights(tileHeights.xMin, tileHeights.xMax, tileHeights.yMin, tileHeights.yMax, tileHeights.heights);
+}
+
+/**
+ * Calculates a hash of all input used for building a tile, for use with the TileCacheStore.
+ */
+static std::uint64_t hashTileInput(const rcConfig& tcfg, const TileHeights& tileHeights, const std::vector<WFMath::RotBox<2>>& entityAreas)
+{
+    //Include the tile cache version, so that tiles built by another version of Detour are rebuilt.
+    int version = DT_TILECACHE_VERSION;
+    auto hash = TileCacheStore::hash(&version, sizeof(version));
+    hash = TileCacheStore::hash(&tcfg, sizeof(tcfg), hash);
+    int bounds[] = {tileHeights.xMin, tileHeights.xMax, tileHeights.yMin, tileHeights.yMax};
+    hash = TileCacheStore::hash(bounds, sizeof(bounds), hash);
+    hash = TileCacheStore::hash(tileHeights.heights.data(), tileHeights.heights.size() * sizeof(float), hash);
+
+    //The order of the areas depends on the order of the entities in memory, so it must not affect the hash.
+    std::vector<std::uint64_t> areaHashes;
+    areaHashes.reserve(entityAreas.size());
+    for (auto& area : entityAreas) {
+        std::uint64_t areaHash = TileCacheStore::hash(nullptr, 0);
+        for (size_t i = 0; i < 4; ++i) {
+            auto corner = area.getCorner(i);
+            float coords[] = {corner.x(), corner.y()};
+            areaHash = TileCacheStore::hash(coords, sizeof(coords), areaHash);
+        }
+        areaHashes.push_back(areaHash);
+    }
+    std::sort(areaHashes.begin(), areaHashes.end());
+    return TileCacheStore::hash(areaHashes.data(), areaHashes.size() * sizeof(std::uint64_t), hash);
+}
+
+/**
+ * Copies stored tile layers into newly allocated tile data, ready to be added to the tile cache.
+ */
+static int loadStoredTileLayers(const TileCacheStore::Layers& layers, TileCacheData* tiles, int maxTiles)
+{
+    int ntiles = 0;
+    for (auto& layer : layers) {
+        if (ntiles == maxTiles) {
+            break;
+        }
+        auto data = static_cast<unsigned char*>(dtAlloc(static_cast<int>(layer.size()), DT_ALLOC_PERM));
+        if (!data) {
+            break;
+        }
+        memcpy(data, layer.data(), layer.size());
+        tiles[ntiles].data = data;
+        tiles[ntiles].dataSize = static_cast<int>(layer.size());
+        ntiles++;
+    }
+    return ntiles;
+}
+
+static TileCacheStore::Layers copyTileLayers(const TileCacheData* tiles, int ntiles)
+{
+    TileCacheStore::Layers layers;
+    layers.reserve(ntiles);
+    for (int i = 0; i < ntiles; ++i) {
+        layers.emplace_back(tiles[i].data, tiles[i].data + tiles[i].dataSize);
+    }
+    return layers;
+}
+
+/**
+ * Rasterizes the tile layers. This only touches the supplied data, and so can be called from any thread.
+ */
+static int rasterizeTileLayers(rcContext* ctx, const rcConfig& tcfg, const TileHeights& tileHeights, const std::vector<WFMath::RotBox<2>>& entityAreas,
+                               int tx, int ty, TileCacheData* tiles, int maxTiles);
+
 Awareness::Awareness(const LocatedEntity& domainEntity,
                      float agentRadius,
                      float agentHeight,
                      float stepHeight,
                      IHeightProvider& heightProvider,
                      const WFMath::AxisBox<3>& extent,
-                     int tileSize) :
+                     int tileSize,
+                     JobQueue* tileBuildQueue,
+                     std::shared_ptr<TileCacheStore> tileCacheStore) :
         mHeightProvider(heightProvider),
         mDomainEntity(domainEntity),
         mTalloc(nullptr),
@@ -178,7 +364,9 @@ Awareness::Awareness(const LocatedEntity& domainEntity,
         mNavQuery(dtAllocNavMeshQuery()),
         mFilter(new dtQueryFilter()),
         mActiveTileList(new MRUList<std::pair<int, int>>()),
-        mObserverCount(0)
+        mObserverCount(0),
+        mTileBuildQueue(tileBuildQueue),
+        mTileCacheStore(std::move(tileCacheStore))
 {
     auto validExtent = extent;
     if (!extent.isValid()) {
@@ -331,6 +519,10 @@ Awareness::Awareness(const LocatedEntity& domainEntity,
 
 Awareness::~Awareness()
 {
+    //Any builds still running will be thrown away by the worker threads.
+    for (auto& entry : mTileBuilds) {
+        entry.second->cancelled = true;
+    }
 
     dtFreeObstacleAvoidanceQuery(mObstacleAvoidanceQuery);
 
@@ -411,7 +603,7 @@ void Awareness::removeEntity(const MemEntity& observer, const LocatedEntity& ent
                     for (auto& entry : areas) {
                         markTilesAsDirty(entry.second.boundingBox());
                     }
-                    mEntityAreas.erase(entityEntry.get());
+                    removeEntityArea(entityEntry.get());
                 }
             }
             mObservedEntities.erase(I);
@@ -464,7 +656,7 @@ void Awareness::processEntityMovementChange(EntityEntry& entityEntry, const Loca
             for (auto& entry : areas) {
                 markTilesAsDirty(entry.second.boundingBox());
             }
-            mEntityAreas.erase(&entityEntry);
+            removeEntityArea(&entityEntry);
 
         } else {
 
@@ -486,7 +678,7 @@ void Awareness::processEntityMovementChange(EntityEntry& entityEntry, const Loca
                     if (existingI != mEntityAreas.end()) {
                         //The entity already was registered; mark those tiles where the entity previously were as dirty.
                         markTilesAsDirty(existingI->second.boundingBox());
-                        mEntityAreas.erase(&entityEntry);
+                        removeEntityArea(&entityEntry);
                     }
                 } else {
                     std::map<const EntityEntry*, WFMath::RotBox<2>> areas;
@@ -499,10 +691,8 @@ void Awareness::processEntityMovementChange(EntityEntry& entityEntry, const Loca
                         if (existingI != mEntityAreas.end()) {
                             //The entity already was registered; mark both those tiles where the entity previously were as well as the new tiles as dirty.
                             markTilesAsDirty(existingI->second.boundingBox());
-                            existingI->second = entry.second;
-                        } else {
-                            mEntityAreas.insert(entry);
                         }
+                        setEntityArea(entry.first, entry.second);
                     }
                     debug_print("Entity affects " << areas.size() << " areas. Dirty unaware tiles: " << mDirtyUnwareTiles.size() << " Dirty aware tiles: " << mDirtyAwareTiles.size())
                 }
@@ -623,6 +813,8 @@ void Awareness::markTilesAsDirty(int tileMinXIndex, int tileMaxXIndex, int tileM
     for (int tx = tileMinXIndex; tx <= tileMaxXIndex; ++tx) {
         for (int ty = tileMinYIndex; ty <= tileMaxYIndex; ++ty) {
             std::pair<int, int> index(tx, ty);
+            //Any build in progress would be out of date, so it needs to be rebuilt once it's dirty.
+            cancelTileBuild(index);
             if (mAwareTiles.find(index) != mAwareTiles.end()) {
                 if (mDirtyAwareTiles.insert(index).second) {
                     mDirtyAwareOrderedTiles.push_back(index);
@@ -640,17 +832,29 @@ void Awareness::markTilesAsDirty(int tileMinXIndex, int tileMaxXIndex, int tileM
 
 size_t Awareness::rebuildDirtyTile()
 {
+    if (mTileBuildQueue) {
+        installFinishedTileBuilds();
+
+        size_t maxBuilds = mTileBuildQueue->getNumberOfThreads() * MAX_TILE_BUILDS_PER_THREAD;
+        //Tiles loaded from the tile cache store are installed directly; limit those too so that the main thread isn't stalled.
+        size_t started = 0;
+        while (!mDirtyAwareOrderedTiles.empty() && mTileBuilds.size() < maxBuilds && started < maxBuilds) {
+            auto tileIndex = mDirtyAwareOrderedTiles.front();
+            mDirtyAwareOrderedTiles.pop_front();
+            mDirtyAwareTiles.erase(tileIndex);
+            startTileBuild(tileIndex.first, tileIndex.second);
+            started++;
+        }
+        return mDirtyAwareTiles.size() + mTileBuilds.size();
+    }
+
     if (!mDirtyAwareTiles.empty()) {
         debug_print("Rebuilding aware tiles. Number of dirty aware tiles: " << mDirtyAwareTiles.size())
         const auto tileIndexI = mDirtyAwareOrderedTiles.begin();
         const auto& tileIndex = *tileIndexI;
 
-        float tilesize = mCfg.tileSize * mCfg.cs;
-        WFMath::AxisBox<2> adjustedArea(WFMath::Point<2>(mCfg.bmin[0] + (tileIndex.first * tilesize), mCfg.bmin[2] + (tileIndex.second * tilesize)),
-                                        WFMath::Point<2>(mCfg.bmin[0] + ((tileIndex.first + 1) * tilesize), mCfg.bmin[2] + ((tileIndex.second + 1) * tilesize)));
-
         std::vector<WFMath::RotBox<2>> entityAreas;
-        findEntityAreas(adjustedArea, entityAreas);
+        findEntityAreas(getTileArea(tileIndex.first, tileIndex.second), entityAreas);
 
         rebuildTile(tileIndex.first, tileIndex.second, entityAreas);
         mDirtyAwareTiles.erase(tileIndex);
@@ -659,6 +863,75 @@ size_t Awareness::rebuildDirtyTile()
     return mDirtyAwareTiles.size();
 }
 
+void Awareness::startTileBuild(int tx, int ty)
+{
+    auto build = std::make_shared<TileBuild>();
+    build->tx = tx;
+    build->ty = ty;
+    build->cfg = createTileConfig(mCfg, tx, ty);
+    //The terrain and entities might change while the tile is being built, so copy what's needed.
+    blitTileHeights(mHeightProvider, build->cfg, build->heights);
+    findEntityAreas(getTileArea(tx, ty), build->entityAreas);
+
+    if (mTileCacheStore) {
+        build->inputHash = hashTileInput(build->cfg, build->heights, build->entityAreas);
+        auto layers = mTileCacheStore->find(tx, ty, build->inputHash);
+        if (layers) {
+            TileCacheData tiles[MAX_LAYERS]{};
+            int ntiles = loadStoredTileLayers(*layers, tiles, MAX_LAYERS);
+            installTileLayers(tx, ty, tiles, ntiles);
+            return;
+        }
+    }
+
+    mTileBuilds[std::make_pair(tx, ty)] = build;
+
+    mTileBuildQueue->post([build]() {
+        if (!build->cancelled) {
+            build->ntiles = rasterizeTileLayers(&build->context, build->cfg, build->heights, build->entityAreas, build->tx, build->ty, build->tiles, MAX_LAYERS);
+        }
+        build->done.store(true, std::memory_order_release);
+    });
+}
+
+void Awareness::installFinishedTileBuilds()
+{
+    for (auto I = mTileBuilds.begin(); I != mTileBuilds.end();) {
+        auto& build = *I->second;
+        if (build.done.load(std::memory_order_acquire)) {
+            for (auto& message : build.context.messages) {
+                logRecastMessage(message.first, message.second);
+            }
+            if (mTileCacheStore && build.ntiles > 0) {
+                mTileCacheStore->store(build.tx, build.ty, build.inputHash, copyTileLayers(build.tiles, build.ntiles));
+            }
+            installTileLayers(build.tx, build.ty, build.tiles, build.ntiles);
+            build.ntiles = 0;
+            I = mTileBuilds.erase(I);
+        } else {
+            ++I;
+        }
+    }
+}
+
+bool Awareness::cancelTileBuild(const std::pair<int, int>& tileIndex)
+{
+    auto I = mTileBuilds.find(tileIndex);
+    if (I != mTileBuilds.end()) {
+        I->second->cancelled = true;
+        mTileBuilds.erase(I);
+        return true;
+    }
+    return false;
+}
+
+WFMath::AxisBox<2> Awareness::getTileArea(int tx, int ty) const
+{
+    float tilesize = mCfg.tileSize * mCfg.cs;
+    return {WFMath::Point<2>(mCfg.bmin[0] + (tx * tilesize), mCfg.bmin[2] + (ty * tilesize)),
+            WFMath::Point<2>(mCfg.bmin[0] + ((tx + 1) * tilesize), mCfg.bmin[2] + ((ty + 1) * tilesize))};
+}
+
 void Awareness::pruneTiles()
 {
     //remove any tiles that aren't used
@@ -965,6 +1238,11 @@ void Awareness::returnAwareTiles(const std::set<std::pair<int, int>>& tileset)
         awareEntry->second--;
         if (awareEntry->second == 0) {
             mAwareTiles.erase(awareEntry);
+            //Nobody is interested in the tile any more, so there's no need to finish building it. It still needs
+            //to be built if it becomes aware again, so it's treated as dirty.
+            if (cancelTileBuild(tileIndex)) {
+                mDirtyUnwareTiles.insert(tileIndex);
+            }
             if (mDirtyAwareTiles.erase(tileIndex)) {
                 mDirtyAwareOrderedTiles.remove(tileIndex);
                 mDirtyUnwareTiles.insert(tileIndex);
@@ -1010,6 +1288,11 @@ void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>
 
     int ntiles = rasterizeTileLayers(entityAreas, tx, ty, tiles, MAX_LAYERS);
 
+    installTileLayers(tx, ty, tiles, ntiles);
+}
+
+void Awareness::installTileLayers(int tx, int ty, TileCacheData* tiles, int ntiles)
+{
     for (int j = 0; j < ntiles; ++j) {
         TileCacheData* tile = &tiles[j];
 
@@ -1022,9 +1305,8 @@ void Awareness::rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>
         if (dtStatusFailed(status)) {
             log(WARNING, String::compose("Failed to add tile in awareness. x: %1 y: %2 Reason: %3", tx, ty, status));
             dtFree(tile->data);
-            tile->data = 0;
-            continue;
         }
+        tile->data = nullptr;
     }
 
     dtStatus status = mTileCache->buildNavMeshTilesAt(tx, ty, mNavMesh);
@@ -1083,15 +1365,105 @@ void Awareness::buildEntityAreas(const EntityEntry& entity, std::map<const Entit
 
 void Awareness::findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2> >& areas)
 {
-    for (auto& entry : mEntityAreas) {
-        auto& rotbox = entry.second;
+    int tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex;
+    findAffectedTiles(extent, tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex);
+
+    //Entities touching more than one tile are in multiple buckets, so collect them first to get rid of duplicates.
+    std::vector<const EntityEntry*> candidates;
+    for (int tx = tileMinXIndex; tx <= tileMaxXIndex; ++tx) {
+        for (int ty = tileMinYIndex; ty <= tileMaxYIndex; ++ty) {
+            auto I = mEntityAreasByTile.find(std::make_pair(tx, ty));
+            if (I != mEntityAreasByTile.end()) {
+                candidates.insert(candidates.end(), I->second.begin(), I->second.end());
+            }
+        }
+    }
+    //Sorting also keeps the same order as in mEntityAreas.
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (auto entity : candidates) {
+        auto& rotbox = mEntityAreas.find(entity)->second;
         if (WFMath::Contains(extent, rotbox, false) || WFMath::Intersect(extent, rotbox, false)) {
             areas.push_back(rotbox);
         }
     }
 }
 
+void Awareness::setEntityArea(const EntityEntry* entity, const WFMath::RotBox<2>& area)
+{
+    auto I = mEntityAreas.find(entity);
+    if (I != mEntityAreas.end()) {
+        updateEntityAreaBuckets(entity, I->second, false);
+        I->second = area;
+    } else {
+        mEntityAreas.emplace(entity, area);
+    }
+    updateEntityAreaBuckets(entity, area, true);
+}
+
+void Awareness::removeEntityArea(const EntityEntry* entity)
+{
+    auto I = mEntityAreas.find(entity);
+    if (I != mEntityAreas.end()) {
+        updateEntityAreaBuckets(entity, I->second, false);
+        mEntityAreas.erase(I);
+    }
+}
+
+void Awareness::updateEntityAreaBuckets(const EntityEntry* entity, const WFMath::RotBox<2>& area, bool add)
+{
+    //Since the tile configuration never changes the same area always maps to the same tiles, so the tiles don't need to be stored.
+    int tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex;
+    findAffectedTiles(area.boundingBox(), tileMinXIndex, tileMaxXIndex, tileMinYIndex, tileMaxYIndex);
+
+    for (int tx = tileMinXIndex; tx <= tileMaxXIndex; ++tx) {
+        for (int ty = tileMinYIndex; ty <= tileMaxYIndex; ++ty) {
+            auto index = std::make_pair(tx, ty);
+            if (add) {
+                mEntityAreasByTile[index].push_back(entity);
+            } else {
+                auto I = mEntityAreasByTile.find(index);
+                if (I != mEntityAreasByTile.end()) {
+                    auto& bucket = I->second;
+                    auto entityI = std::find(bucket.begin(), bucket.end(), entity);
+                    if (entityI != bucket.end()) {
+                        *entityI = bucket.back();
+                        bucket.pop_back();
+                    }
+                    if (bucket.empty()) {
+                        mEntityAreasByTile.erase(I);
+                    }
+                }
+            }
+        }
+    }
+}
+
 int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, int tx, int ty, TileCacheData* tiles, int maxTiles)
+{
+    rcConfig tcfg = createTileConfig(mCfg, tx, ty);
+    TileHeights tileHeights{};
+    blitTileHeights(mHeightProvider, tcfg, tileHeights);
+
+    if (!mTileCacheStore) {
+        return ::rasterizeTileLayers(mCtx.get(), tcfg, tileHeights, entityAreas, tx, ty, tiles, maxTiles);
+    }
+
+    auto inputHash = hashTileInput(tcfg, tileHeights, entityAreas);
+    auto layers = mTileCacheStore->find(tx, ty, inputHash);
+    if (layers) {
+        return loadStoredTileLayers(*layers, tiles, maxTiles);
+    }
+    int ntiles = ::rasterizeTileLayers(mCtx.get(), tcfg, tileHeights, entityAreas, tx, ty, tiles, maxTiles);
+    if (ntiles > 0) {
+        mTileCacheStore->store(tx, ty, inputHash, copyTileLayers(tiles, ntiles));
+    }
+    return ntiles;
+}
+
+static int rasterizeTileLayers(rcContext* ctx, const rcConfig& tcfg, const TileHeights& tileHeights, const std::vector<WFMath::RotBox<2>>& entityAreas,
+                               int tx, int ty, TileCacheData* tiles, int maxTiles)
 {
     std::vector<float> vertsVector;
     std::vector<int> trisVector;
@@ -1099,38 +1471,13 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
     FastLZCompressor comp;
     RasterizationContext rc;
 
-// Tile bounds.
-    const float tcs = mCfg.tileSize * mCfg.cs;
-
-    rcConfig tcfg{};
-    memcpy(&tcfg, &mCfg, sizeof(tcfg));
-
-    tcfg.bmin[0] = mCfg.bmin[0] + tx * tcs;
-    tcfg.bmin[1] = mCfg.bmin[1];
-    tcfg.bmin[2] = mCfg.bmin[2] + ty * tcs;
-    tcfg.bmax[0] = mCfg.bmin[0] + (tx + 1) * tcs;
-    tcfg.bmax[1] = mCfg.bmax[1];
-    tcfg.bmax[2] = mCfg.bmin[2] + (ty + 1) * tcs;
-    tcfg.bmin[0] -= tcfg.borderSize * tcfg.cs;
-    tcfg.bmin[2] -= tcfg.borderSize * tcfg.cs;
-    tcfg.bmax[0] += tcfg.borderSize * tcfg.cs;
-    tcfg.bmax[2] += tcfg.borderSize * tcfg.cs;
+    int sizeX = tileHeights.xMax - tileHeights.xMin;
+    int sizeY = tileHeights.yMax - tileHeights.yMin;
 
-//First define all vertices. Get one extra vertex in each direction so that there's no cutoff at the tile's edges.
-    int heightsXMin = static_cast<int>(std::floor(tcfg.bmin[0]) - 1);
-    int heightsXMax = static_cast<int>(std::ceil(tcfg.bmax[0]) + 1);
-    int heightsYMin = static_cast<int>(std::floor(tcfg.bmin[2]) - 1);
-    int heightsYMax = static_cast<int>(std::ceil(tcfg.bmax[2]) + 1);
-    int sizeX = heightsXMax - heightsXMin;
-    int sizeY = heightsYMax - heightsYMin;
-
-//Blit height values with 1 meter interval
-    std::vector<float> heights(sizeX * sizeY);
-    mHeightProvider.blitHeights(heightsXMin, heightsXMax, heightsYMin, heightsYMax, heights);
-
-    float* heightData = heights.data();
-    for (int y = heightsYMin; y < heightsYMax; ++y) {
-        for (int x = heightsXMin; x < heightsXMax; ++x) {
+//First define all vertices, from the height values with 1 meter interval.
+    const float* heightData = tileHeights.heights.data();
+    for (int y = tileHeights.yMin; y < tileHeights.yMax; ++y) {
+        for (int x = tileHeights.xMin; x < tileHeights.xMax; ++x) {
             vertsVector.push_back(x);
             vertsVector.push_back(*heightData);
             vertsVector.push_back(y);
@@ -1161,25 +1508,25 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 // Allocate voxel heightfield where we rasterize our input data to.
     rc.solid = rcAllocHeightfield();
     if (!rc.solid) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
         return 0;
     }
-    if (!rcCreateHeightfield(mCtx.get(), *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+    if (!rcCreateHeightfield(ctx, *rc.solid, tcfg.width, tcfg.height, tcfg.bmin, tcfg.bmax, tcfg.cs, tcfg.ch)) {
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
         return 0;
     }
 
 // Allocate array that can hold triangle flags.
     rc.triareas = new unsigned char[ntris];
     if (!rc.triareas) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", ntris / 3);
         return 0;
     }
 
     memset(rc.triareas, 0, ntris * sizeof(unsigned char));
-    rcMarkWalkableTriangles(mCtx.get(), tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
+    rcMarkWalkableTriangles(ctx, tcfg.walkableSlopeAngle, verts, nverts, tris, ntris, rc.triareas);
 
-    rcRasterizeTriangles(mCtx.get(), verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
+    rcRasterizeTriangles(ctx, verts, nverts, tris, rc.triareas, ntris, *rc.solid, tcfg.walkableClimb);
 
 // Once all geometry is rasterized, we do initial pass of filtering to
 // remove unwanted overhangs caused by the conservative rasterization
@@ -1193,17 +1540,17 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
 
     rc.chf = rcAllocCompactHeightfield();
     if (!rc.chf) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
         return 0;
     }
-    if (!rcBuildCompactHeightfield(mCtx.get(), tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
+    if (!rcBuildCompactHeightfield(ctx, tcfg.walkableHeight, tcfg.walkableClimb, *rc.solid, *rc.chf)) {
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
         return 0;
     }
 
 // Erode the walkable area by agent radius.
-    if (!rcErodeWalkableArea(mCtx.get(), tcfg.walkableRadius, *rc.chf)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
+    if (!rcErodeWalkableArea(ctx, tcfg.walkableRadius, *rc.chf)) {
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
         return 0;
     }
 
@@ -1227,16 +1574,16 @@ int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityA
         areaVerts[10] = 0;
         areaVerts[11] = rotbox.getCorner(0).y();
 
-        rcMarkConvexPolyArea(mCtx.get(), areaVerts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
+        rcMarkConvexPolyArea(ctx, areaVerts, 4, tcfg.bmin[1], tcfg.bmax[1], DT_TILECACHE_NULL_AREA, *rc.chf);
     }
 
     rc.lset = rcAllocHeightfieldLayerSet();
     if (!rc.lset) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'lset'.");
         return 0;
     }
-    if (!rcBuildHeightfieldLayers(mCtx.get(), *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
-        mCtx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
+    if (!rcBuildHeightfieldLayers(ctx, *rc.chf, tcfg.borderSize, tcfg.walkableHeight, *rc.lset)) {
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build heighfield layers.");
         return 0;
     }
 
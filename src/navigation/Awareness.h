@@ -38,6 +38,7 @@
 #include <map>
 #include <unordered_map>
 #include <functional>
+#include <memory>
 
 class MemEntity;
 
@@ -70,6 +71,11 @@ class MRUList;
 
 struct TileCacheData;
 struct InputGeometry;
+struct TileBuild;
+
+class JobQueue;
+
+class TileCacheStore;
 
 enum PolyAreas
 {
@@ -127,6 +133,9 @@ struct EntityEntry
  *
  * Internally this class uses a dtTileCache to manage the tiles. Since the world is dynamic we need to manage the
  * navmeshes through tiles in order to keep the resource usage down.
+ *
+ * Instances are shared between minds through the AwarenessStore, and aren't thread safe. All calls must be made from
+ * the thread running the minds; if a tile build queue is used the background threads only work on copied data.
  */
 class Awareness
 {
@@ -141,6 +150,8 @@ class Awareness
          * @param domainEntity The entity holding the domain of the awareness.
          * @param heightProvider A height provider, used for getting terrain height data.
          * @param tileSize The size, in voxels, of one side of a tile. The larger this is the longer each tile takes to generate, but the overhead of managing tiles is decreased.
+         * @param tileBuildQueue An optional queue on which tiles will be built in the background. If null tiles are built synchronously.
+         * @param tileCacheStore An optional persistent store of tiles. Tiles built from the same input as a stored tile are loaded from the store instead of being rasterized.
          */
         Awareness(const LocatedEntity& domainEntity,
                   float agentRadius,
@@ -148,7 +159,9 @@ class Awareness
                   float stepHeight,
                   IHeightProvider& heightProvider,
                   const WFMath::AxisBox<3>& extent,
-                  int tileSize = 64);
+                  int tileSize = 64,
+                  JobQueue* tileBuildQueue = nullptr,
+                  std::shared_ptr<TileCacheStore> tileCacheStore = nullptr);
 
         virtual ~Awareness();
 
@@ -167,10 +180,22 @@ class Awareness
 
         /**
          * @brief Rebuilds a dirty tile if any such exists.
-         * @return The number of dirty tiles remaining.
+         *
+         * If tiles are built in the background this instead installs any finished tiles, and starts building dirty tiles.
+         * @return The number of dirty tiles remaining, including those being built in the background.
          */
         size_t rebuildDirtyTile();
 
+        /**
+         * @brief Returns true if tiles are built in the background.
+         *
+         * If so there's no point in calling rebuildDirtyTile() again immediately when there are tiles remaining.
+         */
+        bool isBuildingTilesInBackground() const
+        {
+            return mTileBuildQueue != nullptr;
+        }
+
         /**
          * @brief Finds a path from the start to the finish.
          * @param start A starting position.
@@ -417,6 +442,14 @@ class Awareness
          */
         std::map<const EntityEntry*, WFMath::RotBox<2>> mEntityAreas;
 
+        /**
+         * @brief A spatial index of mEntityAreas, with the entities bucketed by the tiles their areas touch.
+         *
+         * This allows findEntityAreas() to only check the entities near the tile being built.
+         * Always update it through setEntityArea() and removeEntityArea().
+         */
+        std::map<std::pair<int, int>, std::vector<const EntityEntry*>> mEntityAreasByTile;
+
         /**
          * @brief Keeps track of all currently observed entities.
          */
@@ -454,6 +487,24 @@ class Awareness
          */
         size_t mObserverCount;
 
+        /**
+         * @brief Queue used for building tiles in the background. If null tiles are built synchronously.
+         */
+        JobQueue* mTileBuildQueue;
+
+        /**
+         * @brief Tiles which currently are being built in the background.
+         *
+         * Once finished they are installed by rebuildDirtyTile(). If a tile is marked as dirty again, or stops being aware,
+         * while being built the build is cancelled and removed from here.
+         */
+        std::map<std::pair<int, int>, std::shared_ptr<TileBuild>> mTileBuilds;
+
+        /**
+         * @brief An optional persistent store of built tiles.
+         */
+        std::shared_ptr<TileCacheStore> mTileCacheStore;
+
         void processEntityMovementChange(EntityEntry& entry, const LocatedEntity& entity);
 
         /**
@@ -464,6 +515,43 @@ class Awareness
          */
         void rebuildTile(int tx, int ty, const std::vector<WFMath::RotBox<2>>& entityAreas);
 
+        /**
+         * @brief Adds rasterized tile layers to the tile cache, and rebuilds the navmesh tile.
+         * @param tx X index.
+         * @param ty Y index.
+         * @param tiles The tile layers. Ownership of the data is transferred to the tile cache.
+         * @param ntiles The number of tile layers.
+         */
+        void installTileLayers(int tx, int ty, TileCacheData* tiles, int ntiles);
+
+        /**
+         * @brief Snapshots the data needed to build a tile, and queues it to be built in the background.
+         * If the tile can be loaded from the tile cache store it's installed directly instead.
+         * @param tx X index.
+         * @param ty Y index.
+         */
+        void startTileBuild(int tx, int ty);
+
+        /**
+         * @brief Installs all tiles which have been built in the background.
+         */
+        void installFinishedTileBuilds();
+
+        /**
+         * @brief Cancels any background build of the tile at the specific index.
+         * @param tileIndex The tile index.
+         * @return True if a build was cancelled.
+         */
+        bool cancelTileBuild(const std::pair<int, int>& tileIndex);
+
+        /**
+         * @brief Gets the world area covered by the tile at the specific index.
+         * @param tx X index.
+         * @param ty Y index.
+         * @return An area in world units.
+         */
+        WFMath::AxisBox<2> getTileArea(int tx, int ty) const;
+
         /**
          * @brief Calculates the 2d rotbox area of the entity and adds it to the supplied map of areas.
          * @param entity An entity.
@@ -478,8 +566,30 @@ class Awareness
          */
         void findEntityAreas(const WFMath::AxisBox<2>& extent, std::vector<WFMath::RotBox<2> >& areas);
 
+        /**
+         * @brief Adds or replaces the area of an entity, keeping the spatial index up to date.
+         * @param entity An entity.
+         * @param area The area of the entity.
+         */
+        void setEntityArea(const EntityEntry* entity, const WFMath::RotBox<2>& area);
+
+        /**
+         * @brief Removes the area of an entity, if there is one, keeping the spatial index up to date.
+         * @param entity An entity.
+         */
+        void removeEntityArea(const EntityEntry* entity);
+
+        /**
+         * @brief Adds or removes an entity in the buckets of all tiles touched by its area.
+         * @param entity An entity.
+         * @param area The area of the entity.
+         * @param add True if the entity should be added, false if it should be removed.
+         */
+        void updateEntityAreaBuckets(const EntityEntry* entity, const WFMath::RotBox<2>& area, bool add);
+
         /**
          * @brief Rasterizes the tile at the specified index.
+         * If there's a tile cache store the tile is loaded from it if possible, and stored in it if not.
          * @param entityAreas The entity areas that affects the tile.
          * @param tx X index.
          * @param ty Y index.
@@ -0,0 +1,227 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "TileCacheStore.h"
+
+#include "common/log.h"
+#include "common/compose.hpp"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace {
+    const std::uint32_t FILE_MAGIC = 0x43545943; // "CYTC"
+    const std::uint32_t FILE_VERSION = 1;
+
+    /**
+     * Upper limits used to detect corrupt records, so that we don't try to allocate huge buffers.
+     */
+    const std::uint32_t MAX_LAYERS_PER_TILE = 255;
+    const std::uint32_t MAX_LAYER_SIZE = 16 * 1024 * 1024;
+
+    template<typename T>
+    bool readValue(std::istream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+    template<typename T>
+    void writeValue(std::ostream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+TileCacheStore::TileCacheStore(std::string path)
+        : m_path(std::move(path)),
+          m_lockFd(-1),
+          m_persistent(false)
+{
+    if (!lock()) {
+        return;
+    }
+    m_persistent = true;
+    if (load() && !compact()) {
+        return;
+    }
+    openForAppending();
+}
+
+TileCacheStore::~TileCacheStore()
+{
+    //Make sure everything is written before the lock is released.
+    m_file.close();
+#ifndef _WIN32
+    if (m_lockFd != -1) {
+        ::flock(m_lockFd, LOCK_UN);
+        ::close(m_lockFd);
+    }
+#endif // _WIN32
+}
+
+bool TileCacheStore::lock()
+{
+#ifndef _WIN32
+    auto lockPath = m_path + ".lock";
+    m_lockFd = ::open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_lockFd == -1) {
+        log(WARNING, String::compose("Could not open navmesh tile cache lock '%1'; tiles will not be stored.", lockPath));
+        return false;
+    }
+    if (::flock(m_lockFd, LOCK_EX | LOCK_NB) != 0) {
+        log(NOTICE, String::compose("Navmesh tile cache '%1' is used by another process; tiles will not be stored.", m_path));
+        ::close(m_lockFd);
+        m_lockFd = -1;
+        return false;
+    }
+#endif // _WIN32
+    return true;
+}
+
+const TileCacheStore::Layers* TileCacheStore::find(int tx, int ty, std::uint64_t hash) const
+{
+    auto I = m_tiles.find(std::make_pair(tx, ty));
+    if (I != m_tiles.end() && I->second.hash == hash) {
+        return &I->second.layers;
+    }
+    return nullptr;
+}
+
+void TileCacheStore::store(int tx, int ty, std::uint64_t hash, Layers layers)
+{
+    auto& entry = m_tiles[std::make_pair(tx, ty)];
+    entry.hash = hash;
+    entry.layers = std::move(layers);
+    if (m_file.is_open()) {
+        writeRecord(m_file, tx, ty, entry);
+        m_file.flush();
+        if (!m_file) {
+            log(WARNING, String::compose("Could not write to navmesh tile cache '%1'; tiles will no longer be stored.", m_path));
+            m_file.close();
+        }
+    }
+}
+
+std::uint64_t TileCacheStore::hash(const void* data, size_t length, std::uint64_t hash)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool TileCacheStore::load()
+{
+    std::ifstream file(m_path, std::ios::binary);
+    if (!file) {
+        return true;
+    }
+    std::uint32_t magic, version;
+    if (!readValue(file, magic) || !readValue(file, version) || magic != FILE_MAGIC || version != FILE_VERSION) {
+        log(INFO, String::compose("Navmesh tile cache '%1' is of an unknown format; it will be recreated.", m_path));
+        return true;
+    }
+
+    size_t records = 0;
+    while (true) {
+        std::int32_t tx, ty;
+        std::uint32_t layerCount;
+        Entry entry{};
+        if (!readValue(file, tx)) {
+            //End of file.
+            break;
+        }
+        if (!readValue(file, ty) || !readValue(file, entry.hash) || !readValue(file, layerCount) || layerCount > MAX_LAYERS_PER_TILE) {
+            //A partially written record, probably because the process was killed. Rewrite the file to get rid of it.
+            return true;
+        }
+        bool valid = true;
+        entry.layers.resize(layerCount);
+        for (auto& layer : entry.layers) {
+            std::uint32_t size;
+            if (!readValue(file, size) || size > MAX_LAYER_SIZE) {
+                valid = false;
+                break;
+            }
+            layer.resize(size);
+            if (!file.read(reinterpret_cast<char*>(layer.data()), size)) {
+                valid = false;
+                break;
+            }
+        }
+        if (!valid) {
+            return true;
+        }
+        m_tiles[std::make_pair(tx, ty)] = std::move(entry);
+        records++;
+    }
+    //Rewrite the file if it mostly contains outdated records.
+    return records > m_tiles.size() * 2;
+}
+
+bool TileCacheStore::compact()
+{
+    auto tempPath = m_path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        writeValue(file, FILE_MAGIC);
+        writeValue(file, FILE_VERSION);
+        for (auto& entry : m_tiles) {
+            writeRecord(file, entry.first.first, entry.first.second, entry.second);
+        }
+        if (!file) {
+            log(WARNING, String::compose("Could not write navmesh tile cache '%1'; tiles will not be stored.", tempPath));
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), m_path.c_str()) != 0) {
+        log(WARNING, String::compose("Could not replace navmesh tile cache '%1'; tiles will not be stored.", m_path));
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void TileCacheStore::openForAppending()
+{
+    m_file.open(m_path, std::ios::binary | std::ios::app);
+    if (!m_file) {
+        log(WARNING, String::compose("Could not open navmesh tile cache '%1'; tiles will not be stored.", m_path));
+        m_file.close();
+    }
+}
+
+void TileCacheStore::writeRecord(std::ostream& stream, int tx, int ty, const Entry& entry)
+{
+    writeValue(stream, static_cast<std::int32_t>(tx));
+    writeValue(stream, static_cast<std::int32_t>(ty));
+    writeValue(stream, entry.hash);
+    writeValue(stream, static_cast<std::uint32_t>(entry.layers.size()));
+    for (auto& layer : entry.layers) {
+        writeValue(stream, static_cast<std::uint32_t>(layer.size()));
+        stream.write(reinterpret_cast<const char*>(layer.data()), layer.size());
+    }
+}
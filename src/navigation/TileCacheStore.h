@@ -0,0 +1,144 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_TILECACHESTORE_H
+#define CYPHESIS_TILECACHESTORE_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A persistent store of compressed navmesh tile layers, so that tiles don't need to be rasterized again when the AI client is restarted.
+ *
+ * Each tile is stored together with a hash of all the input used for building it (the tile configuration, the terrain heights and the entity areas).
+ * A stored tile is only used if the hash matches, so any change to the terrain or the entities will make the tile be rebuilt.
+ *
+ * The store is backed by a single file, to which new tiles are appended. The whole file is read when the store is created;
+ * if a tile has been stored more than once the last record is used. If the file contains more outdated records than current
+ * ones it's rewritten when loaded.
+ *
+ * Since multiple AI clients might use the same file, it's locked for as long as the store exists. A store which
+ * can't get the lock doesn't use the file at all, and only keeps its tiles in memory.
+ */
+class TileCacheStore
+{
+    public:
+        /**
+         * The compressed layers of one tile, as produced by dtBuildTileCacheLayer.
+         */
+        typedef std::vector<std::vector<unsigned char>> Layers;
+
+        /**
+         * @param path The path to the file backing the store. It will be created if it doesn't exist.
+         */
+        explicit TileCacheStore(std::string path);
+
+        ~TileCacheStore();
+
+        TileCacheStore(const TileCacheStore&) = delete;
+
+        TileCacheStore& operator=(const TileCacheStore&) = delete;
+
+        /**
+         * @brief Looks up the layers for a tile.
+         * @param tx The x index of the tile.
+         * @param ty The y index of the tile.
+         * @param hash The hash of the input the tile would be built from.
+         * @return The stored layers, or null if there's no tile stored, or if it was built from other input.
+         */
+        const Layers* find(int tx, int ty, std::uint64_t hash) const;
+
+        /**
+         * @brief Stores the layers of a tile, replacing any earlier layers for the tile.
+         * @param tx The x index of the tile.
+         * @param ty The y index of the tile.
+         * @param hash The hash of the input the tile was built from.
+         * @param layers The compressed layers.
+         */
+        void store(int tx, int ty, std::uint64_t hash, Layers layers);
+
+        size_t size() const
+        {
+            return m_tiles.size();
+        }
+
+        /**
+         * @return True if the store got the lock on the file, and tiles are read from and written to it.
+         */
+        bool isPersistent() const
+        {
+            return m_persistent;
+        }
+
+        /**
+         * @brief Hashes data, using 64 bit FNV-1a.
+         * @param data The data to hash.
+         * @param length The length of the data, in bytes.
+         * @param hash The hash to continue from, allowing multiple calls to be chained.
+         * @return The new hash.
+         */
+        static std::uint64_t hash(const void* data, size_t length, std::uint64_t hash = 14695981039346656037ULL);
+
+    private:
+        struct Entry
+        {
+            std::uint64_t hash;
+            Layers layers;
+        };
+
+        std::string m_path;
+        std::map<std::pair<int, int>, Entry> m_tiles;
+        std::ofstream m_file;
+
+        /**
+         * The descriptor of the lock file, or -1 if not locked.
+         */
+        int m_lockFd;
+        bool m_persistent;
+
+        /**
+         * Takes an exclusive lock on a separate lock file, since the file itself is replaced when compacted.
+         * @return True if the lock was taken.
+         */
+        bool lock();
+
+        /**
+         * Reads all records from the file.
+         * @return True if the file needs to be rewritten, because it's missing, invalid, or mostly contains outdated records.
+         */
+        bool load();
+
+        /**
+         * Writes all current records to a new file, which then replaces the existing one.
+         * @return True if successful.
+         */
+        bool compact();
+
+        /**
+         * Opens the file for appending. The file must already have a header.
+         */
+        void openForAppending();
+
+        static void writeRecord(std::ostream& stream, int tx, int ty, const Entry& entry);
+};
+
+
+#endif //CYPHESIS_TILECACHESTORE_H
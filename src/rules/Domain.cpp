@@ -24,6 +24,13 @@ Domain::Domain(LocatedEntity& entity) : m_entity(entity)
 
 Domain::~Domain() = default;
 
+void Domain::addEntities(const std::vector<LocatedEntity*>& entities)
+{
+    for (auto entity : entities) {
+        addEntity(*entity);
+    }
+}
+
 void Domain::installDelegates(LocatedEntity* entity, const std::string& propertyName)
 {
 }
@@ -27,6 +27,7 @@
 #include <string>
 #include <list>
 #include <set>
+#include <vector>
 #include <boost/optional.hpp>
 
 namespace WFMath {
@@ -108,6 +109,16 @@ class Domain
          */
         virtual void addEntity(LocatedEntity& entity) = 0;
 
+        /**
+         * Adds multiple child entities to this domain at once, such as when the world is restored from storage.
+         *
+         * The result is the same as calling addEntity(...) for each entity in order, but domains can override this to
+         * set up their internal structures in one pass. The default implementation just calls addEntity(...).
+         *
+         * @param entities Child entities, all guaranteed to be direct children of the entity to which the domain belongs.
+         */
+        virtual void addEntities(const std::vector<LocatedEntity*>& entities);
+
         /**
          * Removes a child entity from this domain. The child entity is guaranteed to be a direct child of the entity to which the domain belongs, and to have addEntity(...) being called earlier.
          *
@@ -123,13 +134,14 @@ class Domain
         virtual void getVisibleEntitiesFor(const LocatedEntity& observingEntity, std::list<LocatedEntity*>& entityList) const = 0;
 
         /**
-         * Fills the supplied list with all entities in the domain that are currently observing the supplied entity.
+         * Appends all entities in the domain that are currently observing the supplied entity to the supplied vector.
+         *
+         * The vector isn't cleared, so that observers from multiple domains can be collected into the same vector without any allocations.
          * @param observedEntity The entity which is being observed.
-         * @return A list of entities.
+         * @param entityList A vector of entities, to which observers are appended.
          */
-        virtual std::list<LocatedEntity*> getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+        virtual void getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
         {
-            return std::list<LocatedEntity*>();
         }
 
         /**
@@ -30,6 +30,7 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
 
+#include <algorithm>
 #include <memory>
 
 using Atlas::Objects::Operation::Update;
@@ -202,6 +203,7 @@ PropertyBase* LocatedEntity::setAttr(const std::string& name, const Modifier* mo
             m_properties[name].property = std::move(newProp);
             propNeedsInstalling = true;
         }
+        onPropertyInstanceChanged(name);
     } else {
         prop = I->second.property.get();
     }
@@ -376,6 +378,7 @@ PropertyBase* LocatedEntity::modProperty(const std::string& name, const Atlas::M
             new_prop->removeFlags(prop_flag_class);
             m_properties[name].property.reset(new_prop);
             new_prop->install(this, name);
+            onPropertyInstanceChanged(name);
             applyProperty(name, new_prop);
             return new_prop;
         }
@@ -389,6 +392,7 @@ PropertyBase* LocatedEntity::setProperty(const std::string& name,
     auto p = prop.get();
     m_properties[name].property = std::move(prop);
     p->install(this, name);
+    onPropertyInstanceChanged(name);
     return p;
 }
 
@@ -400,6 +404,10 @@ void LocatedEntity::removeDelegate(int, const std::string&)
 {
 }
 
+void LocatedEntity::onPropertyInstanceChanged(const std::string& name)
+{
+}
+
 /// \brief Called when the container of this entity changes.
 ///
 void LocatedEntity::onContainered(const Ref<LocatedEntity>& new_loc)
@@ -471,6 +479,7 @@ void LocatedEntity::makeContainer()
     if (!m_contains) {
         m_contains = std::make_unique<LocatedEntitySet>();
         m_properties[ContainsProperty::property_name].property = std::make_unique<ContainsProperty>(*m_contains);
+        onPropertyInstanceChanged(ContainsProperty::property_name);
     }
 }
 
@@ -491,9 +500,22 @@ void LocatedEntity::changeContainer(const Ref<LocatedEntity>& new_loc)
 
 void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op, OpVector& res, Visibility visibility) const
 {
-    std::set<const LocatedEntity*> receivers;
+    //Broadcasts are very frequent, so reuse the memory of the receivers between calls.
+    //The buffer is moved out while in use, in case a broadcast somehow would lead to another one.
+    static thread_local std::vector<const LocatedEntity*> receiversBuffer;
+    std::vector<const LocatedEntity*> receivers(std::move(receiversBuffer));
+    receivers.clear();
     collectObservers(receivers);
 
+    //Remove duplicates. Sorting by address gives the same order as when a std::set was used.
+    std::sort(receivers.begin(), receivers.end());
+    receivers.erase(std::unique(receivers.begin(), receivers.end()), receivers.end());
+
+    //All receivers share the same op body, except for the "to" attribute. Set "from" once instead of for each copy.
+    auto templateOp = op.copy();
+    templateOp->setFrom(getId());
+    res.reserve(res.size() + receivers.size());
+
     for (auto& entity : receivers) {
         if (visibility == Visibility::PRIVATE) {
             //Only send private ops to admins
@@ -507,22 +529,28 @@ void LocatedEntity::broadcast(const Atlas::Objects::Operation::RootOperation& op
                 continue;
             }
         }
-        auto newOp = op.copy();
+        auto newOp = templateOp.copy();
         newOp->setTo(entity->getId());
-        newOp->setFrom(getId());
-        res.push_back(newOp);
+        res.push_back(std::move(newOp));
     }
+    receiversBuffer = std::move(receivers);
 }
 
 void LocatedEntity::collectObservers(std::set<const LocatedEntity*>& receivers) const
+{
+    std::vector<const LocatedEntity*> observers;
+    collectObservers(observers);
+    receivers.insert(observers.begin(), observers.end());
+}
+
+void LocatedEntity::collectObservers(std::vector<const LocatedEntity*>& receivers) const
 {
     if (isPerceptive()) {
-        receivers.insert(this);
+        receivers.push_back(this);
     }
     const Domain* domain = getDomain();
     if (domain) {
-        auto observingEntities = domain->getObservingEntitiesFor(*this);
-        receivers.insert(observingEntities.begin(), observingEntities.end());
+        domain->getObservingEntitiesFor(*this, receivers);
     }
     if (m_location.m_parent) {
         m_location.m_parent->collectObserversForChild(*this, receivers);
@@ -539,17 +567,16 @@ void LocatedEntity::collectObserved(std::set<const LocatedEntity*>& observed) co
     }
 }
 
-void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const
+void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const
 {
     const Domain* domain = getDomain();
 
     if (isPerceptive()) {
-        receivers.insert(this);
+        receivers.push_back(this);
     }
 
     if (domain) {
-        auto observingEntities = domain->getObservingEntitiesFor(child);
-        receivers.insert(observingEntities.begin(), observingEntities.end());
+        domain->getObservingEntitiesFor(child, receivers);
     }
     if (m_location.m_parent) {
         //If this entity have a movement domain, check if the child entity is visible to the parent entity (i.e. it's "exposed outside of the domain"). If not, the broadcast chain stops here.
@@ -592,7 +619,9 @@ void LocatedEntity::applyProperty(const std::string& name, PropertyBase* prop)
 {
     // Allow the value to take effect.
     prop->apply(this);
+    // The property needs to be both sent to observers and persisted.
     prop->addFlags(prop_flag_unsent);
+    prop->removeFlags(prop_flag_persistence_clean);
     propertyApplied(name, *prop);
     // Mark the Entity as unclean
     m_flags.removeFlags(entity_clean);
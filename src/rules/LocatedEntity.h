@@ -198,7 +198,14 @@ class LocatedEntity : public Router, public ReferenceCounted
          * @param op
          * @param res
          */
-        void collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const;
+        void collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const;
+
+        /**
+         * Called when the property instance for a name has been installed, replaced or removed.
+         * Subclasses which keep pointers to properties should refresh them here.
+         * @param name The name of the property.
+         */
+        virtual void onPropertyInstanceChanged(const std::string& name);
 
     public:
 
@@ -364,6 +371,8 @@ class LocatedEntity : public Router, public ReferenceCounted
 
         /**
          * Applies the property and set flags on both the property and the entity to mark them as unclean.
+         *
+         * The property will have its prop_flag_persistence_clean flag removed, so that it's written to storage on the next update.
          * @param name
          * @param prop
          */
@@ -375,6 +384,12 @@ class LocatedEntity : public Router, public ReferenceCounted
          */
         void collectObservers(std::set<const LocatedEntity*>& observers) const;
 
+        /**
+         * Collects all entities that are observing this entity, without allocating any new memory if the vector has enough capacity.
+         * @param observers A vector to which observing entities are appended. The same entity might be appended more than once.
+         */
+        void collectObservers(std::vector<const LocatedEntity*>& observers) const;
+
         void collectObserved(std::set<const LocatedEntity*>& observed) const;
 
         /**
@@ -512,6 +527,7 @@ class LocatedEntity : public Router, public ReferenceCounted
                 sp->flags().addFlags(PropertyBase::flagsForPropertyName(name));
                 m_properties[name].property.reset(sp);
                 sp->install(this, name);
+                onPropertyInstanceChanged(name);
                 if (p != nullptr) {
                     log(WARNING, String::compose("Property %1 on entity with id %2 "
                                                  "reinstalled with new class."
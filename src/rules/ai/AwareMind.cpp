@@ -112,7 +112,8 @@ void AwareMind::processMoveTick(const Operation& op, OpVector& res)
     if (mAwareness) {
         auto remainingDirtyTiles = mAwareness->rebuildDirtyTile();
         if (remainingDirtyTiles > 0) {
-            futureTick = 0;
+            //When tiles are built in the background there's no use in checking back immediately.
+            futureTick = mAwareness->isBuildingTilesInBackground() ? 0.05 : 0;
         } else {
             if (mAwareness->needsPruning()) {
                 mAwareness->pruneTiles();
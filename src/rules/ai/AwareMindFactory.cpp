@@ -21,16 +21,20 @@
 
 #include "AwareMindFactory.h"
 #include "AwareMind.h"
+#include "common/JobQueue.h"
 
 
-AwareMindFactory::AwareMindFactory(const PropertyManager& propertyManager)
+AwareMindFactory::AwareMindFactory(const PropertyManager& propertyManager, size_t navmeshThreads, std::string navmeshCacheDirectory)
         : mPropertyManager(propertyManager),
           mSharedTerrain(new SharedTerrain()),
-          mAwarenessStoreProvider(new AwarenessStoreProvider(*mSharedTerrain))
+          mTileBuildQueue(navmeshThreads > 0 ? new JobQueue(navmeshThreads) : nullptr),
+          mAwarenessStoreProvider(new AwarenessStoreProvider(*mSharedTerrain, mTileBuildQueue.get(), std::move(navmeshCacheDirectory)))
 {
 
 }
 
+AwareMindFactory::~AwareMindFactory() = default;
+
 BaseMind* AwareMindFactory::newMind(const std::string& mind_id, const std::string& entity_id) const
 {
     return new AwareMind(mind_id, entity_id, mPropertyManager, *mSharedTerrain, *mAwarenessStoreProvider);
@@ -27,19 +27,29 @@
 
 class AwarenessStore;
 class PropertyManager;
+class JobQueue;
 
 class AwareMindFactory : public MindKit
 {
     public:
-        explicit AwareMindFactory(const PropertyManager& propertyManager);
+        /**
+         * @param propertyManager The property manager.
+         * @param navmeshThreads The number of threads used for building navmesh tiles in the background. If 0 tiles are built on the main thread.
+         * @param navmeshCacheDirectory If not empty, built navmesh tiles are stored in this directory and reused after restarts.
+         */
+        explicit AwareMindFactory(const PropertyManager& propertyManager, size_t navmeshThreads = 0, std::string navmeshCacheDirectory = "");
 
-        ~AwareMindFactory() override = default;
+        ~AwareMindFactory() override;
 
         BaseMind* newMind(const std::string& mind_id, const std::string& entity_id) const override;
 
     protected:
         const PropertyManager& mPropertyManager;
         std::unique_ptr<SharedTerrain> mSharedTerrain;
+        /**
+         * Declared before the awareness stores, so that it outlives them.
+         */
+        std::unique_ptr<JobQueue> mTileBuildQueue;
         std::unique_ptr<AwarenessStoreProvider> mAwarenessStoreProvider;
 
 };
@@ -20,16 +20,20 @@
 #endif
 
 #include "navigation/Awareness.h"
+#include "navigation/TileCacheStore.h"
 #include "rules/LocatedEntity.h"
 
 #include "AwarenessStore.h"
 
-AwarenessStore::AwarenessStore(float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, int tileSize) :
+AwarenessStore::AwarenessStore(float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, int tileSize, JobQueue* tileBuildQueue,
+                               std::string tileCachePathPrefix) :
     mAgentRadius(agentRadius),
     mAgentHeight(agentHeight),
     mStepHeight(stepHeight),
     mHeightProvider(heightProvider),
-    mTileSize(tileSize)
+    mTileSize(tileSize),
+    mTileBuildQueue(tileBuildQueue),
+    mTileCachePathPrefix(std::move(tileCachePathPrefix))
 {
 }
 
@@ -48,7 +52,12 @@ std::shared_ptr<Awareness> AwarenessStore::requestAwareness(const LocatedEntity&
 
     auto bbox = domainEntity.m_location.bBox();
 
-    auto awareness = std::make_shared<Awareness>(domainEntity, mAgentRadius, mAgentHeight, mStepHeight, mHeightProvider, bbox, mTileSize);
+    std::shared_ptr<TileCacheStore> tileCacheStore;
+    if (!mTileCachePathPrefix.empty()) {
+        tileCacheStore = std::make_shared<TileCacheStore>(mTileCachePathPrefix + "_" + domainEntity.getId() + ".tiles");
+    }
+
+    auto awareness = std::make_shared<Awareness>(domainEntity, mAgentRadius, mAgentHeight, mStepHeight, mHeightProvider, bbox, mTileSize, mTileBuildQueue, tileCacheStore);
     m_awarenesses.insert(std::make_pair(domainEntity.getIntId(), std::weak_ptr<Awareness>(awareness)));
     return awareness;
 }
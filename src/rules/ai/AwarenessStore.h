@@ -29,9 +29,18 @@ struct IHeightProvider;
 
 class Awareness;
 
-class LocatedEntity;
+class JobQueue;
 
+class LocatedEntity;
 
+/**
+ * @brief Keeps track of the awarenesses for one agent profile, sharing them between all minds using the same domain.
+ *
+ * Neither this class nor the awarenesses it hands out are thread safe; they must only be used from the thread
+ * which runs the minds. Only the rasterization of navmesh tiles is done on other threads, and Awareness takes care
+ * of copying the data needed for that. To use more cores for the AI, run more AI client processes (see the
+ * "aiclients" option); each process has its own awareness stores.
+ */
 class AwarenessStore
 {
     public:
@@ -39,7 +48,9 @@ class AwarenessStore
                        float agentHeight,
                        float stepHeight,
                        IHeightProvider& heightProvider,
-                       int tileSize = 64);
+                       int tileSize = 64,
+                       JobQueue* tileBuildQueue = nullptr,
+                       std::string tileCachePathPrefix = "");
 
         virtual ~AwarenessStore() = default;
 
@@ -58,6 +69,16 @@ class AwarenessStore
 
         int mTileSize;
 
+        /**
+         * @brief An optional queue for building navmesh tiles in the background.
+         */
+        JobQueue* mTileBuildQueue;
+
+        /**
+         * @brief If not empty, built tiles are stored persistently in a file per domain, with a path starting with this prefix.
+         */
+        std::string mTileCachePathPrefix;
+
         /**
          * @brief A map of existing awarenesses, ordered by the id of the domain entity.
          */
@@ -23,6 +23,7 @@
 #include "common/TypeNode.h"
 #include "common/debug.h"
 #include "common/Property.h"
+#include "common/compose.hpp"
 
 #include <wfmath/ball.h>
 #include <wfmath/atlasconv.h>
@@ -30,8 +31,10 @@
 static const bool debug_flag = false;
 
 
-AwarenessStoreProvider::AwarenessStoreProvider(IHeightProvider& heightProvider)
-        : m_heightProvider(heightProvider)
+AwarenessStoreProvider::AwarenessStoreProvider(IHeightProvider& heightProvider, JobQueue* tileBuildQueue, std::string tileCacheDirectory)
+        : m_heightProvider(heightProvider),
+          m_tileBuildQueue(tileBuildQueue),
+          m_tileCacheDirectory(std::move(tileCacheDirectory))
 {
 }
 
@@ -68,7 +71,13 @@ AwarenessStore& AwarenessStoreProvider::getStore(const TypeNode* type, int tileS
         }
     }
 
-    return m_awarenessStores.emplace(type->name(), AwarenessStore(agentRadius, (float) agentHeight, stepHeight, m_heightProvider, tileSize)).first->second;
+    //Each agent profile gets its own tile cache files, since the tiles depend on the size of the agent.
+    std::string tileCachePathPrefix;
+    if (!m_tileCacheDirectory.empty()) {
+        tileCachePathPrefix = String::compose("%1/%2_%3", m_tileCacheDirectory, type->name(), tileSize);
+    }
+
+    return m_awarenessStores.emplace(type->name(), AwarenessStore(agentRadius, (float) agentHeight, stepHeight, m_heightProvider, tileSize, m_tileBuildQueue, tileCachePathPrefix)).first->second;
 
 }
 
@@ -29,10 +29,17 @@ class TypeNode;
 
 struct IHeightProvider;
 
+class JobQueue;
+
 class AwarenessStoreProvider
 {
     public:
-        explicit AwarenessStoreProvider(IHeightProvider& heightProvider);
+        /**
+         * @param heightProvider A height provider, used for getting terrain height data.
+         * @param tileBuildQueue An optional queue on which navmesh tiles are built in the background.
+         * @param tileCacheDirectory If not empty, built navmesh tiles are stored in this directory, and reused when the same tiles are needed again.
+         */
+        explicit AwarenessStoreProvider(IHeightProvider& heightProvider, JobQueue* tileBuildQueue = nullptr, std::string tileCacheDirectory = "");
 
         virtual ~AwarenessStoreProvider() = default;
 
@@ -41,6 +48,8 @@ class AwarenessStoreProvider
     protected:
         std::unordered_map<std::string, AwarenessStore> m_awarenessStores;
         IHeightProvider& m_heightProvider;
+        JobQueue* m_tileBuildQueue;
+        std::string m_tileCacheDirectory;
 
 };
 
@@ -159,33 +159,35 @@ void BaseMind::SightOperation(const Operation& op, OpVector& res)
         debug_print(" no args!");
         return;
     }
-    const Root& arg = args.front();
-    Operation op2(Atlas::Objects::smart_dynamic_cast<Operation>(arg));
-    if (op2.isValid()) {
-        debug_print(String::compose(" args is an op (%1)!", op2->getParent()));
-        std::string event_name("sight_");
-        event_name += op2->getParent();
-
-        //Check that the argument had seconds set; if not the timestamp of the updates will be wrong.
-        if (!op2->hasAttrFlag(Atlas::Objects::Operation::SECONDS_FLAG)) {
-            //Copy from wrapping op to fix this. This indicates an error in the server.
-            op2->setSeconds(op->getSeconds());
-            log(WARNING, String::compose("Sight op argument ('%1') had no seconds set.", op2->getParent()));
-        }
+    //Batched sights (such as movement updates from a physical domain) can contain more than one arg.
+    for (const Root& arg : args) {
+        Operation op2(Atlas::Objects::smart_dynamic_cast<Operation>(arg));
+        if (op2.isValid()) {
+            debug_print(String::compose(" args is an op (%1)!", op2->getParent()));
+            std::string event_name("sight_");
+            event_name += op2->getParent();
+
+            //Check that the argument had seconds set; if not the timestamp of the updates will be wrong.
+            if (!op2->hasAttrFlag(Atlas::Objects::Operation::SECONDS_FLAG)) {
+                //Copy from wrapping op to fix this. This indicates an error in the server.
+                op2->setSeconds(op->getSeconds());
+                log(WARNING, String::compose("Sight op argument ('%1') had no seconds set.", op2->getParent()));
+            }
 
-        if (!m_script || m_script->operation(event_name, op2, res) != OPERATION_BLOCKED) {
-            callSightOperation(op2, res);
-        }
-    } else /* if (op2->getObjtype() == "object") */ {
-        RootEntity ent(Atlas::Objects::smart_dynamic_cast<RootEntity>(arg));
-        if (!ent.isValid()) {
-            log(ERROR, "Arg of sight operation is not an op or an entity");
-            return;
-        }
-        debug_print(" arg is an entity!");
-        auto me = m_map.updateAdd(ent, op->getSeconds());
-        if (me) {
-            me->setVisible();
+            if (!m_script || m_script->operation(event_name, op2, res) != OPERATION_BLOCKED) {
+                callSightOperation(op2, res);
+            }
+        } else /* if (op2->getObjtype() == "object") */ {
+            RootEntity ent(Atlas::Objects::smart_dynamic_cast<RootEntity>(arg));
+            if (!ent.isValid()) {
+                log(ERROR, "Arg of sight operation is not an op or an entity");
+                continue;
+            }
+            debug_print(" arg is an entity!");
+            auto me = m_map.updateAdd(ent, op->getSeconds());
+            if (me) {
+                me->setVisible();
+            }
         }
     }
 }
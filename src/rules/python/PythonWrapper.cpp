@@ -17,6 +17,7 @@
 
 
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include "PythonWrapper.h"
 #include "CyPy_Operation.h"
 #include "CyPy_Oplist.h"
@@ -31,17 +32,29 @@
 
 static const bool debug_flag = false;
 
+bool PythonWrapper::s_deferPropertyUpdates = false;
+std::vector<PythonWrapper*> PythonWrapper::s_pendingPropertyUpdateWrappers;
+std::vector<PythonWrapper*> PythonWrapper::s_flushingPropertyUpdateWrappers;
+
+namespace {
+    /// \brief Whether each script class has handlers for operations, keyed by class and then by operation name.
+    ///
+    /// A reference is held to each class, so that its address isn't reused by another class while cached.
+    /// Raw pointers are used since the map outlives the Python interpreter.
+    std::unordered_map<PyObject*, std::unordered_map<std::string, bool>> s_classOperationHandlers;
+}
+
 /// \brief PythonWrapper constructor
 PythonWrapper::PythonWrapper(const Py::Object& wrapper)
-        : m_wrapper(wrapper)
+        : m_wrapper(wrapper),
+          m_propertyUpdateEntity(nullptr)
 {
 }
 
 PythonWrapper::~PythonWrapper()
 {
-    for (auto& connection : m_propertyUpdateConnections) {
-        connection.disconnect();
-    }
+    m_propertyUpdateConnection.disconnect();
+    cancelPendingPropertyUpdates();
 }
 
 
@@ -50,25 +63,32 @@ HandlerResult PythonWrapper::operation(const std::string& op_type,
                                        OpVector& res)
 {
     assert(!m_wrapper.isNull());
-    std::string op_name = op_type + "_operation";
-    debug_print("Got script " << this->m_wrapper.type().str() << " on object " << this->m_wrapper.str() << " for " << op_name);
-    if (!m_wrapper.hasAttr(op_name)) {
-        debug_print("No method to be found for " << op_name);
-        return OPERATION_IGNORED;
+    debug_print("Got script " << this->m_wrapper.type().str() << " on object " << this->m_wrapper.str() << " for " << op_type);
+    auto handlerI = m_operationHandlers.find(op_type);
+    if (handlerI == m_operationHandlers.end()) {
+        if (!hasOperationHandler(op_type)) {
+            debug_print("No method to be found for " << op_type);
+            return OPERATION_IGNORED;
+        }
+        handlerI = m_operationHandlers.emplace(op_type, OperationHandler{op_type + "_operation", Py::Object()}).first;
     }
+    auto& handler = handlerI->second;
 
     try {
+        if (handler.method.isNull()) {
+            handler.method = m_wrapper.getAttr(handler.name);
+        }
         PythonLogGuard logGuard([this, op_type]() {
             return String::compose("%1, %2: ", this->m_wrapper.str(), op_type);
         });
-        auto ret = m_wrapper.callMemberFunction(op_name, Py::TupleN(CyPy_Operation::wrap(op)));
+        auto ret = Py::Callable(handler.method).apply(Py::TupleN(CyPy_Operation::wrap(op)));
 
-        debug_print("Called python method " << op_name);
-        return processScriptResult(op_name, ret, res);
+        debug_print("Called python method " << handler.name);
+        return processScriptResult(handler.name, ret, res);
 
     } catch (const Py::BaseException& py_ex) {
         log(ERROR, String::compose("Python error calling \"%1\" on " +
-                                   m_wrapper.as_string(), op_name));
+                                   m_wrapper.as_string(), handler.name));
         if (PyErr_Occurred()) {
             PyErr_Print();
         }
@@ -83,48 +103,134 @@ HandlerResult PythonWrapper::operation(const std::string& op_type,
     }
 }
 
+bool PythonWrapper::hasOperationHandler(const std::string& op_type) const
+{
+    auto type = reinterpret_cast<PyObject*>(Py_TYPE(m_wrapper.ptr()));
+    auto classI = s_classOperationHandlers.find(type);
+    if (classI == s_classOperationHandlers.end()) {
+        Py_INCREF(type);
+        classI = s_classOperationHandlers.emplace(type, std::unordered_map<std::string, bool>()).first;
+    }
+    auto& handlers = classI->second;
+    auto I = handlers.find(op_type);
+    if (I == handlers.end()) {
+        I = handlers.emplace(op_type, m_wrapper.hasAttr(op_type + "_operation")).first;
+    }
+    return I->second;
+}
+
+void PythonWrapper::clearOperationHandlerCache()
+{
+    for (auto& entry : s_classOperationHandlers) {
+        Py_DECREF(entry.first);
+    }
+    s_classOperationHandlers.clear();
+}
+
 void PythonWrapper::attachPropertyCallbacks(LocatedEntity& entity)
 {
+    m_propertyUpdateConnection.disconnect();
+    cancelPendingPropertyUpdates();
+    m_propertyUpdateCallbacks.clear();
+    m_propertyUpdateEntity = &entity;
+
     auto list = m_wrapper.dir();
     for (int i = 0; i < list.size(); ++i) {
         auto fieldName = list[i].str().as_string();
         //Look for fields named "<something>_property_update". These are methods that should be called when that property changes.
         if (boost::algorithm::ends_with(fieldName, "_property_update")) {
             auto propertyName = fieldName.substr(0, fieldName.length() - 16);
-            auto connection = entity.propertyApplied.connect([this, fieldName, propertyName, &entity](const std::string& changedPropertyName, const PropertyBase& property) {
-                if (propertyName == changedPropertyName) {
-                    try {
-                        PythonLogGuard logGuard([this, fieldName]() {
-                            return String::compose("%1, %2: ", this->m_wrapper.str(), fieldName);
-                        });
-                        OpVector res;
-                        auto ret = m_wrapper.callMemberFunction(fieldName);
-                        //Ignore Handler result; it does nothing in this context. But process any ops.
-                        processScriptResult(fieldName, ret, res);
-                        for (auto& resOp: res) {
-                            if (resOp->getClassNo() == Atlas::Objects::Operation::SET_NO && !resOp->isDefaultTo() && resOp->getTo() == entity.getId()) {
-                                //Handle any Set ops to the own entity directly here, so Set ops that affect multiple properties become atomic.
-                                //TODO: how to make sure there's no endless loops here when different properties affect each others?
-                                if (!resOp->getArgs().empty()) {
-                                    entity.merge(resOp->getArgs().front()->asMessage());
-                                }
-                            } else {
-                                entity.sendWorld(resOp);
-                            }
-                        }
-                    } catch (const Py::BaseException& py_ex) {
-                        log(ERROR, String::compose("Could not call property update function %1 on %2 for entity %3", fieldName, m_wrapper.str(), entity.describeEntity()));
-                        if (PyErr_Occurred()) {
-                            PyErr_Print();
-                        }
-                    }
+            m_propertyUpdateCallbacks.emplace(std::move(propertyName), std::move(fieldName));
+        }
+    }
+
+    if (!m_propertyUpdateCallbacks.empty()) {
+        //Use one connection for all callbacks, so that each property change only costs one lookup.
+        m_propertyUpdateConnection = entity.propertyApplied.connect([this](const std::string& changedPropertyName, const PropertyBase& property) {
+            auto I = m_propertyUpdateCallbacks.find(changedPropertyName);
+            if (I == m_propertyUpdateCallbacks.end()) {
+                return;
+            }
+            if (s_deferPropertyUpdates) {
+                if (m_pendingPropertyUpdates.empty()) {
+                    s_pendingPropertyUpdateWrappers.push_back(this);
+                }
+                if (std::find(m_pendingPropertyUpdates.begin(), m_pendingPropertyUpdates.end(), I->second) == m_pendingPropertyUpdates.end()) {
+                    m_pendingPropertyUpdates.push_back(I->second);
+                }
+            } else {
+                callPropertyUpdate(I->second);
+            }
+        });
+    }
+}
+
+void PythonWrapper::callPropertyUpdate(const std::string& fieldName)
+{
+    auto& entity = *m_propertyUpdateEntity;
+    try {
+        PythonLogGuard logGuard([this, fieldName]() {
+            return String::compose("%1, %2: ", this->m_wrapper.str(), fieldName);
+        });
+        OpVector res;
+        auto ret = m_wrapper.callMemberFunction(fieldName);
+        //Ignore Handler result; it does nothing in this context. But process any ops.
+        processScriptResult(fieldName, ret, res);
+        for (auto& resOp: res) {
+            if (resOp->getClassNo() == Atlas::Objects::Operation::SET_NO && !resOp->isDefaultTo() && resOp->getTo() == entity.getId()) {
+                //Handle any Set ops to the own entity directly here, so Set ops that affect multiple properties become atomic.
+                //TODO: how to make sure there's no endless loops here when different properties affect each others?
+                if (!resOp->getArgs().empty()) {
+                    entity.merge(resOp->getArgs().front()->asMessage());
                 }
-            });
-            m_propertyUpdateConnections.emplace_back(connection);
+            } else {
+                entity.sendWorld(resOp);
+            }
         }
+    } catch (const Py::BaseException& py_ex) {
+        log(ERROR, String::compose("Could not call property update function %1 on %2 for entity %3", fieldName, m_wrapper.str(), entity.describeEntity()));
+        if (PyErr_Occurred()) {
+            PyErr_Print();
+        }
+    }
+}
+
+void PythonWrapper::cancelPendingPropertyUpdates()
+{
+    if (!m_pendingPropertyUpdates.empty()) {
+        m_pendingPropertyUpdates.clear();
+        s_pendingPropertyUpdateWrappers.erase(std::remove(s_pendingPropertyUpdateWrappers.begin(), s_pendingPropertyUpdateWrappers.end(), this),
+                                              s_pendingPropertyUpdateWrappers.end());
     }
+    std::replace(s_flushingPropertyUpdateWrappers.begin(), s_flushingPropertyUpdateWrappers.end(), this, static_cast<PythonWrapper*>(nullptr));
 }
 
+void PythonWrapper::flushPropertyUpdates()
+{
+    //Only handle the wrappers which are pending now; any callbacks triggered for wrappers
+    //which already have been handled are left for the next flush, to prevent endless loops.
+    s_flushingPropertyUpdateWrappers.swap(s_pendingPropertyUpdateWrappers);
+    for (size_t i = 0; i < s_flushingPropertyUpdateWrappers.size(); ++i) {
+        auto wrapper = s_flushingPropertyUpdateWrappers[i];
+        //The wrapper might have been destroyed by an earlier callback.
+        if (!wrapper) {
+            continue;
+        }
+        std::vector<std::string> fieldNames;
+        fieldNames.swap(wrapper->m_pendingPropertyUpdates);
+        for (auto& fieldName : fieldNames) {
+            if (wrapper->m_propertyUpdateEntity->isDestroyed()) {
+                break;
+            }
+            wrapper->callPropertyUpdate(fieldName);
+            //The callback might have destroyed the wrapper.
+            if (!s_flushingPropertyUpdateWrappers[i]) {
+                break;
+            }
+        }
+    }
+    s_flushingPropertyUpdateWrappers.clear();
+}
 
 void PythonWrapper::hook(const std::string& function,
                          LocatedEntity* entity,
@@ -22,6 +22,7 @@
 #include "rules/Script.h"
 #include "pycxx/CXX/Objects.hxx"
 #include <sigc++/connection.h>
+#include <unordered_map>
 
 /// \brief A Python script wrapping a C++ class.
 /// \ingroup Scripts
@@ -30,7 +31,54 @@ class PythonWrapper : public Script
     protected:
         /// \brief Python object that wraps the entity.
         Py::Object m_wrapper;
-        std::vector<sigc::connection> m_propertyUpdateConnections;
+
+        /// \brief The single connection to the propertyApplied signal of the entity, if the script has any property update callbacks.
+        sigc::connection m_propertyUpdateConnection;
+
+        /// \brief The entity the property update callbacks are attached to.
+        LocatedEntity* m_propertyUpdateEntity;
+
+        /// \brief The "<property>_property_update" methods of the script, keyed by property name.
+        std::unordered_map<std::string, std::string> m_propertyUpdateCallbacks;
+
+        /// \brief Property update methods waiting to be called by flushPropertyUpdates(), in the order they were triggered.
+        ///
+        /// Each method is only present once, no matter how many times the property was changed.
+        std::vector<std::string> m_pendingPropertyUpdates;
+
+        /// \brief Wrappers with pending property updates.
+        static std::vector<PythonWrapper*> s_pendingPropertyUpdateWrappers;
+
+        /// \brief Wrappers whose property updates are being called by flushPropertyUpdates().
+        ///
+        /// Wrappers which are destroyed during the flush are replaced with null.
+        static std::vector<PythonWrapper*> s_flushingPropertyUpdateWrappers;
+
+        /// \brief Calls a property update method, and handles the resulting ops.
+        void callPropertyUpdate(const std::string& fieldName);
+
+        /// \brief Discards any pending property updates.
+        void cancelPendingPropertyUpdates();
+
+        /// \brief A bound operation handler method.
+        struct OperationHandler
+        {
+            /// \brief The name of the method, such as "look_operation".
+            std::string name;
+            Py::Object method;
+        };
+
+        /// \brief Handler methods for the operations seen so far, keyed by operation name.
+        ///
+        /// Only operations which the script class has handlers for are stored here.
+        std::unordered_map<std::string, OperationHandler> m_operationHandlers;
+
+        /// \brief Checks if the script class has a handler for the operation.
+        ///
+        /// The result is cached per script class, so that operations which aren't handled are cheap to ignore.
+        /// Handlers are looked up on the class, so handlers added to script instances after they are created are ignored.
+        bool hasOperationHandler(const std::string& op_type) const;
+
     public:
         explicit PythonWrapper(const Py::Object& wrapper);
 
@@ -46,6 +94,23 @@ class PythonWrapper : public Script
 
         static HandlerResult processScriptResult(const std::string& scriptName, const Py::Object& ret, OpVector& res);
 
+        /// \brief Clears the cache of which operations each script class handles.
+        ///
+        /// This must be called when scripts are reloaded, since the classes then might have changed.
+        static void clearOperationHandlerCache();
+
+        /// \brief If true, property update callbacks aren't called directly but deferred until flushPropertyUpdates() is called.
+        ///
+        /// This means that a callback is called once, even if its property is changed by many ops.
+        static bool s_deferPropertyUpdates;
+
+        /// \brief Calls all deferred property update callbacks.
+        ///
+        /// Only the wrappers which are pending when the flush starts are handled. Property changes made by the callbacks are
+        /// handled in the same flush only if they are for one of those wrappers whose callbacks haven't been called yet;
+        /// all others, including changes to the entity whose callback made them, are deferred until the next flush.
+        static void flushPropertyUpdates();
+
 
         /// \brief Accessor for the python object that wraps the entity.
         const Py::Object& wrapper() const
@@ -34,6 +34,7 @@
 #include "rules/python/CyPy_Physics.h"
 #include "rules/simulation/python/CyPy_Server.h"
 #include "rules/python/WrapperBase.h"
+#include "rules/python/PythonWrapper.h"
 
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Anonymous.h>
@@ -219,6 +220,8 @@ namespace {
                 }
 
             }
+            //The reloaded modules contain new classes, which might handle other operations.
+            PythonWrapper::clearOperationHandlerCache();
             python_reload_scripts();
             changedPaths.clear();
         }
@@ -345,6 +348,7 @@ void init_python_api(std::vector<std::function<std::string()>> initFunctions, st
 
 void shutdown_python_api()
 {
+    PythonWrapper::clearOperationHandlerCache();
 
     Py_Finalize();
 }
@@ -151,6 +151,9 @@ class BaseWorld : public Singleton<BaseWorld>
 
         /// \brief Signal that an operation is being dispatched.
         sigc::signal<void, Atlas::Objects::Operation::RootOperation> Dispatching;
+
+        /// \brief Signal that an operation has been delivered to its destination.
+        sigc::signal<void> Dispatched;
 };
 
 #endif // RULESETS_BASE_WORLD_H
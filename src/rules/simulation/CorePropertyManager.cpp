@@ -186,6 +186,16 @@ CorePropertyManager::CorePropertyManager(Inheritance& inheritance)
      */
     installProperty<BoolProperty>("water_body");
 
+    /**
+     * Selects how a physical domain keeps track of what each entity can see; either "bullet" (the default) or "grid".
+     */
+    installProperty<Property<std::string>>("visibility_backend");
+
+    /**
+     * If set to 1 a physical domain merges all movement seen by an observer during a tick into one Sight op.
+     */
+    installProperty<BoolProperty>("batch_move_sights");
+
     installProperty<PerceptionSightProperty>();
 
     /**
@@ -62,7 +62,8 @@ std::unordered_map<const TypeNode*, std::unique_ptr<int>> Entity::s_monitorsMap;
 
 /// \brief Entity constructor
 Entity::Entity(const std::string& id, long intId) :
-        LocatedEntity(id, intId)
+        LocatedEntity(id, intId),
+        m_delegatesTypeRevision(0)
 {
 }
 
@@ -80,6 +81,7 @@ Entity::~Entity()
 void Entity::setType(const TypeNode* t)
 {
     LocatedEntity::setType(t);
+    resolveDelegates();
 
     if (t) {
         auto I = s_monitorsMap.find(t);
@@ -152,17 +154,50 @@ void Entity::addToEntity(const RootEntity& ent) const
 /// @param delegate The name of the property to delegate it to.
 void Entity::installDelegate(int class_no, const std::string& delegate)
 {
-    m_delegates.insert(std::make_pair(class_no, delegate));
+    m_delegates.insert(std::make_pair(class_no, Delegate{delegate, findDelegateProperty(delegate)}));
 }
 
 void Entity::removeDelegate(int class_no, const std::string& delegate)
 {
     auto I = m_delegates.find(class_no);
-    if (I != m_delegates.end() && I->second == delegate) {
+    if (I != m_delegates.end() && I->second.name == delegate) {
         m_delegates.erase(I);
     }
 }
 
+PropertyBase* Entity::findDelegateProperty(const std::string& name) const
+{
+    auto I = m_properties.find(name);
+    if (I != m_properties.end()) {
+        return I->second.property.get();
+    } else if (m_type != nullptr) {
+        auto J = m_type->defaults().find(name);
+        if (J != m_type->defaults().end()) {
+            return J->second.get();
+        }
+    }
+    return nullptr;
+}
+
+void Entity::resolveDelegates()
+{
+    for (auto& entry : m_delegates) {
+        entry.second.property = findDelegateProperty(entry.second.name);
+    }
+    if (m_type) {
+        m_delegatesTypeRevision = m_type->defaultsRevision();
+    }
+}
+
+void Entity::onPropertyInstanceChanged(const std::string& name)
+{
+    for (auto& entry : m_delegates) {
+        if (entry.second.name == name) {
+            entry.second.property = findDelegateProperty(name);
+        }
+    }
+}
+
 /// \brief Destroy this entity
 ///
 /// Do the jobs required to remove this entity from the world. Handles
@@ -325,9 +360,18 @@ void Entity::operation(const Operation& op, OpVector& res)
         }
     }
 
+    //The type defaults might have been replaced since the delegates were resolved.
+    if (m_type && m_type->defaultsRevision() != m_delegatesTypeRevision) {
+        resolveDelegates();
+    }
+
     auto J = m_delegates.equal_range(op->getClassNo());
     for (; J.first != J.second; ++J.first) {
-        HandlerResult hr_call = callDelegate(J.first->second, op, res);
+        auto property = J.first->second.property;
+        if (!property) {
+            continue;
+        }
+        HandlerResult hr_call = property->operation(this, op, res);
         //We'll record the most blocking of the different results only.
         if (hr != OPERATION_BLOCKED) {
             if (hr_call != OPERATION_IGNORED) {
@@ -361,16 +405,7 @@ HandlerResult Entity::callDelegate(const std::string& name,
                                    const Operation& op,
                                    OpVector& res)
 {
-    PropertyBase* p = nullptr;
-    auto I = m_properties.find(name);
-    if (I != m_properties.end()) {
-        p = I->second.property.get();
-    } else if (m_type != nullptr) {
-        auto J = m_type->defaults().find(name);
-        if (J != m_type->defaults().end()) {
-            p = J->second.get();
-        }
-    }
+    auto p = findDelegateProperty(name);
     if (p != nullptr) {
         return p->operation(this, op, res);
     }
@@ -38,8 +38,23 @@ class Entity : public LocatedEntity
 {
     protected:
 
-        /// Map of delegate properties.
-        std::multimap<int, std::string> m_delegates;
+        /// \brief A property which operations are delegated to.
+        struct Delegate
+        {
+            /// The name of the property.
+            std::string name;
+            /// The property, either an instance property or a default of the type. Null if there's no such property.
+            PropertyBase* property;
+        };
+
+        /// Map of delegate properties, keyed by operation class number.
+        ///
+        /// The properties are resolved when the delegate is installed, and refreshed when
+        /// property instances or the type change, so that no lookups are needed when handling operations.
+        std::multimap<int, Delegate> m_delegates;
+
+        /// The revision of the type defaults that the delegates were resolved against.
+        unsigned int m_delegatesTypeRevision;
 
         /// A static map tracking the number of existing entities per type.
         /// A monitor by the name of "entity_count{type=*}" will be created
@@ -48,6 +63,14 @@ class Entity : public LocatedEntity
 
         std::unique_ptr<Domain> m_domain;
 
+        /// \brief Finds the property with the name, looking first among the instance properties and then among the type defaults.
+        PropertyBase* findDelegateProperty(const std::string& name) const;
+
+        /// \brief Resolves the properties of all delegates again.
+        void resolveDelegates();
+
+        void onPropertyInstanceChanged(const std::string& name) override;
+
 
     public:
         explicit Entity(const std::string& id, long intId);
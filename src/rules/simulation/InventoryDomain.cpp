@@ -124,11 +124,9 @@ void InventoryDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity
     }
 }
 
-std::list<LocatedEntity*> InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void InventoryDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    std::list<LocatedEntity*> list;
-    list.push_back(&m_entity);
-    return list;
+    entityList.push_back(&m_entity);
 }
 
 bool InventoryDomain::isEntityReachable(const LocatedEntity& reachingEntity, float reach, const LocatedEntity& queriedEntity, const WFMath::Point<3>& positionOnQueriedEntity) const
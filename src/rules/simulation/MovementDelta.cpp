@@ -0,0 +1,107 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "MovementDelta.h"
+
+#include <cmath>
+
+constexpr double MovementDelta::POSITION_SCALE;
+constexpr double MovementDelta::VELOCITY_SCALE;
+constexpr double MovementDelta::ORIENTATION_SCALE;
+constexpr double MovementDelta::ANGULAR_SCALE;
+
+namespace {
+    template<size_t N>
+    void writeValues(Atlas::Message::ListType& list, const std::array<Atlas::Message::IntType, N>& values)
+    {
+        for (auto value : values) {
+            list.emplace_back(value);
+        }
+    }
+
+    template<size_t N>
+    bool readValues(const Atlas::Message::ListType& list, size_t& index, std::array<Atlas::Message::IntType, N>& values)
+    {
+        if (index + N > list.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            auto& element = list[index++];
+            if (!element.isInt()) {
+                return false;
+            }
+            values[i] = element.Int();
+        }
+        return true;
+    }
+}
+
+Atlas::Message::IntType MovementDelta::quantize(double value, double scale)
+{
+    return static_cast<Atlas::Message::IntType>(std::llround(value * scale));
+}
+
+void MovementDelta::write(Atlas::Message::ListType& list, bool keyframe) const
+{
+    int writtenFlags = flags & ~KEYFRAME;
+    if (keyframe) {
+        //A keyframe is only of use if it contains the position.
+        writtenFlags |= KEYFRAME | POSITION;
+    }
+    list.emplace_back(static_cast<Atlas::Message::IntType>(entityId));
+    list.emplace_back(static_cast<Atlas::Message::IntType>(sequence));
+    list.emplace_back(static_cast<Atlas::Message::IntType>(writtenFlags));
+    if (writtenFlags & POSITION) {
+        writeValues(list, keyframe ? position : positionDelta);
+    }
+    if (flags & VELOCITY) {
+        writeValues(list, velocity);
+    }
+    if (flags & ORIENTATION) {
+        writeValues(list, orientation);
+    }
+    if (flags & ANGULAR) {
+        writeValues(list, angular);
+    }
+}
+
+bool MovementDelta::read(const Atlas::Message::ListType& list, size_t& index, MovementDelta& record)
+{
+    std::array<Atlas::Message::IntType, 3> header{};
+    if (!readValues(list, index, header)) {
+        return false;
+    }
+    record.entityId = header[0];
+    record.sequence = header[1];
+    record.flags = static_cast<int>(header[2]);
+    if (record.flags & POSITION) {
+        if (!readValues(list, index, (record.flags & KEYFRAME) ? record.position : record.positionDelta)) {
+            return false;
+        }
+    }
+    if ((record.flags & VELOCITY) && !readValues(list, index, record.velocity)) {
+        return false;
+    }
+    if ((record.flags & ORIENTATION) && !readValues(list, index, record.orientation)) {
+        return false;
+    }
+    if ((record.flags & ANGULAR) && !readValues(list, index, record.angular)) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef CYPHESIS_MOVEMENTDELTA_H
+#define CYPHESIS_MOVEMENTDELTA_H
+
+#include <Atlas/Message/Element.h>
+
+#include <array>
+
+/**
+ * @brief A compact movement update, sent to clients which have negotiated the "movement_delta" capability.
+ *
+ * Instead of sending one Set op per moved entity, with the location data as named float attributes, all movement
+ * updates seen by an observer during a tick are written as records into one flat list of integers. The list is sent
+ * as the "movement_delta" attribute of the arg of a single Set op.
+ *
+ * Each record starts with the int id of the entity, a sequence number and a bit field of flags. It is followed by
+ * the fields named by the flags, in this order:
+ * - POSITION: x, y, z, in 1/POSITION_SCALE meters. If KEYFRAME is set these are absolute values, otherwise they are
+ *   deltas relative to the last sent position.
+ * - VELOCITY: x, y, z, in 1/VELOCITY_SCALE meters per second.
+ * - ORIENTATION: x, y, z, w of the quaternion, in 1/ORIENTATION_SCALE units.
+ * - ANGULAR: x, y, z, in 1/ANGULAR_SCALE radians per second.
+ *
+ * Positions are quantized before the delta is calculated, so a client which adds up the deltas will end up with
+ * exactly the quantized position, without any drift.
+ *
+ * The sequence number is increased by one for each movement update of the entity. An observer gets all updates of
+ * the entities it observes, so if a client sees a gap it has missed an update, and should ignore deltas for that
+ * entity until it gets a keyframe.
+ */
+struct MovementDelta
+{
+    enum Flags
+    {
+        KEYFRAME = 1,
+        POSITION = 2,
+        VELOCITY = 4,
+        ORIENTATION = 8,
+        ANGULAR = 16
+    };
+
+    static constexpr double POSITION_SCALE = 1000.0;
+    static constexpr double VELOCITY_SCALE = 1000.0;
+    static constexpr double ORIENTATION_SCALE = 32767.0;
+    static constexpr double ANGULAR_SCALE = 1000.0;
+
+    long entityId;
+    long sequence;
+    /**
+     * Which of the fields are set. When writing KEYFRAME is ignored, since that is decided per observer.
+     */
+    int flags;
+
+    /**
+     * The absolute quantized position.
+     */
+    std::array<Atlas::Message::IntType, 3> position;
+    /**
+     * The quantized position, relative to the last sent position. Not set when reading a keyframe.
+     */
+    std::array<Atlas::Message::IntType, 3> positionDelta;
+    std::array<Atlas::Message::IntType, 3> velocity;
+    std::array<Atlas::Message::IntType, 4> orientation;
+    std::array<Atlas::Message::IntType, 3> angular;
+
+    static Atlas::Message::IntType quantize(double value, double scale);
+
+    /**
+     * Appends the record to a list.
+     * @param list The list of records.
+     * @param keyframe If true the absolute position is always written, otherwise the delta, if POSITION is set.
+     */
+    void write(Atlas::Message::ListType& list, bool keyframe) const;
+
+    /**
+     * Reads a record from a list.
+     * @param list The list of records.
+     * @param index The index at which the record starts. Will be moved to the start of the next record.
+     * @param record The record to fill. For keyframes the position is put in "position", otherwise in "positionDelta".
+     * @return False if the list didn't contain a full record at the index.
+     */
+    static bool read(const Atlas::Message::ListType& list, size_t& index, MovementDelta& record);
+};
+
+#endif //CYPHESIS_MOVEMENTDELTA_H
@@ -30,6 +30,10 @@
 
 #include "common/const.h"
 #include "common/debug.h"
+#include "common/globals.h"
+#include "common/log.h"
+#include "common/compose.hpp"
+#include "common/WorkerPool.h"
 #include "common/operations/Tick.h"
 #include "rules/simulation/BaseWorld.h"
 #include "PerceptionSightProperty.h"
@@ -39,6 +43,10 @@
 #include "SimulationSpeedProperty.h"
 #include "ModeDataProperty.h"
 #include "VisibilityDistanceProperty.h"
+#include "MindsProperty.h"
+#include "ExternalMind.h"
+#include "MovementDelta.h"
+#include "common/Link.h"
 
 #include <Mercator/Terrain.h>
 #include <Mercator/Segment.h>
@@ -53,10 +61,18 @@
 #include <BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 #include <BulletDynamics/Character/btKinematicCharacterController.h>
 
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <LinearMath/btThreads.h>
+#endif
+
 #include <sigc++/bind.h>
 
 #include <memory>
+#include <algorithm>
 #include <unordered_set>
+#include <unordered_map>
 #include <chrono>
 #include <boost/optional.hpp>
 #include <common/Inheritance.h>
@@ -138,6 +154,113 @@ short COLLISION_MASK_STATIC = 8;
  */
 float VISIBILITY_CHECK_INTERVAL_SECONDS = 2.0f;
 
+/**
+ * Size, in meters, of the cells used when the "grid" visibility backend is active.
+ */
+float VISIBILITY_GRID_CELL_SIZE = 64.0f;
+
+namespace {
+    INT_OPTION(visibility_threads, 0, CYPHESIS, "visibility_threads",
+               "Number of worker threads used for visibility checks of entities which have moved. Set to 0 to do all checks on the main thread.")
+
+    /**
+     * Visibility checks are only spread over threads if there are at least this many entries to check, since otherwise the overhead is greater than the gain.
+     */
+    const size_t MIN_PARALLEL_VISIBILITY_QUERIES = 32;
+
+    /**
+     * The pool is shared by all domains, since they are all ticked from the main thread.
+     * @return A worker pool, or null if visibility checks shouldn't be threaded.
+     */
+    WorkerPool* getVisibilityWorkerPool()
+    {
+        static std::unique_ptr<WorkerPool> workerPool(visibility_threads > 0 ? new WorkerPool(static_cast<size_t>(visibility_threads)) : nullptr);
+        return workerPool.get();
+    }
+
+    INT_OPTION(physics_threads, 0, CYPHESIS, "physics_threads",
+               "Number of worker threads used when stepping the physics simulation. Set to 0 to step on the main thread. "
+               "Only has an effect if the server is built with CYPHESIS_BULLET_MULTITHREADED.")
+
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+
+    /**
+     * The Bullet task scheduler is global, so it's only set up once, when the first domain is created.
+     * @return The number of threads used by the task scheduler.
+     */
+    int setupTaskScheduler()
+    {
+        static bool isSetup = false;
+        if (!isSetup) {
+            isSetup = true;
+            if (physics_threads > 0) {
+                auto taskScheduler = btCreateDefaultTaskScheduler();
+                if (taskScheduler) {
+                    taskScheduler->setNumThreads(physics_threads);
+                    btSetTaskScheduler(taskScheduler);
+                    log(INFO, String::compose("Stepping physics using %1 threads.", taskScheduler->getNumThreads()));
+                } else {
+                    log(WARNING, "Could not create a task scheduler for physics; Bullet is probably not built with multithreading. Physics will be stepped on the main thread.");
+                }
+            }
+        }
+        return btGetTaskScheduler()->getNumThreads();
+    }
+
+    btCollisionDispatcher* createDispatcher(btCollisionConfiguration* collisionConfiguration)
+    {
+        setupTaskScheduler();
+        return new btCollisionDispatcherMt(collisionConfiguration);
+    }
+
+    btConstraintSolver* createConstraintSolver()
+    {
+        return new btConstraintSolverPoolMt(std::max(1, setupTaskScheduler()));
+    }
+
+    btConstraintSolver* createConstraintSolverMt()
+    {
+        return new btSequentialImpulseConstraintSolverMt();
+    }
+
+#else
+
+    btCollisionDispatcher* createDispatcher(btCollisionConfiguration* collisionConfiguration)
+    {
+        return new btCollisionDispatcher(collisionConfiguration);
+    }
+
+    btConstraintSolver* createConstraintSolver()
+    {
+        return new btSequentialImpulseConstraintSolver();
+    }
+
+    btConstraintSolver* createConstraintSolverMt()
+    {
+        return nullptr;
+    }
+
+#endif
+
+    float sphereRadius(const btCollisionObject& object)
+    {
+        return static_cast<const btSphereShape*>(object.getCollisionShape())->getRadius();
+    }
+
+    /**
+     * Admin entities can see entities which are private.
+     */
+    short viewSphereGroup(const LocatedEntity& entity)
+    {
+        return entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE;
+    }
+
+    short visibilitySphereMask(const LocatedEntity& entity)
+    {
+        return entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE;
+    }
+}
+
 float CCD_MOTION_FACTOR = 0.2f;
 
 float CCD_SPHERE_FACTOR = 0.2f;
@@ -173,8 +296,8 @@ class PhysicalDomain::PhysicalMotionState : public btMotionState
         void setWorldTransform(const btTransform& /* centerOfMassWorldTrans */) override
         {
             LocatedEntity& entity = m_bulletEntry.entity;
-            m_domain.m_movingEntities.insert(&m_bulletEntry);
-            m_domain.m_dirtyEntries.insert(&m_bulletEntry);
+            m_domain.markAsMoving(&m_bulletEntry);
+            m_domain.markAsDirty(&m_bulletEntry);
 
             //            debug_print(
             //                    "setWorldTransform: "<< m_entity.describeEntity() << " (" << centerOfMassWorldTrans.getOrigin().x() << "," << centerOfMassWorldTrans.getOrigin().y() << "," << centerOfMassWorldTrans.getOrigin().z() << ")");
@@ -202,34 +325,38 @@ class PhysicalDomain::PhysicalMotionState : public btMotionState
                 visibilitySphere->setWorldTransform(
                         btTransform(visibilitySphere->getWorldTransform().getBasis(),
                                     m_bulletEntry.collisionObject->getWorldTransform().getOrigin() / VISIBILITY_SCALING_FACTOR));
-                m_domain.m_visibilityWorld->updateSingleAabb(visibilitySphere.get());
             }
 
             auto& viewSphere = m_bulletEntry.viewSphere;
             if (viewSphere) {
                 viewSphere->setWorldTransform(btTransform(viewSphere->getWorldTransform().getBasis(),
                                                           m_bulletEntry.collisionObject->getWorldTransform().getOrigin() / VISIBILITY_SCALING_FACTOR));
-                m_domain.m_visibilityWorld->updateSingleAabb(viewSphere.get());
             }
+            m_domain.updateVisibilitySpheres(m_bulletEntry);
         }
 };
 
+PhysicalDomain::TickTimings PhysicalDomain::s_tickTimings{};
+
 PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
         Domain(entity),
         mWorldInfo{&m_propellingEntries, &m_steppingEntries},
         //default config for now
         m_collisionConfiguration(new btDefaultCollisionConfiguration()),
-        m_dispatcher(new btCollisionDispatcher(m_collisionConfiguration.get())),
-        m_constraintSolver(new btSequentialImpulseConstraintSolver()),
+        m_dispatcher(createDispatcher(m_collisionConfiguration.get())),
+        m_constraintSolver(createConstraintSolver()),
+        m_constraintSolverMt(createConstraintSolverMt()),
         //We'll use a dynamic broadphase for the main world. It's not as fast as SAP variants, but it's faster when dynamic objects are at rest.
         m_broadphase(new btDbvtBroadphase()),
-        m_dynamicsWorld(new PhysicalWorld(m_dispatcher.get(), m_broadphase.get(), m_constraintSolver.get(), m_collisionConfiguration.get())),
+        m_dynamicsWorld(new PhysicalWorld(m_dispatcher.get(), m_broadphase.get(), m_constraintSolver.get(), m_collisionConfiguration.get(), m_constraintSolverMt.get())),
         m_visibilityDispatcher(new btCollisionDispatcher(m_collisionConfiguration.get())),
         m_visibilityBroadphase(new btDbvtBroadphase()),
         m_visibilityWorld(new btCollisionWorld(m_visibilityDispatcher.get(),
                                                m_visibilityBroadphase.get(),
                                                m_collisionConfiguration.get())),
+        m_batchMoveSights(false),
         m_visibilityCheckCountdown(0),
+        m_tickTimings{},
         mContainingEntityEntry{entity},
         m_terrain(nullptr),
         m_ghostPairCallback(new btGhostPairCallback())
@@ -249,6 +376,16 @@ PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
         m_terrain = &terrainProperty->getData(m_entity);
     }
 
+    auto visibilityBackendProp = m_entity.getPropertyType<std::string>("visibility_backend");
+    if (visibilityBackendProp) {
+        setVisibilityBackend(visibilityBackendProp->data());
+    }
+
+    auto batchMoveSightsProp = m_entity.getPropertyClass<BoolProperty>("batch_move_sights");
+    if (batchMoveSightsProp) {
+        m_batchMoveSights = batchMoveSightsProp->isTrue();
+    }
+
     createDomainBorders();
 
     //Update the linear velocity of all self propelling entities each tick.
@@ -362,6 +499,8 @@ PhysicalDomain::PhysicalDomain(LocatedEntity& entity) :
 
 PhysicalDomain::~PhysicalDomain()
 {
+    setTickTimings({});
+
     for (auto& planeBody : m_borderPlanes) {
         m_dynamicsWorld->removeCollisionObject(planeBody.first.get());
     }
@@ -618,10 +757,8 @@ void PhysicalDomain::getVisibleEntitiesFor(const LocatedEntity& observingEntity,
     }
 }
 
-std::list<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+void PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
 {
-    std::list<LocatedEntity*> entityList;
-
     auto observedI = m_entries.find(observedEntity.getIntId());
     if (observedI != m_entries.end()) {
         auto& bulletEntry = observedI->second;
@@ -629,179 +766,430 @@ std::list<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const LocatedE
             entityList.push_back(&observingEntry->entity);
         }
     }
-
-    return entityList;
 }
 
 class PhysicalDomain::VisibilityCallback : public btCollisionWorld::ContactResultCallback
 {
     public:
-        std::set<BulletEntry*> m_entries;
+        /**
+         * Found entries. Might contain duplicates.
+         */
+        std::vector<BulletEntry*> m_entries;
 
         btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* colObj0Wrap, int partId0, int index0, const btCollisionObjectWrapper* colObj1Wrap,
                                  int partId1, int index1) override
         {
             auto* bulletEntry = static_cast<BulletEntry*>(colObj1Wrap->m_collisionObject->getUserPointer());
             if (bulletEntry) {
-                m_entries.insert(bulletEntry);
+                m_entries.push_back(bulletEntry);
             }
             return btScalar(1.0);
         }
 };
 
+class PhysicalDomain::VisibilityQuery : public btBroadphaseAabbCallback
+{
+    public:
+        const btCollisionObject* m_queryObject;
+        btVector3 m_pos;
+        float m_radius;
+        int m_collisionFilterGroup;
+        int m_collisionFilterMask;
+        /**
+         * Found entries. Might contain duplicates.
+         */
+        std::vector<BulletEntry*>& m_entries;
+
+        VisibilityQuery(const btCollisionObject& queryObject, int collisionFilterGroup, int collisionFilterMask, std::vector<BulletEntry*>& entries)
+                : m_queryObject(&queryObject),
+                  m_pos(queryObject.getWorldTransform().getOrigin()),
+                  m_radius(sphereRadius(queryObject)),
+                  m_collisionFilterGroup(collisionFilterGroup),
+                  m_collisionFilterMask(collisionFilterMask),
+                  m_entries(entries)
+        {
+        }
+
+        /**
+         * Gives the same result as a contact test with a VisibilityCallback, since everything in the visibility world is a sphere.
+         * But unlike a contact test this doesn't create any collision algorithms or manifolds, so it's safe to run from multiple threads at once.
+         */
+        bool process(const btBroadphaseProxy* proxy) override
+        {
+            auto collisionObject = static_cast<const btCollisionObject*>(proxy->m_clientObject);
+            if (collisionObject == m_queryObject) {
+                return true;
+            }
+            if ((proxy->m_collisionFilterGroup & m_collisionFilterMask) == 0 || (m_collisionFilterGroup & proxy->m_collisionFilterMask) == 0) {
+                return true;
+            }
+            //Same check as in btSphereSphereCollisionAlgorithm
+            float combinedRadius = sphereRadius(*collisionObject) + m_radius;
+            if (collisionObject->getWorldTransform().getOrigin().distance2(m_pos) <= combinedRadius * combinedRadius) {
+                auto bulletEntry = static_cast<BulletEntry*>(collisionObject->getUserPointer());
+                if (bulletEntry) {
+                    m_entries.push_back(bulletEntry);
+                }
+            }
+            return true;
+        }
+};
+
+void PhysicalDomain::queryObservedEntries(const BulletEntry& observerEntry, std::vector<BulletEntry*>& result) const
+{
+    if (observerEntry.viewSphere && observerEntry.entity.m_location.m_pos.isValid()) {
+        auto group = viewSphereGroup(observerEntry.entity);
+        auto mask = VISIBILITY_MASK_OBSERVER;
+        auto& viewSphere = *observerEntry.viewSphere;
+        if (m_visibilityGrid) {
+            m_visibilityGrid->findObservables(viewSphere.getWorldTransform().getOrigin(), sphereRadius(viewSphere), group, mask, result);
+        } else {
+            VisibilityQuery query(viewSphere, group, mask, result);
+            btVector3 aabbMin, aabbMax;
+            viewSphere.getCollisionShape()->getAabb(viewSphere.getWorldTransform(), aabbMin, aabbMax);
+            m_visibilityBroadphase->aabbTest(aabbMin, aabbMax, query);
+        }
+    }
+}
+
+void PhysicalDomain::queryObservingEntries(const BulletEntry& observedEntry, std::vector<BulletEntry*>& result) const
+{
+    if (observedEntry.visibilitySphere && observedEntry.entity.m_location.m_pos.isValid()) {
+        auto group = VISIBILITY_MASK_OBSERVER;
+        auto mask = visibilitySphereMask(observedEntry.entity);
+        auto& visibilitySphere = *observedEntry.visibilitySphere;
+        if (m_visibilityGrid) {
+            m_visibilityGrid->findObservers(visibilitySphere.getWorldTransform().getOrigin(), sphereRadius(visibilitySphere), group, mask, result);
+        } else {
+            VisibilityQuery query(visibilitySphere, group, mask, result);
+            btVector3 aabbMin, aabbMax;
+            visibilitySphere.getCollisionShape()->getAabb(visibilitySphere.getWorldTransform(), aabbMin, aabbMax);
+            m_visibilityBroadphase->aabbTest(aabbMin, aabbMax, query);
+        }
+    }
+}
+
 void PhysicalDomain::updateObserverEntry(BulletEntry* bulletEntry, OpVector& res)
 {
     if (bulletEntry->viewSphere) {
-        //This entry is an observer; check what it can see after it has moved
-        VisibilityCallback callback;
+        std::vector<BulletEntry*> observedEntries;
+        queryObservedEntries(*bulletEntry, observedEntries);
+        applyObservedEntries(bulletEntry, observedEntries, res);
+    }
+}
 
-        //callback.m_filterOutEntry = bulletEntry;
-        debug_print("Updating what can be observed by entity " << bulletEntry->entity.describeEntity())
-        callback.m_entries.clear();
+void PhysicalDomain::applyObservedEntries(BulletEntry* bulletEntry, std::vector<BulletEntry*>& foundEntries, OpVector& res)
+{
+    //This entry is an observer; check what it can see after it has moved
+    debug_print("Updating what can be observed by entity " << bulletEntry->entity.describeEntity())
+
+    //Insert the container entity, which should be seen by the observer.
+    foundEntries.push_back(&mContainingEntityEntry);
+    //Sorts and removes duplicates.
+    BulletEntrySet observedEntries(foundEntries.begin(), foundEntries.end());
+    foundEntries.clear();
+
+    debug_print(" observed by " << bulletEntry->entity.describeEntity() << ": " << observedEntries.size())
+
+    auto& observed = bulletEntry->observedByThis;
+
+    std::vector<Atlas::Objects::Root> appearArgs;
+    std::vector<Atlas::Objects::Root> disappearArgs;
+    //See which entities became visible, and which sight was lost of.
+    for (BulletEntry* viewedEntry : observedEntries) {
+        if (viewedEntry == bulletEntry) {
+            continue;
+        }
+        auto I = observed.find(viewedEntry);
+        if (I != observed.end()) {
+            //It was already seen; do nothing special
+            observed.erase(I);
+        } else {
+            //Send Appear
+            // debug_print(" appear: " << viewedEntry->entity.describeEntity() << " for " << bulletEntry->entity.describeEntity());
+            Anonymous that_ent;
+            that_ent->setId(viewedEntry->entity.getId());
+            that_ent->setStamp(viewedEntry->entity.getSeq());
+            appearArgs.push_back(that_ent);
 
-        debug_print(" " << bulletEntry->entity.describeEntity() << " viewSphere: " << bulletEntry->viewSphere->getWorldTransform().getOrigin())
+            viewedEntry->observingThis.insert(bulletEntry);
+        }
+    }
+    if (!appearArgs.empty()) {
+        Appearance appear;
+        appear->setTo(bulletEntry->entity.getId());
+        appear->setArgs(appearArgs);
+        res.push_back(appear);
+    }
 
-        if (bulletEntry->entity.m_location.m_pos.isValid()) {
-            callback.m_collisionFilterGroup = bulletEntry->entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE;
-            callback.m_collisionFilterMask = VISIBILITY_MASK_OBSERVER;
-            m_visibilityWorld->contactTest(bulletEntry->viewSphere.get(), callback);
+    for (BulletEntry* disappearedEntry : observed) {
+        if (disappearedEntry == bulletEntry) {
+            continue;
         }
+        //Send disappearence
+        //debug_print(" disappear: " << disappearedEntry->entity.describeEntity() << " for " << bulletEntry->entity.describeEntity());
+        Anonymous that_ent;
+        that_ent->setId(disappearedEntry->entity.getId());
+        that_ent->setStamp(disappearedEntry->entity.getSeq());
 
-        //Insert the container entity, which should be seen by the observer.
-        callback.m_entries.insert(&mContainingEntityEntry);
+        disappearArgs.push_back(that_ent);
 
-        debug_print(" observed by " << bulletEntry->entity.describeEntity() << ": " << callback.m_entries.size())
+        disappearedEntry->observingThis.erase(bulletEntry);
+        bulletEntry->movementBaselines.erase(disappearedEntry->entity.getIntId());
+    }
 
-        auto& observed = bulletEntry->observedByThis;
+    if (!disappearArgs.empty()) {
+        Disappearance disappear;
+        disappear->setTo(bulletEntry->entity.getId());
+        disappear->setArgs(disappearArgs);
+        res.push_back(disappear);
+    }
 
-        std::vector<Atlas::Objects::Root> appearArgs;
-        std::vector<Atlas::Objects::Root> disappearArgs;
-        //See which entities became visible, and which sight was lost of.
-        for (BulletEntry* viewedEntry : callback.m_entries) {
-            if (viewedEntry == bulletEntry) {
-                continue;
-            }
-            auto I = observed.find(viewedEntry);
-            if (I != observed.end()) {
-                //It was already seen; do nothing special
-                observed.erase(I);
-            } else {
-                //Send Appear
-                // debug_print(" appear: " << viewedEntry->entity.describeEntity() << " for " << bulletEntry->entity.describeEntity());
-                Anonymous that_ent;
-                that_ent->setId(viewedEntry->entity.getId());
-                that_ent->setStamp(viewedEntry->entity.getSeq());
-                appearArgs.push_back(that_ent);
+    bulletEntry->observedByThis = std::move(observedEntries);
+    //Make sure ourselves is in the list
+    bulletEntry->observedByThis.insert(bulletEntry);
+}
 
-                viewedEntry->observingThis.insert(bulletEntry);
+void PhysicalDomain::updateObservedEntry(BulletEntry* bulletEntry, OpVector& res, bool generateOps)
+{
+    if (bulletEntry->visibilitySphere) {
+        std::vector<BulletEntry*> observingEntries;
+        queryObservingEntries(*bulletEntry, observingEntries);
+        applyObservingEntries(bulletEntry, observingEntries, res, generateOps);
+    }
+}
+
+void PhysicalDomain::applyObservingEntries(BulletEntry* bulletEntry, std::vector<BulletEntry*>& foundEntries, OpVector& res, bool generateOps)
+{
+    //This entry is something which can be observed; check what can see it after it has moved
+    debug_print("Updating what is observing entity " << bulletEntry->entity.describeEntity())
+
+    //Sorts and removes duplicates.
+    BulletEntrySet observingEntries(foundEntries.begin(), foundEntries.end());
+    foundEntries.clear();
+
+    debug_print(" observing " << bulletEntry->entity.describeEntity() << ": " << observingEntries.size())
+
+    auto& observing = bulletEntry->observingThis;
+    //See which entities got sight of this, and for which sight was lost.
+    for (BulletEntry* viewingEntry : observingEntries) {
+        auto I = observing.find(viewingEntry);
+        if (I != observing.end()) {
+            //It was already seen; do nothing special
+            observing.erase(I);
+        } else {
+            if (generateOps) {
+                //Send appear
+                // debug_print(" appear: " << bulletEntry->entity.describeEntity() << " for " << viewingEntry->entity.describeEntity());
+                Appearance appear;
+                Anonymous that_ent;
+                that_ent->setId(bulletEntry->entity.getId());
+                that_ent->setStamp(bulletEntry->entity.getSeq());
+                appear->setArgs1(that_ent);
+                appear->setTo(viewingEntry->entity.getId());
+                res.push_back(appear);
             }
+
+            viewingEntry->observedByThis.insert(bulletEntry);
         }
-        if (!appearArgs.empty()) {
-            Appearance appear;
-            appear->setTo(bulletEntry->entity.getId());
-            appear->setArgs(appearArgs);
-            res.push_back(appear);
-        }
+    }
 
-        for (BulletEntry* disappearedEntry : observed) {
-            if (disappearedEntry == bulletEntry) {
-                continue;
-            }
+    for (BulletEntry* noLongerObservingEntry : observing) {
+        if (generateOps) {
             //Send disappearence
-            //debug_print(" disappear: " << disappearedEntry->entity.describeEntity() << " for " << bulletEntry->entity.describeEntity());
+            // debug_print(" disappear: " << bulletEntry->entity.describeEntity() << " for " << noLongerObservingEntry->entity.describeEntity());
+            Disappearance disappear;
             Anonymous that_ent;
-            that_ent->setId(disappearedEntry->entity.getId());
-            that_ent->setStamp(disappearedEntry->entity.getSeq());
+            that_ent->setId(bulletEntry->entity.getId());
+            that_ent->setStamp(bulletEntry->entity.getSeq());
+            disappear->setArgs1(that_ent);
+            disappear->setTo(noLongerObservingEntry->entity.getId());
+            res.push_back(disappear);
+        }
 
-            disappearArgs.push_back(that_ent);
+        noLongerObservingEntry->observedByThis.erase(bulletEntry);
+        noLongerObservingEntry->movementBaselines.erase(bulletEntry->entity.getIntId());
+    }
+
+    bulletEntry->observingThis = std::move(observingEntries);
+}
 
-            disappearedEntry->observingThis.erase(bulletEntry);
+void PhysicalDomain::updateVisibilityOfDirtyEntities(OpVector& res)
+{
+    //First query what each dirty entry sees and is seen by. This doesn't alter anything, so it's done in parallel.
+    //Then apply the results serially, in order, so that the ops are always the same no matter how many threads are used.
+    auto queriedCount = m_dirtyEntries.size();
+    if (m_visibilityQueryResults.size() < queriedCount) {
+        m_visibilityQueryResults.resize(queriedCount);
+    }
+    auto queryFn = [&](size_t i) {
+        auto bulletEntry = m_dirtyEntries[i];
+        if (bulletEntry) {
+            queryObservingEntries(*bulletEntry, m_visibilityQueryResults[i].observing);
+            queryObservedEntries(*bulletEntry, m_visibilityQueryResults[i].observed);
         }
+    };
+    auto workerPool = getVisibilityWorkerPool();
+    if (workerPool && queriedCount >= MIN_PARALLEL_VISIBILITY_QUERIES) {
+        workerPool->parallelFor(queriedCount, queryFn);
+    } else {
+        for (size_t i = 0; i < queriedCount; ++i) {
+            queryFn(i);
+        }
+    }
 
-        if (!disappearArgs.empty()) {
-            Disappearance disappear;
-            disappear->setTo(bulletEntry->entity.getId());
-            disappear->setArgs(disappearArgs);
-            res.push_back(disappear);
+    for (size_t i = 0; i < queriedCount; ++i) {
+        auto bulletEntry = m_dirtyEntries[i];
+        auto& queryResult = m_visibilityQueryResults[i];
+        if (bulletEntry) {
+            if (bulletEntry->visibilitySphere) {
+                applyObservingEntries(bulletEntry, queryResult.observing, res, true);
+            }
+            if (bulletEntry->viewSphere) {
+                applyObservedEntries(bulletEntry, queryResult.observed, res);
+            }
         }
+        queryResult.observing.clear();
+        queryResult.observed.clear();
+    }
 
-        bulletEntry->observedByThis = std::move(callback.m_entries);
-        //Make sure ourselves is in the list
-        bulletEntry->observedByThis.insert(bulletEntry);
+    //Only call "onUpdated" once all query results have been applied, since it might lead to entries being removed, which would
+    //leave dangling pointers in the results not yet applied.
+    //Iterate by index, since entries can be added or removed as a result of the "onUpdated" call.
+    for (size_t i = 0; i < m_dirtyEntries.size(); ++i) {
+        auto bulletEntry = m_dirtyEntries[i];
+        if (bulletEntry) {
+            if (i >= queriedCount) {
+                //Entries made dirty by an "onUpdated" call.
+                updateObservedEntry(bulletEntry, res);
+                updateObserverEntry(bulletEntry, res);
+            }
+            bulletEntry->entity.onUpdated();
+        }
     }
+    for (auto bulletEntry : m_dirtyEntries) {
+        if (bulletEntry) {
+            bulletEntry->isDirty = false;
+        }
+    }
+    m_dirtyEntries.clear();
 }
 
-void PhysicalDomain::updateObservedEntry(BulletEntry* bulletEntry, OpVector& res, bool generateOps)
+void PhysicalDomain::markAsMoving(BulletEntry* entry)
 {
-    if (bulletEntry->visibilitySphere) {
-        //This entry is something which can be observed; check what can see it after it has moved
+    if (!entry->isMoving) {
+        entry->isMoving = true;
+        m_movingEntities.push_back(entry);
+    }
+}
 
-        VisibilityCallback callback;
+void PhysicalDomain::markAsDirty(BulletEntry* entry)
+{
+    if (!entry->isDirty) {
+        entry->isDirty = true;
+        m_dirtyEntries.push_back(entry);
+    }
+}
+
+void PhysicalDomain::setVisibilityBackend(const std::string& backend)
+{
+    bool useGrid;
+    if (backend == "grid") {
+        useGrid = true;
+    } else if (backend == "bullet" || backend.empty()) {
+        useGrid = false;
+    } else {
+        log(WARNING, String::compose("Unknown visibility backend '%1' for domain of entity %2; using 'bullet'.", backend, m_entity.describeEntity()));
+        useGrid = false;
+    }
 
-        debug_print("Updating what is observing entity " << bulletEntry->entity.describeEntity())
-        debug_print(" " << bulletEntry->entity.describeEntity() << " visibilitySphere: " << bulletEntry->visibilitySphere->getWorldTransform().getOrigin())
+    if (useGrid == (m_visibilityGrid != nullptr)) {
+        return;
+    }
 
-        if (bulletEntry->entity.m_location.m_pos.isValid()) {
-            callback.m_collisionFilterGroup = VISIBILITY_MASK_OBSERVER;
-            callback.m_collisionFilterMask = bulletEntry->entity.hasFlags(entity_visibility_protected) || bulletEntry->entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE
-                                                                                                                                                                  : VISIBILITY_MASK_OBSERVABLE;
-            m_visibilityWorld->contactTest(bulletEntry->visibilitySphere.get(), callback);
+    //Move all entries over. Any observation sets are kept, and will be reconciled at the next visibility check.
+    for (auto& entry : m_entries) {
+        if (entry.second->viewSphere) {
+            removeViewSphere(*entry.second);
         }
+        if (entry.second->visibilitySphere) {
+            removeVisibilitySphere(*entry.second);
+        }
+    }
 
-        debug_print(" observing " << bulletEntry->entity.describeEntity() << ": " << callback.m_entries.size())
-
-        auto& observing = bulletEntry->observingThis;
-        //See which entities got sight of this, and for which sight was lost.
-        for (BulletEntry* viewingEntry : callback.m_entries) {
-            auto I = observing.find(viewingEntry);
-            if (I != observing.end()) {
-                //It was already seen; do nothing special
-                observing.erase(I);
-            } else {
-                if (generateOps) {
-                    //Send appear
-                    // debug_print(" appear: " << bulletEntry->entity.describeEntity() << " for " << viewingEntry->entity.describeEntity());
-                    Appearance appear;
-                    Anonymous that_ent;
-                    that_ent->setId(bulletEntry->entity.getId());
-                    that_ent->setStamp(bulletEntry->entity.getSeq());
-                    appear->setArgs1(that_ent);
-                    appear->setTo(viewingEntry->entity.getId());
-                    res.push_back(appear);
-                }
+    if (useGrid) {
+        m_visibilityGrid = std::make_unique<VisibilityGrid<BulletEntry>>(VISIBILITY_GRID_CELL_SIZE / VISIBILITY_SCALING_FACTOR);
+    } else {
+        m_visibilityGrid.reset();
+    }
 
-                viewingEntry->observedByThis.insert(bulletEntry);
+    for (auto& entry : m_entries) {
+        if (entry.second->entity.m_location.m_pos.isValid()) {
+            if (entry.second->viewSphere) {
+                addViewSphere(*entry.second);
+            }
+            if (entry.second->visibilitySphere) {
+                addVisibilitySphere(*entry.second);
             }
         }
+    }
+}
 
-        for (BulletEntry* noLongerObservingEntry : observing) {
-            if (generateOps) {
-                //Send disappearence
-                // debug_print(" disappear: " << bulletEntry->entity.describeEntity() << " for " << noLongerObservingEntry->entity.describeEntity());
-                Disappearance disappear;
-                Anonymous that_ent;
-                that_ent->setId(bulletEntry->entity.getId());
-                that_ent->setStamp(bulletEntry->entity.getSeq());
-                disappear->setArgs1(that_ent);
-                disappear->setTo(noLongerObservingEntry->entity.getId());
-                res.push_back(disappear);
-            }
+void PhysicalDomain::addVisibilitySphere(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        m_visibilityGrid->addObservable(&entry, entry.visibilitySphere->getWorldTransform().getOrigin(), sphereRadius(*entry.visibilitySphere),
+                                        VISIBILITY_MASK_OBSERVER, visibilitySphereMask(entry.entity));
+    } else {
+        m_visibilityWorld->addCollisionObject(entry.visibilitySphere.get(), VISIBILITY_MASK_OBSERVER, visibilitySphereMask(entry.entity));
+    }
+}
 
-            noLongerObservingEntry->observedByThis.erase(bulletEntry);
-        }
+void PhysicalDomain::addViewSphere(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        m_visibilityGrid->addObserver(&entry, entry.viewSphere->getWorldTransform().getOrigin(), sphereRadius(*entry.viewSphere),
+                                      viewSphereGroup(entry.entity), VISIBILITY_MASK_OBSERVER);
+    } else {
+        m_visibilityWorld->addCollisionObject(entry.viewSphere.get(), viewSphereGroup(entry.entity), VISIBILITY_MASK_OBSERVER);
+    }
+}
 
-        bulletEntry->observingThis = std::move(callback.m_entries);
+void PhysicalDomain::removeVisibilitySphere(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        m_visibilityGrid->removeObservable(&entry);
+    } else {
+        m_visibilityWorld->removeCollisionObject(entry.visibilitySphere.get());
     }
 }
 
-void PhysicalDomain::updateVisibilityOfDirtyEntities(OpVector& res)
+void PhysicalDomain::removeViewSphere(BulletEntry& entry)
 {
-    for (auto& bulletEntry : m_dirtyEntries) {
-        updateObservedEntry(bulletEntry, res);
-        updateObserverEntry(bulletEntry, res);
-        bulletEntry->entity.onUpdated();
+    if (m_visibilityGrid) {
+        m_visibilityGrid->removeObserver(&entry);
+    } else {
+        m_visibilityWorld->removeCollisionObject(entry.viewSphere.get());
+    }
+}
+
+void PhysicalDomain::updateVisibilitySpheres(BulletEntry& entry)
+{
+    if (m_visibilityGrid) {
+        if (entry.visibilitySphere) {
+            m_visibilityGrid->updateObservable(&entry, entry.visibilitySphere->getWorldTransform().getOrigin(), sphereRadius(*entry.visibilitySphere));
+        }
+        if (entry.viewSphere) {
+            m_visibilityGrid->updateObserver(&entry, entry.viewSphere->getWorldTransform().getOrigin());
+        }
+    } else {
+        if (entry.visibilitySphere) {
+            m_visibilityWorld->updateSingleAabb(entry.visibilitySphere.get());
+        }
+        if (entry.viewSphere) {
+            m_visibilityWorld->updateSingleAabb(entry.viewSphere.get());
+        }
     }
-    m_dirtyEntries.clear();
 }
 
 float PhysicalDomain::getMassForEntity(const LocatedEntity& entity) const
@@ -831,12 +1219,99 @@ std::shared_ptr<btCollisionShape> PhysicalDomain::createCollisionShapeForEntry(L
 }
 
 void PhysicalDomain::addEntity(LocatedEntity& entity)
+{
+    auto entry = createEntry(entity);
+    if (!entry) {
+        return;
+    }
+
+    OpVector res;
+    updateObserverEntry(entry, res);
+    updateObservedEntry(entry, res, false); //Don't send any ops, since that will be handled by the calling code when changing locations.
+    for (auto& op : res) {
+        m_entity.sendWorld(op);
+    }
+}
+
+void PhysicalDomain::addEntities(const std::vector<LocatedEntity*>& entities)
+{
+    std::vector<BulletEntry*> entries;
+    entries.reserve(entities.size());
+    for (auto entity : entities) {
+        auto entry = createEntry(*entity);
+        if (entry) {
+            entries.push_back(entry);
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+
+    //If most entries are new, rebuild the broadphase trees top down in one go, instead of relying on them being
+    //gradually rebalanced as the simulation is stepped.
+    if (entries.size() * 2 >= m_entries.size()) {
+        static_cast<btDbvtBroadphase*>(m_broadphase.get())->optimize();
+        if (!m_visibilityGrid) {
+            static_cast<btDbvtBroadphase*>(m_visibilityBroadphase.get())->optimize();
+        }
+    }
+
+    //Query visibility for all new entries once all of them are in place, in the same way as for dirty entries when ticking.
+    //The results are then applied in order, as if each entry had been added with addEntity().
+    std::unordered_map<const BulletEntry*, size_t> entryIndices;
+    entryIndices.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entryIndices.emplace(entries[i], i);
+    }
+    if (m_visibilityQueryResults.size() < entries.size()) {
+        m_visibilityQueryResults.resize(entries.size());
+    }
+    auto queryFn = [&](size_t i) {
+        queryObservedEntries(*entries[i], m_visibilityQueryResults[i].observed);
+        queryObservingEntries(*entries[i], m_visibilityQueryResults[i].observing);
+    };
+    auto workerPool = getVisibilityWorkerPool();
+    if (workerPool && entries.size() >= MIN_PARALLEL_VISIBILITY_QUERIES) {
+        workerPool->parallelFor(entries.size(), queryFn);
+    } else {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            queryFn(i);
+        }
+    }
+
+    OpVector res;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        auto entry = entries[i];
+        auto& queryResult = m_visibilityQueryResults[i];
+        //The queries found entries which are added after this one too. Those would not have been in place if this
+        //entry had been added on its own, and will instead see, and be seen by, this entry when they are applied.
+        auto isAddedLater = [&](const BulletEntry* foundEntry) {
+            auto I = entryIndices.find(foundEntry);
+            return I != entryIndices.end() && I->second > i;
+        };
+        queryResult.observed.erase(std::remove_if(queryResult.observed.begin(), queryResult.observed.end(), isAddedLater), queryResult.observed.end());
+        queryResult.observing.erase(std::remove_if(queryResult.observing.begin(), queryResult.observing.end(), isAddedLater), queryResult.observing.end());
+        if (entry->viewSphere) {
+            applyObservedEntries(entry, queryResult.observed, res);
+        }
+        if (entry->visibilitySphere) {
+            applyObservingEntries(entry, queryResult.observing, res, false);
+        }
+        queryResult.observed.clear();
+        queryResult.observing.clear();
+    }
+    for (auto& op : res) {
+        m_entity.sendWorld(op);
+    }
+}
+
+PhysicalDomain::BulletEntry* PhysicalDomain::createEntry(LocatedEntity& entity)
 {
     assert(m_entries.find(entity.getIntId()) == m_entries.end());
 
     if (!entity.m_location.m_pos.isValid()) {
         log(WARNING, String::compose("Tried to add entity %1 to physical domain belonging to %2, but there's no valid position.", entity.describeEntity(), m_entity.describeEntity()));
-        return;
+        return nullptr;
     }
 
     float mass = getMassForEntity(entity);
@@ -1012,12 +1487,12 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
         visObject->setUserPointer(entry);
         if (entity.m_location.m_pos.isValid()) {
             visObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) / VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->addCollisionObject(visObject.get(), VISIBILITY_MASK_OBSERVER,
-                                                  entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE
-                                                                                                                                             : VISIBILITY_MASK_OBSERVABLE);
         }
         entry->visibilitySphere = std::move(visObject);
         entry->visibilityShape = std::move(visSphere);
+        if (entity.m_location.m_pos.isValid()) {
+            addVisibilitySphere(*entry);
+        }
     }
     if (entity.isPerceptive()) {
         auto viewSphere = std::make_unique<btSphereShape>(0.5f / VISIBILITY_SCALING_FACTOR);
@@ -1026,11 +1501,12 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
         visObject->setUserPointer(entry);
         if (entity.m_location.m_pos.isValid()) {
             visObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) / VISIBILITY_SCALING_FACTOR));
-            m_visibilityWorld->addCollisionObject(visObject.get(), entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                  VISIBILITY_MASK_OBSERVER);
         }
         entry->viewSphere = std::move(visObject);
         entry->viewShape = std::move(viewSphere);
+        if (entity.m_location.m_pos.isValid()) {
+            addViewSphere(*entry);
+        }
         mContainingEntityEntry.observingThis.insert(entry);
     }
 
@@ -1039,12 +1515,7 @@ void PhysicalDomain::addEntity(LocatedEntity& entity)
         mContainingEntityEntry.observedByThis.insert(entry);
     }
 
-    OpVector res;
-    updateObserverEntry(entry, res);
-    updateObservedEntry(entry, res, false); //Don't send any ops, since that will be handled by the calling code when changing locations.
-    for (auto& op : res) {
-        m_entity.sendWorld(op);
-    }
+    return entry;
 }
 
 void PhysicalDomain::toggleChildPerception(LocatedEntity& entity)
@@ -1064,10 +1535,12 @@ void PhysicalDomain::toggleChildPerception(LocatedEntity& entity)
             visObject->setUserPointer(entry.get());
             if (entity.m_location.m_pos.isValid()) {
                 visObject->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) / VISIBILITY_SCALING_FACTOR));
-                m_visibilityWorld->addCollisionObject(visObject.get(), entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                      VISIBILITY_MASK_OBSERVER);
             }
             entry->viewSphere = std::move(visObject);
+            entry->viewShape = std::move(viewSphere);
+            if (entity.m_location.m_pos.isValid()) {
+                addViewSphere(*entry);
+            }
             OpVector res;
             updateObserverEntry(entry.get(), res);
             for (auto& op : res) {
@@ -1076,7 +1549,7 @@ void PhysicalDomain::toggleChildPerception(LocatedEntity& entity)
         }
     } else {
         if (entry->viewSphere) {
-            m_visibilityWorld->removeCollisionObject(entry->viewSphere.get());
+            removeViewSphere(*entry);
             entry->viewShape.reset();
             entry->viewSphere.reset();
             mContainingEntityEntry.observingThis.erase(entry.get());
@@ -1100,8 +1573,14 @@ void PhysicalDomain::removeEntity(LocatedEntity& entity)
         m_terrainMods.erase(modI);
     }
 
-    m_lastMovingEntities.erase(entry.get());
-    m_movingEntities.erase(entry.get());
+    //The entry lists are iterated by index, so null the entry out instead of erasing it.
+    if (entry->isMoving) {
+        std::replace(m_movingEntities.begin(), m_movingEntities.end(), entry.get(), static_cast<BulletEntry*>(nullptr));
+    }
+    //The "wasMoving" flag is cleared during the tick for entries that moved again, so those might be in the list too.
+    if (entry->wasMoving || entry->isMoving) {
+        std::replace(m_lastMovingEntities.begin(), m_lastMovingEntities.end(), entry.get(), static_cast<BulletEntry*>(nullptr));
+    }
 
     //Remove it from the map of submerged entities.
     auto submergedEntryI = m_submergedEntities.find(entry.get());
@@ -1134,19 +1613,22 @@ void PhysicalDomain::removeEntity(LocatedEntity& entity)
 
     entry->propertyUpdatedConnection.disconnect();
     if (entry->viewSphere) {
-        m_visibilityWorld->removeCollisionObject(entry->viewSphere.get());
+        removeViewSphere(*entry);
     }
     if (entry->visibilitySphere) {
-        m_visibilityWorld->removeCollisionObject(entry->visibilitySphere.get());
+        removeVisibilitySphere(*entry);
     }
     for (BulletEntry* observer : entry->observingThis) {
         observer->observedByThis.erase(entry.get());
+        observer->movementBaselines.erase(entity.getIntId());
     }
     for (BulletEntry* observedEntry : entry->observedByThis) {
         observedEntry->observingThis.erase(entry.get());
     }
 
-    m_dirtyEntries.erase(entry.get());
+    if (entry->isDirty) {
+        std::replace(m_dirtyEntries.begin(), m_dirtyEntries.end(), entry.get(), static_cast<BulletEntry*>(nullptr));
+    }
     mContainingEntityEntry.observingThis.erase(entry.get());
 
     //The entity owning the domain should normally not be perceptive, so we'll check first to optimize a bit.
@@ -1165,7 +1647,9 @@ void PhysicalDomain::removeEntity(LocatedEntity& entity)
         }
     }
 
-    for (auto& observation : entry->closenessObservations) {
+    //Copy, since callbacks can alter the collection.
+    auto closenessObservations = entry->closenessObservations;
+    for (auto& observation : closenessObservations) {
         if (observation->callback) {
             observation->callback();
         }
@@ -1226,6 +1710,9 @@ void PhysicalDomain::childEntityPropertyApplied(const std::string& name, const P
 //                }
 //            }
 //        }
+    } else if (name == MindsProperty::property_name) {
+        //Any new minds, or their links, haven't been sent any of the keyframes sent earlier.
+        bulletEntry->movementBaselines.clear();
     } else if (name == PropelProperty::property_name) {
         auto propelProp = dynamic_cast<const PropelProperty*>(&prop);
         if (propelProp) {
@@ -1341,7 +1828,7 @@ void PhysicalDomain::childEntityPropertyApplied(const std::string& name, const P
 
             //sendMoveSight(*bulletEntry);
         }
-        m_movingEntities.insert(bulletEntry);
+        markAsMoving(bulletEntry);
         return;
     } else if (name == SolidProperty::property_name) {
         if (bulletEntry->collisionObject) {
@@ -1433,6 +1920,9 @@ void PhysicalDomain::childEntityPropertyApplied(const std::string& name, const P
                     } else {
                         bulletEntry->visibilityShape->setUnscaledRadius(0.25f);
                     }
+                    if (m_visibilityGrid) {
+                        updateVisibilitySpheres(*bulletEntry);
+                    }
                 }
             }
         }
@@ -1638,6 +2128,19 @@ void PhysicalDomain::entityPropertyApplied(const std::string& name, const Proper
         if (terrainProperty) {
             m_terrain = &terrainProperty->getData(m_entity);
         }
+    } else if (name == "visibility_backend") {
+        auto backendProp = dynamic_cast<const Property<std::string>*>(&prop);
+        if (backendProp) {
+            setVisibilityBackend(backendProp->data());
+        }
+    } else if (name == "batch_move_sights") {
+        auto batchProp = dynamic_cast<const BoolProperty*>(&prop);
+        if (batchProp) {
+            m_batchMoveSights = batchProp->isTrue();
+            if (!m_batchMoveSights) {
+                flushMoveSights();
+            }
+        }
     }
 }
 
@@ -1942,15 +2445,14 @@ void PhysicalDomain::applyNewPositionForEntity(BulletEntry* entry, const WFMath:
 
     if (entry->viewSphere) {
         entry->viewSphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) / VISIBILITY_SCALING_FACTOR));
-        m_visibilityWorld->updateSingleAabb(entry->viewSphere.get());
     }
     if (entry->visibilitySphere) {
         entry->visibilitySphere->setWorldTransform(btTransform(btQuaternion::getIdentity(), Convert::toBullet(entity.m_location.m_pos) / VISIBILITY_SCALING_FACTOR));
-        m_visibilityWorld->updateSingleAabb(entry->visibilitySphere.get());
     }
+    updateVisibilitySpheres(*entry);
 
-    // m_movingEntities.insert(entry);
-    m_dirtyEntries.insert(entry);
+    // markAsMoving(entry);
+    markAsDirty(entry);
 }
 
 void PhysicalDomain::applyPropel(BulletEntry& entry, const WFMath::Vector<3>& propel)
@@ -2144,14 +2646,10 @@ void PhysicalDomain::applyTransformInternal(LocatedEntity& entity,
                     }
                 }
                 if (entry->viewSphere) {
-                    m_visibilityWorld->addCollisionObject(entry->viewSphere.get(),
-                                                          entity.hasFlags(entity_admin) ? VISIBILITY_MASK_OBSERVABLE | VISIBILITY_MASK_OBSERVABLE_PRIVATE : VISIBILITY_MASK_OBSERVABLE,
-                                                          VISIBILITY_MASK_OBSERVER);
+                    addViewSphere(*entry);
                 }
                 if (entry->visibilitySphere) {
-                    m_visibilityWorld->addCollisionObject(entry->visibilitySphere.get(), VISIBILITY_MASK_OBSERVER,
-                                                          entity.hasFlags(entity_visibility_protected) || entity.hasFlags(entity_visibility_private) ? VISIBILITY_MASK_OBSERVABLE_PRIVATE
-                                                                                                                                                     : VISIBILITY_MASK_OBSERVABLE);
+                    addVisibilitySphere(*entry);
                 }
             }
         }
@@ -2278,25 +2776,62 @@ void PhysicalDomain::sendMoveSight(BulletEntry& entry, bool posChange, bool velo
         Location& lastSentLocation = entry.lastSentLocation;
         bool shouldSendOp = false;
         Anonymous move_arg;
+
+        //The compact version of the update needs the last sent position, so it's filled in before that is overwritten.
+        MovementDelta delta{};
+        delta.entityId = entity.getIntId();
+        delta.flags = 0;
+        //If the last sent position isn't known no delta can be calculated, and all observers need to get a keyframe.
+        bool deltaNeedsKeyframe = !lastSentLocation.m_pos.isValid();
+        if (m_batchMoveSights && entity.m_location.m_pos.isValid()) {
+            for (size_t i = 0; i < 3; ++i) {
+                delta.position[i] = MovementDelta::quantize(entity.m_location.m_pos[i], MovementDelta::POSITION_SCALE);
+                delta.positionDelta[i] = deltaNeedsKeyframe ? 0 : delta.position[i] - MovementDelta::quantize(lastSentLocation.m_pos[i], MovementDelta::POSITION_SCALE);
+            }
+            //Always include the position if the quantized position has changed, even if it's not enough for a full update, since the
+            //last sent position will be updated if anything is sent, and the deltas must add up.
+            if (posChange || delta.positionDelta != std::array<Atlas::Message::IntType, 3>{}) {
+                delta.flags |= MovementDelta::POSITION;
+            }
+        }
         if (velocityChange) {
             ::addToEntity(entity.m_location.velocity(), move_arg->modifyVelocity());
             shouldSendOp = true;
+            if (entity.m_location.velocity().isValid()) {
+                delta.flags |= MovementDelta::VELOCITY;
+                for (size_t i = 0; i < 3; ++i) {
+                    delta.velocity[i] = MovementDelta::quantize(entity.m_location.velocity()[i], MovementDelta::VELOCITY_SCALE);
+                }
+            }
             lastSentLocation.m_velocity = entity.m_location.velocity();
         }
         if (angularChange) {
             move_arg->setAttr("angular", entity.m_location.m_angularVelocity.toAtlas());
             shouldSendOp = true;
+            if (entity.m_location.m_angularVelocity.isValid()) {
+                delta.flags |= MovementDelta::ANGULAR;
+                for (size_t i = 0; i < 3; ++i) {
+                    delta.angular[i] = MovementDelta::quantize(entity.m_location.m_angularVelocity[i], MovementDelta::ANGULAR_SCALE);
+                }
+            }
             lastSentLocation.m_angularVelocity = entity.m_location.m_angularVelocity;
         }
         if (orientationChange) {
             move_arg->setAttr("orientation", entity.m_location.orientation().toAtlas());
             shouldSendOp = true;
+            if (entity.m_location.orientation().isValid()) {
+                delta.flags |= MovementDelta::ORIENTATION;
+                auto& orientation = entity.m_location.orientation();
+                delta.orientation = {MovementDelta::quantize(orientation.vector().x(), MovementDelta::ORIENTATION_SCALE),
+                                     MovementDelta::quantize(orientation.vector().y(), MovementDelta::ORIENTATION_SCALE),
+                                     MovementDelta::quantize(orientation.vector().z(), MovementDelta::ORIENTATION_SCALE),
+                                     MovementDelta::quantize(orientation.scalar(), MovementDelta::ORIENTATION_SCALE)};
+            }
             lastSentLocation.m_orientation = entity.m_location.m_orientation;
         }
         if (posChange) {
             ::addToEntity(entity.m_location.pos(), move_arg->modifyPos());
             shouldSendOp = true;
-            lastSentLocation.m_pos = entity.m_location.m_pos;
         }
         if (modeChange) {
             auto prop = entity.getPropertyClassFixed<ModeProperty>();
@@ -2310,6 +2845,9 @@ void PhysicalDomain::sendMoveSight(BulletEntry& entry, bool posChange, bool velo
         }
 
         if (shouldSendOp) {
+            //The position is the baseline for the deltas, so it must only be updated when something actually is sent.
+            lastSentLocation.m_pos = entity.m_location.m_pos;
+
             Set setOp;
             move_arg->setId(entity.getId());
             if (debug_flag) {
@@ -2327,17 +2865,90 @@ void PhysicalDomain::sendMoveSight(BulletEntry& entry, bool posChange, bool velo
             double seconds = BaseWorld::instance().getTimeAsSeconds();
             setOp->setSeconds(seconds);
 
-            for (BulletEntry* observer : entry.observingThis) {
-                Sight s;
-                s->setArgs1(setOp);
-                s->setTo(observer->entity.getId());
-                s->setFrom(entity.getId());
-                s->setSeconds(seconds);
+            entry.movementSequence++;
+            delta.sequence = entry.movementSequence;
 
-                entity.sendWorld(s);
+            if (m_batchMoveSights) {
+                for (BulletEntry* observer : entry.observingThis) {
+                    auto result = m_pendingMoveSights.emplace(observer->entity.getIntId(), PendingMoveSight{});
+                    auto& pending = result.first->second;
+                    if (result.second) {
+                        pending.observerId = observer->entity.getId();
+                        pending.useMovementDeltas = acceptsMovementDeltas(observer->entity);
+                    }
+                    if (pending.useMovementDeltas) {
+                        //An observer which hasn't got a keyframe for the entity yet can't make sense of a delta.
+                        bool hadBaseline = !observer->movementBaselines.insert(delta.entityId).second;
+                        delta.write(pending.movementDeltas, deltaNeedsKeyframe || !hadBaseline);
+                        //Mode changes can't be expressed in the compact form, so the full op is sent as well.
+                        if (modeChange) {
+                            pending.setOps.emplace_back(setOp);
+                        }
+                    } else {
+                        //Whatever gets the full ops now won't have the keyframes sent earlier, so they must be sent again
+                        //if deltas are used later on.
+                        observer->movementBaselines.clear();
+                        pending.setOps.emplace_back(setOp);
+                    }
+                }
+            } else {
+                for (BulletEntry* observer : entry.observingThis) {
+                    Sight s;
+                    s->setArgs1(setOp);
+                    s->setTo(observer->entity.getId());
+                    s->setFrom(entity.getId());
+                    s->setSeconds(seconds);
+
+                    entity.sendWorld(s);
+                }
             }
         }
+    } else {
+        //Nobody has been sent any earlier position, so there's no baseline to keep.
+        entry.lastSentLocation.m_pos = entry.entity.m_location.m_pos;
+    }
+}
+
+void PhysicalDomain::flushMoveSights()
+{
+    if (m_pendingMoveSights.empty()) {
+        return;
+    }
+    double seconds = BaseWorld::instance().getTimeAsSeconds();
+    for (auto& entry : m_pendingMoveSights) {
+        auto& pending = entry.second;
+        if (!pending.movementDeltas.empty()) {
+            Anonymous deltaArg;
+            deltaArg->setAttr("movement_delta", std::move(pending.movementDeltas));
+            Set setOp;
+            setOp->setArgs1(deltaArg);
+            setOp->setFrom(m_entity.getId());
+            setOp->setSeconds(seconds);
+            pending.setOps.emplace_back(setOp);
+        }
+        Sight s;
+        s->setArgs(std::move(pending.setOps));
+        s->setTo(pending.observerId);
+        s->setSeconds(seconds);
+
+        m_entity.sendWorld(s);
     }
+    m_pendingMoveSights.clear();
+}
+
+bool PhysicalDomain::acceptsMovementDeltas(const LocatedEntity& observer)
+{
+    auto mindsProperty = observer.getPropertyClassFixed<MindsProperty>();
+    if (!mindsProperty || mindsProperty->getMinds().empty()) {
+        return false;
+    }
+    for (auto mind : mindsProperty->getMinds()) {
+        auto externalMind = dynamic_cast<ExternalMind*>(mind);
+        if (!externalMind || !externalMind->getLink() || !externalMind->getLink()->m_movementDeltas) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void PhysicalDomain::processMovedEntity(BulletEntry& bulletEntry)
@@ -2392,7 +3003,6 @@ void PhysicalDomain::processMovedEntity(BulletEntry& bulletEntry)
 
         if (posChange || velocityChange || orientationChange || angularChange || bulletEntry.modeChanged) {
             sendMoveSight(bulletEntry, posChange, velocityChange, orientationChange, angularChange, bulletEntry.modeChanged);
-            lastSentLocation.m_pos = entity.m_location.m_pos;
             bulletEntry.modeChanged = false;
         }
         if (posChange && !bulletEntry.closenessObservations.empty()) {
@@ -2465,14 +3075,20 @@ void PhysicalDomain::tick(double tickSize, OpVector& res)
     }
 
     projectileCollisions.clear();
-    auto start = std::chrono::steady_clock::now();
     //Step simulations with 60 hz.
     m_dynamicsWorld->stepSimulation((float) tickSize, static_cast<int>(60 * tickSize));
 
+    auto postProcessStart = std::chrono::steady_clock::now();
+    auto& stepTimings = m_dynamicsWorld->getStepTimings();
+    TickTimings tickTimings{};
+    tickTimings.broadphase = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(stepTimings.broadphase).count());
+    tickTimings.narrowphase = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(stepTimings.narrowphase).count());
+    tickTimings.solve = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(stepTimings.solve).count());
+
     if (debug_flag) {
         std::stringstream ss;
         ss << "Tick: " << (tickSize * 1000) << " ms Time: "
-           << (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.f)
+           << (std::chrono::duration_cast<std::chrono::microseconds>(stepTimings.total).count() / 1000.f)
            << " ms";
         debug_print(ss.str())
     }
@@ -2526,35 +3142,58 @@ void PhysicalDomain::tick(double tickSize, OpVector& res)
     processWaterBodies();
 
     //Check all entities that moved this tick.
-    for (BulletEntry* entry : m_movingEntities) {
-        //Check if the entity also moved last tick.
-        if (m_lastMovingEntities.find(entry) == m_lastMovingEntities.end()) {
-            //Didn't move before
-            processMovedEntity(*entry);
-        } else {
+    //Iterate by index, since processing an entry can cause others to be marked as moving.
+    for (size_t i = 0; i < m_movingEntities.size(); ++i) {
+        auto entry = m_movingEntities[i];
+        if (entry) {
             processMovedEntity(*entry);
-            //Erase from last moving entities, so we can find those that moved last tick, but not this.
-            m_lastMovingEntities.erase(entry);
+            //Clear the flag, so we can find those that moved last tick, but not this.
+            entry->wasMoving = false;
         }
     }
 
-    for (BulletEntry* entry : m_lastMovingEntities) {
-        //Stopped moving
-        if (entry->entity.m_location.m_angularVelocity.isValid()) {
-            entry->entity.m_location.m_angularVelocity.zero();
-        }
-        if (entry->entity.m_location.m_velocity.isValid()) {
-            debug_print("Stopped moving " << entry->entity.describeEntity())
-            entry->entity.m_location.m_velocity.zero();
+    for (size_t i = 0; i < m_lastMovingEntities.size(); ++i) {
+        auto entry = m_lastMovingEntities[i];
+        if (entry && entry->wasMoving) {
+            //Stopped moving
+            entry->wasMoving = false;
+            if (entry->entity.m_location.m_angularVelocity.isValid()) {
+                entry->entity.m_location.m_angularVelocity.zero();
+            }
+            if (entry->entity.m_location.m_velocity.isValid()) {
+                debug_print("Stopped moving " << entry->entity.describeEntity())
+                entry->entity.m_location.m_velocity.zero();
+            }
+            processMovedEntity(*entry);
         }
-        processMovedEntity(*entry);
     }
 
     //Stash those entities that moved this tick for checking next tick.
     std::swap(m_movingEntities, m_lastMovingEntities);
     m_movingEntities.clear();
+    for (auto entry : m_lastMovingEntities) {
+        if (entry) {
+            entry->isMoving = false;
+            entry->wasMoving = true;
+        }
+    }
+
+    flushMoveSights();
 
     processDirtyTerrainAreas();
+
+    tickTimings.postProcess = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - postProcessStart).count());
+    setTickTimings(tickTimings);
+}
+
+void PhysicalDomain::setTickTimings(const TickTimings& tickTimings)
+{
+    //Replace this domain's share of the totals.
+    s_tickTimings.broadphase += tickTimings.broadphase - m_tickTimings.broadphase;
+    s_tickTimings.narrowphase += tickTimings.narrowphase - m_tickTimings.narrowphase;
+    s_tickTimings.solve += tickTimings.solve - m_tickTimings.solve;
+    s_tickTimings.postProcess += tickTimings.postProcess - m_tickTimings.postProcess;
+    m_tickTimings = tickTimings;
 }
 
 void PhysicalDomain::processWaterBodies()
@@ -2591,7 +3230,7 @@ void PhysicalDomain::processWaterBodies()
                 auto prop = bulletEntry->entity.requirePropertyClassFixed<ModeProperty>("submerged");
                 prop->set("submerged");
                 bulletEntry->modeChanged = true;
-                m_movingEntities.insert(bulletEntry);
+                markAsMoving(bulletEntry);
             }
             return true;
         } else {
@@ -2605,7 +3244,7 @@ void PhysicalDomain::processWaterBodies()
                 auto prop = bulletEntry->entity.requirePropertyClassFixed<ModeProperty>("free");
                 prop->set("free");
                 bulletEntry->modeChanged = true;
-                m_movingEntities.insert(bulletEntry);
+                markAsMoving(bulletEntry);
             }
             return false;
         }
@@ -2656,7 +3295,7 @@ void PhysicalDomain::transformRestingEntities(PhysicalDomain::BulletEntry* entry
     if (collObject) {
 
         //Check if there are any objects resting on us, and move them along too.
-        std::set<BulletEntry*> objectsRestingOnOurObject = entry->attachedEntities;
+        BulletEntrySet objectsRestingOnOurObject = entry->attachedEntities;
         int numManifolds = m_dynamicsWorld->getDispatcher()->getNumManifolds();
         for (int i = 0; i < numManifolds; i++) {
             btPersistentManifold* contactManifold = m_dynamicsWorld->getDispatcher()->getManifoldByIndexInternal(i);
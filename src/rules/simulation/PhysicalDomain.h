@@ -21,11 +21,15 @@
 #include "rules/Domain.h"
 #include "rules/Location.h"
 #include "ModeProperty.h"
+#include "VisibilityGrid.h"
 
 #include <sigc++/connection.h>
 
 #include <LinearMath/btVector3.h>
 
+#include <boost/container/flat_set.hpp>
+#include <boost/container/flat_map.hpp>
+
 #include <map>
 #include <unordered_map>
 #include <tuple>
@@ -49,7 +53,7 @@ class btBroadphaseInterface;
 
 class btCollisionWorld;
 
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
 
 class PhysicalWorld;
 
@@ -72,6 +76,26 @@ class PropertyBase;
 class PhysicalDomain : public Domain
 {
     public:
+
+        /**
+         * Time, in microseconds, spent in the different phases of a tick.
+         */
+        struct TickTimings
+        {
+            int broadphase;
+            int narrowphase;
+            int solve;
+            /**
+             * Everything done after the physics simulation has been stepped, such as visibility checks and movement updates.
+             */
+            int postProcess;
+        };
+
+        /**
+         * The timings of the last tick of all physical domains added together, exposed as monitors.
+         */
+        static TickTimings s_tickTimings;
+
         explicit PhysicalDomain(LocatedEntity& entity);
 
         ~PhysicalDomain() override;
@@ -80,10 +104,15 @@ class PhysicalDomain : public Domain
 
         void getVisibleEntitiesFor(const LocatedEntity& observingEntity, std::list<LocatedEntity*>& entityList) const override;
 
-        std::list<LocatedEntity*> getObservingEntitiesFor(const LocatedEntity& observedEntity) const override;
+        void getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const override;
 
         void addEntity(LocatedEntity& entity) override;
 
+        /**
+         * Creates entries for all entities first, and then updates the broadphase structures and the visibility of all new entries once.
+         */
+        void addEntities(const std::vector<LocatedEntity*>& entities) override;
+
         void removeEntity(LocatedEntity& entity) override;
 
         void applyTransform(LocatedEntity& entity, const TransformData& transformData,
@@ -101,6 +130,14 @@ class PhysicalDomain : public Domain
 
         void tick(double t, OpVector& res);
 
+        /**
+         * The timings of the last tick of this domain.
+         */
+        const TickTimings& getTickTimings() const
+        {
+            return m_tickTimings;
+        }
+
         std::vector<CollisionEntry> queryCollision(const WFMath::Ball<3>& sphere) const override;
 
         boost::optional<std::function<void()>> observeCloseness(LocatedEntity& entity1, LocatedEntity& entity2, double reach, std::function<void()> callback) override;
@@ -113,8 +150,17 @@ class PhysicalDomain : public Domain
 
         class VisibilityCallback;
 
+        class VisibilityQuery;
+
         struct ClosenessObserverEntry;
 
+        struct BulletEntry;
+
+        /**
+         * Sets of entries are kept as sorted vectors, since they are small, iterated often and rarely changed one element at a time.
+         */
+        typedef boost::container::flat_set<BulletEntry*> BulletEntrySet;
+
         struct BulletEntry
         {
             LocatedEntity& entity;
@@ -132,11 +178,11 @@ class PhysicalDomain : public Domain
             /**
              * Set of entries which are observing by this.
              */
-            std::set<BulletEntry*> observedByThis;
+            BulletEntrySet observedByThis;
             /**
              * Set of entries which are observing this.
              */
-            std::set<BulletEntry*> observingThis;
+            BulletEntrySet observingThis;
 
             btVector3 centerOfMassOffset;
 
@@ -166,14 +212,42 @@ class PhysicalDomain : public Domain
             /**
              * A set of entities which are planted on this. They move along.
              */
-            std::set<BulletEntry*> attachedEntities;
+            BulletEntrySet attachedEntities;
 
             /**
              * Keeps track of whether the entity is actively jumping. If so we shouldn't try to clamp it to the ground.
              */
             bool isJumping = false;
 
-            std::set<ClosenessObserverEntry*> closenessObservations;
+            /**
+             * Set when the entry is in m_movingEntities, to avoid duplicates.
+             */
+            bool isMoving = false;
+
+            /**
+             * Set when the entry is in m_lastMovingEntities and hasn't moved yet this tick.
+             */
+            bool wasMoving = false;
+
+            /**
+             * Set when the entry is in m_dirtyEntries, to avoid duplicates.
+             */
+            bool isDirty = false;
+
+            /**
+             * Increased for each movement update sent for the entity. Used by the compact movement updates.
+             */
+            long movementSequence = 0;
+
+            /**
+             * Int ids of the observed entities for which this observer has been sent a compact movement keyframe.
+             * Movement deltas for other entities can't be sent until a keyframe has been sent.
+             * Cleared whenever the minds of the observer change, or it's sent full movement ops, since whatever then
+             * receives the updates might not have the keyframes.
+             */
+            boost::container::flat_set<long> movementBaselines;
+
+            boost::container::flat_set<ClosenessObserverEntry*> closenessObservations;
 
         };
 
@@ -199,13 +273,43 @@ class PhysicalDomain : public Domain
 
         std::unordered_map<long, std::unique_ptr<BulletEntry>> m_entries;
 
-        std::set<BulletEntry*> m_movingEntities;
-        std::set<BulletEntry*> m_lastMovingEntities;
-        std::set<BulletEntry*> m_dirtyEntries;
+        /**
+         * @brief Entries which have moved this tick.
+         *
+         * This and m_lastMovingEntities and m_dirtyEntries are plain lists, with membership tracked through flags in each entry,
+         * and are iterated by index since processing an entry can cause other entries to be added.
+         * Removed entries are set to null rather than erased.
+         */
+        std::vector<BulletEntry*> m_movingEntities;
+        /**
+         * Entries which moved last tick.
+         */
+        std::vector<BulletEntry*> m_lastMovingEntities;
+        /**
+         * Entries which needs to have their visibility updated.
+         */
+        std::vector<BulletEntry*> m_dirtyEntries;
+
+        /**
+         * The results of the visibility queries for the dirty entries, computed before any of them are applied.
+         * Kept between ticks to reuse the allocated memory.
+         */
+        struct VisibilityQueryResult
+        {
+            /**
+             * Entries which can see the dirty entry.
+             */
+            std::vector<BulletEntry*> observing;
+            /**
+             * Entries which can be seen by the dirty entry.
+             */
+            std::vector<BulletEntry*> observed;
+        };
+        std::vector<VisibilityQueryResult> m_visibilityQueryResults;
         /**
          * A map of all submerged entities, and the water body they currently are submerged into.
          */
-        std::map<BulletEntry*, btGhostObject*> m_submergedEntities;
+        boost::container::flat_map<BulletEntry*, btGhostObject*> m_submergedEntities;
         std::vector<WFMath::AxisBox<2>> m_dirtyTerrainAreas;
 
         std::unordered_map<long, std::tuple<std::unique_ptr<Mercator::TerrainMod>, WFMath::Point<3>, WFMath::Quaternion, WFMath::AxisBox<2>>> m_terrainMods;
@@ -243,7 +347,11 @@ class PhysicalDomain : public Domain
 
         std::unique_ptr<btDefaultCollisionConfiguration> m_collisionConfiguration;
         std::unique_ptr<btCollisionDispatcher> m_dispatcher;
-        std::unique_ptr<btSequentialImpulseConstraintSolver> m_constraintSolver;
+        std::unique_ptr<btConstraintSolver> m_constraintSolver;
+        /**
+         * Only used if Bullet is built with multithreading, in which case m_constraintSolver is a pool of solvers.
+         */
+        std::unique_ptr<btConstraintSolver> m_constraintSolverMt;
         std::unique_ptr<btBroadphaseInterface> m_broadphase;
         std::unique_ptr<PhysicalWorld> m_dynamicsWorld;
 
@@ -251,10 +359,50 @@ class PhysicalDomain : public Domain
         std::unique_ptr<btBroadphaseInterface> m_visibilityBroadphase;
         std::unique_ptr<btCollisionWorld> m_visibilityWorld;
 
+        /**
+         * @brief If set, visibility is handled by this spatial hash instead of by the m_visibilityWorld.
+         *
+         * Selected per domain through the "visibility_backend" property of the domain entity, which can be either "bullet" (the default) or "grid".
+         * The Bullet world is kept as the reference implementation; both should result in the same Appearance and Disappearance ops.
+         */
+        std::unique_ptr<VisibilityGrid<BulletEntry>> m_visibilityGrid;
+
+        /**
+         * @brief If true, all movement updates seen by an observer during a tick are merged into one Sight op, with one Set op arg per moved entity.
+         *
+         * This means that each observer gets at most one movement Sight per tick, regardless of how many entities are moving around it.
+         * Controlled by the "batch_move_sights" property of the domain entity.
+         *
+         * Observers which only have minds connected to clients that have negotiated the "movement_delta" capability instead get
+         * all movement of the tick as compact records in one Set op (see MovementDelta).
+         */
+        bool m_batchMoveSights;
+
+        struct PendingMoveSight
+        {
+            std::string observerId;
+            std::vector<Atlas::Objects::Root> setOps;
+            /**
+             * True if the observer should get compact movement updates (see MovementDelta).
+             */
+            bool useMovementDeltas;
+            /**
+             * Compact movement records, if useMovementDeltas is set.
+             */
+            Atlas::Message::ListType movementDeltas;
+        };
+
+        /**
+         * Movement Set ops which are to be sent to each observer (keyed by entity id) at the end of the tick, when batching.
+         */
+        std::unordered_map<long, PendingMoveSight> m_pendingMoveSights;
+
         sigc::connection m_propertyAppliedConnection;
 
         double m_visibilityCheckCountdown;
 
+        TickTimings m_tickTimings;
+
         BulletEntry mContainingEntityEntry;
 
         Mercator::Terrain* m_terrain;
@@ -321,12 +469,90 @@ class PhysicalDomain : public Domain
 
         void processMovedEntity(BulletEntry& bulletEntry);
 
+        /**
+         * Marks the entry as having moved this tick.
+         */
+        void markAsMoving(BulletEntry* entry);
+
+        /**
+         * Marks the entry as needing to have its visibility updated.
+         */
+        void markAsDirty(BulletEntry* entry);
+
+        /**
+         * Sends all movement Set ops which were batched during the tick, as one Sight op per observer.
+         */
+        void flushMoveSights();
+
+        /**
+         * Checks if an observer should get compact movement updates, which is the case if all of its minds are
+         * connected to clients which have negotiated the "movement_delta" capability.
+         */
+        static bool acceptsMovementDeltas(const LocatedEntity& observer);
+
+        /**
+         * Creates a new entry for a child entity and adds it to the physics and visibility worlds, without updating what it observes or is observed by.
+         * @return The new entry, or null if the entity couldn't be added.
+         */
+        BulletEntry* createEntry(LocatedEntity& entity);
+
         void updateVisibilityOfDirtyEntities(OpVector& res);
 
         void updateObservedEntry(BulletEntry* entry, OpVector& res, bool generateOps = true);
 
         void updateObserverEntry(BulletEntry* bulletEntry, OpVector& res);
 
+        /**
+         * Finds all entries which can be seen by the observer entry.
+         * This doesn't alter any state, so it can be called from multiple threads at once.
+         * @param result Found entries are added here. Might contain duplicates.
+         */
+        void queryObservedEntries(const BulletEntry& observerEntry, std::vector<BulletEntry*>& result) const;
+
+        /**
+         * Finds all entries which can see the observed entry.
+         * This doesn't alter any state, so it can be called from multiple threads at once.
+         * @param result Found entries are added here. Might contain duplicates.
+         */
+        void queryObservingEntries(const BulletEntry& observedEntry, std::vector<BulletEntry*>& result) const;
+
+        /**
+         * Updates what the observer entry can see, sending Appearance and Disappearance ops for any changes.
+         * @param observedEntries The result of queryObservedEntries(). Will be cleared.
+         */
+        void applyObservedEntries(BulletEntry* observerEntry, std::vector<BulletEntry*>& observedEntries, OpVector& res);
+
+        /**
+         * Updates what can see the observed entry, sending Appearance and Disappearance ops for any changes if generateOps is true.
+         * @param observingEntries The result of queryObservingEntries(). Will be cleared.
+         */
+        void applyObservingEntries(BulletEntry* observedEntry, std::vector<BulletEntry*>& observingEntries, OpVector& res, bool generateOps);
+
+        /**
+         * @brief Switches between the Bullet visibility world and the spatial hash, moving all entries over.
+         * @param backend Either "bullet" or "grid".
+         */
+        void setVisibilityBackend(const std::string& backend);
+
+        /**
+         * Registers the visibility sphere of the entry with the active visibility backend.
+         */
+        void addVisibilitySphere(BulletEntry& entry);
+
+        /**
+         * Registers the view sphere of the entry with the active visibility backend.
+         */
+        void addViewSphere(BulletEntry& entry);
+
+        void removeVisibilitySphere(BulletEntry& entry);
+
+        void removeViewSphere(BulletEntry& entry);
+
+        /**
+         * Updates the active visibility backend after the positions or sizes of the entry's spheres have changed.
+         */
+        void updateVisibilitySpheres(BulletEntry& entry);
+
         void applyNewPositionForEntity(BulletEntry* entry, const WFMath::Point<3>& pos, bool calculatePosition = true);
 
         bool getTerrainHeight(float x, float y, float& height) const;
@@ -344,6 +570,11 @@ class PhysicalDomain : public Domain
          */
         void processWaterBodies();
 
+        /**
+         * Stores the timings of the last tick, updating this domain's share of the static totals.
+         */
+        void setTickTimings(const TickTimings& tickTimings);
+
         std::shared_ptr<btCollisionShape> createCollisionShapeForEntry(LocatedEntity& entity,
                                                                        const WFMath::AxisBox<3>& bbox, float mass,
                                                                        btVector3& centerOfMassOffse);
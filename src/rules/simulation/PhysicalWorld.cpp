@@ -18,9 +18,19 @@
 
 #include "PhysicalWorld.h"
 #include <BulletDynamics/Dynamics/btRigidBody.h>
+#include <BulletCollision/BroadphaseCollision/btDispatcher.h>
 
-PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration)
-    : btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher,
+                             btBroadphaseInterface* pairCache,
+                             btConstraintSolver* constraintSolver,
+                             btCollisionConfiguration* collisionConfiguration,
+                             btConstraintSolver* constraintSolverMt)
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+    : PhysicalWorldBase(dispatcher, pairCache, static_cast<btConstraintSolverPoolMt*>(constraintSolver), constraintSolverMt, collisionConfiguration),
+#else
+    : PhysicalWorldBase(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+#endif
+      m_stepTimings{}
 {}
 
 void PhysicalWorld::synchronizeMotionStates()
@@ -30,7 +40,10 @@ void PhysicalWorld::synchronizeMotionStates()
 
 int PhysicalWorld::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
 {
-    int steps = btDiscreteDynamicsWorld::stepSimulation(timeStep, maxSubSteps, fixedTimeStep);
+    m_stepTimings = {};
+    auto start = std::chrono::steady_clock::now();
+
+    int steps = PhysicalWorldBase::stepSimulation(timeStep, maxSubSteps, fixedTimeStep);
 
     //iterate over all active rigid bodies
     for (int i = 0; i < m_nonStaticRigidBodies.size(); i++) {
@@ -39,5 +52,32 @@ int PhysicalWorld::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar f
             synchronizeSingleMotionState(body);
         }
     }
+    m_stepTimings.total = std::chrono::steady_clock::now() - start;
     return steps;
 }
+
+void PhysicalWorld::performDiscreteCollisionDetection()
+{
+    //This does the same as btCollisionWorld::performDiscreteCollisionDetection, but with timing of the broadphase and narrowphase.
+    auto start = std::chrono::steady_clock::now();
+
+    updateAabbs();
+    m_broadphasePairCache->calculateOverlappingPairs(m_dispatcher1);
+
+    auto broadphaseEnd = std::chrono::steady_clock::now();
+    m_stepTimings.broadphase += broadphaseEnd - start;
+
+    btDispatcher* dispatcher = getDispatcher();
+    if (dispatcher) {
+        dispatcher->dispatchAllCollisionPairs(m_broadphasePairCache->getOverlappingPairCache(), getDispatchInfo(), m_dispatcher1);
+    }
+
+    m_stepTimings.narrowphase += std::chrono::steady_clock::now() - broadphaseEnd;
+}
+
+void PhysicalWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+    auto start = std::chrono::steady_clock::now();
+    PhysicalWorldBase::solveConstraints(solverInfo);
+    m_stepTimings.solve += std::chrono::steady_clock::now() - start;
+}
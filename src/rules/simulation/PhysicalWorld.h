@@ -21,17 +21,75 @@
 
 
 #include <BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h>
+#include <chrono>
 
-class PhysicalWorld : public btDiscreteDynamicsWorld
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+
+/**
+ * When Bullet is built with multithreading support we'll use the multithreaded world,
+ * which dispatches collisions and solves islands through the Bullet task scheduler.
+ * If no task scheduler with worker threads has been set up it will run everything sequentially.
+ */
+typedef btDiscreteDynamicsWorldMt PhysicalWorldBase;
+#else
+typedef btDiscreteDynamicsWorld PhysicalWorldBase;
+#endif
+
+class PhysicalWorld : public PhysicalWorldBase
 {
     public:
-        PhysicalWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration);
+
+        /**
+         * Time spent in the different phases of the simulation during the last call to stepSimulation.
+         * If there were multiple sub steps the time for each is added together.
+         */
+        struct StepTimings
+        {
+            /**
+             * Updating of AABBs and finding of overlapping pairs.
+             */
+            std::chrono::steady_clock::duration broadphase;
+            /**
+             * Generating contacts for the overlapping pairs.
+             */
+            std::chrono::steady_clock::duration narrowphase;
+            /**
+             * Solving constraints and contacts.
+             */
+            std::chrono::steady_clock::duration solve;
+            /**
+             * The whole step, including the above as well as integration and synchronization of motion states.
+             */
+            std::chrono::steady_clock::duration total;
+        };
+
+        /**
+         * @param constraintSolver The solver. If Bullet is multithreaded this must be a btConstraintSolverPoolMt instance.
+         * @param constraintSolverMt A multithreaded solver, used for large islands. Only used if Bullet is multithreaded.
+         */
+        PhysicalWorld(btDispatcher* dispatcher,
+                      btBroadphaseInterface* pairCache,
+                      btConstraintSolver* constraintSolver,
+                      btCollisionConfiguration* collisionConfiguration,
+                      btConstraintSolver* constraintSolverMt = nullptr);
 
 
         void synchronizeMotionStates() override;
 
         int stepSimulation(btScalar timeStep, int maxSubSteps = 1, btScalar fixedTimeStep = btScalar(1.) / btScalar(60.)) override;
 
+        void performDiscreteCollisionDetection() override;
+
+        const StepTimings& getStepTimings() const
+        {
+            return m_stepTimings;
+        }
+
+    protected:
+        void solveConstraints(btContactSolverInfo& solverInfo) override;
+
+        StepTimings m_stepTimings;
 
 };
 
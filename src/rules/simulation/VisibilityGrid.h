@@ -0,0 +1,322 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+#ifndef CYPHESIS_VISIBILITYGRID_H
+#define CYPHESIS_VISIBILITYGRID_H
+
+#include <LinearMath/btVector3.h>
+
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief A uniform spatial hash used for interest management, i.e. for figuring out which observers can see which entries.
+ *
+ * This is an alternative to the Bullet collision world which the PhysicalDomain otherwise uses for visibility checks.
+ * Both observers (view spheres) and observables (visibility spheres) are stored as spheres, and are bucketed into square
+ * cells on the horizontal (x, z) plane. A sphere is registered in every cell touched by its bounds, so any two
+ * overlapping spheres are guaranteed to share at least one cell.
+ *
+ * Updates are incremental: when a sphere moves the cell buckets are only touched if the set of cells it covers
+ * has changed, which for most movement isn't the case.
+ *
+ * Spheres which would cover very many cells (for example entities with a large "visibility" value) are kept in a
+ * separate list which is checked by all queries, to keep the memory and update cost bounded.
+ *
+ * Filtering uses the same group/mask semantics as Bullet, and the overlap test is the same as Bullet's sphere-sphere
+ * test, so queries give the same results as a contact test against a btCollisionWorld.
+ *
+ * @tparam T The entry type referenced by the grid. The grid doesn't own the entries.
+ */
+template<typename T>
+class VisibilityGrid
+{
+    public:
+        /**
+         * Max number of cells along one axis a sphere can cover before it's treated as oversized.
+         */
+        static constexpr int MAX_CELLS_PER_AXIS = 16;
+
+        /**
+         * @param cellSize The size of each cell, in the same units as the positions.
+         */
+        explicit VisibilityGrid(float cellSize)
+                : m_cellSize(cellSize)
+        {
+        }
+
+        void addObserver(T* entry, const btVector3& pos, float radius, short group, short mask)
+        {
+            add(m_observers, entry, pos, radius, group, mask);
+        }
+
+        void addObservable(T* entry, const btVector3& pos, float radius, short group, short mask)
+        {
+            add(m_observables, entry, pos, radius, group, mask);
+        }
+
+        void updateObserver(T* entry, const btVector3& pos)
+        {
+            update(m_observers, entry, pos, nullptr);
+        }
+
+        void updateObservable(T* entry, const btVector3& pos, float radius)
+        {
+            update(m_observables, entry, pos, &radius);
+        }
+
+        void removeObserver(T* entry)
+        {
+            remove(m_observers, entry);
+        }
+
+        void removeObservable(T* entry)
+        {
+            remove(m_observables, entry);
+        }
+
+        /**
+         * Finds all observables touching the supplied sphere, and which passes the filter.
+         * @param pos Center of the sphere.
+         * @param radius Radius of the sphere.
+         * @param group The filter group of the sphere.
+         * @param mask The filter mask of the sphere.
+         * @param result All found entries will be added here. Entries might be added more than once.
+         */
+        void findObservables(const btVector3& pos, float radius, short group, short mask, std::vector<T*>& result) const
+        {
+            find(m_observables, pos, radius, group, mask, result);
+        }
+
+        /**
+         * Finds all observers touching the supplied sphere, and which passes the filter.
+         * @param pos Center of the sphere.
+         * @param radius Radius of the sphere.
+         * @param group The filter group of the sphere.
+         * @param mask The filter mask of the sphere.
+         * @param result All found entries will be added here. Entries might be added more than once.
+         */
+        void findObservers(const btVector3& pos, float radius, short group, short mask, std::vector<T*>& result) const
+        {
+            find(m_observers, pos, radius, group, mask, result);
+        }
+
+        size_t observerCount() const
+        {
+            return m_observers.items.size();
+        }
+
+        size_t observableCount() const
+        {
+            return m_observables.items.size();
+        }
+
+        /**
+         * @return The number of non-empty cells. Mainly useful for diagnostics and tests.
+         */
+        size_t cellCount() const
+        {
+            return m_observers.cells.size() + m_observables.cells.size();
+        }
+
+    private:
+
+        struct CellRange
+        {
+            int minX;
+            int minZ;
+            int maxX;
+            int maxZ;
+
+            bool operator==(const CellRange& rhs) const
+            {
+                return minX == rhs.minX && minZ == rhs.minZ && maxX == rhs.maxX && maxZ == rhs.maxZ;
+            }
+
+            bool operator!=(const CellRange& rhs) const
+            {
+                return !(*this == rhs);
+            }
+
+            bool isOversized() const
+            {
+                return (maxX - minX) >= MAX_CELLS_PER_AXIS || (maxZ - minZ) >= MAX_CELLS_PER_AXIS;
+            }
+        };
+
+        struct Item
+        {
+            T* entry;
+            btVector3 pos;
+            float radius;
+            short group;
+            short mask;
+            CellRange range;
+        };
+
+        struct Layer
+        {
+            std::unordered_map<T*, Item> items;
+            std::unordered_map<std::int64_t, std::vector<Item*>> cells;
+            std::vector<Item*> oversized;
+        };
+
+        float m_cellSize;
+        Layer m_observers;
+        Layer m_observables;
+
+        static std::int64_t cellKey(int x, int z)
+        {
+            return (static_cast<std::int64_t>(x) << 32) | static_cast<std::uint32_t>(z);
+        }
+
+        CellRange rangeFor(const btVector3& pos, float radius) const
+        {
+            return CellRange{static_cast<int>(std::floor((pos.x() - radius) / m_cellSize)),
+                             static_cast<int>(std::floor((pos.z() - radius) / m_cellSize)),
+                             static_cast<int>(std::floor((pos.x() + radius) / m_cellSize)),
+                             static_cast<int>(std::floor((pos.z() + radius) / m_cellSize))};
+        }
+
+        static void link(Layer& layer, Item& item)
+        {
+            if (item.range.isOversized()) {
+                layer.oversized.push_back(&item);
+            } else {
+                for (int x = item.range.minX; x <= item.range.maxX; ++x) {
+                    for (int z = item.range.minZ; z <= item.range.maxZ; ++z) {
+                        layer.cells[cellKey(x, z)].push_back(&item);
+                    }
+                }
+            }
+        }
+
+        static void unlinkFrom(std::vector<Item*>& items, Item& item)
+        {
+            auto I = std::find(items.begin(), items.end(), &item);
+            if (I != items.end()) {
+                *I = items.back();
+                items.pop_back();
+            }
+        }
+
+        static void unlink(Layer& layer, Item& item)
+        {
+            if (item.range.isOversized()) {
+                unlinkFrom(layer.oversized, item);
+            } else {
+                for (int x = item.range.minX; x <= item.range.maxX; ++x) {
+                    for (int z = item.range.minZ; z <= item.range.maxZ; ++z) {
+                        auto I = layer.cells.find(cellKey(x, z));
+                        if (I != layer.cells.end()) {
+                            unlinkFrom(I->second, item);
+                            if (I->second.empty()) {
+                                layer.cells.erase(I);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        void add(Layer& layer, T* entry, const btVector3& pos, float radius, short group, short mask)
+        {
+            auto result = layer.items.emplace(entry, Item{entry, pos, radius, group, mask, rangeFor(pos, radius)});
+            auto& item = result.first->second;
+            if (!result.second) {
+                //Already registered; treat as a full re-add, since the filter might have changed.
+                unlink(layer, item);
+                item = Item{entry, pos, radius, group, mask, rangeFor(pos, radius)};
+            }
+            link(layer, item);
+        }
+
+        void update(Layer& layer, T* entry, const btVector3& pos, const float* radius)
+        {
+            auto I = layer.items.find(entry);
+            if (I == layer.items.end()) {
+                return;
+            }
+            auto& item = I->second;
+            item.pos = pos;
+            if (radius) {
+                item.radius = *radius;
+            }
+            auto newRange = rangeFor(pos, item.radius);
+            //Only touch the cells if the entry has crossed into other cells.
+            if (newRange != item.range) {
+                unlink(layer, item);
+                item.range = newRange;
+                link(layer, item);
+            }
+        }
+
+        static void remove(Layer& layer, T* entry)
+        {
+            auto I = layer.items.find(entry);
+            if (I != layer.items.end()) {
+                unlink(layer, I->second);
+                layer.items.erase(I);
+            }
+        }
+
+        static bool passes(const Item& item, const btVector3& pos, float radius, short group, short mask)
+        {
+            if ((item.group & mask) == 0 || (group & item.mask) == 0) {
+                return false;
+            }
+            //Same check as in btSphereSphereCollisionAlgorithm
+            float combinedRadius = item.radius + radius;
+            return item.pos.distance2(pos) <= combinedRadius * combinedRadius;
+        }
+
+        void find(const Layer& layer, const btVector3& pos, float radius, short group, short mask, std::vector<T*>& result) const
+        {
+            for (auto item : layer.oversized) {
+                if (passes(*item, pos, radius, group, mask)) {
+                    result.push_back(item->entry);
+                }
+            }
+            auto range = rangeFor(pos, radius);
+            if (range.isOversized()) {
+                //The query covers too many cells for the buckets to be of any help; check every item.
+                for (auto& entry : layer.items) {
+                    if (!entry.second.range.isOversized() && passes(entry.second, pos, radius, group, mask)) {
+                        result.push_back(entry.first);
+                    }
+                }
+                return;
+            }
+            for (int x = range.minX; x <= range.maxX; ++x) {
+                for (int z = range.minZ; z <= range.maxZ; ++z) {
+                    auto I = layer.cells.find(cellKey(x, z));
+                    if (I != layer.cells.end()) {
+                        for (auto item : I->second) {
+                            if (passes(*item, pos, radius, group, mask)) {
+                                result.push_back(item->entry);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+};
+
+#endif //CYPHESIS_VISIBILITYGRID_H
@@ -173,7 +173,9 @@ void World::clearWorld(OpVector& res)
         if (propIter->first != "id") {
             auto& prop = propIter->second;
             prop.property->remove(this, propIter->first);
+            auto name = propIter->first;
             m_properties.erase(propIter++);
+            onPropertyInstanceChanged(name);
         } else {
             ++propIter;
         }
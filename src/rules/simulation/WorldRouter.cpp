@@ -338,6 +338,8 @@ void WorldRouter::operation(const Operation& op, Ref<LocatedEntity> from)
             deliverTo(op, entry.second);
         }
     }
+
+    Dispatched.emit();
 }
 
 /// Find an entity of the given name. This is provided to allow administrators
@@ -286,6 +286,7 @@ void Connection::LoginOperation(const Operation & op, OpVector & res)
         clientError(op, "This account is already logged in", res);
         return;
     }
+    readCapabilities(arg);
     // Connect everything up
     addConnectableRouter(account);
     m_server.getLobby().addAccount(account);
@@ -352,6 +353,7 @@ void Connection::CreateOperation(const Operation & op, OpVector & res)
         clientError(op, "Account creation failed", res);
         return;
     }
+    readCapabilities(arg);
     Info info;
     Anonymous info_arg;
     account->addToEntity(info_arg);
@@ -366,6 +368,25 @@ void Connection::CreateOperation(const Operation & op, OpVector & res)
                                     account->getType()));
 }
 
+/// \brief Reads the optional protocol capabilities a client asks for when
+/// logging in or creating an account.
+///
+/// The client sends these as a list of strings in the "capabilities"
+/// attribute. Any capability which isn't offered by the server is ignored,
+/// and the client should then expect the standard ops.
+void Connection::readCapabilities(const Root & arg)
+{
+    Element capabilities_attr;
+    if (arg->copyAttr("capabilities", capabilities_attr) != 0 || !capabilities_attr.isList()) {
+        return;
+    }
+    for (auto& capability : capabilities_attr.List()) {
+        if (capability == "movement_delta" && movement_deltas_flag) {
+            m_movementDeltas = true;
+        }
+    }
+}
+
 void Connection::LogoutOperation(const Operation & op, OpVector & res)
 {
     const std::vector<Root> & args = op->getArgs();
@@ -61,6 +61,7 @@ class Connection : public Link, virtual public sigc::trackable {
                                  const std::string & id, long intId);
     virtual int verifyCredentials(const Account &,
                                   const Atlas::Objects::Root &) const;
+    void readCapabilities(const Atlas::Objects::Root & arg);
   public:
     ServerRouting & m_server;
 
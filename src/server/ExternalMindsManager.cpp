@@ -71,6 +71,14 @@ int ExternalMindsManager::addConnection(
 int ExternalMindsManager::removeConnection(const std::string& routerId)
 {
     auto result = m_connections.erase(routerId);
+    m_assignmentCounts.erase(routerId);
+    for (auto I = m_assignedRouters.begin(); I != m_assignedRouters.end();) {
+        if (I->second == routerId) {
+            I = m_assignedRouters.erase(I);
+        } else {
+            ++I;
+        }
+    }
     if (result == 0) {
         log(WARNING,
             String::compose(
@@ -132,10 +140,11 @@ int ExternalMindsManager::requestPossessionFromRegisteredClients(const std::stri
     if (!m_connections.empty()) {
         auto result = PossessionAuthenticator::instance().getPossessionKey(entity_id);
         if (result.is_initialized()) {
-            //Use the last one registered.
-            //TODO: implement a better way to select the connection to use. Should we rotate the connections?
-            //Or do some kind of selection?
-            ExternalMindsConnection& connection = m_connections.rbegin()->second;
+            //If the entity was assigned to a connection earlier it might now be better handled by another.
+            unassignEntity(entity_id);
+            ExternalMindsConnection& connection = selectConnection();
+            m_assignedRouters[entity_id] = connection.getRouterId();
+            m_assignmentCounts[connection.getRouterId()]++;
 
             Atlas::Objects::Operation::Possess possessOp;
 
@@ -160,10 +169,39 @@ int ExternalMindsManager::requestPossessionFromRegisteredClients(const std::stri
     return 1;
 }
 
+ExternalMindsConnection& ExternalMindsManager::selectConnection()
+{
+    //Prefer the last registered connection if there are multiple with the same number of entities.
+    ExternalMindsConnection* selected = nullptr;
+    size_t selectedCount = 0;
+    for (auto& entry : m_connections) {
+        auto I = m_assignmentCounts.find(entry.first);
+        size_t count = I == m_assignmentCounts.end() ? 0 : I->second;
+        if (!selected || count <= selectedCount) {
+            selected = &entry.second;
+            selectedCount = count;
+        }
+    }
+    return *selected;
+}
+
+void ExternalMindsManager::unassignEntity(const std::string& entity_id)
+{
+    auto I = m_assignedRouters.find(entity_id);
+    if (I != m_assignedRouters.end()) {
+        auto countI = m_assignmentCounts.find(I->second);
+        if (countI != m_assignmentCounts.end() && countI->second > 0) {
+            countI->second--;
+        }
+        m_assignedRouters.erase(I);
+    }
+}
+
 void ExternalMindsManager::entity_destroyed(LocatedEntity* entity)
 {
     m_unpossessedEntities.erase(entity);
     m_possessedEntities.erase(entity);
+    unassignEntity(entity->getId());
 }
 
 void ExternalMindsManager::entity_mindsChanged(LocatedEntity* entity, const MindsProperty* mindsProp)
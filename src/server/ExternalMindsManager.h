@@ -63,11 +63,31 @@ class ExternalMindsManager : public virtual sigc::trackable, public Singleton<Ex
         std::unordered_set<LocatedEntity*> m_unpossessedEntities;
         std::unordered_set<LocatedEntity*> m_possessedEntities;
 
+        /**
+         * The router which each entity last was asked to be possessed by, keyed by entity id.
+         */
+        std::map<std::string, std::string> m_assignedRouters;
+        /**
+         * The number of entities assigned to each router, keyed by router id.
+         */
+        std::map<std::string, size_t> m_assignmentCounts;
+
         void entity_destroyed(LocatedEntity* character);
         void entity_mindsChanged(LocatedEntity* character, const MindsProperty* mindsProp);
 
         int requestPossessionFromRegisteredClients(const std::string& character_id);
 
+        /**
+         * Selects the connection to ask for possession, which is the one with the fewest entities assigned to it.
+         *
+         * Since each AI client process runs all of its minds on one thread, this spreads the minds over all
+         * processes (as set by the "aiclients" option), letting the AI use more than one core.
+         * @return A connection. There must be at least one registered.
+         */
+        ExternalMindsConnection& selectConnection();
+
+        void unassignEntity(const std::string& entity_id);
+
         void addPossessionEntryForCharacter(LocatedEntity* character);
 
 
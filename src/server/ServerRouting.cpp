@@ -43,6 +43,9 @@ using Atlas::Objects::Entity::RootEntity;
 BOOL_OPTION(restricted_flag, false, CYPHESIS, "restricted",
             "Flag to control restricted mode");
 
+BOOL_OPTION(movement_deltas_flag, false, CYPHESIS, "movement_deltas",
+            "Flag to allow clients to ask for compact movement updates");
+
 /// \brief Constructor for server object.
 ///
 /// Requires a reference to the World management object, as well as the
@@ -183,6 +186,10 @@ void ServerRouting::addToEntity(const RootEntity& ent) const
 
     ent->setAttr("assets", Atlas::Message::ListType{"file://" + assets_directory});
 
+    if (movement_deltas_flag) {
+        ent->setAttr("capabilities", Atlas::Message::ListType{"movement_delta"});
+    }
+
     // We could add all sorts of stats here, but I don't know exactly what yet.
 }
 
@@ -35,6 +35,7 @@ class Lobby;
 typedef std::map<long, std::unique_ptr<ConnectableRouter>> ConnectableRouterMap;
 
 extern bool restricted_flag;
+extern bool movement_deltas_flag;
 
 /// \brief ServerRouting represents the core of the server.
 ///
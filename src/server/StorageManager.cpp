@@ -31,6 +31,8 @@
 #include "common/PropertyManager.h"
 #include "common/id.h"
 #include "common/Variable.h"
+#include "common/WorkerPool.h"
+#include "common/globals.h"
 
 
 #include <Atlas/Objects/Anonymous.h>
@@ -39,6 +41,9 @@
 
 #include <sigc++/adaptors/bind.h>
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
 #include <unordered_set>
 
 using Atlas::Message::MapType;
@@ -50,11 +55,17 @@ typedef Database::KeyValues KeyValues;
 
 static const bool debug_flag = false;
 
+namespace {
+    INT_OPTION(restore_threads, 0, CYPHESIS, "restore_threads",
+               "Number of worker threads used for decoding entities when restoring the world from storage. Set to 0 to decode on the main thread.")
+}
+
 StorageManager::StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder) :
         m_world(world),
         m_db(db), m_entityBuilder(entityBuilder),
         m_insertEntityCount(0), m_updateEntityCount(0),
         m_insertPropertyCount(0), m_updatePropertyCount(0),
+        m_writtenPropertyCount(0), m_skippedPropertyCount(0),
         m_insertQps(0), m_updateQps(0),
         m_insertQpsNow(0), m_updateQpsNow(0),
         m_insertQpsAvg(0), m_updateQpsAvg(0),
@@ -73,6 +84,10 @@ StorageManager::StorageManager(WorldRouter& world, Database& db, EntityBuilder&
                                new Variable<int>(m_insertPropertyCount));
     Monitors::instance().watch("storage_property_updates",
                                new Variable<int>(m_updatePropertyCount));
+    Monitors::instance().watch(R"(storage_properties{result="written"})",
+                               new Variable<int>(m_writtenPropertyCount));
+    Monitors::instance().watch(R"(storage_properties{result="skipped"})",
+                               new Variable<int>(m_skippedPropertyCount));
 
     Monitors::instance().watch(R"(storage_qps{qtype="inserts",t="1"})",
                                new Variable<int>(m_insertQpsNow));
@@ -146,39 +161,16 @@ void StorageManager::encodeElement(const Atlas::Message::Element& element, std::
     m_db.encodeObject(map, store);
 }
 
-void StorageManager::restorePropertiesRecursively(LocatedEntity* ent)
+void StorageManager::restoreProperties(LocatedEntity* ent, const std::vector<std::pair<std::string, Element>>& properties)
 {
-    DatabaseResult res = m_db.selectProperties(ent->getId());
-
     //Keep track of those properties that have been set on the instance, so we'll know what
     //type properties we should ignore.
     std::unordered_set<std::string> instanceProperties;
 
-    auto I = res.begin();
-    auto Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string name = I.column("name");
-        if (name.empty()) {
-            log(ERROR, compose("No name column in property row for %1",
-                               ent->describeEntity()));
-            continue;
-        }
-        const std::string val_string = I.column("value");
-        if (name.empty()) {
-            log(ERROR, compose("No value column in property row for %1,%2",
-                               ent->describeEntity(), name));
-            continue;
-        }
-        MapType prop_data;
-        m_db.decodeMessage(val_string, prop_data);
-        auto J = prop_data.find("val");
-        if (J == prop_data.end()) {
-            log(ERROR, compose("No property value data for %1:%2",
-                               ent->describeEntity(), name));
-            continue;
-        }
+    for (auto& entry : properties) {
+        auto& name = entry.first;
         assert(ent->getType() != nullptr);
-        auto& val = J->second;
+        auto& val = entry.second;
 
         Element existingVal;
         if (ent->getAttr(name, existingVal) == 0) {
@@ -218,35 +210,6 @@ void StorageManager::restorePropertiesRecursively(LocatedEntity* ent)
             }
         }
     }
-
-    if (ent->m_location.m_parent) {
-        auto domain = ent->m_location.m_parent->getDomain();
-        if (domain) {
-            domain->addEntity(*ent);
-        }
-    }
-
-
-    //Now restore all properties of the child entities.
-    if (ent->m_contains) {
-        //It might be that the contains field gets altered by restoring of children, so we need to operate on a copy.
-        auto contains = *ent->m_contains;
-        for (auto& childEntity : contains) {
-            restorePropertiesRecursively(childEntity.get());
-        }
-    }
-
-//    //We should also send a sight op to the parent entity which owns the entity.
-//    //TODO: should this really be necessary or should we rely on other Sight functionality?
-//    if (ent->m_location.m_parent) {
-//        Atlas::Objects::Operation::Sight sight;
-//        sight->setTo(ent->m_location.m_parent->getId());
-//        Atlas::Objects::Entity::Anonymous args;
-//        ent->addToEntity(args);
-//        sight->setArgs1(args);
-//        ent->m_location.m_parent->sendWorld(sight);
-//    }
-
 }
 
 void StorageManager::insertEntity(LocatedEntity* ent)
@@ -283,6 +246,7 @@ void StorageManager::insertEntity(LocatedEntity* ent)
         } else {
             encodeElement(entry.second.baseValue, property_tuples[entry.first]);
         }
+        ++m_writtenPropertyCount;
         prop->addFlags(prop_flag_persistence_clean | prop_flag_persistence_seen);
     }
     if (!property_tuples.empty()) {
@@ -328,32 +292,22 @@ void StorageManager::updateEntity(LocatedEntity* ent)
         if (!prop) {
             continue;
         }
-        if (prop->hasFlags(prop_flag_persistence_mask)) {
+        if (prop->hasFlags(prop_flag_persistence_ephem)) {
+            continue;
+        }
+        //Only properties which have been changed since they were last persisted need to be written.
+        if (prop->hasFlags(prop_flag_persistence_clean)) {
+            ++m_skippedPropertyCount;
             continue;
         }
         KeyValues& active_store = prop->hasFlags(prop_flag_persistence_seen) ? upd_property_tuples : new_property_tuples;
+        //TODO: Add code for deleting a database row when the value is none.
         if (property.second.modifiers.empty()) {
-            Atlas::Message::Element element;
-            prop->get(element);
-            if (element.isNone()) {
-                //TODO: Add code for deleting a database row when the value is none.
-                Atlas::Message::MapType propMap{{"val", std::move(element)}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            } else {
-                Atlas::Message::MapType propMap{{"val", std::move(element)}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            }
+            encodeProperty(prop.get(), active_store[property.first]);
         } else {
-            auto& element = property.second.baseValue;
-            if (element.isNone()) {
-                //TODO: Add code for deleting a database row when the value is none.
-                Atlas::Message::MapType propMap{{"val", element}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            } else {
-                Atlas::Message::MapType propMap{{"val", element}};
-                m_db.encodeObject(propMap, active_store[property.first]);
-            }
+            encodeElement(property.second.baseValue, active_store[property.first]);
         }
+        ++m_writtenPropertyCount;
 
         // FIXME check if this is new or just modded.
         if (prop->hasFlags(prop_flag_persistence_seen)) {
@@ -374,40 +328,92 @@ void StorageManager::updateEntity(LocatedEntity* ent)
     ent->addFlags(entity_clean_mask);
 }
 
-size_t StorageManager::restoreChildren(LocatedEntity* parent)
+std::vector<StorageManager::StoredEntity> StorageManager::readStoredEntities(const std::string& rootId, size_t& propertyCount)
 {
-    size_t childCount = 0;
-    DatabaseResult res = m_db.selectEntities(parent->getId());
-
-    // Iterate over res creating entities, and sorting out position, location
-    // and orientation. Restore children, but don't restore any properties yet.
-    auto I = res.begin();
-    auto Iend = res.end();
-    for (; I != Iend; ++I) {
-        const std::string id = I.column("id");
-        const long int_id = forceIntegerId(id);
-        const std::string type = I.column("type");
-        //By sending an empty attributes pointer we're telling the builder not to apply any default
-        //attributes. We will instead apply all attributes ourselves when we later on restore attributes.
-        Atlas::Objects::SmartPtr<Atlas::Objects::Entity::RootEntityData> attrs(nullptr);
-        auto child = m_entityBuilder.newEntity(id, int_id, type, attrs);
-        if (!child) {
-            log(ERROR, compose("Could not restore entity with id %1 of type %2"
-                               ", most likely caused by this type missing.",
-                               id, type));
-            continue;
+    std::vector<StoredEntity> storedEntities;
+    std::unordered_map<std::string, size_t> indices;
+
+    //The root entity normally has no row of its own in the entities table, but it might have properties.
+    storedEntities.emplace_back();
+    storedEntities.front().id = rootId;
+    indices.emplace(rootId, 0);
+
+    {
+        DatabaseResult res = m_db.selectAllEntities();
+        storedEntities.reserve(static_cast<size_t>(res.size()) + 1);
+        for (auto I = res.begin(); I != res.end(); ++I) {
+            std::string id = I.column("id");
+            if (id == rootId) {
+                continue;
+            }
+            indices.emplace(id, storedEntities.size());
+            storedEntities.emplace_back();
+            auto& stored = storedEntities.back();
+            stored.id = std::move(id);
+            stored.loc = I.column("loc");
+            stored.type = I.column("type");
+            stored.encodedLocation = I.data("location");
         }
-        childCount++;
+    }
 
-        const std::string location_string = I.column("location");
-        MapType loc_data;
-        m_db.decodeMessage(location_string, loc_data);
-        child->m_location.readFromMessage(loc_data);
-        child->addFlags(entity_clean | entity_pos_clean | entity_orient_clean);
-        m_world.addEntity(child, parent);
-        childCount += restoreChildren(child.get());
+    //Entities can only be linked to their parents once all have been read, since they might be stored in any order.
+    for (size_t i = 1; i < storedEntities.size(); ++i) {
+        auto I = indices.find(storedEntities[i].loc);
+        if (I != indices.end()) {
+            storedEntities[I->second].children.push_back(i);
+        }
     }
-    return childCount;
+
+    propertyCount = 0;
+    {
+        //The properties are ordered by entity id, so that we only need to look up each entity once.
+        DatabaseResult res = m_db.selectAllProperties();
+        StoredEntity* stored = nullptr;
+        std::string currentId;
+        for (auto I = res.begin(); I != res.end(); ++I) {
+            const char* id = I.column("id");
+            if (!stored || currentId != id) {
+                currentId = id;
+                auto J = indices.find(currentId);
+                stored = J != indices.end() ? &storedEntities[J->second] : nullptr;
+            }
+            if (!stored) {
+                continue;
+            }
+            std::string name = I.column("name");
+            if (name.empty()) {
+                log(ERROR, compose("No name column in property row for %1", currentId));
+                continue;
+            }
+            stored->encodedProperties.emplace_back(std::move(name), I.data("value"));
+            propertyCount++;
+        }
+    }
+
+    return storedEntities;
+}
+
+void StorageManager::decodeStoredEntities(std::vector<StoredEntity>& storedEntities)
+{
+    WorkerPool workerPool(static_cast<size_t>(std::max(restore_threads, 0)));
+    workerPool.parallelFor(storedEntities.size(), [&](size_t index) {
+        auto& stored = storedEntities[index];
+        m_db.decodeMessage(stored.encodedLocation, stored.location);
+        stored.properties.reserve(stored.encodedProperties.size());
+        for (auto& entry : stored.encodedProperties) {
+            MapType prop_data;
+            m_db.decodeMessage(entry.second, prop_data);
+            auto J = prop_data.find("val");
+            if (J == prop_data.end()) {
+                stored.invalidProperties.push_back(entry.first);
+                continue;
+            }
+            stored.properties.emplace_back(entry.first, std::move(J->second));
+        }
+        //Free the encoded data as soon as possible, since large worlds take up a lot of memory.
+        std::string().swap(stored.encodedLocation);
+        std::vector<std::pair<std::string, std::string>>().swap(stored.encodedProperties);
+    });
 }
 
 void StorageManager::tick()
@@ -508,17 +514,96 @@ int StorageManager::restoreWorld(const Ref<LocatedEntity>& ent)
 {
     log(INFO, "Starting restoring world from storage.");
 
+    auto millisecondsSince = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    //All entities and properties are read in two queries, and the properties are then decoded on worker threads.
+    auto start = std::chrono::steady_clock::now();
+    size_t propertyCount;
+    auto storedEntities = readStoredEntities(ent->getId(), propertyCount);
+    auto readDuration = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    decodeStoredEntities(storedEntities);
+    auto decodeDuration = millisecondsSince(start);
+
     //The order here is important. We want to restore the children before we restore the properties.
     //The reason for this is that some properties (such as "attached_*") refer to child entities; if
     //the child isn't present when the property is installed there will be issues.
     //We do this by first restoring the children, without any properties, and the assigning the properties to
-    //all entities in order.
-    auto childCount = restoreChildren(ent.get());
+    //all entities in order. Entities are created depth first, with parents before their children.
+    start = std::chrono::steady_clock::now();
+    std::vector<std::pair<const StoredEntity*, Ref<LocatedEntity>>> restoredEntities;
+    restoredEntities.reserve(storedEntities.size());
+    restoredEntities.emplace_back(&storedEntities.front(), ent);
+    std::vector<std::pair<size_t, LocatedEntity*>> pending;
+    auto pushChildren = [&](const StoredEntity& stored, LocatedEntity* parent) {
+        for (auto I = stored.children.rbegin(); I != stored.children.rend(); ++I) {
+            pending.emplace_back(*I, parent);
+        }
+    };
+    pushChildren(storedEntities.front(), ent.get());
+    while (!pending.empty()) {
+        auto entry = pending.back();
+        pending.pop_back();
+        auto& stored = storedEntities[entry.first];
+        //By sending an empty attributes pointer we're telling the builder not to apply any default
+        //attributes. We will instead apply all attributes ourselves when we later on restore attributes.
+        Atlas::Objects::SmartPtr<Atlas::Objects::Entity::RootEntityData> attrs(nullptr);
+        auto child = m_entityBuilder.newEntity(stored.id, forceIntegerId(stored.id), stored.type, attrs);
+        if (!child) {
+            log(ERROR, compose("Could not restore entity with id %1 of type %2"
+                               ", most likely caused by this type missing.",
+                               stored.id, stored.type));
+            continue;
+        }
+        child->m_location.readFromMessage(stored.location);
+        child->addFlags(entity_clean | entity_pos_clean | entity_orient_clean);
+        m_world.addEntity(child, Ref<LocatedEntity>(entry.second));
+        restoredEntities.emplace_back(&stored, child);
+        pushChildren(stored, child.get());
+    }
+    auto createDuration = millisecondsSince(start);
 
-    restorePropertiesRecursively(ent.get());
+    start = std::chrono::steady_clock::now();
+    for (auto& entry : restoredEntities) {
+        for (auto& name : entry.first->invalidProperties) {
+            log(ERROR, compose("No property value data for %1:%2",
+                               entry.second->describeEntity(), name));
+        }
+        restoreProperties(entry.second.get(), entry.first->properties);
+    }
+    auto propertiesDuration = millisecondsSince(start);
+
+    //Add the entities to the domains of their parents only once all properties are restored, so that each domain
+    //gets all of its children at once.
+    start = std::chrono::steady_clock::now();
+    std::vector<std::pair<LocatedEntity*, std::vector<LocatedEntity*>>> domainChildren;
+    std::unordered_map<LocatedEntity*, size_t> domainIndices;
+    for (auto& entry : restoredEntities) {
+        auto parent = entry.second->m_location.m_parent.get();
+        if (parent) {
+            auto result = domainIndices.emplace(parent, domainChildren.size());
+            if (result.second) {
+                domainChildren.emplace_back(parent, std::vector<LocatedEntity*>());
+            }
+            domainChildren[result.first->second].second.push_back(entry.second.get());
+        }
+    }
+    for (auto& entry : domainChildren) {
+        auto domain = entry.first->getDomain();
+        if (domain) {
+            domain->addEntities(entry.second);
+        }
+    }
+    auto domainsDuration = millisecondsSince(start);
 
+    auto childCount = restoredEntities.size() - 1;
     if (childCount > 0) {
-        log(INFO, "Completed restoring world from storage.");
+        log(INFO, compose("Completed restoring world from storage. Restored %1 entities with %2 properties. "
+                          "Reading took %3 ms, decoding %4 ms, creating entities %5 ms, restoring properties %6 ms and adding to domains %7 ms.",
+                          childCount, propertyCount, readDuration, decodeDuration, createDuration, propertiesDuration, domainsDuration));
     } else {
         log(INFO, "No existing world found in storage.");
     }
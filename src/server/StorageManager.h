@@ -28,6 +28,7 @@
 #include <string>
 #include <map>
 #include <set>
+#include <vector>
 #include <Atlas/Message/Element.h>
 
 class Entity;
@@ -65,6 +66,11 @@ class StorageManager : public sigc::trackable
         int m_insertPropertyCount;
         int m_updatePropertyCount;
 
+        /// \brief Number of properties which have been encoded and written to storage.
+        int m_writtenPropertyCount;
+        /// \brief Number of properties which were skipped when updating an entity, since they were unchanged.
+        int m_skippedPropertyCount;
+
         int m_insertQps;
         int m_updateQps;
 
@@ -88,13 +94,42 @@ class StorageManager : public sigc::trackable
 
         void encodeElement(const Atlas::Message::Element& element, std::string& store);
 
-        void restorePropertiesRecursively(LocatedEntity*);
+        /// \brief An entity read from storage, which hasn't been restored yet.
+        struct StoredEntity
+        {
+            std::string id;
+            std::string type;
+            /// The id of the parent entity.
+            std::string loc;
+            std::string encodedLocation;
+            /// The encoded properties, as name and value. Cleared once decoded.
+            std::vector<std::pair<std::string, std::string>> encodedProperties;
+
+            Atlas::Message::MapType location;
+            std::vector<std::pair<std::string, Atlas::Message::Element>> properties;
+            /// Names of properties which couldn't be decoded.
+            std::vector<std::string> invalidProperties;
+
+            /// Indices of the child entities.
+            std::vector<size_t> children;
+        };
+
+        /// \brief Applies restored properties to an entity, and installs any type properties which weren't restored.
+        ///
+        /// The entity isn't added to the domain of its parent; that's done in bulk by restoreWorld().
+        void restoreProperties(LocatedEntity* ent, const std::vector<std::pair<std::string, Atlas::Message::Element>>& properties);
 
         void insertEntity(LocatedEntity*);
 
         void updateEntity(LocatedEntity*);
 
-        size_t restoreChildren(LocatedEntity*);
+        /// \brief Reads all entities and properties from storage, in two queries.
+        ///
+        /// The root entity is placed first in the returned list.
+        std::vector<StoredEntity> readStoredEntities(const std::string& rootId, size_t& propertyCount);
+
+        /// \brief Decodes the locations and properties of the entities, spread over worker threads.
+        void decodeStoredEntities(std::vector<StoredEntity>& storedEntities);
 
     public:
         explicit StorageManager(WorldRouter& world, Database& db, EntityBuilder& entityBuilder);
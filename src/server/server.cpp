@@ -39,6 +39,7 @@
 #include "HttpCache.h"
 
 #include "rules/python/Python_API.h"
+#include "rules/python/PythonWrapper.h"
 #include "rules/LocatedEntity.h"
 #include "rules/simulation/World.h"
 
@@ -79,12 +80,15 @@
 #include <rules/python/CyPy_Common.h>
 #include <rules/python/CyPy_Rules.h>
 #include <rules/simulation/ExternalMind.h>
+#include <rules/simulation/PhysicalDomain.h>
 
 #include <Atlas/Objects/RootEntity.h>
 
 #include <memory>
 #include <thread>
 #include <fstream>
+#include <iostream>
+#include <vector>
 
 using String::compose;
 using namespace boost::asio;
@@ -109,6 +113,52 @@ namespace {
     INT_OPTION(ai_clients, 1, CYPHESIS, "aiclients",
                "Number of AI clients to spawn.")
 
+    BOOL_OPTION(coalesce_ticks, false, CYPHESIS, "coalesce_ticks",
+                "Flag to control if queued Tick operations to an entity should be superseded by newer ones")
+
+    BOOL_OPTION(defer_property_updates, false, CYPHESIS, "defer_property_updates",
+                "Flag to control if script property update callbacks should be called once after each operation, instead of for every change")
+
+    INT_OPTION(network_threads, 0, CYPHESIS, "network_threads",
+               "Number of threads used for reading from and writing to client sockets. Atlas encoding and decoding "
+               "always run on the main thread. 0 does all socket IO on the main thread as well.")
+
+    /**
+     * Runs a separate io_context on a number of threads, used for client sockets when "network_threads" is set.
+     */
+    struct NetworkThreads
+    {
+        boost::asio::io_context io_context;
+        std::unique_ptr<boost::asio::io_context::work> work;
+        std::vector<std::thread> threads;
+
+        explicit NetworkThreads(int count)
+                : work(new boost::asio::io_context::work(io_context))
+        {
+            for (int i = 0; i < count; ++i) {
+                threads.emplace_back([this]() {
+                    while (true) {
+                        try {
+                            io_context.run();
+                            return;
+                        } catch (const std::exception& e) {
+                            //The logging system isn't thread safe, so just write to cerr.
+                            std::cerr << "Exception caught in network thread: " << e.what() << std::endl;
+                        }
+                    }
+                });
+            }
+        }
+
+        ~NetworkThreads()
+        {
+            work.reset();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+    };
+
     /**
      * Wraps either a Postgres server connection along with a vacuum socket, or a SQLite connection along with a vacuum task.
      */
@@ -231,13 +281,13 @@ namespace {
         std::unique_ptr<CommAsioListener<ip::tcp, CommHttpClient>> httpListener;
     };
 
-    SocketListeners createListeners(io_context& io_context, ServerRouting& serverRouting, Atlas::Objects::Factories& atlasFactories)
+    SocketListeners createListeners(io_context& io_context, io_context& networkContext, ServerRouting& serverRouting, Atlas::Objects::Factories& atlasFactories)
     {
 
         SocketListeners socketListeners;
 
         auto tcpAtlasCreator = [&]() -> std::shared_ptr<CommAsioClient<ip::tcp>> {
-            return std::make_shared<CommAsioClient<ip::tcp>>(serverRouting.getName(), io_context, atlasFactories);
+            return std::make_shared<CommAsioClient<ip::tcp>>(serverRouting.getName(), io_context, networkContext, atlasFactories);
         };
 
         std::function<void(CommAsioClient<ip::tcp>&)> tcpAtlasStarter = [&](CommAsioClient<ip::tcp>& client) {
@@ -310,7 +360,7 @@ namespace {
 
         remove(client_socket_name.c_str());
         auto localCreator = [&]() -> std::shared_ptr<CommAsioClient<local::stream_protocol>> {
-            return std::make_shared<CommAsioClient<local::stream_protocol>>(serverRouting.getName(), io_context, atlasFactories);
+            return std::make_shared<CommAsioClient<local::stream_protocol>>(serverRouting.getName(), io_context, networkContext, atlasFactories);
         };
         auto localStarter = [&](CommAsioClient<local::stream_protocol>& client) {
             std::string connection_id;
@@ -352,6 +402,10 @@ namespace {
         Monitors monitors;
         monitors.watch("minds", new Variable<int>(ExternalMind::s_numberOfMinds));
         monitors.watch("players", new Variable<int>(Player::s_numberOfPlayers));
+        monitors.watch(R"(physics_tick_us{phase="broadphase"})", new Variable<int>(PhysicalDomain::s_tickTimings.broadphase));
+        monitors.watch(R"(physics_tick_us{phase="narrowphase"})", new Variable<int>(PhysicalDomain::s_tickTimings.narrowphase));
+        monitors.watch(R"(physics_tick_us{phase="solve"})", new Variable<int>(PhysicalDomain::s_tickTimings.solve));
+        monitors.watch(R"(physics_tick_us{phase="postprocess"})", new Variable<int>(PhysicalDomain::s_tickTimings.postProcess));
 
         //Check if we should spawn AI clients.
         if (ai_clients) {
@@ -383,6 +437,13 @@ namespace {
 
 
         auto io_context = std::make_unique<boost::asio::io_context>();
+        //If enabled, client sockets are handled by threads of their own, while Atlas data and ops are handled on the main thread.
+        std::unique_ptr<NetworkThreads> networkThreads;
+        if (network_threads > 0) {
+            networkThreads = std::make_unique<NetworkThreads>(network_threads);
+            log(INFO, String::compose("Using %1 threads for client network IO.", network_threads));
+        }
+        auto& networkContext = networkThreads ? networkThreads->io_context : *io_context;
 
         {
             Atlas::Objects::Factories atlasFactories;
@@ -582,6 +643,11 @@ namespace {
             };
 
 
+            world.getOperationsHandler().m_coalesce_ticks = coalesce_ticks;
+            PythonWrapper::s_deferPropertyUpdates = defer_property_updates;
+            if (defer_property_updates) {
+                world.Dispatched.connect(sigc::ptr_fun(&PythonWrapper::flushPropertyUpdates));
+            }
             //Initially there are a couple of pent up operations we need to run to get up to speed. 10 seconds is a suitable large number.
             world.getOperationsHandler().idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
             //Report to log when time diff between when an operation should have been handled and when it actually was
@@ -589,7 +655,7 @@ namespace {
 
             //Inner loop, where listeners are active.
             {
-                auto socketListeners = createListeners(*io_context, serverRouting, atlasFactories);
+                auto socketListeners = createListeners(*io_context, networkContext, serverRouting, atlasFactories);
 
                 auto metaClient = createMetaClient(*io_context);
                 auto mdnsClient = createMDNSClient(*io_context, serverRouting);
@@ -638,6 +704,8 @@ namespace {
         //Run any outstanding tasks before shutting down service.
         io_context->run();
 
+        //The network threads might post to the main io_context, so stop them first.
+        networkThreads.reset();
         io_context.reset();
 
         shutdown_python_api();
@@ -33,6 +33,9 @@ struct const_iterator_worker_null : public DatabaseResult::const_iterator_worker
     const char* column(const char* column) const override
     { return ""; }
 
+    std::string data(const char* column) const override
+    { return ""; }
+
     DatabaseResult::const_iterator_worker& operator++() override
     { return *this; }
 
@@ -0,0 +1,192 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/BinaryElementCodec.h"
+
+#include <limits>
+
+using Atlas::Message::Element;
+using Atlas::Message::ListType;
+using Atlas::Message::MapType;
+
+class BinaryElementCodecTest : public Cyphesis::TestBase
+{
+    public:
+        BinaryElementCodecTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_roundTrip();
+
+        void test_floatPrecision();
+
+        void test_isEncoded();
+
+        void test_corrupt();
+
+        void test_terrainPoints();
+};
+
+BinaryElementCodecTest::BinaryElementCodecTest()
+{
+    ADD_TEST(BinaryElementCodecTest::test_roundTrip);
+    ADD_TEST(BinaryElementCodecTest::test_floatPrecision);
+    ADD_TEST(BinaryElementCodecTest::test_isEncoded);
+    ADD_TEST(BinaryElementCodecTest::test_corrupt);
+    ADD_TEST(BinaryElementCodecTest::test_terrainPoints);
+}
+
+void BinaryElementCodecTest::setup()
+{
+}
+
+void BinaryElementCodecTest::teardown()
+{
+}
+
+void BinaryElementCodecTest::test_roundTrip()
+{
+    MapType original{
+        {"none", Element()},
+        {"int", 12},
+        {"negative", -300},
+        {"largest", std::numeric_limits<Atlas::Message::IntType>::max()},
+        {"smallest", std::numeric_limits<Atlas::Message::IntType>::min()},
+        {"float", 0.25},
+        {"string", "foo'bar"},
+        {"binary", std::string("a\0b", 3)},
+        {"", "empty key"},
+        {"emptyList", ListType()},
+        {"floats", ListType{1.0, 2.5, -3.0}},
+        {"mixed", ListType{1.0, 2, "three", ListType{4.0}, MapType{{"five", 5}}}},
+        {"map", MapType{{"nested", MapType{{"deeper", ListType{MapType()}}}}}}
+    };
+
+    std::string data;
+    BinaryElementCodec::encode(original, data);
+
+    MapType decoded;
+    ASSERT_TRUE(BinaryElementCodec::decode(data, decoded));
+    ASSERT_EQUAL(Element(decoded), Element(original));
+    ASSERT_TRUE(decoded["floats"].List()[0].isFloat());
+    ASSERT_TRUE(decoded["mixed"].List()[1].isInt());
+
+    //Any previous content should be replaced.
+    BinaryElementCodec::encode(MapType{{"val", 1}}, data);
+    ASSERT_TRUE(BinaryElementCodec::decode(data, decoded));
+    ASSERT_EQUAL(Element(decoded), Element(MapType{{"val", 1}}));
+}
+
+void BinaryElementCodecTest::test_floatPrecision()
+{
+    //Values which can't be stored as single precision floats must not lose any precision.
+    MapType original{
+        {"tenth", 0.1},
+        {"big", 1e300},
+        {"infinity", std::numeric_limits<double>::infinity()},
+        {"floats", ListType{0.5, 0.1}},
+        {"singles", ListType{0.5, 1024.0}}
+    };
+
+    std::string data;
+    BinaryElementCodec::encode(original, data);
+
+    MapType decoded;
+    ASSERT_TRUE(BinaryElementCodec::decode(data, decoded));
+    ASSERT_EQUAL(Element(decoded), Element(original));
+
+    //A list of floats which can be stored as single precision takes four bytes per float.
+    std::string singles;
+    BinaryElementCodec::encode(MapType{{"val", ListType(100, 0.5)}}, singles);
+    ASSERT_LESS(singles.size(), 420u);
+    ASSERT_GREATER(singles.size(), 400u);
+}
+
+void BinaryElementCodecTest::test_isEncoded()
+{
+    std::string data;
+    BinaryElementCodec::encode(MapType(), data);
+    ASSERT_TRUE(BinaryElementCodec::isEncoded(data));
+
+    ASSERT_FALSE(BinaryElementCodec::isEncoded(""));
+    ASSERT_FALSE(BinaryElementCodec::isEncoded("[@val=1]"));
+    ASSERT_FALSE(BinaryElementCodec::isEncoded(std::string("\0", 1)));
+
+    MapType decoded;
+    ASSERT_FALSE(BinaryElementCodec::decode("[@val=1]", decoded));
+}
+
+void BinaryElementCodecTest::test_corrupt()
+{
+    std::string data;
+    BinaryElementCodec::encode(MapType{{"val", ListType{1.0, "foo", MapType{{"bar", 1}}}}}, data);
+
+    //Every truncation of valid data must be rejected.
+    for (size_t i = 2; i < data.size(); ++i) {
+        MapType decoded;
+        ASSERT_FALSE(BinaryElementCodec::decode(data.substr(0, i), decoded));
+    }
+
+    //As must trailing garbage.
+    MapType decoded;
+    ASSERT_FALSE(BinaryElementCodec::decode(data + "x", decoded));
+
+    //A length larger than the data must not be trusted.
+    std::string huge = data.substr(0, 2);
+    huge += "\xff\xff\xff\xff\x0f";
+    ASSERT_FALSE(BinaryElementCodec::decode(huge, decoded));
+}
+
+void BinaryElementCodecTest::test_terrainPoints()
+{
+    //Something like the terrain points of a large area.
+    ListType points;
+    for (int x = -10; x <= 10; ++x) {
+        for (int y = -10; y <= 10; ++y) {
+            points.emplace_back(ListType{x * 64.0, y * 64.0, 10.5 + x * 0.25});
+        }
+    }
+    MapType original{{"val", MapType{{"points", points}}}};
+
+    std::string data;
+    BinaryElementCodec::encode(original, data);
+
+    //Each point is a tag, a length and three single precision floats.
+    ASSERT_LESS(data.size(), points.size() * 14 + 32);
+
+    MapType decoded;
+    ASSERT_TRUE(BinaryElementCodec::decode(data, decoded));
+    ASSERT_EQUAL(Element(decoded), Element(original));
+}
+
+int main()
+{
+    BinaryElementCodecTest t;
+
+    return t.run();
+}
@@ -0,0 +1,320 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/CommAsioClient_impl.h"
+#include "common/Link.h"
+#include "common/Monitors.h"
+
+#include <Atlas/Objects/Operation.h>
+#include <Atlas/Codecs/Bach.h>
+
+#include <boost/asio/local/connect_pair.hpp>
+#include <boost/asio/read.hpp>
+
+#include <sstream>
+#include <thread>
+
+typedef boost::asio::local::stream_protocol Protocol;
+
+struct TestLink : public Link
+{
+    using Link::Link;
+
+    std::vector<Operation> received;
+
+    void externalOperation(const Operation& op, Link&) override
+    {
+        received.push_back(op);
+    }
+
+    void operation(const Operation&, OpVector&) override
+    {
+    }
+};
+
+struct TestCommAsioClient : public CommAsioClient<Protocol>
+{
+    using CommAsioClient<Protocol>::CommAsioClient;
+
+    /**
+     * Skips negotiation, and uses the Bach codec directly.
+     */
+    void setupCodec()
+    {
+        m_codec = std::make_unique<Atlas::Codecs::Bach>(mInStream, mOutStream, *this);
+        m_encoder = std::make_unique<Atlas::Objects::ObjectsEncoder>(*m_codec);
+        m_codec->streamBegin();
+    }
+
+    void startReading()
+    {
+        do_read();
+    }
+
+    int pendingNetworkTasks() const
+    {
+        return mPendingNetworkTasks;
+    }
+
+    void setLink(std::unique_ptr<Link> link)
+    {
+        m_link = std::move(link);
+    }
+
+    int writes() const
+    {
+        return mStatisticsWrites;
+    }
+
+    size_t pendingBytes() const
+    {
+        return mWriteBuffer->size();
+    }
+
+    bool isSending() const
+    {
+        return mIsSending;
+    }
+
+    bool isStatisticsTimerActive() const
+    {
+        return mStatisticsTimerActive;
+    }
+
+    using CommAsioClient<Protocol>::publishStatistics;
+};
+
+namespace {
+    /**
+     * Runs a network io_context on a separate thread, until destroyed.
+     */
+    struct NetworkThread
+    {
+        boost::asio::io_context networkContext;
+        boost::asio::io_context::work work;
+        std::thread thread;
+
+        NetworkThread() : work(networkContext), thread([this]() { networkContext.run(); })
+        {
+        }
+
+        ~NetworkThread()
+        {
+            networkContext.stop();
+            thread.join();
+        }
+    };
+
+    /**
+     * Reads a numeric monitor, returning -1 if it doesn't exist.
+     */
+    long readMonitor(const std::string& key)
+    {
+        std::stringstream ss;
+        Monitors::instance().sendNumerics(ss);
+        std::string line;
+        while (std::getline(ss, line)) {
+            if (line.compare(0, key.size() + 1, key + " ") == 0) {
+                return std::stol(line.substr(key.size() + 1));
+            }
+        }
+        return -1;
+    }
+}
+
+struct Tested : public Cyphesis::TestBase
+{
+    Atlas::Objects::Factories factories;
+
+    Tested()
+    {
+        ADD_TEST(Tested::test_corkedSendsAreMerged)
+        ADD_TEST(Tested::test_corkedSendsAreWrittenAboveThreshold)
+        ADD_TEST(Tested::test_statisticsDropToZeroWhenIdle)
+        ADD_TEST(Tested::test_threaded)
+    }
+
+    void setup() override
+    {
+    }
+
+    void teardown() override
+    {
+        CommSocket::s_corked = false;
+        CommSocket::flushCorkedSockets();
+    }
+
+    void test_corkedSendsAreMerged()
+    {
+        boost::asio::io_context io_context;
+        auto client = std::make_shared<TestCommAsioClient>("test", io_context, factories);
+        Protocol::socket peer(io_context);
+        boost::asio::local::connect_pair(client->getSocket(), peer);
+        client->setupCodec();
+
+        CommSocket::s_corked = true;
+        for (int i = 0; i < 3; ++i) {
+            client->send(Atlas::Objects::Operation::Sight());
+        }
+        //Nothing should be written until the corked sockets are flushed.
+        ASSERT_EQUAL(0, client->writes())
+        auto pending = client->pendingBytes();
+        ASSERT_GREATER(pending, 0u)
+
+        CommSocket::flushCorkedSockets();
+        ASSERT_EQUAL(1, client->writes())
+        ASSERT_EQUAL(0u, client->pendingBytes())
+
+        //Nothing has been sent since, so another flush shouldn't write anything.
+        CommSocket::flushCorkedSockets();
+        ASSERT_EQUAL(1, client->writes())
+
+        while (client->isSending()) {
+            io_context.run_one();
+        }
+
+        //All three ops should have arrived at the other end.
+        std::vector<char> data(pending);
+        ASSERT_EQUAL(pending, boost::asio::read(peer, boost::asio::buffer(data)))
+    }
+
+    void test_corkedSendsAreWrittenAboveThreshold()
+    {
+        boost::asio::io_context io_context;
+        auto client = std::make_shared<TestCommAsioClient>("test", io_context, factories);
+        Protocol::socket peer(io_context);
+        boost::asio::local::connect_pair(client->getSocket(), peer);
+        client->setupCodec();
+
+        CommSocket::s_corked = true;
+        while (client->writes() == 0) {
+            Atlas::Objects::Operation::Sight op;
+            op->setAttr("padding", std::string(1024, 'x'));
+            client->send(op);
+            //Data should never pile up much beyond the threshold.
+            ASSERT_LESS(client->pendingBytes(), 65536u + 2048u)
+        }
+        ASSERT_EQUAL(1, client->writes())
+    }
+
+    void test_statisticsDropToZeroWhenIdle()
+    {
+        boost::asio::io_context io_context;
+        auto client = std::make_shared<TestCommAsioClient>("test", io_context, factories);
+        Protocol::socket peer(io_context);
+        boost::asio::local::connect_pair(client->getSocket(), peer);
+        client->setupCodec();
+        client->setLink(std::make_unique<TestLink>(*client, "1", 1));
+
+        std::string bytesKey = "comm_bytes_per_second{connection=\"1\"}";
+        std::string writesKey = "comm_writes_per_second{connection=\"1\"}";
+
+        client->send(Atlas::Objects::Operation::Sight());
+        ASSERT_EQUAL(1, client->writes())
+        ASSERT_TRUE(client->isStatisticsTimerActive())
+
+        client->publishStatistics();
+        ASSERT_GREATER(readMonitor(bytesKey), 0)
+        ASSERT_GREATER(readMonitor(writesKey), 0)
+        //There were writes, so the timer should keep running.
+        ASSERT_TRUE(client->isStatisticsTimerActive())
+
+        //Nothing was written since last time, so the rates should be reported as zero, and the timer should stop.
+        client->publishStatistics();
+        ASSERT_EQUAL(0, readMonitor(bytesKey))
+        ASSERT_EQUAL(0, readMonitor(writesKey))
+        ASSERT_FALSE(client->isStatisticsTimerActive())
+
+        //A new write should start the timer again.
+        while (client->isSending()) {
+            io_context.run_one();
+        }
+        client->send(Atlas::Objects::Operation::Sight());
+        ASSERT_TRUE(client->isStatisticsTimerActive())
+    }
+
+    void test_threaded()
+    {
+        boost::asio::io_context io_context;
+        NetworkThread networkThread;
+        auto& networkContext = networkThread.networkContext;
+
+        //One client with its socket handled by the network thread, talking to one which isn't threaded.
+        auto threadedClient = std::make_shared<TestCommAsioClient>("threaded", io_context, networkContext, factories);
+        auto client = std::make_shared<TestCommAsioClient>("test", io_context, factories);
+        boost::asio::local::connect_pair(threadedClient->getSocket(), client->getSocket());
+
+        auto threadedLink = new TestLink(*threadedClient, "1", 1);
+        threadedClient->setLink(std::unique_ptr<Link>(threadedLink));
+        threadedClient->setupCodec();
+        auto link = new TestLink(*client, "2", 2);
+        client->setLink(std::unique_ptr<Link>(link));
+        client->setupCodec();
+
+        threadedClient->startReading();
+        client->startReading();
+        //The read loop counts as one task.
+        ASSERT_GREATER(threadedClient->pendingNetworkTasks(), 0)
+
+        for (int i = 0; i < 10; ++i) {
+            threadedClient->send(Atlas::Objects::Operation::Sight());
+            client->send(Atlas::Objects::Operation::Sound());
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while ((threadedLink->received.size() < 10 || link->received.size() < 10) && std::chrono::steady_clock::now() < deadline) {
+            io_context.run_one_for(std::chrono::milliseconds(100));
+        }
+        ASSERT_EQUAL(10u, threadedLink->received.size())
+        ASSERT_EQUAL(10u, link->received.size())
+        for (auto& op : threadedLink->received) {
+            ASSERT_EQUAL(Atlas::Objects::Operation::SOUND_NO, op->getClassNo())
+        }
+        for (auto& op : link->received) {
+            ASSERT_EQUAL(Atlas::Objects::Operation::SIGHT_NO, op->getClassNo())
+        }
+
+        //Once disconnected, the network thread should let go of the client, which should then be destroyed on this thread.
+        std::weak_ptr<TestCommAsioClient> weakThreadedClient = threadedClient;
+        threadedClient->disconnect();
+        threadedClient.reset();
+        client->disconnect();
+        while (!weakThreadedClient.expired() && std::chrono::steady_clock::now() < deadline) {
+            io_context.run_one_for(std::chrono::milliseconds(100));
+        }
+        ASSERT_TRUE(weakThreadedClient.expired())
+    }
+};
+
+
+int main()
+{
+    Monitors m;
+    Tested t;
+
+    return t.run();
+}
@@ -0,0 +1,178 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/DatabasePostgres.h"
+#include "common/compose.hpp"
+#include "common/globals.h"
+#include "common/log.h"
+
+#include <varconf/config.h>
+
+#include <chrono>
+#include <cstdlib>
+
+using String::compose;
+
+namespace {
+    /**
+     * Allows the batch size to be set directly, instead of through the config.
+     */
+    struct TestDatabasePostgres : DatabasePostgres
+    {
+        explicit TestDatabasePostgres(size_t batchSize)
+        {
+            m_batchSize = batchSize;
+        }
+    };
+
+    /**
+     * Sends all queued commands, waiting for each query to complete, in the same way as StorageManager::shutdown.
+     */
+    void drain(Database& db)
+    {
+        while (db.queryQueueSize()) {
+            if (!db.queryInProgress()) {
+                db.launchNewQuery();
+            } else {
+                db.clearPendingQuery();
+            }
+        }
+    }
+}
+
+/**
+ * Runs the writes done by the StorageManager against a local PostgreSQL database, with different batch sizes.
+ *
+ * Set the environment variable CYPHESIS_BENCHMARK_PGDATABASE to the name of a scratch database to run it;
+ * the usual libpq environment variables (PGHOST, PGUSER etc.) can be used to select the server.
+ * Any "entities" and "properties" tables are created if missing, and the rows written by the benchmark are removed afterwards.
+ * The tables are compacted with VACUUM FULL after each run.
+ */
+class DatabasePostgresBenchmark : public Cyphesis::TestBase
+{
+    public:
+        DatabasePostgresBenchmark();
+
+        void setup();
+
+        void teardown();
+
+        void test_storageWorkload();
+
+        /**
+         * Inserts entities with properties, and then updates them a number of times.
+         * @return The number of commands per second.
+         */
+        long runWorkload(size_t batchSize);
+};
+
+DatabasePostgresBenchmark::DatabasePostgresBenchmark()
+{
+    ADD_TEST(DatabasePostgresBenchmark::test_storageWorkload);
+}
+
+void DatabasePostgresBenchmark::setup()
+{
+}
+
+void DatabasePostgresBenchmark::teardown()
+{
+}
+
+long DatabasePostgresBenchmark::runWorkload(size_t batchSize)
+{
+    const long entityCount = 2000;
+    const int updateRounds = 5;
+    //Use ids far above any the server would hand out.
+    const long firstId = 1000000000;
+
+    TestDatabasePostgres db(batchSize);
+    ASSERT_EQUAL(db.initConnection(), 0);
+
+    std::map<std::string, int> chunks;
+    chunks["location"] = 0;
+    ASSERT_EQUAL(db.registerEntityTable(chunks), 0);
+    ASSERT_EQUAL(db.registerPropertyTable(), 0);
+
+    std::string location;
+    db.encodeObject({{"pos", Atlas::Message::ListType{1.0, 2.0, 3.0}}, {"orientation", Atlas::Message::ListType{0.0, 0.0, 0.0, 1.0}}}, location);
+    std::string value;
+    db.encodeObject({{"val", 1.5}}, value);
+
+    long commandCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < entityCount; ++i) {
+        auto id = std::to_string(firstId + i);
+        db.insertEntity(id, "0", "thing", 0, location);
+        db.insertProperties(id, {{"mass", value}, {"status", value}, {"description", value}});
+        commandCount += 2;
+    }
+    for (int round = 1; round <= updateRounds; ++round) {
+        for (long i = 0; i < entityCount; ++i) {
+            auto id = std::to_string(firstId + i);
+            db.updateEntity(id, round, location, "0");
+            db.updateProperties(id, {{"status", value}});
+            commandCount += 2;
+        }
+    }
+    drain(db);
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    for (long i = 0; i < entityCount; ++i) {
+        db.dropEntity(firstId + i);
+    }
+    //Compact the tables, so that the dead rows left behind don't slow down the runs with the following batch sizes.
+    db.runMaintainance(DatabasePostgres::MAINTAIN_VACUUM | DatabasePostgres::MAINTAIN_VACUUM_FULL);
+    drain(db);
+
+    auto commandsPerSecond = (commandCount * 1000) / std::max(1L, static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count()));
+    log(INFO, compose("Batch size %1: %2 commands in %3 ms, %4 commands per second.",
+                      batchSize, commandCount, std::chrono::duration_cast<std::chrono::milliseconds>(duration).count(), commandsPerSecond));
+    return commandsPerSecond;
+}
+
+void DatabasePostgresBenchmark::test_storageWorkload()
+{
+    auto dbname = std::getenv("CYPHESIS_BENCHMARK_PGDATABASE");
+    if (!dbname) {
+        log(INFO, "Set CYPHESIS_BENCHMARK_PGDATABASE to the name of a scratch PostgreSQL database to run this benchmark.");
+        return;
+    }
+    global_conf = varconf::Config::inst();
+    global_conf->setItem(::instance, "dbname", dbname);
+
+    for (size_t batchSize : {0, 4, 8, 16, 32, 64, 128, 256}) {
+        runWorkload(batchSize);
+    }
+}
+
+int main()
+{
+    DatabasePostgresBenchmark t;
+
+    return t.run();
+}
@@ -0,0 +1,203 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/DatabasePostgres.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+    /// The query strings sent to the database, in order.
+    std::vector<std::string> sentQueries;
+
+    /// Stands in for a connection, since all calls which use it are stubbed.
+    char fakeConnection;
+
+    /**
+     * Allows the batch size to be set directly, and pretends to be connected.
+     */
+    struct TestDatabasePostgres : DatabasePostgres
+    {
+        explicit TestDatabasePostgres(size_t batchSize)
+        {
+            m_batchSize = batchSize;
+            m_connection = reinterpret_cast<PGconn*>(&fakeConnection);
+        }
+
+        ~TestDatabasePostgres() override
+        {
+            m_connection = nullptr;
+            pendingQueries.clear();
+        }
+    };
+
+    /**
+     * Feeds the results of the query in progress to the database, in the same way as CommPSQLSocket does.
+     */
+    void completeQuery(DatabasePostgres& db, const std::vector<ExecStatusType>& results)
+    {
+        for (auto status : results) {
+            db.queryResult(status);
+        }
+        db.queryComplete();
+    }
+}
+
+class DatabasePostgresTest : public Cyphesis::TestBase
+{
+    public:
+        DatabasePostgresTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_batch();
+
+        void test_failedBatchIsSentAgainUnbatched();
+};
+
+DatabasePostgresTest::DatabasePostgresTest()
+{
+    ADD_TEST(DatabasePostgresTest::test_batch);
+    ADD_TEST(DatabasePostgresTest::test_failedBatchIsSentAgainUnbatched);
+}
+
+void DatabasePostgresTest::setup()
+{
+}
+
+void DatabasePostgresTest::teardown()
+{
+    sentQueries.clear();
+}
+
+void DatabasePostgresTest::test_batch()
+{
+    TestDatabasePostgres db(3);
+
+    //Nothing is in progress, so the first command is sent on its own.
+    db.scheduleCommand("c0");
+    for (int i = 1; i <= 4; ++i) {
+        db.scheduleCommand("c" + std::to_string(i));
+    }
+    ASSERT_EQUAL(sentQueries.size(), 1u);
+    ASSERT_EQUAL(sentQueries.back(), "c0");
+
+    completeQuery(db, {PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 4u);
+
+    //The rest are sent in batches no larger than the batch size.
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c1;\nc2;\nc3;\n");
+    completeQuery(db, {PGRES_COMMAND_OK, PGRES_COMMAND_OK, PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 1u);
+
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c4");
+    completeQuery(db, {PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 0u);
+    ASSERT_FALSE(db.queryInProgress());
+}
+
+void DatabasePostgresTest::test_failedBatchIsSentAgainUnbatched()
+{
+    TestDatabasePostgres db(4);
+
+    db.scheduleCommand("c0");
+    for (int i = 1; i <= 4; ++i) {
+        db.scheduleCommand("c" + std::to_string(i));
+    }
+    completeQuery(db, {PGRES_COMMAND_OK});
+
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c1;\nc2;\nc3;\nc4;\n");
+
+    //The third command fails. Postgres then rolls back the transaction, and sends no results for the rest.
+    completeQuery(db, {PGRES_COMMAND_OK, PGRES_COMMAND_OK, PGRES_FATAL_ERROR});
+    ASSERT_FALSE(db.queryInProgress());
+    //None of the commands should be dropped, since none were applied.
+    ASSERT_EQUAL(db.queryQueueSize(), 4u);
+
+    //The commands should be sent again one at a time, and only the failing one dropped.
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c1");
+    completeQuery(db, {PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 3u);
+
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c2");
+    completeQuery(db, {PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 2u);
+
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c3");
+    completeQuery(db, {PGRES_FATAL_ERROR});
+    ASSERT_EQUAL(db.queryQueueSize(), 1u);
+
+    //Commands queued meanwhile should be batched again once the failed batch has been sent.
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c4");
+    db.scheduleCommand("c5");
+    db.scheduleCommand("c6");
+    completeQuery(db, {PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 2u);
+
+    ASSERT_EQUAL(db.launchNewQuery(), 0);
+    ASSERT_EQUAL(sentQueries.back(), "c5;\nc6;\n");
+    completeQuery(db, {PGRES_COMMAND_OK, PGRES_COMMAND_OK});
+    ASSERT_EQUAL(db.queryQueueSize(), 0u);
+
+    //Every command, and each batch, should have been sent exactly once.
+    ASSERT_TRUE(sentQueries == (std::vector<std::string>{"c0", "c1;\nc2;\nc3;\nc4;\n", "c1", "c2", "c3", "c4", "c5;\nc6;\n"}));
+}
+
+int main()
+{
+    DatabasePostgresTest t;
+
+    return t.run();
+}
+
+// stubs
+
+int PQsendQuery(PGconn*, const char* query)
+{
+    sentQueries.emplace_back(query);
+    return 1;
+}
+
+int PQflush(PGconn*)
+{
+    return 0;
+}
+
+char* PQerrorMessage(const PGconn*)
+{
+    static char message[] = "Stubbed error\n";
+    return message;
+}
@@ -0,0 +1,155 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/IdBlockAllocator.h"
+
+#include <atomic>
+#include <set>
+#include <thread>
+
+class IdBlockAllocatorTest : public Cyphesis::TestBase
+{
+    public:
+        IdBlockAllocatorTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_synchronous();
+
+        void test_asynchronous();
+
+        void test_smallBlock();
+
+        void test_failure();
+};
+
+IdBlockAllocatorTest::IdBlockAllocatorTest()
+{
+    ADD_TEST(IdBlockAllocatorTest::test_synchronous);
+    ADD_TEST(IdBlockAllocatorTest::test_asynchronous);
+    ADD_TEST(IdBlockAllocatorTest::test_smallBlock);
+    ADD_TEST(IdBlockAllocatorTest::test_failure);
+}
+
+void IdBlockAllocatorTest::setup()
+{
+}
+
+void IdBlockAllocatorTest::teardown()
+{
+}
+
+void IdBlockAllocatorTest::test_synchronous()
+{
+    long highWaterMark = 100;
+    int reservations = 0;
+    auto callingThread = std::this_thread::get_id();
+    IdBlockAllocator allocator([&](long count) {
+        ASSERT_TRUE(std::this_thread::get_id() == callingThread);
+        reservations++;
+        IdBlockAllocator::Block block{highWaterMark + 1, highWaterMark + 1 + count};
+        highWaterMark += count;
+        return block;
+    }, 10, false);
+
+    //Nothing should be reserved until the first id is needed.
+    ASSERT_EQUAL(reservations, 0);
+    for (long i = 101; i <= 125; ++i) {
+        ASSERT_EQUAL(allocator.next(), i);
+    }
+    ASSERT_EQUAL(reservations, 3);
+    ASSERT_EQUAL(highWaterMark, 130);
+}
+
+void IdBlockAllocatorTest::test_asynchronous()
+{
+    std::atomic<long> highWaterMark(0);
+    std::atomic<int> reservations(0);
+    std::set<long> ids;
+    {
+        IdBlockAllocator allocator([&](long count) {
+            reservations++;
+            long first = highWaterMark.fetch_add(count) + 1;
+            return IdBlockAllocator::Block{first, first + count};
+        }, 16, true);
+
+        long lastId = 0;
+        for (int i = 0; i < 1000; ++i) {
+            auto id = allocator.next();
+            ASSERT_TRUE(id > lastId);
+            ids.insert(id);
+            lastId = id;
+        }
+    }
+    //All ids should be unique, and no more than one block ahead should have been reserved.
+    ASSERT_EQUAL(ids.size(), 1000u);
+    ASSERT_TRUE(reservations.load() <= (1000 / 16) + 2);
+    ASSERT_TRUE(highWaterMark.load() >= *ids.rbegin());
+}
+
+void IdBlockAllocatorTest::test_smallBlock()
+{
+    //A reserve function may return a smaller block than asked for.
+    std::vector<IdBlockAllocator::Block> blocks{{5, 6}, {6, 20}};
+    size_t index = 0;
+    IdBlockAllocator allocator([&](long count) {
+        return blocks[index++];
+    }, 14, false);
+
+    ASSERT_EQUAL(allocator.next(), 5);
+    for (long i = 6; i < 20; ++i) {
+        ASSERT_EQUAL(allocator.next(), i);
+    }
+    ASSERT_EQUAL(index, 2u);
+}
+
+void IdBlockAllocatorTest::test_failure()
+{
+    bool fail = true;
+    IdBlockAllocator allocator([&](long count) {
+        if (fail) {
+            return IdBlockAllocator::Block{-1, -1};
+        }
+        return IdBlockAllocator::Block{1, 1 + count};
+    }, 10, false);
+
+    ASSERT_EQUAL(allocator.next(), -1);
+    fail = false;
+    ASSERT_EQUAL(allocator.next(), 1);
+}
+
+int main()
+{
+    IdBlockAllocatorTest t;
+
+    return t.run();
+}
+
+// stubs
+
+#include "../stubs/common/stublog.h"
@@ -0,0 +1,100 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/JobQueue.h"
+
+#include <atomic>
+#include <chrono>
+
+class JobQueueTest : public Cyphesis::TestBase
+{
+    public:
+        JobQueueTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_allJobsRun();
+
+        void test_runsOnWorkerThread();
+};
+
+JobQueueTest::JobQueueTest()
+{
+    ADD_TEST(JobQueueTest::test_allJobsRun);
+    ADD_TEST(JobQueueTest::test_runsOnWorkerThread);
+}
+
+void JobQueueTest::setup()
+{
+}
+
+void JobQueueTest::teardown()
+{
+}
+
+void JobQueueTest::test_allJobsRun()
+{
+    JobQueue queue(4);
+    ASSERT_EQUAL(queue.getNumberOfThreads(), 4u);
+
+    std::atomic<int> finished(0);
+    for (int i = 0; i < 1000; ++i) {
+        queue.post([&]() { finished++; });
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (finished.load() != 1000 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQUAL(finished.load(), 1000);
+}
+
+void JobQueueTest::test_runsOnWorkerThread()
+{
+    auto callingThread = std::this_thread::get_id();
+    std::atomic<bool> onCallingThread(true);
+    std::atomic<bool> done(false);
+    {
+        JobQueue queue(1);
+        queue.post([&]() {
+            onCallingThread = std::this_thread::get_id() == callingThread;
+            done = true;
+        });
+        while (!done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    ASSERT_FALSE(onCallingThread.load());
+}
+
+int main()
+{
+    JobQueueTest t;
+
+    return t.run();
+}
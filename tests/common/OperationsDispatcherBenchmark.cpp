@@ -0,0 +1,159 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/OperationsDispatcher_impl.h"
+#include "common/Monitors.h"
+#include "common/compose.hpp"
+
+#include <modules/ReferenceCounted.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+using String::compose;
+
+struct TestEntity : ReferenceCounted
+{
+    std::string describeEntity() const
+    {
+        return "";
+    }
+
+    std::string getId() const
+    {
+        return "1";
+    }
+};
+
+class OperationsDispatcherBenchmark : public Cyphesis::TestBase
+{
+    public:
+        OperationsDispatcherBenchmark();
+
+        void setup();
+
+        void teardown();
+
+        void test_heapQueue();
+
+        void test_timingWheelQueue();
+
+        /**
+         * Fills a dispatcher with Tick-like ops, scheduled between 1/15 s and 5 s into the future, and then dispatches ops,
+         * with each dispatched op rescheduling itself, like Tick ops do.
+         * @param pendingOps The number of ops kept in the queue.
+         */
+        template<typename QueueT>
+        void runTicks(const std::string& queueName, size_t pendingOps);
+};
+
+OperationsDispatcherBenchmark::OperationsDispatcherBenchmark()
+{
+    ADD_TEST(OperationsDispatcherBenchmark::test_heapQueue);
+    ADD_TEST(OperationsDispatcherBenchmark::test_timingWheelQueue);
+}
+
+void OperationsDispatcherBenchmark::setup()
+{
+}
+
+void OperationsDispatcherBenchmark::teardown()
+{
+}
+
+template<typename QueueT>
+void OperationsDispatcherBenchmark::runTicks(const std::string& queueName, size_t pendingOps)
+{
+    std::mt19937 random(static_cast<unsigned int>(pendingOps));
+    std::uniform_int_distribution<int> delayMs(66, 5000);
+    std::chrono::milliseconds time(0);
+    auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+    OperationsDispatcher<TestEntity, QueueT>* dispatcher = nullptr;
+    auto processorFn = [&](const Operation& op, Ref<TestEntity> from) {
+        //Reschedule the op, like a Tick op does.
+        Operation tick = op;
+        tick->setSeconds((time.count() + delayMs(random)) / 1000.0);
+        dispatcher->addOperationToQueue(tick, std::move(from));
+    };
+
+    OperationsDispatcher<TestEntity, QueueT> operationsDispatcher(processorFn, timeProviderFn);
+    dispatcher = &operationsDispatcher;
+
+    Ref<TestEntity> entity(new TestEntity);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pendingOps; ++i) {
+        Operation op;
+        op->setSeconds(delayMs(random) / 1000.0);
+        operationsDispatcher.addOperationToQueue(op, entity);
+    }
+    auto insertDuration = std::chrono::steady_clock::now() - start;
+
+    auto& queue = operationsDispatcher.getQueue();
+    size_t dispatchCount = std::max(pendingOps, size_t(100000));
+    auto dispatch = [&]() {
+        for (size_t i = 0; i < dispatchCount; ++i) {
+            time = queue.top().time_for_dispatch;
+            operationsDispatcher.dispatchNextOp();
+        }
+    };
+    //Let all ops be rescheduled once before measuring, so that the queue is in the state it would be in a running server.
+    dispatch();
+    start = std::chrono::steady_clock::now();
+    dispatch();
+    auto dispatchDuration = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQUAL(pendingOps, operationsDispatcher.getQueueSize());
+
+    log(INFO, compose("%1 with %2 pending ops: %3 ns per insert, %4 ns per dispatch and reschedule.", queueName, pendingOps,
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(insertDuration).count() / static_cast<long>(pendingOps),
+                      std::chrono::duration_cast<std::chrono::nanoseconds>(dispatchDuration).count() / static_cast<long>(dispatchCount)));
+}
+
+void OperationsDispatcherBenchmark::test_heapQueue()
+{
+    for (size_t pendingOps : {10000, 100000, 1000000}) {
+        runTicks<OpHeapQueue<TestEntity>>("Heap queue", pendingOps);
+    }
+}
+
+void OperationsDispatcherBenchmark::test_timingWheelQueue()
+{
+    for (size_t pendingOps : {10000, 100000, 1000000}) {
+        runTicks<OpTimingWheelQueue<TestEntity>>("Timing wheel queue", pendingOps);
+    }
+}
+
+int main()
+{
+    OperationsDispatcherBenchmark t;
+    Monitors m;
+
+    return t.run();
+}
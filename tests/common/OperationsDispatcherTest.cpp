@@ -24,6 +24,7 @@
 #include <Atlas/Objects/Operation.h>
 #include <Atlas/Objects/Entity.h>
 
+#include <algorithm>
 #include <memory>
 #include <wfmath/atlasconv.h>
 #include <modules/ReferenceCounted.h>
@@ -58,17 +59,27 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
     Tested()
     {
         ADD_TEST(test_dispatchInOrder)
+        ADD_TEST(test_queuesGiveSameOrder)
+        ADD_TEST(test_coalesceTicks)
+        ADD_TEST(test_coalesceTicksDueOutOfOrder)
 
     }
 
     void test_dispatchInOrder(TestContext& context)
+    {
+        dispatchInOrder<OpTimingWheelQueue<TestEntity>>();
+        dispatchInOrder<OpHeapQueue<TestEntity>>();
+    }
+
+    template<typename QueueT>
+    void dispatchInOrder()
     {
 
         std::chrono::milliseconds time(0);
         auto processorFn = [](const Operation&, Ref<TestEntity>) {};
         auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
 
-        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        OperationsDispatcher<TestEntity, QueueT> dispatcher(processorFn, timeProviderFn);
         auto& queue = dispatcher.getQueue();
 
         Ref<TestEntity> entity(new TestEntity);
@@ -193,6 +204,179 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
 
     }
 
+    void test_queuesGiveSameOrder(TestContext& context)
+    {
+        std::chrono::milliseconds time(0);
+        auto processorFn = [](const Operation&, Ref<TestEntity>) {};
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+        OperationsDispatcher<TestEntity, OpTimingWheelQueue<TestEntity>> wheelDispatcher(processorFn, timeProviderFn);
+        OperationsDispatcher<TestEntity, OpHeapQueue<TestEntity>> heapDispatcher(processorFn, timeProviderFn);
+        auto& wheelQueue = wheelDispatcher.getQueue();
+        auto& heapQueue = heapDispatcher.getQueue();
+
+        Ref<TestEntity> entity(new TestEntity);
+
+        //Mix ops which are late, at the same time, a tick ahead, and so far ahead that they overflow the wheel, and interleave adding with removing.
+        long refno = 0;
+        for (int round = 0; round < 50; ++round) {
+            for (double offset : {-0.5, 0.0, 0.0, 0.001, 1.0 / 15.0, 1.0 / 15.0, 3.0, 120.0, 100000.0}) {
+                refno++;
+                Operation wheelOp;
+                wheelOp->setSeconds(time.count() / 1000.0 + offset + (round % 7) * 0.01);
+                wheelOp->setRefno(refno);
+                Operation heapOp = wheelOp.copy();
+                wheelDispatcher.addOperationToQueue(wheelOp, entity);
+                heapDispatcher.addOperationToQueue(heapOp, entity);
+            }
+            for (int i = 0; i < 5; ++i) {
+                ASSERT_EQUAL(wheelQueue.size(), heapQueue.size())
+                ASSERT_EQUAL(wheelQueue.top().op->getRefno(), heapQueue.top().op->getRefno())
+                time = wheelQueue.top().time_for_dispatch;
+                wheelQueue.pop();
+                heapQueue.pop();
+            }
+        }
+        while (!heapQueue.empty()) {
+            ASSERT_FALSE(wheelQueue.empty())
+            ASSERT_EQUAL(wheelQueue.top().op->getRefno(), heapQueue.top().op->getRefno())
+            wheelQueue.pop();
+            heapQueue.pop();
+        }
+        ASSERT_TRUE(wheelQueue.empty())
+    }
+
+    void test_coalesceTicks(TestContext& context)
+    {
+        std::chrono::milliseconds time(0);
+        std::vector<Operation> dispatched;
+        auto processorFn = [&](const Operation& op, Ref<TestEntity>) { dispatched.push_back(op); };
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        dispatcher.m_coalesce_ticks = true;
+
+        Ref<TestEntity> entity(new TestEntity);
+
+        auto addTick = [&](const std::string& to, const std::string& name, const std::string& argId, double seconds, double lastTick) {
+            Atlas::Objects::Operation::Tick tick;
+            Anonymous arg;
+            arg->setName(name);
+            if (!argId.empty()) {
+                arg->setId(argId);
+            }
+            tick->setArgs1(arg);
+            tick->setTo(to);
+            tick->setSeconds(seconds);
+            tick->setAttr("lastTick", lastTick);
+            dispatcher.addOperationToQueue(tick, entity);
+        };
+
+        addTick("2", "domain", "", 1.0, 0.0);
+        addTick("2", "domain", "", 2.0, 1.0);
+        addTick("2", "domain", "", 3.0, 2.0);
+        //Ticks to other entities, with other names or for other tasks shouldn't be coalesced.
+        addTick("3", "domain", "", 1.0, 0.0);
+        addTick("2", "task", "1", 1.0, 0.0);
+        addTick("2", "task", "2", 1.0, 0.0);
+
+        ASSERT_EQUAL(dispatcher.getQueueSize(), 6u)
+
+        time = std::chrono::seconds(4);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+
+        ASSERT_EQUAL(dispatcher.getQueueSize(), 0u)
+        ASSERT_EQUAL(dispatcher.getCoalescedTickCount(), 2)
+        ASSERT_EQUAL(dispatched.size(), 4u)
+
+        //The last domain tick to "2" should be dispatched, with the lastTick of the first one.
+        auto I = std::find_if(dispatched.begin(), dispatched.end(), [](const Operation& op) {
+            return op->getTo() == "2" && op->getArgs().front()->getName() == "domain";
+        });
+        ASSERT_TRUE(I != dispatched.end())
+        Atlas::Message::Element lastTick;
+        ASSERT_EQUAL((*I)->copyAttr("lastTick", lastTick), 0)
+        ASSERT_EQUAL(lastTick.asNum(), 0.0)
+
+        //Once the newest tick has been dispatched new ticks shouldn't be coalesced with it.
+        dispatched.clear();
+        addTick("2", "domain", "", 5.0, 4.0);
+        time = std::chrono::seconds(5);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        ASSERT_EQUAL(dispatched.size(), 1u)
+        ASSERT_EQUAL(dispatcher.getCoalescedTickCount(), 2)
+
+        //Without coalescing all ticks should be dispatched.
+        dispatched.clear();
+        dispatcher.m_coalesce_ticks = false;
+        addTick("2", "domain", "", 6.0, 5.0);
+        addTick("2", "domain", "", 7.0, 6.0);
+        time = std::chrono::seconds(8);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        ASSERT_EQUAL(dispatched.size(), 2u)
+    }
+
+    void test_coalesceTicksDueOutOfOrder(TestContext& context)
+    {
+        std::chrono::milliseconds time(0);
+        std::vector<Operation> dispatched;
+        auto processorFn = [&](const Operation& op, Ref<TestEntity>) { dispatched.push_back(op); };
+        auto timeProviderFn = [&time]() -> std::chrono::steady_clock::duration { return time; };
+
+        OperationsDispatcher<TestEntity> dispatcher(processorFn, timeProviderFn);
+        dispatcher.m_coalesce_ticks = true;
+
+        Ref<TestEntity> entity(new TestEntity);
+
+        auto addTick = [&](double seconds, double lastTick) {
+            Atlas::Objects::Operation::Tick tick;
+            Anonymous arg;
+            arg->setName("domain");
+            tick->setArgs1(arg);
+            tick->setTo("2");
+            tick->setSeconds(seconds);
+            tick->setAttr("lastTick", lastTick);
+            dispatcher.addOperationToQueue(tick, entity);
+        };
+
+        //The newer tick is due before the older one, so it's popped first. The older one must still be dropped.
+        addTick(3.0, 1.0);
+        addTick(2.0, 1.5);
+
+        time = std::chrono::seconds(4);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+
+        ASSERT_EQUAL(dispatcher.getQueueSize(), 0u)
+        ASSERT_EQUAL(dispatched.size(), 1u)
+        ASSERT_EQUAL(dispatched.front()->getSeconds(), 2.0)
+        ASSERT_EQUAL(dispatcher.getCoalescedTickCount(), 1)
+
+        //A newer tick which is due earlier still takes over the lastTick of the older one.
+        dispatched.clear();
+        addTick(6.0, 1.0);
+        addTick(5.0, 4.0);
+        time = std::chrono::seconds(5);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        ASSERT_EQUAL(dispatched.size(), 1u)
+        ASSERT_EQUAL(dispatched.front()->getSeconds(), 5.0)
+        Atlas::Message::Element lastTick;
+        ASSERT_EQUAL(dispatched.front()->copyAttr("lastTick", lastTick), 0)
+        ASSERT_EQUAL(lastTick.asNum(), 1.0)
+        ASSERT_EQUAL(dispatcher.getQueueSize(), 1u)
+
+        //Once that has been dispatched, the older tick still in the queue should be dropped, and not pass its lastTick on to newer ticks.
+        dispatched.clear();
+        addTick(7.0, 5.0);
+        time = std::chrono::seconds(8);
+        dispatcher.idle(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+        ASSERT_EQUAL(dispatched.size(), 1u)
+        ASSERT_EQUAL(dispatched.front()->getSeconds(), 7.0)
+        ASSERT_EQUAL(dispatched.front()->copyAttr("lastTick", lastTick), 0)
+        ASSERT_EQUAL(lastTick.asNum(), 5.0)
+        ASSERT_EQUAL(dispatcher.getCoalescedTickCount(), 2)
+        ASSERT_EQUAL(dispatcher.getQueueSize(), 0u)
+    }
+
 };
 
 int main()
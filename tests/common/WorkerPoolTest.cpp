@@ -0,0 +1,120 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "common/WorkerPool.h"
+
+#include <atomic>
+
+class WorkerPoolTest : public Cyphesis::TestBase
+{
+    public:
+        WorkerPoolTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_noThreads();
+
+        void test_allIndicesVisitedOnce();
+
+        void test_repeatedBatches();
+};
+
+WorkerPoolTest::WorkerPoolTest()
+{
+    ADD_TEST(WorkerPoolTest::test_noThreads);
+    ADD_TEST(WorkerPoolTest::test_allIndicesVisitedOnce);
+    ADD_TEST(WorkerPoolTest::test_repeatedBatches);
+}
+
+void WorkerPoolTest::setup()
+{
+}
+
+void WorkerPoolTest::teardown()
+{
+}
+
+void WorkerPoolTest::test_noThreads()
+{
+    WorkerPool pool(0);
+    ASSERT_EQUAL(pool.getNumberOfThreads(), 0u);
+
+    auto callingThread = std::this_thread::get_id();
+    std::vector<size_t> visited;
+    pool.parallelFor(10, [&](size_t i) {
+        ASSERT_TRUE(std::this_thread::get_id() == callingThread);
+        visited.push_back(i);
+    });
+    ASSERT_EQUAL(visited.size(), 10u);
+    for (size_t i = 0; i < visited.size(); ++i) {
+        ASSERT_EQUAL(visited[i], i);
+    }
+}
+
+void WorkerPoolTest::test_allIndicesVisitedOnce()
+{
+    WorkerPool pool(4);
+    ASSERT_EQUAL(pool.getNumberOfThreads(), 4u);
+
+    std::vector<std::atomic<int>> visits(10000);
+    for (auto& visit : visits) {
+        visit = 0;
+    }
+    pool.parallelFor(visits.size(), [&](size_t i) {
+        visits[i]++;
+    });
+    for (auto& visit : visits) {
+        ASSERT_EQUAL(visit.load(), 1);
+    }
+}
+
+void WorkerPoolTest::test_repeatedBatches()
+{
+    WorkerPool pool(3);
+
+    std::atomic<size_t> sum(0);
+    for (size_t batch = 0; batch < 1000; ++batch) {
+        pool.parallelFor(batch % 7, [&](size_t i) {
+            sum += i + 1;
+        });
+    }
+    size_t expected = 0;
+    for (size_t batch = 0; batch < 1000; ++batch) {
+        auto count = batch % 7;
+        expected += (count * (count + 1)) / 2;
+    }
+    ASSERT_EQUAL(sum.load(), expected);
+}
+
+int main()
+{
+    WorkerPoolTest t;
+
+    return t.run();
+}
@@ -0,0 +1,228 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "navigation/Awareness.h"
+#include "navigation/IHeightProvider.h"
+#include "rules/MemEntity.h"
+
+#include <wfmath/rotbox.h>
+#include <wfmath/intersect.h>
+
+namespace {
+    const int tileSize = 64;
+
+    struct FlatHeightProvider : public IHeightProvider
+    {
+        void blitHeights(int xMin, int xMax, int yMin, int yMax, std::vector<float>& heights) const override
+        {
+            heights.resize(tileSize * tileSize, 0);
+        }
+    };
+
+    /**
+     * Exposes the handling of entity areas.
+     */
+    struct TestAwareness : public Awareness
+    {
+        using Awareness::Awareness;
+        using Awareness::findEntityAreas;
+        using Awareness::setEntityArea;
+        using Awareness::removeEntityArea;
+        using Awareness::mEntityAreas;
+        using Awareness::mEntityAreasByTile;
+    };
+
+    WFMath::RotBox<2> axisArea(WFMath::CoordType x1, WFMath::CoordType y1, WFMath::CoordType x2, WFMath::CoordType y2)
+    {
+        return WFMath::RotBox<2>({x1, y1}, {x2 - x1, y2 - y1}, WFMath::RotMatrix<2>().identity());
+    }
+}
+
+class AwarenessTest : public Cyphesis::TestBase
+{
+    private:
+        Ref<MemEntity> m_worldEntity;
+        FlatHeightProvider m_heightProvider;
+        TestAwareness* m_awareness;
+
+    public:
+        AwarenessTest();
+
+        void setup();
+
+        void teardown();
+
+        /**
+         * Checks that the areas found through the tile index are the same, and in the same order,
+         * as those found by checking every area.
+         */
+        void checkAgainstLinearScan(const WFMath::AxisBox<2>& extent);
+
+        /**
+         * Checks a set of extents covering each tile, parts of tiles, tile borders and the whole world.
+         */
+        void checkAllExtents();
+
+        void test_findEntityAreas();
+
+        void test_areaSpanningTilesIsFoundOnce();
+};
+
+AwarenessTest::AwarenessTest()
+{
+    ADD_TEST(AwarenessTest::test_findEntityAreas);
+    ADD_TEST(AwarenessTest::test_areaSpanningTilesIsFoundOnce);
+}
+
+void AwarenessTest::setup()
+{
+    m_worldEntity = new MemEntity("0", 0);
+    //With an agent radius of 1 the cell size is 0.5, so each tile covers 32 meters, with tile borders at -32, 0 and 32.
+    m_awareness = new TestAwareness(*m_worldEntity, 1, 2, 0.5, m_heightProvider, {{-64, -64, -64}, {64, 64, 64}}, tileSize);
+}
+
+void AwarenessTest::teardown()
+{
+    delete m_awareness;
+    m_worldEntity = nullptr;
+}
+
+void AwarenessTest::checkAgainstLinearScan(const WFMath::AxisBox<2>& extent)
+{
+    std::vector<WFMath::RotBox<2>> expected;
+    for (auto& entry : m_awareness->mEntityAreas) {
+        if (WFMath::Contains(extent, entry.second, false) || WFMath::Intersect(extent, entry.second, false)) {
+            expected.push_back(entry.second);
+        }
+    }
+
+    std::vector<WFMath::RotBox<2>> areas;
+    m_awareness->findEntityAreas(extent, areas);
+
+    ASSERT_EQUAL(areas.size(), expected.size());
+    for (size_t i = 0; i < areas.size() && i < expected.size(); ++i) {
+        ASSERT_TRUE(areas[i].isEqualTo(expected[i]));
+    }
+}
+
+void AwarenessTest::checkAllExtents()
+{
+    auto tileSizeInMeters = m_awareness->getTileSizeInMeters();
+    ASSERT_FUZZY_EQUAL(tileSizeInMeters, 32, 0.0001);
+
+    for (int x = -64; x < 64; x += 32) {
+        for (int y = -64; y < 64; y += 32) {
+            //Whole tiles.
+            checkAgainstLinearScan({{(WFMath::CoordType) x, (WFMath::CoordType) y}, {x + 32.0f, y + 32.0f}});
+            //Parts of tiles.
+            checkAgainstLinearScan({{x + 1.0f, y + 1.0f}, {x + 8.0f, y + 8.0f}});
+            //Around tile borders.
+            checkAgainstLinearScan({{x - 4.0f, y - 4.0f}, {x + 4.0f, y + 4.0f}});
+        }
+    }
+    checkAgainstLinearScan({{-64, -64}, {64, 64}});
+}
+
+void AwarenessTest::test_findEntityAreas()
+{
+    EntityEntry inOneTile{1};
+    EntityEntry onBorder{2};
+    EntityEntry rotated{3};
+
+    m_awareness->setEntityArea(&inOneTile, axisArea(10, 10, 12, 12));
+    m_awareness->setEntityArea(&onBorder, axisArea(-2, 5, 2, 7));
+    m_awareness->setEntityArea(&rotated, WFMath::RotBox<2>({30, -3}, {4, 2}, WFMath::RotMatrix<2>().rotation(WFMath::numeric_constants<WFMath::CoordType>::pi() / 4)));
+    checkAllExtents();
+
+    std::vector<WFMath::RotBox<2>> areas;
+    m_awareness->findEntityAreas({{-4, 4}, {4, 8}}, areas);
+    ASSERT_EQUAL(areas.size(), 1u);
+
+    //Move across the border, entirely into another tile.
+    m_awareness->setEntityArea(&onBorder, axisArea(-20, 5, -18, 7));
+    checkAllExtents();
+    areas.clear();
+    m_awareness->findEntityAreas({{0, 0}, {8, 8}}, areas);
+    ASSERT_TRUE(areas.empty());
+
+    //Move into a corner shared by four tiles.
+    m_awareness->setEntityArea(&inOneTile, axisArea(-1, -1, 1, 1));
+    checkAllExtents();
+    for (auto& extent : std::vector<WFMath::AxisBox<2>>{{{-8, -8}, {-1, -1}}, {{1, -8}, {8, -1}}, {{-8, 1}, {-1, 8}}, {{1, 1}, {8, 8}}}) {
+        areas.clear();
+        m_awareness->findEntityAreas(extent, areas);
+        ASSERT_EQUAL(areas.size(), 1u);
+    }
+
+    m_awareness->removeEntityArea(&rotated);
+    checkAllExtents();
+    //Removing an entity without an area should do nothing.
+    m_awareness->removeEntityArea(&rotated);
+    checkAllExtents();
+
+    m_awareness->removeEntityArea(&inOneTile);
+    m_awareness->removeEntityArea(&onBorder);
+    checkAllExtents();
+    ASSERT_TRUE(m_awareness->mEntityAreas.empty());
+    ASSERT_TRUE(m_awareness->mEntityAreasByTile.empty());
+}
+
+void AwarenessTest::test_areaSpanningTilesIsFoundOnce()
+{
+    EntityEntry large{1};
+    EntityEntry small{2};
+
+    //Touches nine tiles.
+    m_awareness->setEntityArea(&large, axisArea(-40, -40, 10, 10));
+    m_awareness->setEntityArea(&small, axisArea(50, 50, 52, 52));
+    ASSERT_EQUAL(m_awareness->mEntityAreasByTile.size(), 10u);
+    checkAllExtents();
+
+    std::vector<WFMath::RotBox<2>> areas;
+    m_awareness->findEntityAreas({{-64, -64}, {64, 64}}, areas);
+    ASSERT_EQUAL(areas.size(), 2u);
+
+    areas.clear();
+    m_awareness->findEntityAreas({{-35, -35}, {35, 35}}, areas);
+    ASSERT_EQUAL(areas.size(), 1u);
+
+    //Shrink it so it only touches the four tiles around the origin.
+    m_awareness->setEntityArea(&large, axisArea(-10, -10, 10, 10));
+    ASSERT_EQUAL(m_awareness->mEntityAreasByTile.size(), 5u);
+    checkAllExtents();
+
+    m_awareness->removeEntityArea(&large);
+    ASSERT_EQUAL(m_awareness->mEntityAreasByTile.size(), 1u);
+    checkAllExtents();
+}
+
+int main()
+{
+    AwarenessTest t;
+
+    return t.run();
+}
@@ -19,6 +19,7 @@
 #include <navigation/Steering.h>
 #include <navigation/Awareness.h>
 #include "navigation/IHeightProvider.h"
+#include "common/JobQueue.h"
 #include "rules/MemEntity.h"
 #include "../TestBase.h"
 #include "../TestWorld.h"
@@ -58,6 +59,7 @@ struct SteeringIntegration : public Cyphesis::TestBase
         ADD_TEST(SteeringIntegration::test_resolveDestination);
         ADD_TEST(SteeringIntegration::test_distance);
         ADD_TEST(SteeringIntegration::test_navigation);
+        ADD_TEST(SteeringIntegration::test_navigationWithBackgroundTileBuilding);
     }
 
     void setup()
@@ -357,6 +359,17 @@ struct SteeringIntegration : public Cyphesis::TestBase
     }
 
     void test_navigation()
+    {
+        navigation(nullptr);
+    }
+
+    void test_navigationWithBackgroundTileBuilding()
+    {
+        JobQueue tileBuildQueue(2);
+        navigation(&tileBuildQueue);
+    }
+
+    void navigation(JobQueue* tileBuildQueue)
     {
 
         Ref<MemEntity> worldEntity(new MemEntity("0", 0));
@@ -408,7 +421,7 @@ struct SteeringIntegration : public Cyphesis::TestBase
 
         } heightProvider;
 
-        Awareness awareness(*worldEntity, avatarHorizontalRadius, 2, 0.5, heightProvider, extent, tileSize);
+        Awareness awareness(*worldEntity, avatarHorizontalRadius, 2, 0.5, heightProvider, extent, tileSize, tileBuildQueue);
         steering.setAwareness(&awareness);
         auto rebuildAllTilesFn = [&]() {
             while (true) {
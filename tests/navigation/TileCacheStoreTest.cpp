@@ -0,0 +1,162 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "navigation/TileCacheStore.h"
+
+#include <boost/filesystem/operations.hpp>
+
+#include <fstream>
+
+class TileCacheStoreTest : public Cyphesis::TestBase
+{
+    private:
+        boost::filesystem::path m_path;
+
+    public:
+        TileCacheStoreTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_storeAndReload();
+
+        void test_hashMismatch();
+
+        void test_truncatedFile();
+
+        void test_lockedByOtherStore();
+};
+
+TileCacheStoreTest::TileCacheStoreTest()
+{
+    ADD_TEST(TileCacheStoreTest::test_storeAndReload);
+    ADD_TEST(TileCacheStoreTest::test_hashMismatch);
+    ADD_TEST(TileCacheStoreTest::test_truncatedFile);
+    ADD_TEST(TileCacheStoreTest::test_lockedByOtherStore);
+}
+
+void TileCacheStoreTest::setup()
+{
+    m_path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("cyphesis-tiles-%%%%-%%%%.tiles");
+}
+
+void TileCacheStoreTest::teardown()
+{
+    boost::filesystem::remove(m_path);
+    boost::filesystem::remove(m_path.string() + ".lock");
+}
+
+void TileCacheStoreTest::test_storeAndReload()
+{
+    {
+        TileCacheStore store(m_path.string());
+        ASSERT_EQUAL(store.size(), 0u);
+        store.store(1, 2, 100, {{1, 2, 3}, {4, 5}});
+        store.store(-1, 0, 200, {{6}});
+        //Replacing a tile should only keep the last layers.
+        store.store(1, 2, 101, {{7, 8}});
+    }
+
+    TileCacheStore store(m_path.string());
+    ASSERT_EQUAL(store.size(), 2u);
+    auto layers = store.find(1, 2, 101);
+    ASSERT_NOT_NULL(layers);
+    ASSERT_EQUAL(layers->size(), 1u);
+    ASSERT_TRUE((*layers)[0] == std::vector<unsigned char>({7, 8}));
+
+    layers = store.find(-1, 0, 200);
+    ASSERT_NOT_NULL(layers);
+    ASSERT_TRUE((*layers)[0] == std::vector<unsigned char>({6}));
+
+    ASSERT_NULL(store.find(0, 0, 100));
+}
+
+void TileCacheStoreTest::test_hashMismatch()
+{
+    TileCacheStore store(m_path.string());
+    store.store(1, 2, 100, {{1, 2, 3}});
+    ASSERT_NOT_NULL(store.find(1, 2, 100));
+    ASSERT_NULL(store.find(1, 2, 101));
+
+    auto hash = TileCacheStore::hash("abc", 3);
+    ASSERT_EQUAL(hash, TileCacheStore::hash("c", 1, TileCacheStore::hash("ab", 2)));
+    ASSERT_NOT_EQUAL(hash, TileCacheStore::hash("abd", 3));
+}
+
+void TileCacheStoreTest::test_truncatedFile()
+{
+    {
+        TileCacheStore store(m_path.string());
+        store.store(1, 1, 100, {{1, 2, 3}});
+        store.store(2, 2, 200, {{4, 5, 6}});
+    }
+    //Cut off the last record, as if the process was killed while writing it.
+    boost::filesystem::resize_file(m_path, boost::filesystem::file_size(m_path) - 2);
+
+    {
+        TileCacheStore store(m_path.string());
+        ASSERT_EQUAL(store.size(), 1u);
+        ASSERT_NOT_NULL(store.find(1, 1, 100));
+        store.store(3, 3, 300, {{7}});
+    }
+
+    //The partial record should have been removed, so that new records can be read.
+    TileCacheStore store(m_path.string());
+    ASSERT_EQUAL(store.size(), 2u);
+    ASSERT_NOT_NULL(store.find(3, 3, 300));
+}
+
+void TileCacheStoreTest::test_lockedByOtherStore()
+{
+    {
+        TileCacheStore store(m_path.string());
+        ASSERT_TRUE(store.isPersistent());
+        store.store(1, 1, 100, {{1, 2, 3}});
+
+        //Another store using the same file, as if from another process, shouldn't touch the file at all.
+        TileCacheStore otherStore(m_path.string());
+        ASSERT_FALSE(otherStore.isPersistent());
+        ASSERT_NULL(otherStore.find(1, 1, 100));
+        otherStore.store(2, 2, 200, {{4, 5, 6}});
+        ASSERT_NOT_NULL(otherStore.find(2, 2, 200));
+    }
+
+    //Once the first store is gone the file should be available again, with only the tiles of the first store.
+    TileCacheStore store(m_path.string());
+    ASSERT_TRUE(store.isPersistent());
+    ASSERT_EQUAL(store.size(), 1u);
+    ASSERT_NOT_NULL(store.find(1, 1, 100));
+    ASSERT_NULL(store.find(2, 2, 200));
+}
+
+int main()
+{
+    TileCacheStoreTest t;
+
+    return t.run();
+}
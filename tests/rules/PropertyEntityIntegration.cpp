@@ -32,6 +32,8 @@
 #include "common/PropertyManager.h"
 #include "common/TypeNode.h"
 
+#include <Atlas/Objects/Operation.h>
+
 #include <cstdlib>
 
 #include <cassert>
@@ -128,6 +130,37 @@ std::unique_ptr<PropertyBase> TestPropertyManager::addProperty(const std::string
     }
 }
 
+/**
+ * A property which handles Look ops, and counts them.
+ */
+struct DelegateProperty : Property<long>
+{
+    int m_handled = 0;
+
+    void install(LocatedEntity* owner, const std::string& name) override
+    {
+        owner->installDelegate(Atlas::Objects::Operation::LOOK_NO, name);
+    }
+
+    void remove(LocatedEntity* owner, const std::string& name) override
+    {
+        owner->removeDelegate(Atlas::Objects::Operation::LOOK_NO, name);
+    }
+
+    HandlerResult operation(LocatedEntity*, const Operation&, OpVector&) override
+    {
+        m_handled++;
+        return OPERATION_IGNORED;
+    }
+
+    DelegateProperty* copy() const override
+    {
+        auto copy = new DelegateProperty(*this);
+        copy->m_handled = 0;
+        return copy;
+    }
+};
+
 struct TestEntity : Entity
 {
     explicit TestEntity(const std::string& id, long intId) : Entity(id, intId)
@@ -198,6 +231,9 @@ struct PropertyEntityIntegration : public Cyphesis::TestBaseWithContext<TestCont
         ADD_TEST(PropertyEntityIntegration::test_modPropertyClass<double>);
         ADD_TEST(PropertyEntityIntegration::test_modPropertyClass<std::string>);
         ADD_TEST(PropertyEntityIntegration::test_modPropertyClass<MapType>);
+
+        ADD_TEST(PropertyEntityIntegration::test_delegates);
+        ADD_TEST(PropertyEntityIntegration::test_delegatesTypeUpdate);
     }
 
 
@@ -478,6 +514,64 @@ struct PropertyEntityIntegration : public Cyphesis::TestBaseWithContext<TestCont
         ASSERT_EQUAL(p->data(), test_values<T>::initial_value);
     }
 
+    void test_delegates(TestContext& context)
+    {
+        Atlas::Objects::Operation::Look look;
+        OpVector res;
+
+        context.m_type.injectProperty("test_delegate", std::make_unique<DelegateProperty>());
+        auto& dflt = dynamic_cast<DelegateProperty&>(*context.m_type.defaults().find("test_delegate")->second);
+        dflt.install(context.m_entity.get(), "test_delegate");
+
+        //Without an instance property the op should be delegated to the type default.
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(dflt.m_handled, 1);
+
+        //Setting the value creates an instance property, which should then get the ops.
+        context.m_entity->setAttrValue("test_delegate", 5);
+        auto instance = dynamic_cast<DelegateProperty*>(context.m_entity->modProperties().find("test_delegate")->second.property.get());
+        ASSERT_NOT_NULL(instance);
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(dflt.m_handled, 1);
+        ASSERT_EQUAL(instance->m_handled, 1);
+
+        //Replacing the instance property should also replace the delegate.
+        instance->remove(context.m_entity.get(), "test_delegate");
+        auto replacement = new DelegateProperty();
+        context.m_entity->setProperty("test_delegate", std::unique_ptr<DelegateProperty>(replacement));
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(replacement->m_handled, 1);
+
+        //After removing the delegate no ops should be delegated.
+        replacement->remove(context.m_entity.get(), "test_delegate");
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(replacement->m_handled, 1);
+    }
+
+    void test_delegatesTypeUpdate(TestContext& context)
+    {
+        Atlas::Objects::Operation::Look look;
+        OpVector res;
+
+        context.m_type.injectProperty("test_delegate", std::make_unique<DelegateProperty>());
+        context.m_type.defaults().find("test_delegate")->second->install(context.m_entity.get(), "test_delegate");
+
+        //Replacing the type default should make the entity use the new default.
+        context.m_type.injectProperty("test_delegate", std::make_unique<DelegateProperty>());
+        auto& dflt = dynamic_cast<DelegateProperty&>(*context.m_type.defaults().find("test_delegate")->second);
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(dflt.m_handled, 1);
+
+        //A new type should also be used.
+        TypeNode otherType("other_type");
+        otherType.injectProperty("test_delegate", std::make_unique<DelegateProperty>());
+        auto& otherDflt = dynamic_cast<DelegateProperty&>(*otherType.defaults().find("test_delegate")->second);
+        context.m_entity->setType(&otherType);
+        context.m_entity->operation(look, res);
+        ASSERT_EQUAL(dflt.m_handled, 1);
+        ASSERT_EQUAL(otherDflt.m_handled, 1);
+        context.m_entity->setType(&context.m_type);
+    }
 
 };
 
@@ -35,6 +35,7 @@
 #include "rules/python/PythonWrapper.h"
 #include "pycxx/CXX/Extensions.hxx"
 #include "common/operations/Tick.h"
+#include "common/Property.h"
 
 #include "../TestWorld.h"
 
@@ -76,6 +77,7 @@ int main()
     run_python_string("class TestEntity(server.Thing):\n"
                       " def __init__(self, cppthing):\n"
                       "  self.foo = 'bar'\n"
+                      "  self.status_updates = 0\n"
                       "  assert self.foo == 'bar'\n"
                       " def look_operation(self, op): pass\n"
                       " def delete_operation(self, op):\n"
@@ -88,7 +90,9 @@ int main()
                       "  return Operation('sight')\n"
                       " def move_operation(self, op):\n"
                       "  return Operation('sight') + Operation('move')\n"
-                      " def test_hook(self, ent): pass\n");
+                      " def test_hook(self, ent): pass\n"
+                      " def status_property_update(self):\n"
+                      "  self.status_updates += 1\n");
     run_python_string("testmod.TestEntity=TestEntity");
 
     // PyObject * package_name = PyUnicode_FromString("testmod");
@@ -134,6 +138,59 @@ int main()
 
     script->hook("nohookfunction", e.get(), res);
     script->hook("test_hook", e.get(), res);
+
+    //Handler lookups are cached, so calling the same handlers again should give the same results.
+    OpVector scriptRes;
+    assert(script->operation("set", op5, scriptRes) == OPERATION_IGNORED);
+    assert(script->operation("set", op5, scriptRes) == OPERATION_IGNORED);
+    assert(scriptRes.size() == 2);
+    assert(script->operation("create", op2, scriptRes) == OPERATION_IGNORED);
+    assert(scriptRes.size() == 2);
+
+    //Another entity with the same script class uses the same cached lookups.
+    Ref<Entity> e2 = new Entity("2", 2);
+    ret = psf.addScript(e2.get());
+    assert(ret == 0);
+    auto& script2 = e2->m_scripts.front();
+    scriptRes.clear();
+    script2->operation("move", op6, scriptRes);
+    assert(scriptRes.size() == 2);
+    assert(script2->operation("create", op2, scriptRes) == OPERATION_IGNORED);
+    assert(scriptRes.size() == 2);
+
+    //Clearing the cache, as is done when scripts are reloaded, should not affect existing scripts.
+    PythonWrapper::clearOperationHandlerCache();
+    scriptRes.clear();
+    script->operation("set", op5, scriptRes);
+    script2->operation("set", op5, scriptRes);
+    assert(scriptRes.size() == 2);
+    e2 = nullptr;
+
+    //Property update callbacks are only called for their own property.
+    auto statusUpdates = [&]() {
+        return Py::Long(dynamic_cast<PythonWrapper*>(script.get())->wrapper().getAttr("status_updates")).as_long();
+    };
+    SoftProperty property;
+    e->propertyApplied("status", property);
+    e->propertyApplied("mass", property);
+    assert(statusUpdates() == 1);
+
+    //When deferred, callbacks are only called once per flush.
+    PythonWrapper::s_deferPropertyUpdates = true;
+    e->propertyApplied("status", property);
+    e->propertyApplied("status", property);
+    assert(statusUpdates() == 1);
+    PythonWrapper::flushPropertyUpdates();
+    assert(statusUpdates() == 2);
+    PythonWrapper::flushPropertyUpdates();
+    assert(statusUpdates() == 2);
+
+    //Pending callbacks are discarded when the script is destroyed.
+    e->propertyApplied("status", property);
+    e->m_scripts.clear();
+    PythonWrapper::flushPropertyUpdates();
+    PythonWrapper::s_deferPropertyUpdates = false;
+
     e = nullptr;
 
     shutdown_python_api();
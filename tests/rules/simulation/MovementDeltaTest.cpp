@@ -0,0 +1,105 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "../../TestBaseWithContext.h"
+
+#include "rules/simulation/MovementDelta.h"
+
+using Atlas::Message::IntType;
+using Atlas::Message::ListType;
+
+struct TestContext
+{
+};
+
+struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
+{
+    Tested()
+    {
+        ADD_TEST(test_writeAndRead)
+        ADD_TEST(test_quantize)
+        ADD_TEST(test_truncated)
+    }
+
+    static MovementDelta createDelta()
+    {
+        MovementDelta delta{};
+        delta.entityId = 12;
+        delta.sequence = 3;
+        delta.flags = MovementDelta::POSITION | MovementDelta::ORIENTATION;
+        delta.position = {1000, -2000, 3000};
+        delta.positionDelta = {10, 0, -5};
+        delta.orientation = {0, 0, 0, 32767};
+        return delta;
+    }
+
+    void test_writeAndRead(TestContext& context)
+    {
+        auto delta = createDelta();
+        ListType list;
+        delta.write(list, false);
+        delta.write(list, true);
+        //Header plus position and orientation, twice.
+        ASSERT_EQUAL(list.size(), 20u)
+
+        size_t index = 0;
+        MovementDelta record{};
+        ASSERT_TRUE(MovementDelta::read(list, index, record))
+        ASSERT_EQUAL(record.entityId, 12)
+        ASSERT_EQUAL(record.sequence, 3)
+        ASSERT_EQUAL(record.flags, MovementDelta::POSITION | MovementDelta::ORIENTATION)
+        ASSERT_TRUE(record.positionDelta == delta.positionDelta)
+        ASSERT_TRUE(record.orientation == delta.orientation)
+
+        ASSERT_TRUE(MovementDelta::read(list, index, record))
+        ASSERT_EQUAL(record.flags, MovementDelta::KEYFRAME | MovementDelta::POSITION | MovementDelta::ORIENTATION)
+        ASSERT_TRUE(record.position == delta.position)
+        ASSERT_EQUAL(index, list.size())
+    }
+
+    void test_quantize(TestContext& context)
+    {
+        ASSERT_EQUAL(MovementDelta::quantize(0.0004, MovementDelta::POSITION_SCALE), 0)
+        ASSERT_EQUAL(MovementDelta::quantize(0.0006, MovementDelta::POSITION_SCALE), 1)
+        //Negative values should be rounded to nearest as well, not towards zero.
+        ASSERT_EQUAL(MovementDelta::quantize(-0.0006, MovementDelta::POSITION_SCALE), -1)
+        ASSERT_EQUAL(MovementDelta::quantize(-2.3456, MovementDelta::POSITION_SCALE), -2346)
+    }
+
+    void test_truncated(TestContext& context)
+    {
+        auto delta = createDelta();
+        ListType list;
+        delta.write(list, false);
+        list.pop_back();
+        size_t index = 0;
+        MovementDelta record{};
+        ASSERT_FALSE(MovementDelta::read(list, index, record))
+
+        ListType badList{1, 2, "3"};
+        index = 0;
+        ASSERT_FALSE(MovementDelta::read(badList, index, record))
+    }
+};
+
+int main()
+{
+    Tested t;
+
+    return t.run();
+}
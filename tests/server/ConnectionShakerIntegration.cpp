@@ -114,6 +114,7 @@ int main()
 using Atlas::Objects::Root;
 
 bool restricted_flag;
+bool movement_deltas_flag;
 
 namespace Atlas { namespace Objects { namespace Operation {
 int UPDATE_NO = -1;
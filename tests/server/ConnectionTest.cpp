@@ -567,6 +567,7 @@ int main()
 #include "rules/simulation/BaseWorld.h"
 
 bool restricted_flag;
+bool movement_deltas_flag;
 
 namespace Atlas { namespace Objects { namespace Operation {
 int UPDATE_NO = -1;
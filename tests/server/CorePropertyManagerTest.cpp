@@ -33,6 +33,7 @@
 
 #include "common/CommSocket.h"
 #include "common/Inheritance.h"
+#include "common/Property.h"
 #include "common/PropertyFactory.h"
 #include "common/SystemTime.h"
 
@@ -87,6 +88,10 @@ class CorePropertyManagertest : public Cyphesis::TestBase
 
         void test_installFactory();
 
+        void test_visibilityBackend();
+
+        void test_batchMoveSights();
+
         Inheritance* m_inheritance;
 };
 
@@ -95,6 +100,8 @@ CorePropertyManagertest::CorePropertyManagertest()
     ADD_TEST(CorePropertyManagertest::test_addProperty);
     ADD_TEST(CorePropertyManagertest::test_addProperty_named);
     ADD_TEST(CorePropertyManagertest::test_installFactory);
+    ADD_TEST(CorePropertyManagertest::test_visibilityBackend);
+    ADD_TEST(CorePropertyManagertest::test_batchMoveSights);
 }
 
 void CorePropertyManagertest::setup()
@@ -138,6 +145,22 @@ void CorePropertyManagertest::test_installFactory()
     ASSERT_EQUAL(ret, 0);
 }
 
+void CorePropertyManagertest::test_visibilityBackend()
+{
+    //PhysicalDomain reads this with getPropertyType<std::string>, which doesn't work with a SoftProperty.
+    auto p = m_propertyManager->addProperty("visibility_backend");
+    ASSERT_TRUE(p);
+    ASSERT_NOT_NULL(dynamic_cast<Property<std::string>*>(p.get()));
+}
+
+void CorePropertyManagertest::test_batchMoveSights()
+{
+    //PhysicalDomain reads this with getPropertyClass<BoolProperty>.
+    auto p = m_propertyManager->addProperty("batch_move_sights");
+    ASSERT_TRUE(p);
+    ASSERT_NOT_NULL(dynamic_cast<BoolProperty*>(p.get()));
+}
+
 int main()
 {
     CorePropertyManagertest t;
@@ -0,0 +1,250 @@
+/*
+ Copyright (C) 2020 Erik Ogenvik
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 2 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program; if not, write to the Free Software
+ Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+
+#include "server/ExternalMindsManager.h"
+#include "server/ExternalMindsConnection.h"
+#include "server/PossessionAuthenticator.h"
+
+#include "rules/simulation/Entity.h"
+#include "common/CommSocket.h"
+#include "common/Link.h"
+
+#include <Atlas/Message/QueuedDecoder.h>
+#include <Atlas/Objects/Encoder.h>
+
+class TestCommSocket : public CommSocket
+{
+    public:
+        explicit TestCommSocket(boost::asio::io_context& io_context) : CommSocket(io_context)
+        {
+        }
+
+        void disconnect() override
+        {
+        }
+
+        int flush() override
+        {
+            return 0;
+        }
+};
+
+/**
+ * A link which keeps everything sent through it.
+ */
+class TestLink : public Link
+{
+    public:
+        Atlas::Message::QueuedDecoder decoder;
+        Atlas::Objects::ObjectsEncoder encoder;
+
+        TestLink(CommSocket& socket, const std::string& id, long iid) : Link(socket, id, iid), encoder(decoder)
+        {
+            decoder.streamBegin();
+            setEncoder(&encoder);
+        }
+
+        void externalOperation(const Operation&, Link&) override
+        {
+        }
+
+        void operation(const Operation&, OpVector&) override
+        {
+        }
+
+        /**
+         * @return The ids of the entities which have been requested to be possessed, in order.
+         */
+        std::vector<std::string> popPossessedIds()
+        {
+            std::vector<std::string> ids;
+            while (decoder.queueSize() > 0) {
+                auto message = decoder.popMessage();
+                auto& args = message["args"].List();
+                ids.push_back(args.front().Map().find("possess_entity_id")->second.String());
+            }
+            return ids;
+        }
+};
+
+class ExternalMindsManagerTest : public Cyphesis::TestBase
+{
+    private:
+        boost::asio::io_context m_io_context;
+        std::unique_ptr<TestCommSocket> m_socket;
+        std::unique_ptr<PossessionAuthenticator> m_possessionAuthenticator;
+        std::unique_ptr<ExternalMindsManager> m_manager;
+        std::vector<std::unique_ptr<TestLink>> m_links;
+        std::vector<Ref<Entity>> m_entities;
+        long m_idCounter;
+
+    public:
+        ExternalMindsManagerTest();
+
+        void setup();
+
+        void teardown();
+
+        void test_leastLoadedConnection();
+
+        void test_unassignDestroyedEntity();
+
+        void test_removeConnection();
+
+        TestLink& addConnection(const std::string& routerId);
+
+        Ref<Entity> requestPossession();
+};
+
+ExternalMindsManagerTest::ExternalMindsManagerTest() : m_idCounter(0)
+{
+    ADD_TEST(ExternalMindsManagerTest::test_leastLoadedConnection);
+    ADD_TEST(ExternalMindsManagerTest::test_unassignDestroyedEntity);
+    ADD_TEST(ExternalMindsManagerTest::test_removeConnection);
+}
+
+void ExternalMindsManagerTest::setup()
+{
+    m_socket = std::make_unique<TestCommSocket>(m_io_context);
+    m_possessionAuthenticator = std::make_unique<PossessionAuthenticator>();
+    m_manager = std::make_unique<ExternalMindsManager>();
+}
+
+void ExternalMindsManagerTest::teardown()
+{
+    m_entities.clear();
+    m_manager.reset();
+    m_links.clear();
+    m_possessionAuthenticator.reset();
+    m_socket.reset();
+}
+
+TestLink& ExternalMindsManagerTest::addConnection(const std::string& routerId)
+{
+    m_idCounter++;
+    m_links.emplace_back(new TestLink(*m_socket, std::to_string(m_idCounter), m_idCounter));
+    m_manager->addConnection(ExternalMindsConnection(m_links.back().get(), routerId));
+    return *m_links.back();
+}
+
+Ref<Entity> ExternalMindsManagerTest::requestPossession()
+{
+    m_idCounter++;
+    Ref<Entity> entity = new Entity(std::to_string(m_idCounter), m_idCounter);
+    m_entities.push_back(entity);
+    m_manager->requestPossession(entity.get());
+    return entity;
+}
+
+void ExternalMindsManagerTest::test_leastLoadedConnection()
+{
+    auto& link1 = addConnection("router1");
+    auto& link2 = addConnection("router2");
+    auto& link3 = addConnection("router3");
+
+    //With all connections equally loaded the last one should be used.
+    auto entity = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds().empty());
+    ASSERT_TRUE(link2.popPossessedIds().empty());
+    ASSERT_TRUE(link3.popPossessedIds() == std::vector<std::string>{entity->getId()});
+
+    entity = requestPossession();
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity->getId()});
+    entity = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds() == std::vector<std::string>{entity->getId()});
+
+    //The minds should be spread evenly.
+    for (int i = 0; i < 6; ++i) {
+        requestPossession();
+    }
+    ASSERT_EQUAL(link1.popPossessedIds().size(), 2u);
+    ASSERT_EQUAL(link2.popPossessedIds().size(), 2u);
+    ASSERT_EQUAL(link3.popPossessedIds().size(), 2u);
+}
+
+void ExternalMindsManagerTest::test_unassignDestroyedEntity()
+{
+    auto& link1 = addConnection("router1");
+    auto& link2 = addConnection("router2");
+
+    auto entity1 = requestPossession();
+    auto entity2 = requestPossession();
+    auto entity3 = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds() == std::vector<std::string>{entity2->getId()});
+    ASSERT_TRUE(link2.popPossessedIds() == (std::vector<std::string>{entity1->getId(), entity3->getId()}));
+
+    //After destroying both entities on the second connection it should have the fewest entities.
+    entity1->destroyed.emit();
+    entity3->destroyed.emit();
+    auto entity4 = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds().empty());
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity4->getId()});
+
+    //Now both have one entity each.
+    auto entity5 = requestPossession();
+    auto entity6 = requestPossession();
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity5->getId()});
+    ASSERT_TRUE(link1.popPossessedIds() == std::vector<std::string>{entity6->getId()});
+
+    //Destroying an entity twice should only count it once.
+    entity2->destroyed.emit();
+    entity2->destroyed.emit();
+    auto entity7 = requestPossession();
+    auto entity8 = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds() == std::vector<std::string>{entity7->getId()});
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity8->getId()});
+}
+
+void ExternalMindsManagerTest::test_removeConnection()
+{
+    auto& link1 = addConnection("router1");
+    auto& link2 = addConnection("router2");
+
+    auto entity1 = requestPossession();
+    auto entity2 = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds() == std::vector<std::string>{entity2->getId()});
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity1->getId()});
+
+    //Only the remaining connection should be used, even though it has more entities.
+    m_manager->removeConnection("router1");
+    auto entity3 = requestPossession();
+    ASSERT_TRUE(link1.popPossessedIds().empty());
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity3->getId()});
+
+    //Destroying an entity which was assigned to the removed connection shouldn't affect the others.
+    entity2->destroyed.emit();
+    entity1->destroyed.emit();
+    auto entity4 = requestPossession();
+    ASSERT_TRUE(link2.popPossessedIds() == std::vector<std::string>{entity4->getId()});
+}
+
+int main()
+{
+    ExternalMindsManagerTest t;
+
+    return t.run();
+}
@@ -449,6 +449,8 @@ int main()
 
 #include <Atlas/Negotiate.h>
 #include "../stubs/common/stubLink.h"
+#include "../stubs/common/stubCommSocket.h"
+#include "../stubs/common/stubMonitors.h"
 
 namespace Atlas { namespace Objects { namespace Operation {
 
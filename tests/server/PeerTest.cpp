@@ -504,6 +504,8 @@ void Link::send(const Operation & op) const
     stub_CommClient_sent_op = op;
 }
 #include "../stubs/common/stubLink.h"
+#include "../stubs/common/stubCommSocket.h"
+#include "../stubs/common/stubMonitors.h"
 #include "../stubs/rules/stubScript.h"
 #include "../stubs/common/stubTypeNode.h"
 #include "../stubs/rules/stubLocation.h"
@@ -48,6 +48,8 @@
 #include <rules/simulation/PropelProperty.h>
 #include <rules/simulation/AngularFactorProperty.h>
 #include <chrono>
+#include <fstream>
+#include <unistd.h>
 #include <rules/simulation/VisibilityProperty.h>
 
 #include "../stubs/common/stublog.h"
@@ -61,6 +63,21 @@ using Atlas::Objects::Entity::RootEntity;
 
 using String::compose;
 
+namespace {
+    /**
+     * @return The resident memory of the process, in kilobytes, or 0 if it can't be determined.
+     */
+    long getResidentMemoryKb()
+    {
+        std::ifstream statm("/proc/self/statm");
+        long size = 0, resident = 0;
+        if (statm >> size >> resident) {
+            return resident * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        return 0;
+    }
+}
+
 
 class PhysicalDomainBenchmark : public Cyphesis::TestBase
 {
@@ -81,6 +98,18 @@ class PhysicalDomainBenchmark : public Cyphesis::TestBase
         void test_determinism();
 
         void test_visibilityPerformance();
+
+        void test_moveSightBatching();
+
+        void test_entityBookkeeping();
+
+        /**
+         * Runs a crowd of moving observers, all within sight of each other.
+         * @param batchMoveSights Whether the domain should batch movement sights.
+         * @param opCount The number of ops sent to the world will be stored here.
+         * @return The average tick duration in milliseconds.
+         */
+        double runCrowd(bool batchMoveSights, size_t& opCount);
 };
 
 long PhysicalDomainBenchmark::m_id_counter = 0L;
@@ -90,6 +119,8 @@ PhysicalDomainBenchmark::PhysicalDomainBenchmark()
     ADD_TEST(PhysicalDomainBenchmark::test_static_entities_no_move);
     ADD_TEST(PhysicalDomainBenchmark::test_determinism);
     ADD_TEST(PhysicalDomainBenchmark::test_visibilityPerformance);
+    ADD_TEST(PhysicalDomainBenchmark::test_moveSightBatching);
+    ADD_TEST(PhysicalDomainBenchmark::test_entityBookkeeping);
 
 }
 
@@ -153,10 +184,15 @@ void PhysicalDomainBenchmark::test_static_entities_no_move()
 
     //First tick is setup, so we'll exclude that from time measurement
     domain->tick(tickSize, res);
+    PhysicalDomain::TickTimings phaseTotals{};
     auto start = std::chrono::high_resolution_clock::now();
     //Inject ticks for two seconds
     for (int i = 0; i < 30; ++i) {
         domain->tick(tickSize, res);
+        phaseTotals.broadphase += domain->getTickTimings().broadphase;
+        phaseTotals.narrowphase += domain->getTickTimings().narrowphase;
+        phaseTotals.solve += domain->getTickTimings().solve;
+        phaseTotals.postProcess += domain->getTickTimings().postProcess;
     }
 
     std::stringstream ss;
@@ -166,6 +202,10 @@ void PhysicalDomainBenchmark::test_static_entities_no_move()
     ss = std::stringstream();
     ss << "Physics per second: " << (milliseconds / 2.0) / 10.0 << " %";
     log(INFO, ss.str());
+    ss = std::stringstream();
+    ss << "Average phase durations: broadphase " << phaseTotals.broadphase / 30000.0 << " ms, narrowphase " << phaseTotals.narrowphase / 30000.0
+       << " ms, solve " << phaseTotals.solve / 30000.0 << " ms, post process " << phaseTotals.postProcess / 30000.0 << " ms";
+    log(INFO, ss.str());
 
 }
 
@@ -342,6 +382,169 @@ void PhysicalDomainBenchmark::test_visibilityPerformance()
 }
 
 
+double PhysicalDomainBenchmark::runCrowd(bool batchMoveSights, size_t& opCount)
+{
+    double tickSize = 1.0 / 15.0;
+
+    TypeNode* humanType = new TypeNode("human");
+
+    Property<double>* massProp = new Property<double>();
+    massProp->data() = 100;
+
+    Ref<Entity> rootEntity = new Entity("0", newId());
+    rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+    WFMath::AxisBox<3> aabb(WFMath::Point<3>(-64, 0, -64), WFMath::Point<3>(64, 64, 64));
+    rootEntity->m_location.setBBox(aabb);
+    if (batchMoveSights) {
+        auto batchProp = new BoolProperty();
+        batchProp->set(1);
+        rootEntity->setProperty("batch_move_sights", std::unique_ptr<PropertyBase>(batchProp));
+    }
+    std::unique_ptr<PhysicalDomain> domain(new PhysicalDomain(*rootEntity));
+
+    TestWorld testWorld(rootEntity);
+    opCount = 0;
+    testWorld.m_extension.messageFn = [&](const Operation& op, LocatedEntity&) {
+        if (op->getClassNo() == Atlas::Objects::Operation::SIGHT_NO) {
+            opCount++;
+        }
+    };
+
+    int numberOfObservers = 100;
+
+    std::vector<Ref<Entity>> observers;
+    for (int i = 0; i < numberOfObservers; ++i) {
+        long id = newId();
+        Ref<Entity> observerEntity = new Entity(std::to_string(id), id);
+        observers.push_back(observerEntity);
+        observerEntity->m_location.setSolid(false);
+        observerEntity->setType(humanType);
+        //Place everyone in a small area, so that they all see each other.
+        observerEntity->m_location.m_pos = WFMath::Point<3>(-10 + (i % 10) * 2, 0, -10 + (i / 10) * 2);
+        observerEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.1f, 0, -0.1f), WFMath::Point<3>(0.1, 2, 0.1)));
+        auto propelProperty = new PropelProperty();
+        propelProperty->data() = WFMath::Vector<3>((i % 2) ? 1 : -1, 0, (i % 3) ? 1 : -1);
+        observerEntity->setProperty(PropelProperty::property_name, std::unique_ptr<PropertyBase>(propelProperty));
+        observerEntity->addFlags(entity_perceptive);
+        observerEntity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp->copy()));
+        domain->addEntity(*observerEntity);
+    }
+
+    OpVector res;
+    //First tick is setup, so we'll exclude that from time measurement
+    domain->tick(2, res);
+    opCount = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    //Inject ticks for 5 seconds
+    int numberOfTicks = 15 * 5;
+    for (int i = 0; i < numberOfTicks; ++i) {
+        domain->tick(tickSize, res);
+    }
+    long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    for (auto& observer : observers) {
+        domain->removeEntity(*observer);
+    }
+    return milliseconds / static_cast<double>(numberOfTicks);
+}
+
+void PhysicalDomainBenchmark::test_moveSightBatching()
+{
+    size_t unbatchedOpCount;
+    size_t batchedOpCount;
+    double unbatchedTickDuration = runCrowd(false, unbatchedOpCount);
+    double batchedTickDuration = runCrowd(true, batchedOpCount);
+
+    std::stringstream ss;
+    ss << "Unbatched move sights: " << unbatchedOpCount << " Sight ops, average tick duration " << unbatchedTickDuration << " ms";
+    log(INFO, ss.str());
+    ss = std::stringstream();
+    ss << "Batched move sights: " << batchedOpCount << " Sight ops, average tick duration " << batchedTickDuration << " ms";
+    log(INFO, ss.str());
+
+    //With batching each observer should at most get one Sight op per tick.
+    assert(batchedOpCount <= 100u * 15u * 5u);
+    assert(batchedOpCount < unbatchedOpCount);
+}
+
+void PhysicalDomainBenchmark::test_entityBookkeeping()
+{
+    double tickSize = 1.0 / 15.0;
+
+    TypeNode* rockType = new TypeNode("rock");
+    TypeNode* humanType = new TypeNode("human");
+
+    Ref<Entity> rootEntity = new Entity("0", newId());
+    rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+    WFMath::AxisBox<3> aabb(WFMath::Point<3>(-512, 0, -512), WFMath::Point<3>(512, 64, 512));
+    rootEntity->m_location.setBBox(aabb);
+    std::unique_ptr<PhysicalDomain> domain(new PhysicalDomain(*rootEntity));
+
+    TestWorld testWorld(rootEntity);
+
+    long memoryBefore = getResidentMemoryKb();
+
+    size_t numberOfEntities = 10000;
+    std::vector<Ref<Entity>> entities;
+    for (size_t i = 0; i < numberOfEntities; ++i) {
+        long id = newId();
+        Ref<Entity> plantedEntity = new Entity(std::to_string(id), id);
+        auto modeProp = new ModeProperty();
+        modeProp->set("planted");
+        plantedEntity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProp));
+        plantedEntity->setType(rockType);
+        plantedEntity->m_location.m_pos = WFMath::Point<3>(-500 + (i % 100) * 10.f, 0, -500 + (i / 100) * 10.f);
+        plantedEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.25f, 0, -0.25f), WFMath::Point<3>(0.25f, 0.5f, 0.25f)));
+        domain->addEntity(*plantedEntity);
+        entities.push_back(plantedEntity);
+    }
+
+    std::vector<Ref<Entity>> observers;
+    for (int i = 0; i < 100; ++i) {
+        long id = newId();
+        Ref<Entity> observerEntity = new Entity(std::to_string(id), id);
+        observerEntity->m_location.setSolid(false);
+        observerEntity->setType(humanType);
+        observerEntity->m_location.m_pos = WFMath::Point<3>(-500 + (i * 10), 0, -500);
+        observerEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.1f, 0, -0.1f), WFMath::Point<3>(0.1, 2, 0.1)));
+        auto propelProperty = new PropelProperty();
+        propelProperty->data() = WFMath::Vector<3>(0, 0, 5);
+        observerEntity->setProperty(PropelProperty::property_name, std::unique_ptr<PropertyBase>(propelProperty));
+        auto massProp = new Property<double>();
+        massProp->data() = 100;
+        observerEntity->setProperty("mass", std::unique_ptr<PropertyBase>(massProp));
+        observerEntity->addFlags(entity_perceptive);
+        domain->addEntity(*observerEntity);
+        observers.push_back(observerEntity);
+    }
+
+    OpVector res;
+    //First tick is setup, so we'll exclude that from time measurement
+    domain->tick(2, res);
+
+    long memoryAfter = getResidentMemoryKb();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    //Inject ticks for 10 seconds, so that there are a couple of visibility checks
+    int numberOfTicks = 15 * 10;
+    for (int i = 0; i < numberOfTicks; ++i) {
+        domain->tick(tickSize, res);
+        res.clear();
+    }
+    long milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+    std::stringstream ss;
+    ss << "Average tick duration with " << numberOfEntities << " entities and " << observers.size() << " moving observers: "
+       << milliseconds / static_cast<double>(numberOfTicks) << " ms";
+    log(INFO, ss.str());
+    if (memoryBefore && memoryAfter) {
+        ss = std::stringstream();
+        ss << "Resident memory per 10k entities: " << ((memoryAfter - memoryBefore) * 10000.0 / numberOfEntities) << " kB";
+        log(INFO, ss.str());
+    }
+}
+
 
 int main()
 {
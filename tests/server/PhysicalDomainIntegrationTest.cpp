@@ -37,6 +37,8 @@
 #include <Atlas/Objects/Operation.h>
 #include <wfmath/atlasconv.h>
 
+#include <tuple>
+
 #include <rules/simulation/PhysicalDomain.h>
 #include "physics/Convert.h"
 #include <rules/simulation/TerrainProperty.h>
@@ -55,6 +57,11 @@
 #include <rules/simulation/EntityProperty.h>
 #include <rules/simulation/ModeDataProperty.h>
 #include <rules/simulation/VisibilityDistanceProperty.h>
+#include <rules/simulation/MindsProperty.h>
+#include <rules/simulation/ExternalMind.h>
+#include <rules/simulation/MovementDelta.h>
+#include "common/Link.h"
+#include "common/CommSocket.h"
 #include "../stubs/common/stubMonitors.h"
 
 using Atlas::Message::Element;
@@ -152,6 +159,9 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
         ADD_TEST(Tested::test_zoffset);
         ADD_TEST(Tested::test_zscaledoffset);
         ADD_TEST(Tested::test_visibility);
+        ADD_TEST(Tested::test_visibilityBackendsMatch);
+        ADD_TEST(Tested::test_addEntities);
+        ADD_TEST(Tested::test_movementDeltas);
         ADD_TEST(Tested::test_stairs);
     }
 
@@ -1840,6 +1850,509 @@ struct Tested : public Cyphesis::TestBaseWithContext<TestContext>
     }
 
 
+    /**
+     * Sets up the same world in two domains, one using the Bullet visibility world and one using the grid,
+     * and verifies that both result in the same Appearance and Disappearance ops.
+     */
+    void test_visibilityBackendsMatch(TestContext& context)
+    {
+        typedef std::multiset<std::tuple<int, std::string, std::string>> VisibilityOps;
+
+        struct VisibilityWorld
+        {
+            Ref<Entity> rootEntity;
+            std::unique_ptr<TestPhysicalDomain> domain;
+            std::vector<Ref<Entity>> entities;
+            std::vector<Ref<Entity>> observers;
+            /**
+             * The ops sent when adding the entities, as class, recipient and the ids of the arguments.
+             */
+            std::vector<std::tuple<int, std::string, std::set<std::string>>> ops;
+        };
+
+        TypeNode* rockType = new TypeNode("rock");
+        TypeNode* humanType = new TypeNode("human");
+
+        auto createWorld = [&](const std::string& backend) {
+            VisibilityWorld world;
+            long id = 1;
+            world.rootEntity = new Entity("0", id++);
+            world.rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+            world.rootEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-512, 0, -512), WFMath::Point<3>(512, 64, 512)));
+            auto backendProp = new Property<std::string>();
+            backendProp->data() = backend;
+            world.rootEntity->setProperty("visibility_backend", std::unique_ptr<PropertyBase>(backendProp));
+            world.domain.reset(new TestPhysicalDomain(*world.rootEntity));
+
+            for (int i = 0; i < 20; ++i) {
+                for (int j = 0; j < 20; ++j) {
+                    Ref<Entity> entity = new Entity(std::to_string(id), id);
+                    id++;
+                    auto modeProp = new ModeProperty();
+                    modeProp->set("planted");
+                    entity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProp));
+                    entity->setType(rockType);
+                    entity->m_location.m_pos = WFMath::Point<3>(-400 + (i * 40), 0, -400 + (j * 40));
+                    //Mix of small and large entities, so that visibility spheres cover differing number of cells.
+                    float size = ((i + j) % 5 == 0) ? 2.0f : 0.2f;
+                    entity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-size, 0, -size), WFMath::Point<3>(size, size * 2, size)));
+                    if (i == 10 && j == 10) {
+                        entity->addFlags(entity_visibility_private);
+                    }
+                    if (i == 3 && j == 17) {
+                        auto visibilityProperty = new VisibilityDistanceProperty();
+                        visibilityProperty->set(1000.f);
+                        entity->setProperty(VisibilityDistanceProperty::property_name, std::unique_ptr<PropertyBase>(visibilityProperty));
+                    }
+                    world.domain->addEntity(*entity);
+                    world.entities.push_back(entity);
+                }
+            }
+
+            for (int i = 0; i < 5; ++i) {
+                Ref<Entity> observer = new Entity(std::to_string(id), id);
+                id++;
+                observer->setType(humanType);
+                observer->m_location.setSolid(false);
+                observer->m_location.m_pos = WFMath::Point<3>(-400 + (i * 160), 0, -450);
+                observer->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.2f, 0, -0.2f), WFMath::Point<3>(0.2, 2, 0.2)));
+                observer->addFlags(entity_perceptive);
+                if (i == 4) {
+                    observer->addFlags(entity_admin);
+                }
+                world.domain->addEntity(*observer);
+                world.observers.push_back(observer);
+            }
+            return world;
+        };
+
+        auto extractVisibilityOps = [](const OpVector& res) {
+            VisibilityOps ops;
+            for (auto& op : res) {
+                if (op->getClassNo() == Atlas::Objects::Operation::APPEARANCE_NO || op->getClassNo() == Atlas::Objects::Operation::DISAPPEARANCE_NO) {
+                    for (auto& arg : op->getArgs()) {
+                        ops.emplace(op->getClassNo(), op->getTo(), arg->getId());
+                    }
+                }
+            }
+            return ops;
+        };
+
+        auto getVisibleIds = [](VisibilityWorld& world, LocatedEntity& observer) {
+            std::list<LocatedEntity*> observedList;
+            world.domain->getVisibleEntitiesFor(observer, observedList);
+            std::set<std::string> ids;
+            for (auto entity : observedList) {
+                ids.insert(entity->getId());
+            }
+            return ids;
+        };
+
+        auto bulletWorld = createWorld("bullet");
+        auto gridWorld = createWorld("grid");
+
+        TestWorld testWorld(bulletWorld.rootEntity);
+
+        std::set<LocatedEntity*> transformedEntities;
+        size_t appearanceCount = 0;
+        for (int step = 0; step < 10; ++step) {
+            for (size_t i = 0; i < bulletWorld.observers.size(); ++i) {
+                //Move diagonally through the world, crossing multiple cells.
+                WFMath::Point<3> newPos(-400 + (i * 160) + (step * 15), 0, -400 + (step * 80));
+                bulletWorld.domain->applyTransform(*bulletWorld.observers[i], Domain::TransformData{WFMath::Quaternion(), newPos, nullptr, {}}, transformedEntities);
+                gridWorld.domain->applyTransform(*gridWorld.observers[i], Domain::TransformData{WFMath::Quaternion(), newPos, nullptr, {}}, transformedEntities);
+            }
+
+            OpVector bulletRes;
+            OpVector gridRes;
+            //Force visibility updates
+            bulletWorld.domain->tick(2, bulletRes);
+            gridWorld.domain->tick(2, gridRes);
+
+            auto bulletOps = extractVisibilityOps(bulletRes);
+            auto gridOps = extractVisibilityOps(gridRes);
+            ASSERT_EQUAL(bulletOps.size(), gridOps.size());
+            ASSERT_TRUE(bulletOps == gridOps);
+            appearanceCount += std::count_if(gridOps.begin(), gridOps.end(), [](const std::tuple<int, std::string, std::string>& entry) {
+                return std::get<0>(entry) == Atlas::Objects::Operation::APPEARANCE_NO;
+            });
+
+            for (size_t i = 0; i < bulletWorld.observers.size(); ++i) {
+                ASSERT_TRUE(getVisibleIds(bulletWorld, *bulletWorld.observers[i]) == getVisibleIds(gridWorld, *gridWorld.observers[i]));
+            }
+        }
+
+        //Make sure the observers actually saw things come and go.
+        ASSERT_TRUE(appearanceCount > 0);
+
+        //Switching backend at runtime shouldn't result in any visibility changes.
+        auto backendProp = new Property<std::string>();
+        backendProp->data() = "bullet";
+        gridWorld.rootEntity->setProperty("visibility_backend", std::unique_ptr<PropertyBase>(backendProp));
+        gridWorld.rootEntity->propertyApplied.emit("visibility_backend", *backendProp);
+        for (auto& observer : gridWorld.observers) {
+            gridWorld.domain->applyTransform(*observer, Domain::TransformData{WFMath::Quaternion(), observer->m_location.m_pos, nullptr, {}}, transformedEntities);
+        }
+        OpVector res;
+        gridWorld.domain->tick(2, res);
+        ASSERT_TRUE(extractVisibilityOps(res).empty());
+    }
+
+
+    /**
+     * Sets up the same world in two domains, one adding entities one at a time and one adding them all at once,
+     * and verifies that both result in the same visibility.
+     */
+    void test_addEntities(TestContext& context)
+    {
+        struct VisibilityWorld
+        {
+            Ref<Entity> rootEntity;
+            std::unique_ptr<TestPhysicalDomain> domain;
+            std::vector<Ref<Entity>> entities;
+            std::vector<Ref<Entity>> observers;
+        };
+
+        TypeNode* rockType = new TypeNode("rock");
+        TypeNode* humanType = new TypeNode("human");
+
+        auto createWorld = [&](bool bulk) {
+            VisibilityWorld world;
+            long id = 1;
+            world.rootEntity = new Entity("0", id++);
+            world.rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+            world.rootEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-512, 0, -512), WFMath::Point<3>(512, 64, 512)));
+            world.domain.reset(new TestPhysicalDomain(*world.rootEntity));
+
+            std::vector<LocatedEntity*> entities;
+            for (int i = 0; i < 20; ++i) {
+                for (int j = 0; j < 20; ++j) {
+                    Ref<Entity> entity = new Entity(std::to_string(id), id);
+                    id++;
+                    auto modeProp = new ModeProperty();
+                    modeProp->set("planted");
+                    entity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProp));
+                    entity->setType(rockType);
+                    entity->m_location.m_pos = WFMath::Point<3>(-400 + (i * 40), 0, -400 + (j * 40));
+                    float size = ((i + j) % 5 == 0) ? 2.0f : 0.2f;
+                    entity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-size, 0, -size), WFMath::Point<3>(size, size * 2, size)));
+                    world.entities.push_back(entity);
+                    entities.push_back(entity.get());
+                }
+            }
+
+            for (int i = 0; i < 5; ++i) {
+                Ref<Entity> observer = new Entity(std::to_string(id), id);
+                id++;
+                observer->setType(humanType);
+                observer->m_location.m_pos = WFMath::Point<3>(-400 + (i * 160), 0, -400 + (i * 160));
+                observer->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.2f, 0, -0.2f), WFMath::Point<3>(0.2, 2, 0.2)));
+                observer->addFlags(entity_perceptive);
+                world.observers.push_back(observer);
+                //Mix observers in between the other entities.
+                entities.insert(entities.begin() + (i * 80), observer.get());
+            }
+
+            TestWorld testWorld(world.rootEntity);
+            testWorld.m_extension.messageFn = [&](const Operation& op, LocatedEntity&) {
+                std::set<std::string> argIds;
+                for (auto& arg : op->getArgs()) {
+                    argIds.insert(arg->getId());
+                }
+                world.ops.emplace_back(op->getClassNo(), op->getTo(), std::move(argIds));
+            };
+
+            if (bulk) {
+                world.domain->addEntities(entities);
+            } else {
+                for (auto entity : entities) {
+                    world.domain->addEntity(*entity);
+                }
+            }
+            return world;
+        };
+
+        auto getVisibleIds = [](VisibilityWorld& world, LocatedEntity& observer) {
+            std::list<LocatedEntity*> observedList;
+            world.domain->getVisibleEntitiesFor(observer, observedList);
+            std::set<std::string> ids;
+            for (auto entity : observedList) {
+                ids.insert(entity->getId());
+            }
+            return ids;
+        };
+
+        auto getObservingIds = [](VisibilityWorld& world, LocatedEntity& observed) {
+            std::vector<const LocatedEntity*> observingList;
+            world.domain->getObservingEntitiesFor(observed, observingList);
+            std::set<std::string> ids;
+            for (auto entity : observingList) {
+                ids.insert(entity->getId());
+            }
+            return ids;
+        };
+
+        auto singleWorld = createWorld(false);
+        auto bulkWorld = createWorld(true);
+
+        //Observers should be told about the same entities, in the same order, as when adding them one by one.
+        ASSERT_FALSE(singleWorld.ops.empty());
+        ASSERT_EQUAL(singleWorld.ops.size(), bulkWorld.ops.size());
+        for (size_t i = 0; i < singleWorld.ops.size(); ++i) {
+            ASSERT_EQUAL(std::get<0>(singleWorld.ops[i]), std::get<0>(bulkWorld.ops[i]));
+            ASSERT_EQUAL(std::get<1>(singleWorld.ops[i]), std::get<1>(bulkWorld.ops[i]));
+            ASSERT_TRUE(std::get<2>(singleWorld.ops[i]) == std::get<2>(bulkWorld.ops[i]));
+        }
+
+        TestWorld testWorld(singleWorld.rootEntity);
+
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < singleWorld.observers.size(); ++i) {
+            auto visibleIds = getVisibleIds(singleWorld, *singleWorld.observers[i]);
+            ASSERT_TRUE(visibleIds == getVisibleIds(bulkWorld, *bulkWorld.observers[i]));
+            visibleCount += visibleIds.size();
+        }
+        //Make sure the observers actually see something besides themselves and the root.
+        ASSERT_TRUE(visibleCount > singleWorld.observers.size() * 2);
+
+        for (size_t i = 0; i < singleWorld.entities.size(); ++i) {
+            ASSERT_TRUE(getObservingIds(singleWorld, *singleWorld.entities[i]) == getObservingIds(bulkWorld, *bulkWorld.entities[i]));
+        }
+
+        //Nothing has moved, so there should be no visibility changes.
+        OpVector res;
+        bulkWorld.domain->tick(2, res);
+        for (auto& op : res) {
+            ASSERT_NOT_EQUAL(op->getClassNo(), Atlas::Objects::Operation::APPEARANCE_NO);
+            ASSERT_NOT_EQUAL(op->getClassNo(), Atlas::Objects::Operation::DISAPPEARANCE_NO);
+        }
+    }
+
+    /**
+     * Moves an entity around, and rebuilds its position from the compact movement updates sent to observers,
+     * in the same way a client would.
+     */
+    void test_movementDeltas(TestContext& context)
+    {
+        struct TestCommSocket : public CommSocket
+        {
+            explicit TestCommSocket(boost::asio::io_context& io_context) : CommSocket(io_context)
+            {
+            }
+
+            void disconnect() override
+            {
+            }
+
+            int flush() override
+            {
+                return 0;
+            }
+        };
+
+        struct TestLink : public Link
+        {
+            TestLink(CommSocket& socket, const std::string& id, long iid) : Link(socket, id, iid)
+            {
+                m_movementDeltas = true;
+            }
+
+            void externalOperation(const Operation&, Link&) override
+            {
+            }
+
+            void operation(const Operation&, OpVector&) override
+            {
+            }
+        };
+
+        /**
+         * What an observing client knows about the moving entity.
+         */
+        struct ClientView
+        {
+            std::array<Atlas::Message::IntType, 3> position{};
+            long sequence = 0;
+            size_t keyframes = 0;
+            size_t deltas = 0;
+        };
+
+        boost::asio::io_context io_context;
+        TestCommSocket commSocket(io_context);
+        TestLink link(commSocket, "1", 1);
+
+        TypeNode* rockType = new TypeNode("rock");
+        TypeNode* humanType = new TypeNode("human");
+
+        Ref<Entity> rootEntity = new Entity("0", context.newId());
+        rootEntity->m_location.m_pos = WFMath::Point<3>::ZERO();
+        rootEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-64, 0, -64), WFMath::Point<3>(64, 64, 64)));
+        auto batchProp = new BoolProperty();
+        batchProp->set(1);
+        rootEntity->setProperty("batch_move_sights", std::unique_ptr<PropertyBase>(batchProp));
+        std::unique_ptr<TestPhysicalDomain> domain(new TestPhysicalDomain(*rootEntity));
+
+        TestWorld testWorld(rootEntity);
+        std::vector<Operation> sights;
+        testWorld.m_extension.messageFn = [&](const Operation& op, LocatedEntity&) {
+            if (op->getClassNo() == Atlas::Objects::Operation::SIGHT_NO) {
+                sights.push_back(op);
+            }
+        };
+
+        Ref<Entity> movingEntity = new Entity("moving", context.newId());
+        auto modeProp = new ModeProperty();
+        modeProp->set("fixed");
+        movingEntity->setProperty(ModeProperty::property_name, std::unique_ptr<PropertyBase>(modeProp));
+        movingEntity->setType(rockType);
+        movingEntity->m_location.m_pos = WFMath::Point<3>(0, 0, 0);
+        movingEntity->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.5f, 0, -0.5f), WFMath::Point<3>(0.5, 1, 0.5)));
+        domain->addEntity(*movingEntity);
+
+        std::vector<std::unique_ptr<ExternalMind>> minds;
+        auto createObserver = [&](const std::string& id, const WFMath::Point<3>& pos) {
+            Ref<Entity> observer = new Entity(id, context.newId());
+            observer->setType(humanType);
+            observer->m_location.m_pos = pos;
+            observer->m_location.setBBox(WFMath::AxisBox<3>(WFMath::Point<3>(-0.2f, 0, -0.2f), WFMath::Point<3>(0.2, 2, 0.2)));
+            observer->addFlags(entity_perceptive);
+            //Only observers with minds which all have negotiated the capability get the compact updates.
+            minds.emplace_back(new ExternalMind(id, observer->getIntId(), observer));
+            minds.back()->linkUp(&link);
+            auto mindsProp = new MindsProperty();
+            mindsProp->addMind(minds.back().get());
+            observer->setProperty(MindsProperty::property_name, std::unique_ptr<PropertyBase>(mindsProp));
+            domain->addEntity(*observer);
+            return observer;
+        };
+
+        std::map<std::string, ClientView> clientViews;
+        auto applySights = [&]() {
+            for (auto& sight : sights) {
+                auto& view = clientViews[sight->getTo()];
+                for (auto& arg : sight->getArgs()) {
+                    auto setOp = Atlas::Objects::smart_dynamic_cast<Operation>(arg);
+                    ASSERT_TRUE(setOp.isValid())
+                    Element deltaElement;
+                    if (setOp->getArgs().empty() || setOp->getArgs().front()->copyAttr("movement_delta", deltaElement) != 0) {
+                        continue;
+                    }
+                    ASSERT_TRUE(deltaElement.isList())
+                    size_t index = 0;
+                    MovementDelta record{};
+                    while (index < deltaElement.List().size()) {
+                        ASSERT_TRUE(MovementDelta::read(deltaElement.List(), index, record))
+                        if (record.entityId != movingEntity->getIntId()) {
+                            continue;
+                        }
+                        if (record.flags & MovementDelta::KEYFRAME) {
+                            view.position = record.position;
+                            view.keyframes++;
+                        } else {
+                            //A gap in the sequence would mean that the client has missed an update.
+                            ASSERT_EQUAL(view.sequence + 1, record.sequence)
+                            if (record.flags & MovementDelta::POSITION) {
+                                for (size_t i = 0; i < 3; ++i) {
+                                    view.position[i] += record.positionDelta[i];
+                                }
+                            }
+                            view.deltas++;
+                        }
+                        view.sequence = record.sequence;
+                    }
+                }
+            }
+            sights.clear();
+        };
+
+        auto quantized = [](const WFMath::Point<3>& pos) {
+            return std::array<Atlas::Message::IntType, 3>{MovementDelta::quantize(pos.x(), MovementDelta::POSITION_SCALE),
+                                                          MovementDelta::quantize(pos.y(), MovementDelta::POSITION_SCALE),
+                                                          MovementDelta::quantize(pos.z(), MovementDelta::POSITION_SCALE)};
+        };
+
+        std::set<LocatedEntity*> transformedEntities;
+        auto moveAndTick = [&](const WFMath::Point<3>& pos, const WFMath::Quaternion& orientation) {
+            domain->applyTransform(*movingEntity, Domain::TransformData{orientation, pos, nullptr, {}}, transformedEntities);
+            OpVector res;
+            domain->tick(0.1, res);
+            applySights();
+        };
+
+        auto observer1 = createObserver("observer1", WFMath::Point<3>(2, 0, 2));
+        OpVector res;
+        //Force visibility updates
+        domain->tick(2, res);
+        sights.clear();
+
+        //The first update the observer gets must be a keyframe.
+        moveAndTick(WFMath::Point<3>(1, 0, 0), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].keyframes)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+
+        //Too small a move for a position update on its own, but the position must still be included when the orientation is sent.
+        moveAndTick(WFMath::Point<3>(1.005, 0, 0), WFMath::Quaternion(1, 0.5f));
+        ASSERT_EQUAL(1u, clientViews["observer1"].deltas)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+
+        //Nothing is sent for this move, so the baseline must stay at the last sent position.
+        moveAndTick(WFMath::Point<3>(1.0053, 0, 0), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].deltas)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(WFMath::Point<3>(1.005, 0, 0)))
+
+        //A new observer must get a keyframe, while the existing one keeps getting deltas.
+        auto observer2 = createObserver("observer2", WFMath::Point<3>(-2, 0, 2));
+        domain->tick(2, res);
+        sights.clear();
+
+        for (int i = 1; i <= 5; ++i) {
+            moveAndTick(WFMath::Point<3>(1.0053 + (i * 0.1237), 0, -(i * 0.2111)), WFMath::Quaternion());
+            ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+            ASSERT_TRUE(clientViews["observer2"].position == quantized(movingEntity->m_location.m_pos))
+        }
+        ASSERT_EQUAL(1u, clientViews["observer1"].keyframes)
+        ASSERT_EQUAL(6u, clientViews["observer1"].deltas)
+        ASSERT_EQUAL(1u, clientViews["observer2"].keyframes)
+        ASSERT_EQUAL(4u, clientViews["observer2"].deltas)
+
+        //The client of the first observer reconnects, getting a new mind and link. It doesn't know anything sent earlier.
+        TestLink link2(commSocket, "2", 2);
+        auto mindsProp = observer1->modPropertyClassFixed<MindsProperty>();
+        mindsProp->removeMind(minds.front().get(), observer1.get());
+        observer1->applyProperty(MindsProperty::property_name, mindsProp);
+        minds.emplace_back(new ExternalMind("observer1", observer1->getIntId(), observer1));
+        minds.back()->linkUp(&link2);
+        mindsProp->addMind(minds.back().get());
+        observer1->applyProperty(MindsProperty::property_name, mindsProp);
+        clientViews["observer1"] = ClientView{};
+
+        moveAndTick(WFMath::Point<3>(1.8, 0, -1), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].keyframes)
+        ASSERT_EQUAL(0u, clientViews["observer1"].deltas)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+        moveAndTick(WFMath::Point<3>(1.9, 0, -1), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].deltas)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+
+        //While the link doesn't accept deltas full ops are sent, and once it does again it must start over with a keyframe.
+        link2.m_movementDeltas = false;
+        moveAndTick(WFMath::Point<3>(2.0, 0, -1), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].keyframes)
+        ASSERT_EQUAL(1u, clientViews["observer1"].deltas)
+        link2.m_movementDeltas = true;
+        clientViews["observer1"] = ClientView{};
+        moveAndTick(WFMath::Point<3>(2.1, 0, -1), WFMath::Quaternion());
+        ASSERT_EQUAL(1u, clientViews["observer1"].keyframes)
+        ASSERT_EQUAL(0u, clientViews["observer1"].deltas)
+        ASSERT_TRUE(clientViews["observer1"].position == quantized(movingEntity->m_location.m_pos))
+
+        //The other observer wasn't affected.
+        ASSERT_EQUAL(1u, clientViews["observer2"].keyframes)
+        ASSERT_EQUAL(8u, clientViews["observer2"].deltas)
+
+        domain.reset();
+    }
+
     void test_visibilityPerformance(TestContext& context);
 
     void test_stairs(TestContext& context)
@@ -39,6 +39,80 @@
 
 using Atlas::Message::Element;
 
+typedef std::vector<std::map<std::string, std::string>> StubRows;
+
+/// Rows returned when selecting all entities.
+static StubRows stub_entity_rows;
+/// Rows returned when selecting all properties.
+static StubRows stub_property_rows;
+/// The ids of entities added to the world, together with the ids of their parents, in order.
+static std::vector<std::pair<std::string, std::string>> stub_added_entities;
+
+struct const_iterator_worker_rows : public DatabaseResult::const_iterator_worker
+{
+    const StubRows& m_rows;
+    size_t m_index;
+
+    const_iterator_worker_rows(const StubRows& rows, size_t index) : m_rows(rows), m_index(index)
+    {}
+
+    const char* column(int column) const override
+    { return ""; }
+
+    const char* column(const char* column) const override
+    {
+        auto I = m_rows[m_index].find(column);
+        return I == m_rows[m_index].end() ? "" : I->second.c_str();
+    }
+
+    std::string data(const char* column) const override
+    { return this->column(column); }
+
+    DatabaseResult::const_iterator_worker& operator++() override
+    {
+        ++m_index;
+        return *this;
+    }
+
+    bool operator==(const const_iterator_worker& other) const override
+    { return m_index == static_cast<const const_iterator_worker_rows&>(other).m_index; }
+};
+
+/// A result which returns a fixed set of rows.
+class DatabaseRowsResultWorker : public DatabaseResult::DatabaseResultWorker
+{
+    public:
+        const StubRows& m_rows;
+
+        explicit DatabaseRowsResultWorker(const StubRows& rows) : m_rows(rows)
+        {}
+
+        int size() const override
+        {
+            return static_cast<int>(m_rows.size());
+        }
+
+        int columns() const override
+        {
+            return m_rows.empty() ? 0 : static_cast<int>(m_rows.front().size());
+        }
+
+        bool error() const override
+        {
+            return false;
+        }
+
+        DatabaseResult::const_iterator begin() const override
+        {
+            return DatabaseResult::const_iterator(std::unique_ptr<DatabaseResult::const_iterator_worker>(new const_iterator_worker_rows(m_rows, 0)), *this);
+        }
+
+        DatabaseResult::const_iterator end() const override
+        {
+            return DatabaseResult::const_iterator(std::unique_ptr<DatabaseResult::const_iterator_worker>(new const_iterator_worker_rows(m_rows, m_rows.size())), *this);
+        }
+};
+
 class TestStorageManager : public StorageManager
 {
   public:
@@ -56,7 +130,7 @@ class TestStorageManager : public StorageManager
         encodeProperty(p, s);
     }
     void test_restoreProperties(LocatedEntity * e) {
-        restorePropertiesRecursively(e);
+        restoreProperties(e, {});
     }
 
     void test_insertEntity(LocatedEntity * e) {
@@ -65,8 +139,60 @@ class TestStorageManager : public StorageManager
     void test_updateEntity(LocatedEntity * e) {
         updateEntity(e);
     }
-    void test_restoreChildren(LocatedEntity * e) {
-        restoreChildren(e);
+    void test_decodeStoredEntities() {
+        std::vector<StoredEntity> storedEntities(3);
+        decodeStoredEntities(storedEntities);
+        assert(storedEntities[2].properties.empty());
+    }
+
+    void test_readStoredEntities() {
+        size_t propertyCount = 0;
+        auto storedEntities = readStoredEntities("0", propertyCount);
+
+        //The root should be first, and its own row skipped.
+        assert(storedEntities.size() == 7);
+        assert(storedEntities[0].id == "0");
+        //The others are kept in the order they were read.
+        assert(storedEntities[1].id == "3");
+        assert(storedEntities[2].id == "4");
+        assert(storedEntities[3].id == "2");
+        assert(storedEntities[4].id == "5");
+        assert(storedEntities[5].id == "1");
+        assert(storedEntities[6].id == "6");
+
+        //Children should be linked to their parents even if read before them.
+        assert(storedEntities[0].children == std::vector<size_t>{5});
+        assert(storedEntities[5].children == (std::vector<size_t>{2, 3}));
+        assert(storedEntities[3].children == std::vector<size_t>{1});
+        assert(storedEntities[1].children.empty());
+        assert(storedEntities[2].children.empty());
+        //The orphan isn't linked to anything, but keeps its own children.
+        assert(storedEntities[4].loc == "99");
+        assert(storedEntities[4].children == std::vector<size_t>{6});
+        assert(storedEntities[3].type == "thing");
+        assert(storedEntities[3].encodedLocation == "location2");
+
+        //Properties of the root should be read even though it has no row of its own, and properties of unknown
+        //entities or without names should be skipped.
+        assert(propertyCount == 4);
+        assert(storedEntities[0].encodedProperties.size() == 1);
+        assert(storedEntities[0].encodedProperties[0].first == "weather");
+        assert(storedEntities[0].encodedProperties[0].second == "sunny");
+        assert(storedEntities[5].encodedProperties.size() == 2);
+        assert(storedEntities[3].encodedProperties.empty());
+        assert(storedEntities[1].encodedProperties.size() == 1);
+        assert(storedEntities[1].encodedProperties[0].first == "mass");
+
+        decodeStoredEntities(storedEntities);
+        assert(storedEntities[0].properties.size() == 1);
+        assert(storedEntities[0].properties[0].first == "weather");
+        assert(storedEntities[0].properties[0].second == "sunny");
+        assert(storedEntities[5].properties.size() == 1);
+        assert(storedEntities[5].properties[0].first == "mass");
+        assert(storedEntities[5].properties[0].second == "10");
+        assert(storedEntities[5].invalidProperties == std::vector<std::string>{"invalid"});
+        assert(storedEntities[5].encodedProperties.empty());
+        assert(storedEntities[1].properties[0].second == "30");
     }
 
 
@@ -165,7 +291,55 @@ int main()
 
         TestStorageManager store(world, database, eb);
 
-        store.test_restoreChildren(new Entity("1", 1));
+        store.test_decodeStoredEntities();
+    }
+
+    //Rows in no particular order, with children before their parents, a row for the root, and
+    //an orphaned entity (with a child of its own) whose parent doesn't exist.
+    stub_entity_rows = {
+        {{"id", "3"}, {"loc", "2"}, {"type", "thing"}, {"location", "location3"}},
+        {{"id", "4"}, {"loc", "1"}, {"type", "thing"}, {"location", "location4"}},
+        {{"id", "2"}, {"loc", "1"}, {"type", "thing"}, {"location", "location2"}},
+        {{"id", "5"}, {"loc", "99"}, {"type", "thing"}, {"location", "location5"}},
+        {{"id", "1"}, {"loc", "0"}, {"type", "thing"}, {"location", "location1"}},
+        {{"id", "0"}, {"loc", ""}, {"type", "world"}, {"location", ""}},
+        {{"id", "6"}, {"loc", "5"}, {"type", "thing"}, {"location", "location6"}},
+    };
+    //Ordered by id, with properties for the root, for an entity which doesn't exist, and one without a name.
+    stub_property_rows = {
+        {{"id", "0"}, {"name", "weather"}, {"value", "sunny"}},
+        {{"id", "1"}, {"name", "mass"}, {"value", "10"}},
+        {{"id", "1"}, {"name", "invalid"}, {"value", ""}},
+        {{"id", "2"}, {"name", ""}, {"value", "20"}},
+        {{"id", "3"}, {"name", "mass"}, {"value", "30"}},
+        {{"id", "7"}, {"name", "mass"}, {"value", "70"}},
+    };
+
+    {
+        WorldRouter world(le, eb);
+
+        TestStorageManager store(world, database, eb);
+
+        store.test_readStoredEntities();
+    }
+
+    {
+        //Properties can't be restored with the stubbed entities.
+        stub_property_rows.clear();
+
+        Ref<LocatedEntity> root = new Entity("0", 0);
+        WorldRouter world(root, eb);
+
+        StorageManager store(world, database, eb);
+
+        store.restoreWorld(root);
+
+        //Parents should be created before their children, depth first, and orphans not at all.
+        assert(stub_added_entities.size() == 4);
+        assert(stub_added_entities[0] == std::make_pair(std::string("1"), std::string("0")));
+        assert(stub_added_entities[1] == std::make_pair(std::string("4"), std::string("1")));
+        assert(stub_added_entities[2] == std::make_pair(std::string("2"), std::string("1")));
+        assert(stub_added_entities[3] == std::make_pair(std::string("3"), std::string("2")));
     }
 
 
@@ -192,6 +366,12 @@ int main()
 #include "common/SystemTime.h"
 #include "common/Variable.h"
 
+#define STUB_WorldRouter_addEntity
+void WorldRouter::addEntity(const Ref<LocatedEntity>& obj, const Ref<LocatedEntity>& parent)
+{
+    stub_added_entities.emplace_back(obj->getId(), parent->getId());
+}
+
 #include "../stubs/rules/simulation/stubWorldRouter.h"
 #include "../stubs/rules/stubLocation.h"
 #include "../stubs/rules/simulation/stubEntity.h"
@@ -208,6 +388,12 @@ int main()
 using Atlas::Message::MapType;
 using Atlas::Objects::Entity::RootEntity;
 
+#define STUB_EntityBuilder_newEntity
+Ref<LocatedEntity> EntityBuilder::newEntity(const std::string & id, long intId, const std::string & type, const Atlas::Objects::Entity::RootEntity & attrs) const
+{
+    return new Entity(id, intId);
+}
+
 #include "../stubs/server/stubEntityBuilder.h"
 #include "../stubs/rules/stubLocatedEntity.h"
 #include "../stubs/common/stubRouter.h"
@@ -218,6 +404,18 @@ DatabaseResult Database::selectEntities(const std::string & loc)
     return DatabaseResult(std::unique_ptr<DatabaseNullResultWorker>(new DatabaseNullResultWorker()));
 }
 
+#define STUB_Database_selectAllEntities
+DatabaseResult Database::selectAllEntities()
+{
+    return DatabaseResult(std::unique_ptr<DatabaseRowsResultWorker>(new DatabaseRowsResultWorker(stub_entity_rows)));
+}
+
+#define STUB_Database_selectAllProperties
+DatabaseResult Database::selectAllProperties()
+{
+    return DatabaseResult(std::unique_ptr<DatabaseRowsResultWorker>(new DatabaseRowsResultWorker(stub_property_rows)));
+}
+
 #define STUB_Database_selectProperties
 DatabaseResult Database::selectProperties(const std::string& loc)
 {
@@ -230,10 +428,21 @@ DatabaseResult Database::selectThoughts(const std::string& loc)
     return DatabaseResult(std::unique_ptr<DatabaseNullResultWorker>(new DatabaseNullResultWorker()));
 }
 
+#define STUB_Database_decodeMessage
+int Database::decodeMessage(const std::string& data, Atlas::Message::MapType& o)
+{
+    //Anything which isn't empty is treated as a property value.
+    if (!data.empty()) {
+        o["val"] = data;
+    }
+    return 0;
+}
+
 #include "../stubs/common/stubDatabase.h"
 #include "../stubs/server/stubPersistence.h"
 
 #include "../stubs/common/stubPropertyManager.h"
+#include "../stubs/common/stubglobals.h"
 
 #include "../stubs/rules/stubScript.h"
 #include "../stubs/modules/stubWeakEntityRef.h"
@@ -344,6 +344,7 @@ using Atlas::Objects::Root;
 using Atlas::Objects::Entity::RootEntity;
 
 bool restricted_flag;
+bool movement_deltas_flag;
 
 
 #include "../stubs/server/stubExternalMindsManager.h"
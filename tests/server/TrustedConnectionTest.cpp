@@ -180,6 +180,7 @@ int main()
 // Stubs
 
 bool restricted_flag;
+bool movement_deltas_flag;
 
 namespace Atlas { namespace Objects { namespace Operation {
 int UPDATE_NO = -1;
@@ -0,0 +1,315 @@
+// Cyphesis Online RPG Server and AI Engine
+// Copyright (C) 2020 Erik Ogenvik
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+
+
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+#ifndef DEBUG
+#define DEBUG
+#endif
+
+#include "../TestBase.h"
+#include "../NullEntityCreator.h"
+
+#include "rules/simulation/WorldRouter.h"
+#include "rules/simulation/Entity.h"
+
+#include "common/compose.hpp"
+#include "common/log.h"
+#include "common/Monitors.h"
+#include "common/Property.h"
+#include "common/TypeNode.h"
+
+#include <Atlas/Objects/Operation.h>
+
+#include <chrono>
+
+using String::compose;
+
+namespace {
+    /**
+     * A property which handles Look ops, by counting them.
+     */
+    struct CountingProperty : Property<long>
+    {
+        static long s_handled;
+
+        void install(LocatedEntity* owner, const std::string& name) override
+        {
+            owner->installDelegate(Atlas::Objects::Operation::LOOK_NO, name);
+        }
+
+        void remove(LocatedEntity* owner, const std::string& name) override
+        {
+            owner->removeDelegate(Atlas::Objects::Operation::LOOK_NO, name);
+        }
+
+        HandlerResult operation(LocatedEntity*, const Operation&, OpVector&) override
+        {
+            s_handled++;
+            return OPERATION_IGNORED;
+        }
+
+        CountingProperty* copy() const override
+        {
+            return new CountingProperty(*this);
+        }
+    };
+
+    long CountingProperty::s_handled = 0;
+
+    /**
+     * An entity which looks up its delegate properties by name for each op, as Entity::operation did
+     * before the delegate properties were resolved in advance. Used as the baseline.
+     */
+    struct LookupEntity : Entity
+    {
+        LookupEntity(const std::string& id, long intId) : Entity(id, intId)
+        {}
+
+        void operation(const Operation& op, OpVector& res) override
+        {
+            auto J = m_delegates.equal_range(op->getClassNo());
+            for (; J.first != J.second; ++J.first) {
+                callDelegate(J.first->second.name, op, res);
+            }
+            callOperation(op, res);
+        }
+    };
+}
+
+class WorldRouterBenchmark : public Cyphesis::TestBase
+{
+    public:
+        WorldRouterBenchmark();
+
+        void setup();
+
+        void teardown();
+
+        void test_delegateDispatch();
+
+        /**
+         * Delivers ops to entities which each have one delegate installed by a type default and one by an instance property,
+         * as well as a number of other instance properties.
+         * @return The average time for delivering an op, in nanoseconds.
+         */
+        template<typename EntityT>
+        long runDelivery(const std::string& name);
+};
+
+WorldRouterBenchmark::WorldRouterBenchmark()
+{
+    ADD_TEST(WorldRouterBenchmark::test_delegateDispatch);
+}
+
+void WorldRouterBenchmark::setup()
+{
+}
+
+void WorldRouterBenchmark::teardown()
+{
+}
+
+template<typename EntityT>
+long WorldRouterBenchmark::runDelivery(const std::string& name)
+{
+    const long entityCount = 1000;
+    const long opsPerEntity = 1000;
+
+    NullEntityCreator entityCreator;
+    TypeNode type("thing");
+    type.injectProperty("delegate_default", std::make_unique<CountingProperty>());
+
+    Ref<LocatedEntity> base = new Entity("0", 0);
+    WorldRouter world(base, entityCreator);
+
+    std::vector<Ref<LocatedEntity>> entities;
+    for (long i = 1; i <= entityCount; ++i) {
+        Ref<LocatedEntity> entity = new EntityT(std::to_string(i), i);
+        entity->setType(&type);
+        type.defaults().find("delegate_default")->second->install(entity.get(), "delegate_default");
+        //Give the entity about as many instance properties as a typical in game entity, so that lookups by name have a realistic cost.
+        for (int j = 0; j < 20; ++j) {
+            entity->setProperty(compose("property_%1", j), std::make_unique<SoftProperty>());
+        }
+        entity->setProperty("delegate_instance", std::make_unique<CountingProperty>());
+        world.addEntity(entity, base);
+        entities.push_back(entity);
+    }
+
+    std::vector<Operation> ops;
+    for (auto& entity : entities) {
+        Atlas::Objects::Operation::Look look;
+        look->setFrom(entity->getId());
+        look->setTo(entity->getId());
+        ops.push_back(look);
+    }
+
+    CountingProperty::s_handled = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < opsPerEntity; ++i) {
+        for (size_t j = 0; j < ops.size(); ++j) {
+            world.operation(ops[j], entities[j]);
+        }
+    }
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    ASSERT_EQUAL(CountingProperty::s_handled, entityCount * opsPerEntity * 2);
+
+    auto nsPerOp = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / (entityCount * opsPerEntity);
+    log(INFO, compose("%1: %2 ns per delivered op.", name, nsPerOp));
+
+    world.delEntity(base.get());
+    return nsPerOp;
+}
+
+void WorldRouterBenchmark::test_delegateDispatch()
+{
+    runDelivery<LookupEntity>("Delegates looked up by name");
+    runDelivery<Entity>("Delegates resolved in advance");
+}
+
+int main()
+{
+    WorldRouterBenchmark t;
+    Monitors m;
+
+    return t.run();
+}
+
+// stubs
+
+#include "server/EntityFactory.h"
+#include "server/ArchetypeFactory.h"
+#include "rules/simulation/CorePropertyManager.h"
+
+#include "rules/simulation/AreaProperty.h"
+#include "rules/AtlasProperties.h"
+#include "rules/BBoxProperty.h"
+#include "rules/simulation/CalendarProperty.h"
+#include "rules/simulation/EntityProperty.h"
+#include "rules/simulation/StatusProperty.h"
+#include "rules/simulation/TasksProperty.h"
+#include "rules/simulation/TerrainProperty.h"
+#include "rules/simulation/DomainProperty.h"
+
+#include "rules/simulation/ExternalMind.h"
+#include "rules/simulation/Task.h"
+
+#include "rules/python/PythonScriptFactory.h"
+
+#define STUB_PythonScriptFactory_PythonScriptFactory
+
+template<>
+PythonScriptFactory<LocatedEntity>::PythonScriptFactory(const std::string& p,
+                                                        const std::string& t) :
+    PythonClass(p, t)
+{
+}
+
+template<>
+int PythonScriptFactory<LocatedEntity>::setup()
+{
+    return load();
+}
+
+#include "../stubs/rules/stubBBoxProperty.h"
+#include "../stubs/rules/simulation/stubTasksProperty.h"
+#include "../stubs/rules/simulation/stubTerrainProperty.h"
+#include "../stubs/rules/simulation/stubDomainProperty.h"
+#include "../stubs/rules/ai/stubBaseMind.h"
+#include "../stubs/rules/stubMemEntity.h"
+#include "../stubs/rules/ai/stubMemMap.h"
+#include "../stubs/rules/simulation/stubPropelProperty.h"
+#include "../stubs/rules/python/stubPythonClass.h"
+#include "../stubs/rules/simulation/stubPedestrian.h"
+#include "../stubs/rules/simulation/stubMovement.h"
+#include "../stubs/rules/stubLocation.h"
+#include "../stubs/rules/simulation/stubUsagesProperty.h"
+#include "../stubs/rules/entityfilter/stubFilter.h"
+
+#include "../stubs/common/stubOperationsDispatcher.h"
+#include "../stubs/common/stubScriptKit.h"
+#include "../stubs/common/stubRouter.h"
+#include "../stubs/server/stubConnectableRouter.h"
+#include "../stubs/server/stubAccount.h"
+#include "../stubs/server/stubPlayer.h"
+#include "../stubs/server/stubExternalMindsManager.h"
+#include "../stubs/server/stubExternalMindsConnection.h"
+#include "../stubs/server/stubServerRouting.h"
+#include "../stubs/server/stubLobby.h"
+#include "../stubs/rules/simulation/stubEntityProperty.h"
+#include "../stubs/rules/python/stubPythonScriptFactory.h"
+
+#include "../stubs/common/stubMonitors.h"
+
+#include <Atlas/Objects/Operation.h>
+#include "../stubs/rules/python/stubScriptsProperty.h"
+
+#define STUB_CorePropertyManager_addProperty
+std::unique_ptr<PropertyBase> CorePropertyManager::addProperty(const std::string & name) const
+{
+    return std::make_unique<Property<float>>();
+}
+
+#include "../stubs/rules/simulation/stubCorePropertyManager.h"
+
+
+#define STUB_ArchetypeFactory_newEntity
+
+Ref<LocatedEntity> ArchetypeFactory::newEntity(const std::string& id, long intId, const Atlas::Objects::Entity::RootEntity& attributes)
+{
+    return new Entity(id, intId);
+}
+
+#include "../stubs/server/stubArchetypeFactory.h"
+
+
+class World;
+
+
+#include "../stubs/rules/simulation/stubAreaProperty.h"
+#include "../stubs/rules/simulation/stubCalendarProperty.h"
+#include "../stubs/rules/simulation/stubWorldTimeProperty.h"
+#include "../stubs/rules/simulation/stubVoidDomain.h"
+
+#define STUB_IdProperty_get
+
+int IdProperty::get(Atlas::Message::Element& val) const
+{
+    val = m_data;
+    return 0;
+}
+
+#include "../stubs/rules/simulation/stubTask.h"
+#include "../stubs/rules/stubAtlasProperties.h"
+#include "../stubs/rules/simulation/stubStatusProperty.h"
+#include "../stubs/rules/simulation/stubModeDataProperty.h"
+#include "../stubs/rules/simulation/stubModeProperty.h"
+
+#define STUB_ExternalMind_linkUp
+
+void ExternalMind::linkUp(Link* c)
+{
+    m_link = c;
+}
+
+#include "../stubs/rules/simulation/stubExternalMind.h"
+
+sigc::signal<void> python_reload_scripts;
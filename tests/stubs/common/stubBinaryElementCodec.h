@@ -0,0 +1,35 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubBinaryElementCodec_custom.h file.
+
+#ifndef STUB_COMMON_BINARYELEMENTCODEC_H
+#define STUB_COMMON_BINARYELEMENTCODEC_H
+
+#include "common/BinaryElementCodec.h"
+#include "stubBinaryElementCodec_custom.h"
+
+#ifndef STUB_BinaryElementCodec_encode
+//#define STUB_BinaryElementCodec_encode
+   void BinaryElementCodec::encode(const Atlas::Message::MapType& map, std::string& data)
+  {
+    
+  }
+#endif //STUB_BinaryElementCodec_encode
+
+#ifndef STUB_BinaryElementCodec_decode
+//#define STUB_BinaryElementCodec_decode
+   bool BinaryElementCodec::decode(const std::string& data, Atlas::Message::MapType& map)
+  {
+    return false;
+  }
+#endif //STUB_BinaryElementCodec_decode
+
+#ifndef STUB_BinaryElementCodec_isEncoded
+//#define STUB_BinaryElementCodec_isEncoded
+   bool BinaryElementCodec::isEncoded(const std::string& data)
+  {
+    return false;
+  }
+#endif //STUB_BinaryElementCodec_isEncoded
+
+
+#endif
\ No newline at end of file
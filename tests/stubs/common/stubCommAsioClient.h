@@ -17,6 +17,16 @@
   }
 #endif //STUB_CommAsioClient_CommAsioClient
 
+#ifndef STUB_CommAsioClient_CommAsioClient
+//#define STUB_CommAsioClient_CommAsioClient
+  template <typename ProtocolT>
+   CommAsioClient<ProtocolT>::CommAsioClient(std::string name, boost::asio::io_context& io_context, boost::asio::io_context& networkContext, const Atlas::Objects::Factories& factories)
+    : Atlas::Objects::ObjectsDecoder(name, io_context, networkContext, factories)
+  {
+    
+  }
+#endif //STUB_CommAsioClient_CommAsioClient
+
 #ifndef STUB_CommAsioClient_CommAsioClient_DTOR
 //#define STUB_CommAsioClient_CommAsioClient_DTOR
   template <typename ProtocolT>
@@ -98,6 +108,105 @@
   }
 #endif //STUB_CommAsioClient_write
 
+#ifndef STUB_CommAsioClient_network_read
+//#define STUB_CommAsioClient_network_read
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::network_read()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_network_read
+
+#ifndef STUB_CommAsioClient_network_write
+//#define STUB_CommAsioClient_network_write
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::network_write()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_network_write
+
+#ifndef STUB_CommAsioClient_dataReceived
+//#define STUB_CommAsioClient_dataReceived
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::dataReceived(const std::string& data)
+  {
+    
+  }
+#endif //STUB_CommAsioClient_dataReceived
+
+#ifndef STUB_CommAsioClient_postToNetwork
+//#define STUB_CommAsioClient_postToNetwork
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::postToNetwork(std::function<void()> task)
+  {
+    
+  }
+#endif //STUB_CommAsioClient_postToNetwork
+
+#ifndef STUB_CommAsioClient_networkTaskStarted
+//#define STUB_CommAsioClient_networkTaskStarted
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::networkTaskStarted()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_networkTaskStarted
+
+#ifndef STUB_CommAsioClient_networkTaskCompleted
+//#define STUB_CommAsioClient_networkTaskCompleted
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::networkTaskCompleted()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_networkTaskCompleted
+
+#ifndef STUB_CommAsioClient_logSocketError
+//#define STUB_CommAsioClient_logSocketError
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::logSocketError(const boost::system::error_code& ec, const std::string& action)
+  {
+    
+  }
+#endif //STUB_CommAsioClient_logSocketError
+
+#ifndef STUB_CommAsioClient_flushDeferred
+//#define STUB_CommAsioClient_flushDeferred
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::flushDeferred()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_flushDeferred
+
+#ifndef STUB_CommAsioClient_updateStatistics
+//#define STUB_CommAsioClient_updateStatistics
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::updateStatistics(size_t bytes)
+  {
+    
+  }
+#endif //STUB_CommAsioClient_updateStatistics
+
+#ifndef STUB_CommAsioClient_publishStatistics
+//#define STUB_CommAsioClient_publishStatistics
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::publishStatistics()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_publishStatistics
+
+#ifndef STUB_CommAsioClient_scheduleStatistics
+//#define STUB_CommAsioClient_scheduleStatistics
+  template <typename ProtocolT>
+  void CommAsioClient<ProtocolT>::scheduleStatistics()
+  {
+    
+  }
+#endif //STUB_CommAsioClient_scheduleStatistics
+
 #ifndef STUB_CommAsioClient_dispatch
 //#define STUB_CommAsioClient_dispatch
   template <typename ProtocolT>
@@ -15,6 +15,14 @@
   }
 #endif //STUB_CommPSQLSocket_do_read
 
+#ifndef STUB_CommPSQLSocket_do_flush
+//#define STUB_CommPSQLSocket_do_flush
+  void CommPSQLSocket::do_flush()
+  {
+    
+  }
+#endif //STUB_CommPSQLSocket_do_flush
+
 #ifndef STUB_CommPSQLSocket_read
 //#define STUB_CommPSQLSocket_read
   int CommPSQLSocket::read()
@@ -23,5 +23,21 @@
   }
 #endif //STUB_CommSocket_flush
 
+#ifndef STUB_CommSocket_flushCorkedSockets
+//#define STUB_CommSocket_flushCorkedSockets
+   void CommSocket::flushCorkedSockets()
+  {
+    
+  }
+#endif //STUB_CommSocket_flushCorkedSockets
+
+#ifndef STUB_CommSocket_deferFlush
+//#define STUB_CommSocket_deferFlush
+   void CommSocket::deferFlush(std::weak_ptr<CommSocket> socket)
+  {
+    
+  }
+#endif //STUB_CommSocket_deferFlush
+
 
 #endif
\ No newline at end of file
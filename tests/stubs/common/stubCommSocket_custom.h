@@ -1 +1,6 @@
 //Add custom implementations of stubbed functions here; this file won't be rewritten when re-generating stubs.
+
+
+bool CommSocket::s_corked = false;
+
+std::vector<std::weak_ptr<CommSocket>> CommSocket::s_deferredSockets;
@@ -7,6 +7,30 @@
 #include "common/DatabasePostgres.h"
 #include "stubDatabasePostgres_custom.h"
 
+#ifndef STUB_DatabasePostgres_finishQuery
+//#define STUB_DatabasePostgres_finishQuery
+  void DatabasePostgres::finishQuery()
+  {
+    
+  }
+#endif //STUB_DatabasePostgres_finishQuery
+
+#ifndef STUB_DatabasePostgres_scheduleQuery
+//#define STUB_DatabasePostgres_scheduleQuery
+  int DatabasePostgres::scheduleQuery(const std::string& query, bool maintenance)
+  {
+    return 0;
+  }
+#endif //STUB_DatabasePostgres_scheduleQuery
+
+#ifndef STUB_DatabasePostgres_reserveIdBlock
+//#define STUB_DatabasePostgres_reserveIdBlock
+  IdBlockAllocator::Block DatabasePostgres::reserveIdBlock(long count)
+  {
+    return *static_cast<IdBlockAllocator::Block*>(nullptr);
+  }
+#endif //STUB_DatabasePostgres_reserveIdBlock
+
 #ifndef STUB_DatabasePostgres_tuplesOk
 //#define STUB_DatabasePostgres_tuplesOk
   bool DatabasePostgres::tuplesOk()
@@ -28,6 +52,7 @@
    DatabasePostgres::DatabasePostgres()
     : Database()
     , m_connection(nullptr)
+    , m_idConnection(nullptr)
   {
     
   }
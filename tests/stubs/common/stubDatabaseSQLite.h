@@ -15,6 +15,46 @@
   }
 #endif //STUB_DatabaseSQLite_poll_tasks
 
+#ifndef STUB_DatabaseSQLite_runBatch
+//#define STUB_DatabaseSQLite_runBatch
+  void DatabaseSQLite::runBatch(std::vector<PendingCommand>& batch)
+  {
+    
+  }
+#endif //STUB_DatabaseSQLite_runBatch
+
+#ifndef STUB_DatabaseSQLite_runCommand
+//#define STUB_DatabaseSQLite_runCommand
+  int DatabaseSQLite::runCommand(const PendingCommand& pendingCommand)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_runCommand
+
+#ifndef STUB_DatabaseSQLite_runPreparedCommand
+//#define STUB_DatabaseSQLite_runPreparedCommand
+  int DatabaseSQLite::runPreparedCommand(const PendingCommand& pendingCommand)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_runPreparedCommand
+
+#ifndef STUB_DatabaseSQLite_getPreparedStatement
+//#define STUB_DatabaseSQLite_getPreparedStatement
+  sqlite3pp::command& DatabaseSQLite::getPreparedStatement(StatementType type)
+  {
+    return *static_cast<sqlite3pp::command*>(nullptr);
+  }
+#endif //STUB_DatabaseSQLite_getPreparedStatement
+
+#ifndef STUB_DatabaseSQLite_enqueueCommand
+//#define STUB_DatabaseSQLite_enqueueCommand
+  int DatabaseSQLite::enqueueCommand(PendingCommand pendingCommand)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_enqueueCommand
+
 #ifndef STUB_DatabaseSQLite_DatabaseSQLite
 //#define STUB_DatabaseSQLite_DatabaseSQLite
    DatabaseSQLite::DatabaseSQLite()
@@ -152,6 +192,54 @@
   }
 #endif //STUB_DatabaseSQLite_registerSimpleTable
 
+#ifndef STUB_DatabaseSQLite_insertEntity
+//#define STUB_DatabaseSQLite_insertEntity
+  int DatabaseSQLite::insertEntity(const std::string& id, const std::string& loc, const std::string& type, int seq, const std::string& value)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_insertEntity
+
+#ifndef STUB_DatabaseSQLite_updateEntityWithoutLoc
+//#define STUB_DatabaseSQLite_updateEntityWithoutLoc
+  int DatabaseSQLite::updateEntityWithoutLoc(const std::string& id, int seq, const std::string& location_data)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_updateEntityWithoutLoc
+
+#ifndef STUB_DatabaseSQLite_updateEntity
+//#define STUB_DatabaseSQLite_updateEntity
+  int DatabaseSQLite::updateEntity(const std::string& id, int seq, const std::string& location_data, const std::string& location_entity_id)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_updateEntity
+
+#ifndef STUB_DatabaseSQLite_dropEntity
+//#define STUB_DatabaseSQLite_dropEntity
+  int DatabaseSQLite::dropEntity(long id)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_dropEntity
+
+#ifndef STUB_DatabaseSQLite_insertProperties
+//#define STUB_DatabaseSQLite_insertProperties
+  int DatabaseSQLite::insertProperties(const std::string& id, const KeyValues& tuples)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_insertProperties
+
+#ifndef STUB_DatabaseSQLite_updateProperties
+//#define STUB_DatabaseSQLite_updateProperties
+  int DatabaseSQLite::updateProperties(const std::string& id, const KeyValues& tuples)
+  {
+    return 0;
+  }
+#endif //STUB_DatabaseSQLite_updateProperties
+
 #ifndef STUB_DatabaseSQLite_scheduleCommand
 //#define STUB_DatabaseSQLite_scheduleCommand
   int DatabaseSQLite::scheduleCommand(const std::string& query)
@@ -51,6 +51,7 @@ DatabaseResult Database::runSimpleSelectQuery(const std::string& query)
 #ifndef STUB_DatabaseResult_DatabaseResult
 #define STUB_DatabaseResult_DatabaseResult
 DatabaseResult::DatabaseResult(DatabaseResult&& dr) noexcept
+: m_worker(std::move(dr.m_worker))
 {
 
 }
@@ -58,6 +59,7 @@ DatabaseResult::DatabaseResult(DatabaseResult&& dr) noexcept
 
 DatabaseResult::const_iterator& DatabaseResult::const_iterator::operator++()
 {
+    m_worker->operator++();
     return *this;
 }
 
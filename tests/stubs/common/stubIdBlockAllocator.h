@@ -0,0 +1,37 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubIdBlockAllocator_custom.h file.
+
+#ifndef STUB_COMMON_IDBLOCKALLOCATOR_H
+#define STUB_COMMON_IDBLOCKALLOCATOR_H
+
+#include "common/IdBlockAllocator.h"
+#include "stubIdBlockAllocator_custom.h"
+
+#ifndef STUB_IdBlockAllocator_IdBlockAllocator
+//#define STUB_IdBlockAllocator_IdBlockAllocator
+   IdBlockAllocator::IdBlockAllocator(ReserveFunction reserveFunction, long blockSize, bool asynchronous)
+    : m_blockSize(blockSize)
+    , m_asynchronous(asynchronous)
+  {
+    
+  }
+#endif //STUB_IdBlockAllocator_IdBlockAllocator
+
+#ifndef STUB_IdBlockAllocator_IdBlockAllocator_DTOR
+//#define STUB_IdBlockAllocator_IdBlockAllocator_DTOR
+   IdBlockAllocator::~IdBlockAllocator()
+  {
+    
+  }
+#endif //STUB_IdBlockAllocator_IdBlockAllocator_DTOR
+
+#ifndef STUB_IdBlockAllocator_next
+//#define STUB_IdBlockAllocator_next
+  long IdBlockAllocator::next()
+  {
+    return 0;
+  }
+#endif //STUB_IdBlockAllocator_next
+
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubJobQueue_custom.h file.
+
+#ifndef STUB_COMMON_JOBQUEUE_H
+#define STUB_COMMON_JOBQUEUE_H
+
+#include "common/JobQueue.h"
+#include "stubJobQueue_custom.h"
+
+#ifndef STUB_JobQueue_JobQueue
+//#define STUB_JobQueue_JobQueue
+   JobQueue::JobQueue(size_t numberOfThreads)
+  {
+    
+  }
+#endif //STUB_JobQueue_JobQueue
+
+#ifndef STUB_JobQueue_JobQueue_DTOR
+//#define STUB_JobQueue_JobQueue_DTOR
+   JobQueue::~JobQueue()
+  {
+    
+  }
+#endif //STUB_JobQueue_JobQueue_DTOR
+
+#ifndef STUB_JobQueue_post
+//#define STUB_JobQueue_post
+  void JobQueue::post(std::function<void()> job)
+  {
+    
+  }
+#endif //STUB_JobQueue_post
+
+#ifndef STUB_JobQueue_workerLoop
+//#define STUB_JobQueue_workerLoop
+  void JobQueue::workerLoop()
+  {
+    
+  }
+#endif //STUB_JobQueue_workerLoop
+
+
+#endif
\ No newline at end of file
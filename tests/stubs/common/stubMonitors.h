@@ -40,6 +40,14 @@
   }
 #endif //STUB_Monitors_watch
 
+#ifndef STUB_Monitors_remove
+//#define STUB_Monitors_remove
+  void Monitors::remove(const std::string &)
+  {
+    
+  }
+#endif //STUB_Monitors_remove
+
 #ifndef STUB_Monitors_send
 //#define STUB_Monitors_send
   void Monitors::send(std::ostream &)
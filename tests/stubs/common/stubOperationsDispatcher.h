@@ -103,8 +103,8 @@
 
 #ifndef STUB_OperationsDispatcher_OperationsDispatcher
 //#define STUB_OperationsDispatcher_OperationsDispatcher
-  template <typename T>
-   OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor, TimeProviderFnType timeProviderFn)
+  template <typename T,typename QueueT>
+   OperationsDispatcher<T,QueueT>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor, TimeProviderFnType timeProviderFn)
     : OperationsHandler(operationProcessor, timeProviderFn)
   {
     
@@ -113,8 +113,8 @@
 
 #ifndef STUB_OperationsDispatcher_OperationsDispatcher_DTOR
 //#define STUB_OperationsDispatcher_OperationsDispatcher_DTOR
-  template <typename T>
-   OperationsDispatcher<T>::~OperationsDispatcher()
+  template <typename T,typename QueueT>
+   OperationsDispatcher<T,QueueT>::~OperationsDispatcher()
   {
     
   }
@@ -122,8 +122,8 @@
 
 #ifndef STUB_OperationsDispatcher_idle
 //#define STUB_OperationsDispatcher_idle
-  template <typename T>
-  bool OperationsDispatcher<T>::idle(const std::chrono::steady_clock::time_point& processUntil)
+  template <typename T,typename QueueT>
+  bool OperationsDispatcher<T,QueueT>::idle(const std::chrono::steady_clock::time_point& processUntil)
   {
     return false;
   }
@@ -131,8 +131,8 @@
 
 #ifndef STUB_OperationsDispatcher_timeUntilNextOp
 //#define STUB_OperationsDispatcher_timeUntilNextOp
-  template <typename T>
-  std::chrono::steady_clock::duration OperationsDispatcher<T>::timeUntilNextOp() const
+  template <typename T,typename QueueT>
+  std::chrono::steady_clock::duration OperationsDispatcher<T,QueueT>::timeUntilNextOp() const
   {
     return *static_cast<std::chrono::steady_clock::duration*>(nullptr);
   }
@@ -140,8 +140,8 @@
 
 #ifndef STUB_OperationsDispatcher_isQueueDirty
 //#define STUB_OperationsDispatcher_isQueueDirty
-  template <typename T>
-  bool OperationsDispatcher<T>::isQueueDirty() const
+  template <typename T,typename QueueT>
+  bool OperationsDispatcher<T,QueueT>::isQueueDirty() const
   {
     return false;
   }
@@ -149,8 +149,8 @@
 
 #ifndef STUB_OperationsDispatcher_markQueueAsClean
 //#define STUB_OperationsDispatcher_markQueueAsClean
-  template <typename T>
-  void OperationsDispatcher<T>::markQueueAsClean()
+  template <typename T,typename QueueT>
+  void OperationsDispatcher<T,QueueT>::markQueueAsClean()
   {
     
   }
@@ -158,8 +158,8 @@
 
 #ifndef STUB_OperationsDispatcher_clearQueues
 //#define STUB_OperationsDispatcher_clearQueues
-  template <typename T>
-  void OperationsDispatcher<T>::clearQueues()
+  template <typename T,typename QueueT>
+  void OperationsDispatcher<T,QueueT>::clearQueues()
   {
     
   }
@@ -167,8 +167,8 @@
 
 #ifndef STUB_OperationsDispatcher_addOperationToQueue
 //#define STUB_OperationsDispatcher_addOperationToQueue
-  template <typename T>
-  void OperationsDispatcher<T>::addOperationToQueue(Operation, Ref<T>)
+  template <typename T,typename QueueT>
+  void OperationsDispatcher<T,QueueT>::addOperationToQueue(Operation, Ref<T>)
   {
     
   }
@@ -176,8 +176,8 @@
 
 #ifndef STUB_OperationsDispatcher_getQueueSize
 //#define STUB_OperationsDispatcher_getQueueSize
-  template <typename T>
-  size_t OperationsDispatcher<T>::getQueueSize() const
+  template <typename T,typename QueueT>
+  size_t OperationsDispatcher<T,QueueT>::getQueueSize() const
   {
     return 0;
   }
@@ -185,17 +185,35 @@
 
 #ifndef STUB_OperationsDispatcher_dispatchNextOp
 //#define STUB_OperationsDispatcher_dispatchNextOp
-  template <typename T>
-  void OperationsDispatcher<T>::dispatchNextOp()
+  template <typename T,typename QueueT>
+  void OperationsDispatcher<T,QueueT>::dispatchNextOp()
   {
     
   }
 #endif //STUB_OperationsDispatcher_dispatchNextOp
 
+#ifndef STUB_OperationsDispatcher_getCoalescingKey
+//#define STUB_OperationsDispatcher_getCoalescingKey
+  template <typename T,typename QueueT>
+   std::string OperationsDispatcher<T,QueueT>::getCoalescingKey(const Operation& op)
+  {
+    return "";
+  }
+#endif //STUB_OperationsDispatcher_getCoalescingKey
+
+#ifndef STUB_OperationsDispatcher_isSuperseded
+//#define STUB_OperationsDispatcher_isSuperseded
+  template <typename T,typename QueueT>
+  bool OperationsDispatcher<T,QueueT>::isSuperseded(const OpQueEntry<T>& opQueueEntry)
+  {
+    return false;
+  }
+#endif //STUB_OperationsDispatcher_isSuperseded
+
 #ifndef STUB_OperationsDispatcher_dispatchOperation
 //#define STUB_OperationsDispatcher_dispatchOperation
-  template <typename T>
-  void OperationsDispatcher<T>::dispatchOperation(OpQueEntry<T>& opQueueEntry)
+  template <typename T,typename QueueT>
+  void OperationsDispatcher<T,QueueT>::dispatchOperation(OpQueEntry<T>& opQueueEntry)
   {
     
   }
@@ -203,8 +221,8 @@
 
 #ifndef STUB_OperationsDispatcher_getTime
 //#define STUB_OperationsDispatcher_getTime
-  template <typename T>
-  std::chrono::steady_clock::duration OperationsDispatcher<T>::getTime() const
+  template <typename T,typename QueueT>
+  std::chrono::steady_clock::duration OperationsDispatcher<T,QueueT>::getTime() const
   {
     return *static_cast<std::chrono::steady_clock::duration*>(nullptr);
   }
@@ -2,8 +2,8 @@
 
 #ifndef STUB_OperationsDispatcher_OperationsDispatcher
 #define STUB_OperationsDispatcher_OperationsDispatcher
-template <typename T>
-OperationsDispatcher<T>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor, TimeProviderFnType timeProviderFn)
+template <typename T, typename QueueT>
+OperationsDispatcher<T, QueueT>::OperationsDispatcher(std::function<void(const Operation&, Ref<T>)> operationProcessor, TimeProviderFnType timeProviderFn)
     : m_operationProcessor(operationProcessor), m_timeProviderFn(timeProviderFn)
 {
 
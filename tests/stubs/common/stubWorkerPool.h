@@ -0,0 +1,52 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubWorkerPool_custom.h file.
+
+#ifndef STUB_COMMON_WORKERPOOL_H
+#define STUB_COMMON_WORKERPOOL_H
+
+#include "common/WorkerPool.h"
+#include "stubWorkerPool_custom.h"
+
+#ifndef STUB_WorkerPool_WorkerPool
+//#define STUB_WorkerPool_WorkerPool
+   WorkerPool::WorkerPool(size_t numberOfThreads)
+    : m_function(nullptr)
+  {
+    
+  }
+#endif //STUB_WorkerPool_WorkerPool
+
+#ifndef STUB_WorkerPool_WorkerPool_DTOR
+//#define STUB_WorkerPool_WorkerPool_DTOR
+   WorkerPool::~WorkerPool()
+  {
+    
+  }
+#endif //STUB_WorkerPool_WorkerPool_DTOR
+
+#ifndef STUB_WorkerPool_parallelFor
+//#define STUB_WorkerPool_parallelFor
+  void WorkerPool::parallelFor(size_t count, const std::function<void(size_t)>& function)
+  {
+    
+  }
+#endif //STUB_WorkerPool_parallelFor
+
+#ifndef STUB_WorkerPool_workerLoop
+//#define STUB_WorkerPool_workerLoop
+  void WorkerPool::workerLoop()
+  {
+    
+  }
+#endif //STUB_WorkerPool_workerLoop
+
+#ifndef STUB_WorkerPool_process
+//#define STUB_WorkerPool_process
+  void WorkerPool::process(const std::function<void(size_t)>& function, size_t count)
+  {
+    
+  }
+#endif //STUB_WorkerPool_process
+
+
+#endif
\ No newline at end of file
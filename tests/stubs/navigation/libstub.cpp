@@ -18,3 +18,4 @@
 
 #include "stubAwareness.h"
 #include "stubSteering.h"
+#include "stubTileCacheStore.h"
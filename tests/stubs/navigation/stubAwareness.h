@@ -11,8 +11,8 @@
 
 #ifndef STUB_Awareness_Awareness
 //#define STUB_Awareness_Awareness
-   Awareness::Awareness(const LocatedEntity& domainEntity, float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, const WFMath::AxisBox<3>& extent, int tileSize )
-    : mTileCache(nullptr),mNavMesh(nullptr),mNavQuery(nullptr),mObstacleAvoidanceQuery(nullptr)
+   Awareness::Awareness(const LocatedEntity& domainEntity, float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, const WFMath::AxisBox<3>& extent, int tileSize , JobQueue* tileBuildQueue , std::shared_ptr<TileCacheStore> tileCacheStore )
+    : mTileCache(nullptr),mNavMesh(nullptr),mNavQuery(nullptr),mObstacleAvoidanceQuery(nullptr),mTileBuildQueue(nullptr)
   {
     
   }
@@ -210,6 +210,46 @@
   }
 #endif //STUB_Awareness_rebuildTile
 
+#ifndef STUB_Awareness_installTileLayers
+//#define STUB_Awareness_installTileLayers
+  void Awareness::installTileLayers(int tx, int ty, TileCacheData* tiles, int ntiles)
+  {
+    
+  }
+#endif //STUB_Awareness_installTileLayers
+
+#ifndef STUB_Awareness_startTileBuild
+//#define STUB_Awareness_startTileBuild
+  void Awareness::startTileBuild(int tx, int ty)
+  {
+    
+  }
+#endif //STUB_Awareness_startTileBuild
+
+#ifndef STUB_Awareness_installFinishedTileBuilds
+//#define STUB_Awareness_installFinishedTileBuilds
+  void Awareness::installFinishedTileBuilds()
+  {
+    
+  }
+#endif //STUB_Awareness_installFinishedTileBuilds
+
+#ifndef STUB_Awareness_cancelTileBuild
+//#define STUB_Awareness_cancelTileBuild
+  bool Awareness::cancelTileBuild(const std::pair<int, int>& tileIndex)
+  {
+    return false;
+  }
+#endif //STUB_Awareness_cancelTileBuild
+
+#ifndef STUB_Awareness_getTileArea
+//#define STUB_Awareness_getTileArea
+  WFMath::AxisBox<2> Awareness::getTileArea(int tx, int ty) const
+  {
+    return *static_cast<WFMath::AxisBox<2>*>(nullptr);
+  }
+#endif //STUB_Awareness_getTileArea
+
 #ifndef STUB_Awareness_buildEntityAreas
 //#define STUB_Awareness_buildEntityAreas
   void Awareness::buildEntityAreas(const EntityEntry& entity, std::map<const EntityEntry*, WFMath::RotBox<2>>& entityAreas)
@@ -226,6 +266,30 @@
   }
 #endif //STUB_Awareness_findEntityAreas
 
+#ifndef STUB_Awareness_setEntityArea
+//#define STUB_Awareness_setEntityArea
+  void Awareness::setEntityArea(const EntityEntry* entity, const WFMath::RotBox<2>& area)
+  {
+    
+  }
+#endif //STUB_Awareness_setEntityArea
+
+#ifndef STUB_Awareness_removeEntityArea
+//#define STUB_Awareness_removeEntityArea
+  void Awareness::removeEntityArea(const EntityEntry* entity)
+  {
+    
+  }
+#endif //STUB_Awareness_removeEntityArea
+
+#ifndef STUB_Awareness_updateEntityAreaBuckets
+//#define STUB_Awareness_updateEntityAreaBuckets
+  void Awareness::updateEntityAreaBuckets(const EntityEntry* entity, const WFMath::RotBox<2>& area, bool add)
+  {
+    
+  }
+#endif //STUB_Awareness_updateEntityAreaBuckets
+
 #ifndef STUB_Awareness_rasterizeTileLayers
 //#define STUB_Awareness_rasterizeTileLayers
   int Awareness::rasterizeTileLayers(const std::vector<WFMath::RotBox<2>>& entityAreas, int tx, int ty, TileCacheData* tiles, int maxTiles)
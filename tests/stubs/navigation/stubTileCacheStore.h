@@ -0,0 +1,91 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubTileCacheStore_custom.h file.
+
+#ifndef STUB_NAVIGATION_TILECACHESTORE_H
+#define STUB_NAVIGATION_TILECACHESTORE_H
+
+#include "navigation/TileCacheStore.h"
+#include "stubTileCacheStore_custom.h"
+
+#ifndef STUB_TileCacheStore_TileCacheStore
+//#define STUB_TileCacheStore_TileCacheStore
+   TileCacheStore::TileCacheStore(std::string path)
+  {
+    
+  }
+#endif //STUB_TileCacheStore_TileCacheStore
+
+#ifndef STUB_TileCacheStore_TileCacheStore_DTOR
+//#define STUB_TileCacheStore_TileCacheStore_DTOR
+   TileCacheStore::~TileCacheStore()
+  {
+    
+  }
+#endif //STUB_TileCacheStore_TileCacheStore_DTOR
+
+#ifndef STUB_TileCacheStore_find
+//#define STUB_TileCacheStore_find
+  const TileCacheStore::Layers* TileCacheStore::find(int tx, int ty, std::uint64_t hash) const
+  {
+    return nullptr;
+  }
+#endif //STUB_TileCacheStore_find
+
+#ifndef STUB_TileCacheStore_store
+//#define STUB_TileCacheStore_store
+  void TileCacheStore::store(int tx, int ty, std::uint64_t hash, Layers layers)
+  {
+    
+  }
+#endif //STUB_TileCacheStore_store
+
+#ifndef STUB_TileCacheStore_hash
+//#define STUB_TileCacheStore_hash
+   std::uint64_t TileCacheStore::hash(const void* data, size_t length, std::uint64_t hash )
+  {
+    return *static_cast< std::uint64_t*>(nullptr);
+  }
+#endif //STUB_TileCacheStore_hash
+
+#ifndef STUB_TileCacheStore_lock
+//#define STUB_TileCacheStore_lock
+  bool TileCacheStore::lock()
+  {
+    return false;
+  }
+#endif //STUB_TileCacheStore_lock
+
+#ifndef STUB_TileCacheStore_load
+//#define STUB_TileCacheStore_load
+  bool TileCacheStore::load()
+  {
+    return false;
+  }
+#endif //STUB_TileCacheStore_load
+
+#ifndef STUB_TileCacheStore_compact
+//#define STUB_TileCacheStore_compact
+  bool TileCacheStore::compact()
+  {
+    return false;
+  }
+#endif //STUB_TileCacheStore_compact
+
+#ifndef STUB_TileCacheStore_openForAppending
+//#define STUB_TileCacheStore_openForAppending
+  void TileCacheStore::openForAppending()
+  {
+    
+  }
+#endif //STUB_TileCacheStore_openForAppending
+
+#ifndef STUB_TileCacheStore_writeRecord
+//#define STUB_TileCacheStore_writeRecord
+   void TileCacheStore::writeRecord(std::ostream& stream, int tx, int ty, const Entry& entry)
+  {
+    
+  }
+#endif //STUB_TileCacheStore_writeRecord
+
+
+#endif
\ No newline at end of file
@@ -9,13 +9,21 @@
 
 #ifndef STUB_AwareMindFactory_AwareMindFactory
 //#define STUB_AwareMindFactory_AwareMindFactory
-   AwareMindFactory::AwareMindFactory(const PropertyManager& propertyManager)
-    : MindKit(propertyManager)
+   AwareMindFactory::AwareMindFactory(const PropertyManager& propertyManager, size_t navmeshThreads , std::string navmeshCacheDirectory )
+    : mPropertyManager(propertyManager)
   {
     
   }
 #endif //STUB_AwareMindFactory_AwareMindFactory
 
+#ifndef STUB_AwareMindFactory_AwareMindFactory_DTOR
+//#define STUB_AwareMindFactory_AwareMindFactory_DTOR
+   AwareMindFactory::~AwareMindFactory()
+  {
+    
+  }
+#endif //STUB_AwareMindFactory_AwareMindFactory_DTOR
+
 #ifndef STUB_AwareMindFactory_newMind
 //#define STUB_AwareMindFactory_newMind
   BaseMind* AwareMindFactory::newMind(const std::string& mind_id, const std::string& entity_id) const
@@ -9,7 +9,8 @@
 
 #ifndef STUB_AwarenessStore_AwarenessStore
 //#define STUB_AwarenessStore_AwarenessStore
-   AwarenessStore::AwarenessStore(float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, int tileSize )
+   AwarenessStore::AwarenessStore(float agentRadius, float agentHeight, float stepHeight, IHeightProvider& heightProvider, int tileSize , JobQueue* tileBuildQueue , std::string tileCachePathPrefix )
+    : mTileBuildQueue(nullptr)
   {
     
   }
@@ -9,7 +9,8 @@
 
 #ifndef STUB_AwarenessStoreProvider_AwarenessStoreProvider
 //#define STUB_AwarenessStoreProvider_AwarenessStoreProvider
-   AwarenessStoreProvider::AwarenessStoreProvider(IHeightProvider& heightProvider)
+   AwarenessStoreProvider::AwarenessStoreProvider(IHeightProvider& heightProvider, JobQueue* tileBuildQueue , std::string tileCacheDirectory )
+    : m_tileBuildQueue(nullptr)
   {
     
   }
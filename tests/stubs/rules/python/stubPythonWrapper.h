@@ -7,10 +7,35 @@
 #include "rules/python/PythonWrapper.h"
 #include "stubPythonWrapper_custom.h"
 
+#ifndef STUB_PythonWrapper_callPropertyUpdate
+//#define STUB_PythonWrapper_callPropertyUpdate
+  void PythonWrapper::callPropertyUpdate(const std::string& fieldName)
+  {
+    
+  }
+#endif //STUB_PythonWrapper_callPropertyUpdate
+
+#ifndef STUB_PythonWrapper_cancelPendingPropertyUpdates
+//#define STUB_PythonWrapper_cancelPendingPropertyUpdates
+  void PythonWrapper::cancelPendingPropertyUpdates()
+  {
+    
+  }
+#endif //STUB_PythonWrapper_cancelPendingPropertyUpdates
+
+#ifndef STUB_PythonWrapper_hasOperationHandler
+//#define STUB_PythonWrapper_hasOperationHandler
+  bool PythonWrapper::hasOperationHandler(const std::string& op_type) const
+  {
+    return false;
+  }
+#endif //STUB_PythonWrapper_hasOperationHandler
+
 #ifndef STUB_PythonWrapper_PythonWrapper
 //#define STUB_PythonWrapper_PythonWrapper
    PythonWrapper::PythonWrapper(const Py::Object& wrapper)
     : Script(wrapper)
+    , m_propertyUpdateEntity(nullptr)
   {
     
   }
@@ -56,5 +81,21 @@
   }
 #endif //STUB_PythonWrapper_processScriptResult
 
+#ifndef STUB_PythonWrapper_clearOperationHandlerCache
+//#define STUB_PythonWrapper_clearOperationHandlerCache
+   void PythonWrapper::clearOperationHandlerCache()
+  {
+    
+  }
+#endif //STUB_PythonWrapper_clearOperationHandlerCache
+
+#ifndef STUB_PythonWrapper_flushPropertyUpdates
+//#define STUB_PythonWrapper_flushPropertyUpdates
+   void PythonWrapper::flushPropertyUpdates()
+  {
+    
+  }
+#endif //STUB_PythonWrapper_flushPropertyUpdates
+
 
 #endif
\ No newline at end of file
@@ -7,6 +7,30 @@
 #include "rules/simulation/Entity.h"
 #include "stubEntity_custom.h"
 
+#ifndef STUB_Entity_findDelegateProperty
+//#define STUB_Entity_findDelegateProperty
+  PropertyBase* Entity::findDelegateProperty(const std::string& name) const
+  {
+    return nullptr;
+  }
+#endif //STUB_Entity_findDelegateProperty
+
+#ifndef STUB_Entity_resolveDelegates
+//#define STUB_Entity_resolveDelegates
+  void Entity::resolveDelegates()
+  {
+    
+  }
+#endif //STUB_Entity_resolveDelegates
+
+#ifndef STUB_Entity_onPropertyInstanceChanged
+//#define STUB_Entity_onPropertyInstanceChanged
+  void Entity::onPropertyInstanceChanged(const std::string& name)
+  {
+    
+  }
+#endif //STUB_Entity_onPropertyInstanceChanged
+
 #ifndef STUB_Entity_Entity
 //#define STUB_Entity_Entity
    Entity::Entity(const std::string& id, long intId)
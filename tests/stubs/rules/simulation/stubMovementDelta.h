@@ -0,0 +1,35 @@
+// AUTOGENERATED file, created by the tool generate_stub.py, don't edit!
+// If you want to add your own functionality, instead edit the stubMovementDelta_custom.h file.
+
+#ifndef STUB_RULES_SIMULATION_MOVEMENTDELTA_H
+#define STUB_RULES_SIMULATION_MOVEMENTDELTA_H
+
+#include "rules/simulation/MovementDelta.h"
+#include "stubMovementDelta_custom.h"
+
+#ifndef STUB_MovementDelta_quantize
+//#define STUB_MovementDelta_quantize
+   Atlas::Message::IntType MovementDelta::quantize(double value, double scale)
+  {
+    return *static_cast< Atlas::Message::IntType*>(nullptr);
+  }
+#endif //STUB_MovementDelta_quantize
+
+#ifndef STUB_MovementDelta_write
+//#define STUB_MovementDelta_write
+  void MovementDelta::write(Atlas::Message::ListType& list, bool keyframe) const
+  {
+    
+  }
+#endif //STUB_MovementDelta_write
+
+#ifndef STUB_MovementDelta_read
+//#define STUB_MovementDelta_read
+   bool MovementDelta::read(const Atlas::Message::ListType& list, size_t& index, MovementDelta& record)
+  {
+    return false;
+  }
+#endif //STUB_MovementDelta_read
+
+
+#endif
\ No newline at end of file
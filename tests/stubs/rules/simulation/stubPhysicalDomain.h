@@ -43,9 +43,9 @@
 
 #ifndef STUB_PhysicalDomain_getObservingEntitiesFor
 //#define STUB_PhysicalDomain_getObservingEntitiesFor
-  std::list<LocatedEntity*> PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+  void PhysicalDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
   {
-    return std::list<LocatedEntity*>();
+    
   }
 #endif //STUB_PhysicalDomain_getObservingEntitiesFor
 
@@ -57,6 +57,14 @@
   }
 #endif //STUB_PhysicalDomain_addEntity
 
+#ifndef STUB_PhysicalDomain_addEntities
+//#define STUB_PhysicalDomain_addEntities
+  void PhysicalDomain::addEntities(const std::vector<LocatedEntity*>& entities)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_addEntities
+
 #ifndef STUB_PhysicalDomain_removeEntity
 //#define STUB_PhysicalDomain_removeEntity
   void PhysicalDomain::removeEntity(LocatedEntity& entity)
@@ -217,6 +225,46 @@
   }
 #endif //STUB_PhysicalDomain_processMovedEntity
 
+#ifndef STUB_PhysicalDomain_markAsMoving
+//#define STUB_PhysicalDomain_markAsMoving
+  void PhysicalDomain::markAsMoving(BulletEntry* entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_markAsMoving
+
+#ifndef STUB_PhysicalDomain_markAsDirty
+//#define STUB_PhysicalDomain_markAsDirty
+  void PhysicalDomain::markAsDirty(BulletEntry* entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_markAsDirty
+
+#ifndef STUB_PhysicalDomain_flushMoveSights
+//#define STUB_PhysicalDomain_flushMoveSights
+  void PhysicalDomain::flushMoveSights()
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_flushMoveSights
+
+#ifndef STUB_PhysicalDomain_acceptsMovementDeltas
+//#define STUB_PhysicalDomain_acceptsMovementDeltas
+   bool PhysicalDomain::acceptsMovementDeltas(const LocatedEntity& observer)
+  {
+    return false;
+  }
+#endif //STUB_PhysicalDomain_acceptsMovementDeltas
+
+#ifndef STUB_PhysicalDomain_createEntry
+//#define STUB_PhysicalDomain_createEntry
+  PhysicalDomain::BulletEntry* PhysicalDomain::createEntry(LocatedEntity& entity)
+  {
+    return nullptr;
+  }
+#endif //STUB_PhysicalDomain_createEntry
+
 #ifndef STUB_PhysicalDomain_updateVisibilityOfDirtyEntities
 //#define STUB_PhysicalDomain_updateVisibilityOfDirtyEntities
   void PhysicalDomain::updateVisibilityOfDirtyEntities(OpVector& res)
@@ -241,6 +289,86 @@
   }
 #endif //STUB_PhysicalDomain_updateObserverEntry
 
+#ifndef STUB_PhysicalDomain_queryObservedEntries
+//#define STUB_PhysicalDomain_queryObservedEntries
+  void PhysicalDomain::queryObservedEntries(const BulletEntry& observerEntry, std::vector<BulletEntry*>& result) const
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_queryObservedEntries
+
+#ifndef STUB_PhysicalDomain_queryObservingEntries
+//#define STUB_PhysicalDomain_queryObservingEntries
+  void PhysicalDomain::queryObservingEntries(const BulletEntry& observedEntry, std::vector<BulletEntry*>& result) const
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_queryObservingEntries
+
+#ifndef STUB_PhysicalDomain_applyObservedEntries
+//#define STUB_PhysicalDomain_applyObservedEntries
+  void PhysicalDomain::applyObservedEntries(BulletEntry* observerEntry, std::vector<BulletEntry*>& observedEntries, OpVector& res)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_applyObservedEntries
+
+#ifndef STUB_PhysicalDomain_applyObservingEntries
+//#define STUB_PhysicalDomain_applyObservingEntries
+  void PhysicalDomain::applyObservingEntries(BulletEntry* observedEntry, std::vector<BulletEntry*>& observingEntries, OpVector& res, bool generateOps)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_applyObservingEntries
+
+#ifndef STUB_PhysicalDomain_setVisibilityBackend
+//#define STUB_PhysicalDomain_setVisibilityBackend
+  void PhysicalDomain::setVisibilityBackend(const std::string& backend)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_setVisibilityBackend
+
+#ifndef STUB_PhysicalDomain_addVisibilitySphere
+//#define STUB_PhysicalDomain_addVisibilitySphere
+  void PhysicalDomain::addVisibilitySphere(BulletEntry& entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_addVisibilitySphere
+
+#ifndef STUB_PhysicalDomain_addViewSphere
+//#define STUB_PhysicalDomain_addViewSphere
+  void PhysicalDomain::addViewSphere(BulletEntry& entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_addViewSphere
+
+#ifndef STUB_PhysicalDomain_removeVisibilitySphere
+//#define STUB_PhysicalDomain_removeVisibilitySphere
+  void PhysicalDomain::removeVisibilitySphere(BulletEntry& entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_removeVisibilitySphere
+
+#ifndef STUB_PhysicalDomain_removeViewSphere
+//#define STUB_PhysicalDomain_removeViewSphere
+  void PhysicalDomain::removeViewSphere(BulletEntry& entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_removeViewSphere
+
+#ifndef STUB_PhysicalDomain_updateVisibilitySpheres
+//#define STUB_PhysicalDomain_updateVisibilitySpheres
+  void PhysicalDomain::updateVisibilitySpheres(BulletEntry& entry)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_updateVisibilitySpheres
+
 #ifndef STUB_PhysicalDomain_applyNewPositionForEntity
 //#define STUB_PhysicalDomain_applyNewPositionForEntity
   void PhysicalDomain::applyNewPositionForEntity(BulletEntry* entry, const WFMath::Point<3>& pos, bool calculatePosition )
@@ -297,6 +425,14 @@
   }
 #endif //STUB_PhysicalDomain_processWaterBodies
 
+#ifndef STUB_PhysicalDomain_setTickTimings
+//#define STUB_PhysicalDomain_setTickTimings
+  void PhysicalDomain::setTickTimings(const TickTimings& tickTimings)
+  {
+    
+  }
+#endif //STUB_PhysicalDomain_setTickTimings
+
 #ifndef STUB_PhysicalDomain_createCollisionShapeForEntry
 //#define STUB_PhysicalDomain_createCollisionShapeForEntry
   std::shared_ptr<btCollisionShape> PhysicalDomain::createCollisionShapeForEntry(LocatedEntity& entity, const WFMath::AxisBox<3>& bbox, float mass, btVector3& centerOfMassOffse)
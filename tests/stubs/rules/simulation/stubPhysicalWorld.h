@@ -9,8 +9,8 @@
 
 #ifndef STUB_PhysicalWorld_PhysicalWorld
 //#define STUB_PhysicalWorld_PhysicalWorld
-   PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration)
-    : btDiscreteDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration)
+   PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, btConstraintSolver* constraintSolverMt )
+    : PhysicalWorldBase(dispatcher, pairCache, constraintSolver, collisionConfiguration, constraintSolverMt)
   {
     
   }
@@ -32,5 +32,21 @@
   }
 #endif //STUB_PhysicalWorld_stepSimulation
 
+#ifndef STUB_PhysicalWorld_performDiscreteCollisionDetection
+//#define STUB_PhysicalWorld_performDiscreteCollisionDetection
+  void PhysicalWorld::performDiscreteCollisionDetection()
+  {
+    
+  }
+#endif //STUB_PhysicalWorld_performDiscreteCollisionDetection
+
+#ifndef STUB_PhysicalWorld_solveConstraints
+//#define STUB_PhysicalWorld_solveConstraints
+  void PhysicalWorld::solveConstraints(btContactSolverInfo& solverInfo)
+  {
+    
+  }
+#endif //STUB_PhysicalWorld_solveConstraints
+
 
 #endif
\ No newline at end of file
@@ -1 +1,14 @@
 //Add custom implementations of stubbed functions here; this file won't be rewritten when re-generating stubs.
+#ifndef STUB_PhysicalWorld_PhysicalWorld
+#define STUB_PhysicalWorld_PhysicalWorld
+PhysicalWorld::PhysicalWorld(btDispatcher* dispatcher, btBroadphaseInterface* pairCache, btConstraintSolver* constraintSolver, btCollisionConfiguration* collisionConfiguration, btConstraintSolver* constraintSolverMt)
+#if defined(BT_THREADSAFE) && BT_THREADSAFE
+    : PhysicalWorldBase(dispatcher, pairCache, static_cast<btConstraintSolverPoolMt*>(constraintSolver), constraintSolverMt, collisionConfiguration),
+#else
+    : PhysicalWorldBase(dispatcher, pairCache, constraintSolver, collisionConfiguration),
+#endif
+      m_stepTimings{}
+{
+
+}
+#endif //STUB_PhysicalWorld_PhysicalWorld
@@ -34,9 +34,9 @@
 
 #ifndef STUB_StackableDomain_getObservingEntitiesFor
 //#define STUB_StackableDomain_getObservingEntitiesFor
-  std::list<LocatedEntity*> StackableDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity) const
+  void StackableDomain::getObservingEntitiesFor(const LocatedEntity& observedEntity, std::vector<const LocatedEntity*>& entityList) const
   {
-    return std::list<LocatedEntity*>();
+    
   }
 #endif //STUB_StackableDomain_getObservingEntitiesFor
 
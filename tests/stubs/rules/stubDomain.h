@@ -39,6 +39,14 @@
   }
 #endif //STUB_Domain_addEntity
 
+#ifndef STUB_Domain_addEntities
+//#define STUB_Domain_addEntities
+  void Domain::addEntities(const std::vector<LocatedEntity*>& entities)
+  {
+    
+  }
+#endif //STUB_Domain_addEntities
+
 #ifndef STUB_Domain_removeEntity
 //#define STUB_Domain_removeEntity
   void Domain::removeEntity(LocatedEntity& entity)
@@ -18,12 +18,20 @@
 
 #ifndef STUB_LocatedEntity_collectObserversForChild
 //#define STUB_LocatedEntity_collectObserversForChild
-  void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::set<const LocatedEntity*>& receivers) const
+  void LocatedEntity::collectObserversForChild(const LocatedEntity& child, std::vector<const LocatedEntity*>& receivers) const
   {
     
   }
 #endif //STUB_LocatedEntity_collectObserversForChild
 
+#ifndef STUB_LocatedEntity_onPropertyInstanceChanged
+//#define STUB_LocatedEntity_onPropertyInstanceChanged
+  void LocatedEntity::onPropertyInstanceChanged(const std::string& name)
+  {
+    
+  }
+#endif //STUB_LocatedEntity_onPropertyInstanceChanged
+
 #ifndef STUB_LocatedEntity_LocatedEntity
 //#define STUB_LocatedEntity_LocatedEntity
    LocatedEntity::LocatedEntity(const std::string& id, long intId)
@@ -290,6 +298,14 @@
   }
 #endif //STUB_LocatedEntity_collectObservers
 
+#ifndef STUB_LocatedEntity_collectObservers
+//#define STUB_LocatedEntity_collectObservers
+  void LocatedEntity::collectObservers(std::vector<const LocatedEntity*>& observers) const
+  {
+    
+  }
+#endif //STUB_LocatedEntity_collectObservers
+
 #ifndef STUB_LocatedEntity_collectObserved
 //#define STUB_LocatedEntity_collectObserved
   void LocatedEntity::collectObserved(std::set<const LocatedEntity*>& observed) const
@@ -39,6 +39,14 @@
   }
 #endif //STUB_Connection_verifyCredentials
 
+#ifndef STUB_Connection_readCapabilities
+//#define STUB_Connection_readCapabilities
+  void Connection::readCapabilities(const Atlas::Objects::Root & arg)
+  {
+    
+  }
+#endif //STUB_Connection_readCapabilities
+
 #ifndef STUB_Connection_Connection
 //#define STUB_Connection_Connection
    Connection::Connection(CommSocket & commSocket, ServerRouting & svr, const std::string & addr, const std::string & id, long iid)
@@ -63,6 +63,22 @@
   }
 #endif //STUB_ExternalMindsManager_requestPossessionFromRegisteredClients
 
+#ifndef STUB_ExternalMindsManager_selectConnection
+//#define STUB_ExternalMindsManager_selectConnection
+  ExternalMindsConnection& ExternalMindsManager::selectConnection()
+  {
+    return *static_cast<ExternalMindsConnection*>(nullptr);
+  }
+#endif //STUB_ExternalMindsManager_selectConnection
+
+#ifndef STUB_ExternalMindsManager_unassignEntity
+//#define STUB_ExternalMindsManager_unassignEntity
+  void ExternalMindsManager::unassignEntity(const std::string& entity_id)
+  {
+    
+  }
+#endif //STUB_ExternalMindsManager_unassignEntity
+
 #ifndef STUB_ExternalMindsManager_addPossessionEntryForCharacter
 //#define STUB_ExternalMindsManager_addPossessionEntryForCharacter
   void ExternalMindsManager::addPossessionEntryForCharacter(LocatedEntity* character)
@@ -39,13 +39,13 @@
   }
 #endif //STUB_StorageManager_encodeElement
 
-#ifndef STUB_StorageManager_restorePropertiesRecursively
-//#define STUB_StorageManager_restorePropertiesRecursively
-  void StorageManager::restorePropertiesRecursively(LocatedEntity*)
+#ifndef STUB_StorageManager_restoreProperties
+//#define STUB_StorageManager_restoreProperties
+  void StorageManager::restoreProperties(LocatedEntity* ent, const std::vector<std::pair<std::string, Atlas::Message::Element>>& properties)
   {
     
   }
-#endif //STUB_StorageManager_restorePropertiesRecursively
+#endif //STUB_StorageManager_restoreProperties
 
 #ifndef STUB_StorageManager_insertEntity
 //#define STUB_StorageManager_insertEntity
@@ -63,13 +63,21 @@
   }
 #endif //STUB_StorageManager_updateEntity
 
-#ifndef STUB_StorageManager_restoreChildren
-//#define STUB_StorageManager_restoreChildren
-  size_t StorageManager::restoreChildren(LocatedEntity*)
+#ifndef STUB_StorageManager_readStoredEntities
+//#define STUB_StorageManager_readStoredEntities
+  std::vector<StoredEntity> StorageManager::readStoredEntities(const std::string& rootId, size_t& propertyCount)
   {
-    return 0;
+    return std::vector<StoredEntity>();
+  }
+#endif //STUB_StorageManager_readStoredEntities
+
+#ifndef STUB_StorageManager_decodeStoredEntities
+//#define STUB_StorageManager_decodeStoredEntities
+  void StorageManager::decodeStoredEntities(std::vector<StoredEntity>& storedEntities)
+  {
+    
   }
-#endif //STUB_StorageManager_restoreChildren
+#endif //STUB_StorageManager_decodeStoredEntities
 
 #ifndef STUB_StorageManager_StorageManager
 //#define STUB_StorageManager_StorageManager